@@ -32,7 +32,32 @@ LOCAL_C_INCLUDES += bionic
 endif
 
 LOCAL_SRC_FILES:= \
-    RockchipRga.cpp
+    RockchipRga.cpp \
+    RockchipRgaCpu.cpp \
+    RockchipRgaDevice.cpp \
+    RockchipRgaJobQueue.cpp \
+    RockchipRgaPipeline.cpp \
+    RockchipRgaRawVideo.cpp \
+    RockchipRgaThreadPool.cpp
 
 LOCAL_MODULE:= librga
 include $(BUILD_SHARED_LIBRARY)
+
+# the rga_device_t hal over librga, hw_get_module(DRMRGA_HARDWARE_MODULE_ID)
+include $(CLEAR_VARS)
+
+LOCAL_CFLAGS += -Wall -Werror -Wunreachable-code
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    liblog \
+    libutils \
+    libhardware \
+    librga
+
+LOCAL_SRC_FILES:= \
+    RockchipRgaHal.cpp
+
+LOCAL_MODULE_RELATIVE_PATH := hw
+LOCAL_MODULE:= librga.default
+include $(BUILD_SHARED_LIBRARY)
@@ -20,6 +20,8 @@
 #include <utils/misc.h>
 #include <signal.h>
 #include <time.h>
+#include <string>
+#include <algorithm>
 
 #include <cutils/properties.h>
 
@@ -41,6 +43,105 @@
 #include <gui/SurfaceComposerClient.h>
 
 #include "RockchipRga.h"
+#include "RockchipRgaCpu.h"
+#include "RockchipRgaDevice.h"
+#include "RockchipRgaJobQueue.h"
+
+#ifndef DMA_BUF_IOCTL_SYNC
+struct dma_buf_sync {
+    uint64_t flags;
+};
+
+#define DMA_BUF_SYNC_READ               (1 << 0)
+#define DMA_BUF_SYNC_WRITE              (2 << 0)
+#define DMA_BUF_SYNC_RW                 (DMA_BUF_SYNC_READ | DMA_BUF_SYNC_WRITE)
+#define DMA_BUF_SYNC_START              (0 << 2)
+#define DMA_BUF_SYNC_END                (1 << 2)
+#define DMA_BUF_BASE                    'b'
+#define DMA_BUF_IOCTL_SYNC              _IOW(DMA_BUF_BASE, 0, struct dma_buf_sync)
+#endif
+
+/*
+ * sin/cos of 0..359 degrees in 16.16, what the rga expects in
+ * rga_req.sina/cosa. Constant so every instance shares one copy.
+ */
+static const int rgaSinaTable[360] = {
+        0,   1144,   2287,   3430,   4572,   5712,   6850,   7987,   9121,  10252,
+    11380,  12505,  13626,  14742,  15855,  16962,  18064,  19161,  20252,  21336,
+    22415,  23486,  24550,  25607,  26656,  27697,  28729,  29753,  30767,  31772,
+    32768,  33754,  34729,  35693,  36647,  37590,  38521,  39441,  40348,  41243,
+    42126,  42995,  43852,  44695,  45525,  46341,  47143,  47930,  48703,  49461,
+    50203,  50931,  51643,  52339,  53020,  53684,  54332,  54963,  55578,  56175,
+    56756,  57319,  57865,  58393,  58903,  59396,  59870,  60326,  60764,  61183,
+    61584,  61966,  62328,  62672,  62997,  63303,  63589,  63856,  64104,  64332,
+    64540,  64729,  64898,  65048,  65177,  65287,  65376,  65446,  65496,  65526,
+    65536,  65526,  65496,  65446,  65376,  65287,  65177,  65048,  64898,  64729,
+    64540,  64332,  64104,  63856,  63589,  63303,  62997,  62672,  62328,  61966,
+    61584,  61183,  60764,  60326,  59870,  59396,  58903,  58393,  57865,  57319,
+    56756,  56175,  55578,  54963,  54332,  53684,  53020,  52339,  51643,  50931,
+    50203,  49461,  48703,  47930,  47143,  46341,  45525,  44695,  43852,  42995,
+    42126,  41243,  40348,  39441,  38521,  37590,  36647,  35693,  34729,  33754,
+    32768,  31772,  30767,  29753,  28729,  27697,  26656,  25607,  24550,  23486,
+    22415,  21336,  20252,  19161,  18064,  16962,  15855,  14742,  13626,  12505,
+    11380,  10252,   9121,   7987,   6850,   5712,   4572,   3430,   2287,   1144,
+        0,  -1144,  -2287,  -3430,  -4572,  -5712,  -6850,  -7987,  -9121, -10252,
+    -11380, -12505, -13626, -14742, -15855, -16962, -18064, -19161, -20252, -21336,
+    -22415, -23486, -24550, -25607, -26656, -27697, -28729, -29753, -30767, -31772,
+    -32768, -33754, -34729, -35693, -36647, -37590, -38521, -39441, -40348, -41243,
+    -42126, -42995, -43852, -44695, -45525, -46341, -47143, -47930, -48703, -49461,
+    -50203, -50931, -51643, -52339, -53020, -53684, -54332, -54963, -55578, -56175,
+    -56756, -57319, -57865, -58393, -58903, -59396, -59870, -60326, -60764, -61183,
+    -61584, -61966, -62328, -62672, -62997, -63303, -63589, -63856, -64104, -64332,
+    -64540, -64729, -64898, -65048, -65177, -65287, -65376, -65446, -65496, -65526,
+    -65536, -65526, -65496, -65446, -65376, -65287, -65177, -65048, -64898, -64729, 
+    -64540, -64332, -64104, -63856, -63589, -63303, -62997, -62672, -62328, -61966,
+    -61584, -61183, -60764, -60326, -59870, -59396, -58903, -58393, -57865, -57319,
+    -56756, -56175, -55578, -54963, -54332, -53684, -53020, -52339, -51643, -50931,
+    -50203, -49461, -48703, -47930, -47143, -46341, -45525, -44695, -43852, -42995,
+    -42126, -41243, -40348, -39441, -38521, -37590, -36647, -35693, -34729, -33754,
+    -32768, -31772, -30767, -29753, -28729, -27697, -26656, -25607, -24550, -23486, 
+    -22415, -21336, -20252, -19161, -18064, -16962, -15855, -14742, -13626, -12505,
+    -11380, -10252, -9121,   -7987,  -6850,  -5712,  -4572,  -3430,  -2287,  -1144
+};
+
+static const int rgaCosaTable[360] = {
+     65536,  65526,  65496,  65446,  65376,  65287,  65177,  65048,  64898,  64729,
+     64540,  64332,  64104,  63856,  63589,  63303,  62997,  62672,  62328,  61966,
+     61584,  61183,  60764,  60326,  59870,  59396,  58903,  58393,  57865,  57319,
+     56756,  56175,  55578,  54963,  54332,  53684,  53020,  52339,  51643,  50931,
+     50203,  49461,  48703,  47930,  47143,  46341,  45525,  44695,  43852,  42995,
+     42126,  41243,  40348,  39441,  38521,  37590,  36647,  35693,  34729,  33754,
+     32768,  31772,  30767,  29753,  28729,  27697,  26656,  25607,  24550,  23486,
+     22415,  21336,  20252,  19161,  18064,  16962,  15855,  14742,  13626,  12505,
+     11380,  10252,   9121,   7987,   6850,   5712,   4572,   3430,   2287,   1144,
+         0,  -1144,  -2287,  -3430,  -4572,  -5712,  -6850,  -7987,  -9121, -10252,
+    -11380, -12505, -13626, -14742, -15855, -16962, -18064, -19161, -20252, -21336,
+    -22415, -23486, -24550, -25607, -26656, -27697, -28729, -29753, -30767, -31772,
+    -32768, -33754, -34729, -35693, -36647, -37590, -38521, -39441, -40348, -41243,
+    -42126, -42995, -43852, -44695, -45525, -46341, -47143, -47930, -48703, -49461,
+    -50203, -50931, -51643, -52339, -53020, -53684, -54332, -54963, -55578, -56175,
+    -56756, -57319, -57865, -58393, -58903, -59396, -59870, -60326, -60764, -61183,
+    -61584, -61966, -62328, -62672, -62997, -63303, -63589, -63856, -64104, -64332,
+    -64540, -64729, -64898, -65048, -65177, -65287, -65376, -65446, -65496, -65526,
+    -65536, -65526, -65496, -65446, -65376, -65287, -65177, -65048, -64898, -64729, 
+    -64540, -64332, -64104, -63856, -63589, -63303, -62997, -62672, -62328, -61966,
+    -61584, -61183, -60764, -60326, -59870, -59396, -58903, -58393, -57865, -57319,
+    -56756, -56175, -55578, -54963, -54332, -53684, -53020, -52339, -51643, -50931,
+    -50203, -49461, -48703, -47930, -47143, -46341, -45525, -44695, -43852, -42995,
+    -42126, -41243, -40348, -39441, -38521, -37590, -36647, -35693, -34729, -33754,
+    -32768, -31772, -30767, -29753, -28729, -27697, -26656, -25607, -24550, -23486,
+    -22415, -21336, -20252, -19161, -18064, -16962, -15855, -14742, -13626, -12505, 
+    -11380, -10252,  -9121,  -7987,  -6850,  -5712,  -4572,  -3430,  -2287,  -1144,
+         0,   1144,   2287,   3430,   4572,   5712,   6850,   7987,   9121,  10252,
+     11380,  12505,  13626,  14742,  15855,  16962,  18064,  19161,  20252,  21336,
+     22415,  23486,  24550,  25607,  26656,  27697,  28729,  29753,  30767,  31772,
+     32768,  33754,  34729,  35693,  36647,  37590,  38521,  39441,  40348,  41243,
+     42126,  42995,  43852,  44695,  45525,  46341,  47143,  47930,  48703,  49461,
+     50203,  50931,  51643,  52339,  53020,  53684,  54332,  54963,  55578,  56175,
+     56756,  57319,  57865,  58393,  58903,  59396,  59870,  60326,  60764,  61183,
+     61584,  61966,  62328,  62672,  62997,  63303,  63589,  63856,  64104,  64332,
+     64540,  64729,  64898,  65048,  65177,  65287,  65376,  65446,  65496,  65526
+};
 
 namespace android {
 
@@ -52,1031 +153,1231 @@ Mutex RockchipRga::mMutex;
 RockchipRga::RockchipRga():
     rgaFd(-1),
     mLogOnce(0),
-    mLogAlways(0)
+    mLogAlways(0),
+    mVersion(0),
+    mAllocMod(NULL),
+    mProbed(false),
+    mEngine(DRM_RGA_ENGINE_HW),
+    mScaleMode(DRM_RGA_SCALE_AUTO),
+    mDitherMode(DRM_RGA_DITHER_AUTO),
+    mDepthMode(DRM_RGA_DEPTH_TRUNCATE),
+    mPaletteMode(-1),
+    mPatternWidth(0),
+    mPatternHeight(0),
+    mExplicitSync(false)
 {
-    RkRgaInit();
+    memset(&mCacheStats, 0, sizeof(rga_cache_stats_t));
+    memset(&mDispatchStats, 0, sizeof(rga_dispatch_stats_t));
+    memset(mPalette, 0, sizeof(mPalette));
+    mCpu = new RockchipRgaCpu();
 }
 
 RockchipRga::~RockchipRga()
 {
-    if (rgaFd > -1) {
-        close(rgaFd);
-        rgaFd = -1;
+    /* stops the submitters, they blit through this object */
+    mJobQueue.clear();
+
+    for (size_t i = 0; i < mDevices.size(); i++)
+        delete mDevices[i];
+    mDevices.clear();
+    rgaFd = -1;
+
+    delete mCpu;
+}
+
+int RockchipRga::RkRgaOpenDevices()
+{
+    char value[PROPERTY_VALUE_MAX];
+    char cache[PROPERTY_VALUE_MAX];
+    char line[PROPERTY_VALUE_MAX + 32];
+    char *path, *save;
+    std::map<std::string, float> versions, opened;
+    std::map<std::string, float>::iterator it;
+    bool probed = false;
+    RockchipRgaDevice *dev;
+    FILE *file;
+
+    /* "<path> <version>" lines of an earlier probe */
+    property_get("persist.rga.caps_cache", cache, "");
+    file = cache[0] ? fopen(cache, "re") : NULL;
+    while (file && fgets(line, sizeof(line), file)) {
+        char node[PROPERTY_VALUE_MAX];
+        float version;
+
+        if (sscanf(line, "%91s %f", node, &version) == 2 && version > 0)
+            versions[node] = version;
+    }
+    if (file)
+        fclose(file);
+
+    /* comma separated device nodes, the first one is the primary core */
+    property_get("persist.rga.devices", value, "/dev/rga");
+    for (path = strtok_r(value, ",", &save); path;
+                                        path = strtok_r(NULL, ",", &save)) {
+        float known = versions.count(path) ? versions[path] : 0;
+
+        dev = RockchipRgaDevice::open(path, known);
+        if (!dev) {
+            ALOGE("open %s fail: %s", path, strerror(errno));
+            continue;
+        }
+        probed |= known <= 0;
+        opened[path] = dev->version();
+        mDevices.push_back(dev);
+    }
+
+    if (!mDevices.empty()) {
+        rgaFd = mDevices[0]->fd();
+        mVersion = mDevices[0]->version();
+    } else
+        mVersion = 2.0;
+
+    /*
+     * The caps follow from the version, see RockchipRgaDevice::initCaps.
+     * Keyed on the full path, the core names are cut to rga_device_info_t.
+     */
+    if (cache[0] && probed) {
+        snprintf(line, sizeof(line), "%s.tmp", cache);
+        file = fopen(line, "we");
+        if (file) {
+            for (it = opened.begin(); it != opened.end(); it++)
+                fprintf(file, "%s %f\n", it->first.c_str(), it->second);
+            if (fclose(file) == 0)
+                rename(line, cache);
+            else
+                unlink(line);
+        }
+    }
+
+    property_get("persist.rga.emulate", value, "0");
+    if (atoi(value) > 0) {
+        for (int i = 0; i < atoi(value); i++)
+            mDevices.push_back(RockchipRgaDevice::createEmulated(i, mVersion, mCpu));
     }
+
+    return mDevices.size();
 }
 
-int RockchipRga::RkRgaInit()
+/* with mMutex held, the cores are opened once whatever the outcome */
+int RockchipRga::RkRgaProbe()
 {
-    hw_module_t const* module;
-    char buf[256];
-    int ret = 0;
-    if (rgaFd < 0)
-        rgaFd = open("/dev/rga", O_RDWR, 0);
+    if (mProbed)
+        return mDevices.empty() ? -ENODEV : 0;
 
-    if (rgaFd < 0) {
-        printf("open rga fail\n");
-        return -errno;
+    mProbed = true;
+    if (!RkRgaOpenDevices()) {
+        ALOGE("open rga fail");
+        return -ENODEV;
     }
 
-    ret = ioctl(rgaFd, RGA_GET_VERSION, buf);
-    mVersion = atof(buf);
-    fprintf(stderr, "librga:RGA_GET_VERSION:%s,%f\n", buf, mVersion);
+    ALOGD("librga:RGA_GET_VERSION:%f,%d cores", mVersion, (int)mDevices.size());
+    RkRgaLoadCostModel();
+    return 0;
+}
+
+int RockchipRga::RkRgaLoadGralloc()
+{
+    hw_module_t const* module;
+    int ret;
+
+    if (mAllocMod)
+        return 0;
 
     ret = hw_get_module(GRALLOC_HARDWARE_MODULE_ID, &module);
     if (ret) {
-        printf("%s,%d faile get hw moudle\n",__func__,__LINE__);
+        ALOGE("%s,%d faile get hw moudle", __func__, __LINE__);
         return ret;
     }
 
     mAllocMod = reinterpret_cast<gralloc_module_t const *>(module);
-
-    printf("librga:load gralloc module success!\n");
-
-    RkRgaInitTables();
-    printf("librga:init table success!\n");
+    ALOGD("librga:load gralloc module success!");
     return 0;
 }
 
-int RockchipRga::RkRgaGetHandleFd(buffer_handle_t handle, int *fd)
+int RockchipRga::RkRgaInit()
 {
-    int op = 0x80000001;
-    int ret = 0;
-
-    if (mAllocMod->perform)
-        mAllocMod->perform(mAllocMod, op, handle, fd);
-    else
-        return -ENODEV;
+    Mutex::Autolock lock(mMutex);
+    int ret;
 
+    ret = RkRgaProbe();
     if (ret)
-        ALOGE("RockchipRgaGetHandldFd fail %d for:%s",ret,strerror(ret));
-    else if (mLogAlways || mLogOnce) {
-        ALOGD("fd = %d",*fd);
-        fprintf(stderr,"fd = %d\n", *fd);
-    }
+        return ret;
 
-    return ret;
+    return RkRgaLoadGralloc();
 }
 
-int RockchipRga::RkRgaGetHandleAttributes(buffer_handle_t handle,
-                                                        std::vector<int> *attrs)
+int RockchipRga::RkRgaAddEmulatedDevices(int count)
 {
-    int op = 0x80000002;
-    int ret = 0;
-    if (mAllocMod->perform)
-        mAllocMod->perform(mAllocMod,op, handle, attrs);
-    else
-        return -ENODEV;
+    Mutex::Autolock lock(mMutex);
+    int base = 0;
 
-    if (ret)
-        ALOGE("RockchipRgaGetHandldAttributes fail %d for:%s",ret,strerror(ret));
-    else if (mLogAlways || mLogOnce) {
-        ALOGD("%d,%d,%d,%d,%d,%d",attrs->at(0),attrs->at(1),attrs->at(2),
-                                         attrs->at(3),attrs->at(4),attrs->at(5));
-        fprintf(stderr,"%d,%d,%d,%d,%d,%d\n",
-                               attrs->at(0),attrs->at(1),attrs->at(2),
-                                         attrs->at(3),attrs->at(4),attrs->at(5));
-    }
-    return ret;
+    if (count <= 0)
+        return -EINVAL;
+
+    RkRgaProbe();
+    for (size_t i = 0; i < mDevices.size(); i++)
+        base += mDevices[i]->emulated() ? 1 : 0;
+
+    for (int i = 0; i < count; i++)
+        mDevices.push_back(RockchipRgaDevice::createEmulated(base + i,
+                                                            mVersion, mCpu));
+    return 0;
 }
 
-int RockchipRga::RkRgaGetHandleMapAddress(buffer_handle_t handle,
-                                                                     void **buf)
+int RockchipRga::RkRgaSetEngine(int engine)
 {
-    int usage = GRALLOC_USAGE_SW_READ_MASK | GRALLOC_USAGE_SW_WRITE_MASK;
-    int ret = mAllocMod->lock(mAllocMod, handle, usage, 0, 0, 0, 0, buf);
+    Mutex::Autolock lock(mMutex);
 
-    if (ret)
-        ALOGE("GetHandleMapAddress fail %d for:%s",ret,strerror(ret));
-    else if (mLogAlways || mLogOnce) {
-        ALOGD("buf = %p\n", buf);
-        fprintf(stderr, "buf = %p", buf);
-    }
-    return ret;
+    if (engine < DRM_RGA_ENGINE_HW || engine > DRM_RGA_ENGINE_AUTO)
+        return -EINVAL;
+
+    mEngine = engine;
+    return 0;
 }
 
-int RockchipRga::RkRgaPaletteTable(buffer_handle_t dst, 
-                                              unsigned int v, drm_rga_t *rects)
+int RockchipRga::RkRgaSetScaleMode(int mode)
 {
     Mutex::Autolock lock(mMutex);
 
-    //check rects
-    //check buffer_handle_t with rects
-    int srcVirW,srcVirH,srcActW,srcActH,srcXPos,srcYPos;
-    int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
-    int scaleMode,rotateMode,orientation,ditherEn;
-    int srcType,dstType,srcMmuFlag,dstMmuFlag;
-    int planeAlpha;
-    int dstFd = -1;
-    int srcFd = -1;
-    int ret = 0;
-    drm_rga_t tmpRects,relRects;
-    struct rga_req rgaReg;
-    bool perpixelAlpha;
-    void *srcBuf = NULL;
-    void *dstBuf = NULL;
-    RECT clip;
+    if (mode < DRM_RGA_SCALE_AUTO || mode > DRM_RGA_SCALE_AREA)
+        return -EINVAL;
 
-    if (rects && (mLogAlways || mLogOnce)) {
-        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
-            rects->src.xoffset,rects->src.yoffset,
-            rects->src.width, rects->src.height, 
-            rects->src.wstride,rects->src.format, rects->src.size,
-            rects->dst.xoffset,rects->dst.yoffset,
-            rects->dst.width, rects->dst.height,
-            rects->dst.wstride,rects->dst.format, rects->dst.size);
-    }
+    mScaleMode = mode;
+    return 0;
+}
 
-    memset(&rgaReg, 0, sizeof(struct rga_req));
+int RockchipRga::RkRgaSetDitherMode(int mode)
+{
+    Mutex::Autolock lock(mMutex);
 
-    srcType = dstType = srcMmuFlag = dstMmuFlag = 0;
+    if (mode < DRM_RGA_DITHER_AUTO || mode > DRM_RGA_DITHER_DIFFUSION)
+        return -EINVAL;
 
-    ret = RkRgaGetRects(NULL, dst, &srcType, &dstType, &tmpRects);
-    if (ret && !rects) {
-        ALOGE("%d:Has not rects for render", __LINE__);
-        return ret;
-    }
+    mDitherMode = mode;
+    return 0;
+}
 
-    if (rects) {
-        if (rects->src.wstride > 0 && rects->dst.wstride > 0)
-            memcpy(&relRects, rects, sizeof(drm_rga_t));
-        else if (rects->src.wstride > 0) {
-            memcpy(&(relRects.src), &(rects->src), sizeof(rga_rect_t));
-            memcpy(&(relRects.dst), &(tmpRects.dst), sizeof(rga_rect_t));
-        } else if (rects->dst.wstride > 0) {
-            memcpy(&(relRects.src), &(tmpRects.src), sizeof(rga_rect_t));
-            memcpy(&(relRects.dst), &(rects->dst), sizeof(rga_rect_t));
-        }
-    } else
-        memcpy(&relRects, &tmpRects, sizeof(drm_rga_t));
+int RockchipRga::RkRgaSetDepthMode(int mode)
+{
+    Mutex::Autolock lock(mMutex);
 
-    if (mLogAlways || mLogOnce) {
-        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
-            tmpRects.src.xoffset,tmpRects.src.yoffset,
-            tmpRects.src.width, tmpRects.src.height, 
-            tmpRects.src.wstride,tmpRects.src.format, tmpRects.src.size,
-            tmpRects.dst.xoffset,tmpRects.dst.yoffset,
-            tmpRects.dst.width, tmpRects.dst.height,
-            tmpRects.dst.wstride,tmpRects.dst.format, tmpRects.dst.size);
-        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
-            relRects.src.xoffset,relRects.src.yoffset,
-            relRects.src.width, relRects.src.height, 
-            relRects.src.wstride,relRects.src.format, relRects.src.size,
-            relRects.dst.xoffset,relRects.dst.yoffset,
-            relRects.dst.width, relRects.dst.height,
-            relRects.dst.wstride,relRects.dst.format, relRects.dst.size);
-    }
+    if (mode < DRM_RGA_DEPTH_TRUNCATE || mode > DRM_RGA_DEPTH_TONEMAP)
+        return -EINVAL;
 
-    RkRgaGetHandleMapAddress(dst, &dstBuf);
-    RkRgaGetHandleFd(dst, &dstFd);
-    if (dstFd == -1 && !dstBuf) {
-        ALOGE("%d:dst has not fd and address for render", __LINE__);
-        return ret;
-    }
+    mDepthMode = mode;
+    return 0;
+}
 
-    if (dstFd == 0 && !dstBuf) {
-        ALOGE("dstFd is zero, now driver not support");
+int RockchipRga::RkRgaUnpack10Bit(const void *src, const rga_rect_t *rect,
+                                                            uint16_t *dst)
+{
+    RockchipRgaCpu::Image img;
+    rga_img_info_t info;
+
+    if (!src || !rect || !dst || (rect->width & 1))
         return -EINVAL;
-    } else
-        dstFd = -1;
 
-    orientation = 0;
-    rotateMode = 0;
-    srcVirW = relRects.src.wstride;
-    srcVirH = relRects.src.height;
-    srcXPos = relRects.src.xoffset;
-    srcYPos = relRects.src.yoffset;
-    srcActW = relRects.src.width;
-    srcActH = relRects.src.height;
-
-    dstVirW = relRects.dst.wstride;
-    dstVirH = relRects.dst.height;
-    dstXPos = relRects.dst.xoffset;
-    dstYPos = relRects.dst.yoffset;
-    dstActW = relRects.dst.width;
-    dstActH = relRects.dst.height;
+    memset(&info, 0, sizeof(info));
+    info.yrgb_addr = (unsigned long)src;
+    info.format = RkRgaGetRgaFormat(rect->format);
+    info.vir_w = rect->wstride;
+    info.vir_h = rect->height + rect->yoffset;
+    if (!RockchipRgaCpu::is10Bit(info.format) ||
+                            RockchipRgaCpu::setupImage(&img, &info, 0))
+        return -EINVAL;
 
-    RkRgaSetSrcActiveInfo(&rgaReg, srcActW, srcActH, srcXPos, srcYPos);
-    RkRgaSetDstActiveInfo(&rgaReg, dstActW, dstActH, dstXPos, dstYPos);
-    RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
-                                    (unsigned long)srcBuf + srcVirW * srcVirH, 
-                                    (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
-                                    srcVirW, srcVirH,
-                                    RkRgaGetRgaFormat(relRects.src.format),0);
-    /*dst*/
-    RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
-                                    (unsigned long)dstBuf + dstVirW * dstVirH,
-                                    (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
-                                    dstVirW, dstVirH, &clip,
-                                    RkRgaGetRgaFormat(relRects.dst.format),0);
-    RkRgaSetPatInfo(&rgaReg, dstVirW, dstVirH,
-                                     dstXPos, dstYPos, relRects.dst.format);
-    RkRgaSetFadingEnInfo(&rgaReg, v & 0xFF000000, v & 0xFF0000, v & 0xFF00);
+    /* a plain cpu job, no device and no lock */
+    for (int y = 0; y < rect->height; y++, dst += rect->width)
+        RockchipRgaCpu::unpack10(&img, false, rect->yoffset + y,
+                                        rect->xoffset, rect->width, dst);
+    for (int y = 0; y < rect->height / 2; y++, dst += rect->width)
+        RockchipRgaCpu::unpack10(&img, true, rect->yoffset / 2 + y,
+                                        rect->xoffset & ~1, rect->width, dst);
 
-    /*mode*/
-    RkRgaUpdatePaletteTableMode(&rgaReg, 0, v & 0xFF);
+    return 0;
+}
 
-    if (srcMmuFlag || dstMmuFlag) {
-        RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
-        RkRgaMmuFlag(&rgaReg, srcMmuFlag, dstMmuFlag);
-    }
+/* dither_en of a blit between two hal formats */
+int RockchipRga::RkRgaDitherOf(int srcFormat, int dstFormat)
+{
+    if (mDitherMode == DRM_RGA_DITHER_OFF)
+        return 0;
 
-    if (mLogAlways || mLogOnce) 
-        RkRgaLogOutRgaReq(rgaReg);
+    return dstFormat == HAL_PIXEL_FORMAT_RGB_565 &&
+                                    srcFormat != HAL_PIXEL_FORMAT_RGB_565;
+}
 
-    if(ioctl(rgaFd, RGA_BLIT_SYNC, &rgaReg)) {
-        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
-        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+/* rga_req.scale_mode for a blit of the active sizes, see RGA_SCALE_* */
+int RockchipRga::RkRgaScaleModeOf(int srcW, int srcH, int dstW, int dstH)
+{
+    switch (mScaleMode) {
+        case DRM_RGA_SCALE_NEAREST:
+            return RGA_SCALE_NEAREST;
+        case DRM_RGA_SCALE_BILINEAR:
+            return RGA_SCALE_BILINEAR;
+        case DRM_RGA_SCALE_BICUBIC:
+            return RGA_SCALE_BICUBIC;
+        case DRM_RGA_SCALE_AREA:
+            return RGA_SCALE_AREA;
+        default:
+            break;
     }
 
-    if (mLogOnce)
-        mLogOnce = 0;
+    //scale up use bicubic
+    if (srcW < dstW || srcH < dstH)
+        return RGA_SCALE_BICUBIC;
+
+    return RGA_SCALE_BILINEAR;
+}
+
+int RockchipRga::RkRgaSetCpuWorkers(int threads, int cluster)
+{
+    if (threads < 0 || cluster < DRM_RGA_CPU_CLUSTER_ANY ||
+                                    cluster > DRM_RGA_CPU_CLUSTER_LITTLE)
+        return -EINVAL;
 
+    mCpu->setWorkers(threads, cluster);
     return 0;
 }
 
-int RockchipRga::RkRgaBlit(buffer_handle_t src,
-                 buffer_handle_t dst, drm_rga_t *rects, int rotation, int blend)
+int RockchipRga::RkRgaSetCpuSimd(int enable)
 {
-    Mutex::Autolock lock(mMutex);
+    RockchipRgaCpu::setSimd(enable != 0);
+    return 0;
+}
 
-    //check rects
-    //check buffer_handle_t with rects
-    int srcVirW,srcVirH,srcActW,srcActH,srcXPos,srcYPos;
-    int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
-    int scaleMode,rotateMode,orientation,ditherEn;
-    int srcType,dstType,srcMmuFlag,dstMmuFlag;
-    int planeAlpha;
-    int dstFd = -1;
-    int srcFd = -1;
-    int ret = 0;
-    drm_rga_t tmpRects,relRects;
-    struct rga_req rgaReg;
-    bool perpixelAlpha;
-    void *srcBuf = NULL;
-    void *dstBuf = NULL;
-    RECT clip;
+/*
+ * Rows of the destination frame the rga takes in a hybrid blit, 0 if the
+ * request is not worth splitting. The rga part must map to whole source
+ * rows, so the split is a multiple of the vertical scale period.
+ */
+int RockchipRga::RkRgaHybridSplit(const struct rga_req *req, HybridRate *rate)
+{
+    int frameH = req->dst.act_h;
+    int srcH = req->src.act_h;
+    int a = frameH, b = srcH, period, rows;
 
-    if (rects && (mLogAlways || mLogOnce)) {
-        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
-            rects->src.xoffset,rects->src.yoffset,
-            rects->src.width, rects->src.height, 
-            rects->src.wstride,rects->src.format, rects->src.size,
-            rects->dst.xoffset,rects->dst.yoffset,
-            rects->dst.width, rects->dst.height,
-            rects->dst.wstride,rects->dst.format, rects->dst.size);
-    }
+    if (req->render_mode != bitblt_mode)
+        return 0;
 
-    memset(&rgaReg, 0, sizeof(struct rga_req));
+    /* the diffused error runs down the whole frame, see stripeRows */
+    if (req->dither_mode)
+        return 0;
 
-    srcType = dstType = srcMmuFlag = dstMmuFlag = 0;
+    if (req->dst.act_w * frameH < 512 * 512)
+        return 0;
 
-    ret = RkRgaGetRects(src, dst, &srcType, &dstType, &tmpRects);
-    if (ret && !rects) {
-        ALOGE("%d:Has not rects for render", __LINE__);
-        return ret;
+    /* only unrotated rows keep both parts rectangular for the rga */
+    if (req->rotate_mode == BB_Y_MIRROR ||
+            (req->rotate_mode == BB_ROTATE && req->cosa != 65536))
+        return 0;
+
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
     }
+    period = frameH / a;
+    if (period & 1)
+        period *= 2;
+    if (period * 4 > frameH)
+        return 0;
+
+    rows = (int)(frameH * rate->hwRate / (rate->hwRate + rate->cpuRate));
+    rows -= rows % period;
+    if (rows < period)
+        rows = period;
+    if (rows > frameH - period)
+        rows = frameH - period;
+
+    return rows;
+}
 
-    if (rects) {
-        if (rects->src.wstride > 0 && rects->dst.wstride > 0)
-            memcpy(&relRects, rects, sizeof(drm_rga_t));
-        else if (rects->src.wstride > 0) {
-            memcpy(&(relRects.src), &(rects->src), sizeof(rga_rect_t));
-            memcpy(&(relRects.dst), &(tmpRects.dst), sizeof(rga_rect_t));
-        } else if (rects->dst.wstride > 0) {
-            memcpy(&(relRects.src), &(tmpRects.src), sizeof(rga_rect_t));
-            memcpy(&(relRects.dst), &(rects->dst), sizeof(rga_rect_t));
-        }
-    } else
-        memcpy(&relRects, &tmpRects, sizeof(drm_rga_t));
+/* Called without mMutex, see RkRgaSubmit */
+int RockchipRga::RkRgaSubmitHybrid(RockchipRgaDevice *dev,
+                                    struct rga_req *req, int cmd, int layout)
+{
+    RockchipRgaCpu::Stripes stripes;
+    struct rga_req hwReq;
+    HybridRate rate;
+    nsecs_t start, hwTime, cpuTime;
+    int key = (req->src.format << 8) | req->dst.format;
+    int rows, hwRet, cpuRet;
 
-    if (mLogAlways || mLogOnce) {
-        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
-            tmpRects.src.xoffset,tmpRects.src.yoffset,
-            tmpRects.src.width, tmpRects.src.height, 
-            tmpRects.src.wstride,tmpRects.src.format, tmpRects.src.size,
-            tmpRects.dst.xoffset,tmpRects.dst.yoffset,
-            tmpRects.dst.width, tmpRects.dst.height,
-            tmpRects.dst.wstride,tmpRects.dst.format, tmpRects.dst.size);
-        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
-            relRects.src.xoffset,relRects.src.yoffset,
-            relRects.src.width, relRects.src.height, 
-            relRects.src.wstride,relRects.src.format, relRects.src.size,
-            relRects.dst.xoffset,relRects.dst.yoffset,
-            relRects.dst.width, relRects.dst.height,
-            relRects.dst.wstride,relRects.dst.format, relRects.dst.size);
+    {
+        Mutex::Autolock lock(mMutex);
+        std::map<int, HybridRate>::iterator it = mHybridRates.find(key);
+
+        if (it != mHybridRates.end())
+            rate = it->second;
+        else {
+            /* start with the rga doing most of the work */
+            rate.hwRate = 4.0;
+            rate.cpuRate = 1.0;
+            rate.samples = 0;
+        }
     }
 
-    RkRgaGetHandleMapAddress(src, &srcBuf);
-    RkRgaGetHandleFd(src, &srcFd);
-    if (srcFd == -1 && !srcBuf) {
-        ALOGE("%d:src has not fd and address for render", __LINE__);
-        return ret;
+    rows = RkRgaHybridSplit(req, &rate);
+    if (!rows)
+        return dev->blit(req, cmd);
+
+    memcpy(&hwReq, req, sizeof(struct rga_req));
+    hwReq.dst.act_h = rows;
+    hwReq.src.act_h = (int)((int64_t)rows * req->src.act_h / req->dst.act_h);
+    /* the clip may be absolute, the rga part ends where its rows do */
+    if (hwReq.clip.ymax > req->clip.ymin + rows - 1)
+        hwReq.clip.ymax = req->clip.ymin + rows - 1;
+
+    start = systemTime(SYSTEM_TIME_MONOTONIC);
+    cpuRet = mCpu->blitAsync(&stripes, req, layout, rows, req->dst.act_h);
+    if (cpuRet)
+        return dev->blit(req, cmd);
+
+    hwRet = dev->blit(&hwReq, cmd);
+    hwTime = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+
+    cpuRet = mCpu->wait(&stripes);
+    cpuTime = stripes.group.doneTime - start;
+
+    if (!hwRet && !cpuRet && hwTime > 0 && cpuTime > 0) {
+        Mutex::Autolock lock(mMutex);
+        /* rows per millisecond, averaged over the last few blits */
+        double hwRate = (double)rows * 1e6 / hwTime;
+        double cpuRate = (double)(req->dst.act_h - rows) * 1e6 / cpuTime;
+
+        if (rate.samples++) {
+            rate.hwRate = rate.hwRate * 0.75 + hwRate * 0.25;
+            rate.cpuRate = rate.cpuRate * 0.75 + cpuRate * 0.25;
+        } else {
+            rate.hwRate = hwRate;
+            rate.cpuRate = cpuRate;
+        }
+        mHybridRates[key] = rate;
     }
 
-    if (srcFd == 0 && !srcBuf) {
-        ALOGE("srcFd is zero, now driver not support");
-        return -EINVAL;
-    } else
-        srcFd = -1;
+    return hwRet ? hwRet : cpuRet;
+}
 
-    RkRgaGetHandleMapAddress(dst, &dstBuf);
-    RkRgaGetHandleFd(dst, &dstFd);
-    if (dstFd == -1 && !dstBuf) {
-        ALOGE("%d:dst has not fd and address for render", __LINE__);
-        return ret;
+/*
+ * With mMutex held. The engine the cost model predicts fastest for the
+ * request, the rga for format pairs it has not seen. Work is the pixels
+ * read plus the pixels written, which covers scaling either way.
+ */
+int RockchipRga::RkRgaChooseEngine(const struct rga_req *req,
+                                    RockchipRgaDevice *dev, double *predicted)
+{
+    int key = (req->src.format << 8) | req->dst.format;
+    std::map<int, CostModel>::iterator it = mCostModels.find(key);
+    double pixels = (double)req->src.act_w * req->src.act_h +
+                    (double)req->dst.act_w * req->dst.act_h;
+    double hw = -1, cpu = -1;
+    int engine;
+
+    *predicted = 0;
+    if (it == mCostModels.end()) {
+        mDispatchStats.uncalibrated++;
+        return DRM_RGA_ENGINE_HW;
     }
 
-    if (dstFd == 0 && !dstBuf) {
-        ALOGE("dstFd is zero, now driver not support");
-        return -EINVAL;
-    } else
-        dstFd = -1;
-
-    planeAlpha = (blend & 0xFF0000) >> 16;
-    perpixelAlpha = relRects.src.format == HAL_PIXEL_FORMAT_RGBA_8888 ||
-                    relRects.src.format == HAL_PIXEL_FORMAT_BGRA_8888;
+    if (dev && it->second.hwFixed >= 0)
+        hw = it->second.hwFixed + pixels * it->second.hwPerPixel;
+    if (it->second.cpuFixed >= 0 && RockchipRgaCpu::supports(req))
+        cpu = it->second.cpuFixed + pixels * it->second.cpuPerPixel;
 
-    switch ((blend & 0xFFFF)) {
-        case 0x0105:
-            if (perpixelAlpha && planeAlpha < 255)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 1, 9, 0);
-            else if (perpixelAlpha)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 1, 3, 0);
-            else
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
-            break;
+    if (hw < 0 && cpu < 0) {
+        mDispatchStats.uncalibrated++;
+        return DRM_RGA_ENGINE_HW;
+    }
 
-        case 0x0405:
-            if (perpixelAlpha && planeAlpha < 255)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 0, 0, 0);
-            else if (perpixelAlpha)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 0, 0, 0);
-            else
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
-            break;
+    if (cpu < 0 || (hw >= 0 && hw <= cpu)) {
+        engine = DRM_RGA_ENGINE_HW;
+        *predicted = hw;
+    } else {
+        engine = DRM_RGA_ENGINE_CPU;
+        *predicted = cpu;
+    }
 
-        case 0x0100:
-        default:
-            /* Tips: BLENDING_NONE is non-zero value, handle zero value as
-             * BLENDING_NONE. */
-            /* C = Cs
-             * A = As */
-            break;
+    /* both sides run at once, each on its share of the rows */
+    if (hw >= 0 && cpu >= 0 && !dev->emulated()) {
+        HybridRate rate;
+        double both;
+
+        rate.hwRate = 1.0 / it->second.hwPerPixel;
+        rate.cpuRate = 1.0 / it->second.cpuPerPixel;
+        rate.samples = 0;
+        both = (it->second.hwFixed > it->second.cpuFixed ?
+                        it->second.hwFixed : it->second.cpuFixed) +
+                        pixels / (rate.hwRate + rate.cpuRate);
+
+        if (both < *predicted && RkRgaHybridSplit(req, &rate)) {
+            engine = DRM_RGA_ENGINE_HYBRID;
+            *predicted = both;
+        }
     }
 
-    switch (rotation) {
-        case HAL_TRANSFORM_FLIP_H:
-            orientation = 0;
-            rotateMode = 2;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    if (engine == DRM_RGA_ENGINE_HW)
+        mDispatchStats.hwJobs++;
+    else if (engine == DRM_RGA_ENGINE_CPU)
+        mDispatchStats.cpuJobs++;
+    else
+        mDispatchStats.hybridJobs++;
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.xoffset;
-            dstYPos = relRects.dst.yoffset;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
-            break;
-        case HAL_TRANSFORM_FLIP_V:
-            orientation = 0;
-            rotateMode = 3;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    return engine;
+}
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.xoffset;
-            dstYPos = relRects.dst.yoffset;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
-            break;
-        case HAL_TRANSFORM_ROT_90:
-            orientation = 90;
-            rotateMode = 1;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+/*
+ * With mMutex held. Fit time = fixed + perPixel * pixels through the median
+ * of a few unscaled blits at two sizes on one engine. The blits go straight
+ * to a real core or the software renderer: an emulated core or the fallback
+ * of RkRgaSubmit would time the cpu as the rga.
+ */
+int RockchipRga::RkRgaFitCost(void *srcBuf, void *dstBuf, int srcFormat,
+                        int dstFormat, int engine, double *fixed, double *perPixel)
+{
+    static const int sizes[2] = {64, 1024};
+    int layout = RockchipRgaDevice::layoutOf(mVersion);
+    double medians[2], pixels[2];
+    int ret = 0;
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.width - 1;
-            //dstYPos = relRects.dst.yoffset;
-            dstYPos = 0;
-            dstActW = relRects.dst.height;
-            dstActH = relRects.dst.width;
-            break;
-        case HAL_TRANSFORM_ROT_180:
-            orientation = 180;
-            rotateMode = 1;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    for (int i = 0; i < 2 && !ret; i++) {
+        RockchipRgaDevice *dev = NULL;
+        struct rga_req req;
+        double runs[5];
+        drm_rga_t rects;
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.width - 1;
-            dstYPos = relRects.dst.height - 1;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
+        rga_set_rect(&rects.src, 0, 0, sizes[i], sizes[i], sizes[i], srcFormat);
+        rga_set_rect(&rects.dst, 0, 0, sizes[i], sizes[i], sizes[i], dstFormat);
+
+        ret = RkRgaPathRequest(&req, srcBuf, dstBuf, &rects, 0, PATH_CONVERT);
+        if (ret)
             break;
-        case HAL_TRANSFORM_ROT_270:
-            orientation = 270;
-            rotateMode = 1;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            //dstXPos = relRects.dst.xoffset;
-            dstXPos = 0;
-            dstYPos = relRects.dst.height - 1;
-            dstActW = relRects.dst.height;
-            dstActH = relRects.dst.width;
+        for (size_t d = 0; d < mDevices.size() && engine == DRM_RGA_ENGINE_HW; d++) {
+            if (mDevices[d]->emulated() || !mDevices[d]->supports(&req, layout))
+                continue;
+            if (!dev || mDevices[d]->depth() < dev->depth())
+                dev = mDevices[d];
+        }
+        if (engine == DRM_RGA_ENGINE_HW && !dev) {
+            ret = -ENODEV;
             break;
-        default:
-            orientation = 0;
-            rotateMode = 0;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+        }
+        if (engine != DRM_RGA_ENGINE_HW && !RockchipRgaCpu::supports(&req)) {
+            ret = -EINVAL;
+            break;
+        }
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.xoffset;
-            dstYPos = relRects.dst.yoffset;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
+        mMutex.unlock();
+        /* the first one maps the pages */
+        for (int k = -1; k < 5 && !ret; k++) {
+            nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+
+            ret = dev ? dev->blit(&req, RGA_BLIT_SYNC) :
+                                        mCpu->blitParallel(&req, layout);
+            if (k >= 0)
+                runs[k] = (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000.0;
+        }
+        mMutex.lock();
+        if (ret)
             break;
+
+        std::sort(runs, runs + 5);
+        medians[i] = runs[2];
+        pixels[i] = 2.0 * sizes[i] * sizes[i];
     }
 
-    clip.xmin = 0;
-    clip.xmax = dstActW - 1;
-    clip.ymin = 0;
-    clip.ymax = dstActH - 1;
+    if (ret)
+        return ret;
 
-    //scale up use bicubic
-    if (srcActW / dstActW < 1 || srcActH / dstActH < 1)
-        scaleMode = 2;
+    *perPixel = (medians[1] - medians[0]) / (pixels[1] - pixels[0]);
+    if (*perPixel < 1e-6)
+        *perPixel = 1e-6;
+    *fixed = medians[0] - pixels[0] * *perPixel;
+    if (*fixed < 0)
+        *fixed = 0;
 
-    /*
-    if (scaleMode && (srcFormat == RK_FORMAT_RGBA_8888 ||
-                                            srcFormat == RK_FORMAT_BGRA_8888)) {
-        scale_mode = 0;     //  force change scale_mode to 0 ,for rga not support
-    }*/
+    return 0;
+}
 
-    ditherEn = (android::bytesPerPixel(relRects.src.format) 
-                        != android::bytesPerPixel(relRects.src.format) ? 1 : 0);
+/* "<src> <dst> <hw fixed> <hw per pixel> <cpu fixed> <cpu per pixel>" lines */
+int RockchipRga::RkRgaLoadCostModel()
+{
+    char path[PROPERTY_VALUE_MAX];
+    char line[256];
+    FILE *file;
+
+    property_get("persist.rga.cost_model", path, "");
+    file = path[0] ? fopen(path, "re") : NULL;
+    if (!file)
+        return -ENOENT;
+
+    while (fgets(line, sizeof(line), file)) {
+        CostModel model;
+        int srcFormat, dstFormat;
+
+        if (sscanf(line, "%d %d %lf %lf %lf %lf", &srcFormat, &dstFormat,
+                        &model.hwFixed, &model.hwPerPixel,
+                        &model.cpuFixed, &model.cpuPerPixel) != 6)
+            continue;
+        if ((model.hwFixed >= 0 && model.hwPerPixel <= 0) ||
+                        (model.cpuFixed >= 0 && model.cpuPerPixel <= 0))
+            continue;
+        mCostModels[(srcFormat << 8) | dstFormat] = model;
+    }
+    fclose(file);
 
-    if (mVersion <= 1.003) {
-        srcMmuFlag = dstMmuFlag = 1;
+    return 0;
+}
 
-#if defined(__arm64__) || defined(__aarch64__)
-        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
-                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#else
-        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
-                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#endif
-    } else if (mVersion < 2.0) {
-        /*Src*/
-        if (srcFd != -1) {
-            srcMmuFlag = srcType ? 1 : 0;
-            RkRgaSetSrcVirtualInfo(&rgaReg, 0, 0, 0, srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-            RkRgaSetFdsOffsets(&rgaReg, srcFd, 0, 0, 0);
-        } else {
-            srcMmuFlag = 1;
+int RockchipRga::RkRgaSaveCostModel()
+{
+    char path[PROPERTY_VALUE_MAX];
+    char tmp[PROPERTY_VALUE_MAX + 8];
+    FILE *file;
 
-#if defined(__arm64__) || defined(__aarch64__)
-            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
-                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-#else
-            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
-                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-#endif
-        }
-        /*dst*/
-        if (dstFd != -1) {
-            dstMmuFlag = srcType ? 1 : 0;
-            RkRgaSetDstVirtualInfo(&rgaReg, 0, 0, 0, dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-    	    /*src dst fd*/
-            RkRgaSetFdsOffsets(&rgaReg, 0, dstFd, 0, 0);
-        } else {
-            dstMmuFlag = 1;
-#if defined(__arm64__) || defined(__aarch64__)
-            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#else
-            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#endif
-        }
-    } else {
-        srcMmuFlag = ((srcFd != -1 && srcType) || srcFd == -1) ? 1 : 0;
-        dstMmuFlag = ((dstFd != -1 && dstType) || dstFd == -1) ? 1 : 0;
-#if defined(__arm64__) || defined(__aarch64__)
-        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
-                                        (unsigned long)srcBuf, 
-                                        (unsigned long)srcBuf + srcVirW * srcVirH,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
-                                        (unsigned long)dstBuf,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#else
-        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
-                                        (unsigned int)srcBuf, 
-                                        (unsigned int)srcBuf + srcVirW * srcVirH,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
-                                        (unsigned int)dstBuf,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#endif
+    property_get("persist.rga.cost_model", path, "");
+    if (!path[0])
+        return 0;
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    file = fopen(tmp, "we");
+    if (!file)
+        return -errno;
+
+    for (std::map<int, CostModel>::iterator it = mCostModels.begin();
+                                            it != mCostModels.end(); it++)
+        fprintf(file, "%d %d %f %.9f %f %.9f\n", it->first >> 8,
+                    it->first & 0xff, it->second.hwFixed, it->second.hwPerPixel,
+                    it->second.cpuFixed, it->second.cpuPerPixel);
+
+    if (fclose(file)) {
+        unlink(tmp);
+        return -EIO;
     }
 
-    RkRgaSetSrcActiveInfo(&rgaReg, srcActW, srcActH, srcXPos, srcYPos);
-    RkRgaSetDstActiveInfo(&rgaReg, dstActW, dstActH, dstXPos, dstYPos);
+    return rename(tmp, path) ? -errno : 0;
+}
 
-    /*mode*/
-    RkRgaSetBitbltMode(&rgaReg, scaleMode, rotateMode, orientation, ditherEn, 0, 0);
+int RockchipRga::RkRgaCalibrate(const int *formats, int pairs)
+{
+    static const int defaults[] = {
+        HAL_PIXEL_FORMAT_RGBA_8888,  HAL_PIXEL_FORMAT_RGBA_8888,
+        HAL_PIXEL_FORMAT_YCrCb_NV12, HAL_PIXEL_FORMAT_RGBA_8888,
+        HAL_PIXEL_FORMAT_RGBA_8888,  HAL_PIXEL_FORMAT_RGB_565,
+        HAL_PIXEL_FORMAT_YCrCb_NV12, HAL_PIXEL_FORMAT_YCrCb_NV12,
+    };
+    Mutex::Autolock lock(mMutex);
+    void *srcBuf, *dstBuf;
 
-    if (srcMmuFlag || dstMmuFlag) {
-        RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
-        RkRgaMmuFlag(&rgaReg, srcMmuFlag, dstMmuFlag);
+    if (!formats) {
+        formats = defaults;
+        pairs = sizeof(defaults) / sizeof(defaults[0]) / 2;
     }
+    if (pairs <= 0)
+        return -EINVAL;
 
-    if(ioctl(rgaFd, RGA_BLIT_SYNC, &rgaReg)) {
-        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
-        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+    RkRgaProbe();
+
+    srcBuf = malloc(1024 * 1024 * 4);
+    dstBuf = malloc(1024 * 1024 * 4);
+    if (!srcBuf || !dstBuf) {
+        free(srcBuf);
+        free(dstBuf);
+        return -ENOMEM;
+    }
+    memset(srcBuf, 0x80, 1024 * 1024 * 4);
+
+    for (int i = 0; i < pairs; i++) {
+        int srcFormat = formats[i * 2];
+        int dstFormat = formats[i * 2 + 1];
+        CostModel model;
+
+        model.hwFixed = model.cpuFixed = -1;
+        model.hwPerPixel = model.cpuPerPixel = 0;
+
+        if (mDevices.empty() || RkRgaFitCost(srcBuf, dstBuf, srcFormat,
+                        dstFormat, DRM_RGA_ENGINE_HW, &model.hwFixed,
+                        &model.hwPerPixel))
+            model.hwFixed = -1;
+        if (RkRgaFitCost(srcBuf, dstBuf, srcFormat, dstFormat,
+                        DRM_RGA_ENGINE_CPU, &model.cpuFixed, &model.cpuPerPixel))
+            model.cpuFixed = -1;
+        if (model.hwFixed < 0 && model.cpuFixed < 0)
+            continue;
+
+        ALOGD("cost %x->%x: rga %.1fus + %.4fus/px, cpu %.1fus + %.4fus/px",
+                        srcFormat, dstFormat, model.hwFixed, model.hwPerPixel,
+                        model.cpuFixed, model.cpuPerPixel);
+        mCostModels[(RkRgaGetRgaFormat(srcFormat) << 8) |
+                                RkRgaGetRgaFormat(dstFormat)] = model;
     }
 
-    if (mLogOnce)
-        mLogOnce = 0;
+    free(srcBuf);
+    free(dstBuf);
+
+    return RkRgaSaveCostModel();
+}
 
+int RockchipRga::RkRgaGetDispatchStats(rga_dispatch_stats_t *stats)
+{
+    Mutex::Autolock lock(mMutex);
+
+    if (!stats)
+        return -EINVAL;
+
+    memcpy(stats, &mDispatchStats, sizeof(rga_dispatch_stats_t));
     return 0;
 }
 
-int RockchipRga::RkRgaBlit(void *src,
-                    buffer_handle_t dst, drm_rga_t *rects, int rotation, int blend)
+int RockchipRga::RkRgaGetDeviceCount()
 {
     Mutex::Autolock lock(mMutex);
 
-    //check rects
-    //check buffer_handle_t with rects
-    int srcVirW,srcVirH,srcActW,srcActH,srcXPos,srcYPos;
-    int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
-    int scaleMode,rotateMode,orientation,ditherEn;
-    int srcType,dstType,srcMmuFlag,dstMmuFlag;
-    int planeAlpha;
-    int dstFd = -1;
-    int srcFd = -1;
-    int ret = 0;
-    drm_rga_t tmpRects,relRects;
-    struct rga_req rgaReg;
-    bool perpixelAlpha;
-    void *srcBuf = NULL;
-    void *dstBuf = NULL;
-    RECT clip;
+    RkRgaProbe();
 
-    memset(&rgaReg, 0, sizeof(struct rga_req));
+    return mDevices.size();
+}
 
-    srcType = dstType = srcMmuFlag = dstMmuFlag = 0;
+int RockchipRga::RkRgaGetDeviceInfo(int index, rga_device_info_t *info)
+{
+    Mutex::Autolock lock(mMutex);
 
-    if (!rects) {
-        ALOGE("%d:Has not user rects for render", __LINE__);
-        return ret;
-    }
+    RkRgaProbe();
 
-    if (rects->src.wstride <= 0) {
-        ALOGE("%d:Has invalid rects for render", __LINE__);
+    if (index < 0 || index >= (int)mDevices.size())
         return -EINVAL;
-    }
 
-    ret = RkRgaGetRects(NULL, dst, &srcType, &dstType, &tmpRects);
-    if (ret) {
-        ALOGE("%d:Has not rects for render", __LINE__);
-        return ret;
+    return mDevices[index]->getInfo(info);
+}
+
+int RockchipRga::RkRgaSubmit(struct rga_req *req, int cmd)
+{
+    return RkRgaSubmitOn(req, cmd, mEngine);
+}
+
+/*
+ * Called with mMutex held. Picks the least loaded core that can run the
+ * request, and drops mMutex while the job runs so that other callers can
+ * feed the other cores meanwhile. The engine is per request, mEngine may
+ * change while the lock is dropped.
+ */
+int RockchipRga::RkRgaSubmitOn(struct rga_req *req, int cmd, int engine)
+{
+    RockchipRgaDevice *dev = NULL;
+    double predicted = 0;
+    nsecs_t start = 0;
+    int layout, ret;
+
+    RkRgaProbe();
+    layout = RockchipRgaDevice::layoutOf(mVersion);
+
+    for (size_t i = 0; i < mDevices.size(); i++) {
+        if (!mDevices[i]->supports(req, layout))
+            continue;
+        if (!dev || mDevices[i]->depth() < dev->depth())
+            dev = mDevices[i];
     }
 
-    if (rects->dst.wstride > 0)
-        memcpy(&relRects, rects, sizeof(drm_rga_t));
-    else {
-        memcpy(&(relRects.src), &(rects->src), sizeof(rga_rect_t));
-        memcpy(&(relRects.dst), &(tmpRects.dst), sizeof(rga_rect_t));
+    if (engine == DRM_RGA_ENGINE_AUTO) {
+        engine = RkRgaChooseEngine(req, dev, &predicted);
+        start = systemTime(SYSTEM_TIME_MONOTONIC);
     }
 
-    srcBuf = src;
-    if (!srcBuf) {
-        ALOGE("%d:src has not fd and address for render", __LINE__);
-        return ret;
+    if (engine != DRM_RGA_ENGINE_HW && RockchipRgaCpu::supports(req)) {
+        mMutex.unlock();
+        /* auto never picks it on an emulator, asked for it runs there too */
+        if (engine == DRM_RGA_ENGINE_HYBRID && dev)
+            ret = RkRgaSubmitHybrid(dev, req, cmd, layout);
+        else
+            ret = mCpu->blitParallel(req, layout);
+        mMutex.lock();
+    } else if (!dev && RockchipRgaCpu::supports(req)) {
+        /* the software renderer covers what no core can do, e.g. odd angles on rga2 */
+        mMutex.unlock();
+        ret = mCpu->blitParallel(req, layout);
+        mMutex.lock();
+    } else if (dev) {
+        mMutex.unlock();
+        ret = dev->blit(req, cmd);
+        mMutex.lock();
+    } else {
+        ALOGE("no rga core supports the request");
+        errno = EINVAL;
+        return -EINVAL;
     }
 
-    RkRgaGetHandleMapAddress(dst, &dstBuf);
-    RkRgaGetHandleFd(dst, &dstFd);
-    if (dstFd == -1 && !dstBuf) {
-        ALOGE("%d:dst has not fd and address for render", __LINE__);
-        return ret;
+    if (predicted > 0 && !ret) {
+        mDispatchStats.predictedUs += (uint64_t)predicted;
+        mDispatchStats.actualUs += (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000;
     }
 
-    if (dstFd == 0 && !dstBuf) {
-        ALOGE("dstFd is zero, now driver not support");
-        return -EINVAL;
-    } else
-        dstFd = -1;
+    if (ret)
+        errno = -ret;
+    return ret;
+}
 
-    planeAlpha = (blend & 0xFF0000) >> 16;
-    perpixelAlpha = relRects.src.format == HAL_PIXEL_FORMAT_RGBA_8888 ||
-                    relRects.src.format == HAL_PIXEL_FORMAT_BGRA_8888;
+int RockchipRga::RkRgaGetHandleFd(buffer_handle_t handle, int *fd)
+{
+    int op = 0x80000001;
+    int ret = 0;
 
-    switch ((blend & 0xFFFF)) {
-        case 0x0105:
-            if (perpixelAlpha && planeAlpha < 255)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 1, 9, 0);
-            else if (perpixelAlpha)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 1, 3, 0);
-            else
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
-            break;
+    if (RkRgaLoadGralloc())
+        return -ENODEV;
 
-        case 0x0405:
-            if (perpixelAlpha && planeAlpha < 255)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 0, 0, 0);
-            else if (perpixelAlpha)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 0, 0, 0);
-            else
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
-            break;
+    if (mAllocMod->perform)
+        mAllocMod->perform(mAllocMod, op, handle, fd);
+    else
+        return -ENODEV;
 
-        case 0x0100:
-        default:
-            /* Tips: BLENDING_NONE is non-zero value, handle zero value as
-             * BLENDING_NONE. */
-            /* C = Cs
-             * A = As */
-            break;
+    if (ret)
+        ALOGE("RockchipRgaGetHandldFd fail %d for:%s",ret,strerror(ret));
+    else if (mLogAlways || mLogOnce) {
+        ALOGD("fd = %d",*fd);
+        fprintf(stderr,"fd = %d\n", *fd);
     }
 
+    return ret;
+}
 
-    switch (rotation) {
-        case HAL_TRANSFORM_FLIP_H:
-            orientation = 0;
-            rotateMode = 2;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+int RockchipRga::RkRgaGetHandleAttributes(buffer_handle_t handle,
+                                                        std::vector<int> *attrs)
+{
+    int op = 0x80000002;
+    int ret = 0;
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.xoffset;
-            dstYPos = relRects.dst.yoffset;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
-            break;
-        case HAL_TRANSFORM_FLIP_V:
-            orientation = 0;
-            rotateMode = 3;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    if (RkRgaLoadGralloc())
+        return -ENODEV;
+    if (mAllocMod->perform)
+        mAllocMod->perform(mAllocMod,op, handle, attrs);
+    else
+        return -ENODEV;
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.xoffset;
-            dstYPos = relRects.dst.yoffset;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
-            break;
-        case HAL_TRANSFORM_ROT_90:
-            orientation = 90;
-            rotateMode = 1;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    if (ret)
+        ALOGE("RockchipRgaGetHandldAttributes fail %d for:%s",ret,strerror(ret));
+    else if (mLogAlways || mLogOnce) {
+        ALOGD("%d,%d,%d,%d,%d,%d",attrs->at(0),attrs->at(1),attrs->at(2),
+                                         attrs->at(3),attrs->at(4),attrs->at(5));
+        fprintf(stderr,"%d,%d,%d,%d,%d,%d\n",
+                               attrs->at(0),attrs->at(1),attrs->at(2),
+                                         attrs->at(3),attrs->at(4),attrs->at(5));
+    }
+    return ret;
+}
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.width - 1;
-            //dstYPos = relRects.dst.yoffset;
-            dstYPos = 0;
-            dstActW = relRects.dst.height;
-            dstActH = relRects.dst.width;
-            break;
-        case HAL_TRANSFORM_ROT_180:
-            orientation = 180;
-            rotateMode = 1;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+int RockchipRga::RkRgaGetHandleMapAddress(buffer_handle_t handle,
+                                                                     void **buf)
+{
+    int usage = GRALLOC_USAGE_SW_READ_MASK | GRALLOC_USAGE_SW_WRITE_MASK;
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.width - 1;
-            dstYPos = relRects.dst.height - 1;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
-            break;
-        case HAL_TRANSFORM_ROT_270:
-            orientation = 270;
-            rotateMode = 1;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    //cache maintenance is done by RkRgaSyncForDevice/RkRgaCpuAccessBegin
+    if (mExplicitSync)
+        usage = GRALLOC_USAGE_HW_2D;
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            //dstXPos = relRects.dst.xoffset;
-            dstXPos = 0;
-            dstYPos = relRects.dst.height - 1;
-            dstActW = relRects.dst.height;
-            dstActH = relRects.dst.width;
-            break;
-        default:
-            orientation = 0;
-            rotateMode = 0;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    if (RkRgaLoadGralloc())
+        return -ENODEV;
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.xoffset;
-            dstYPos = relRects.dst.yoffset;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
-            break;
+    int ret = mAllocMod->lock(mAllocMod, handle, usage, 0, 0, 0, 0, buf);
+
+    if (ret)
+        ALOGE("GetHandleMapAddress fail %d for:%s",ret,strerror(ret));
+    else if (mLogAlways || mLogOnce) {
+        ALOGD("buf = %p\n", buf);
+        fprintf(stderr, "buf = %p", buf);
     }
+    return ret;
+}
 
-    clip.xmin = 0;
-    clip.xmax = dstActW - 1;
-    clip.ymin = 0;
-    clip.ymax = dstActH - 1;
+void RockchipRga::RkRgaSetExplicitCacheSync(bool enable)
+{
+    Mutex::Autolock lock(mMutex);
+    std::map<buffer_handle_t, SyncState>::iterator it;
 
-    //scale up use bicubic
-    if (srcActW / dstActW < 1 || srcActH / dstActH < 1)
-        scaleMode = 2;
+    mExplicitSync = enable;
+    if (enable)
+        return;
+
+    for (it = mSyncStates.begin(); it != mSyncStates.end(); it++)
+        if (it->second.window)
+            RkRgaDmaBufSync(it->second.fd, DMA_BUF_SYNC_END | it->second.window);
+    mSyncStates.clear();
+}
+
+RockchipRga::SyncState* RockchipRga::RkRgaGetSyncState(buffer_handle_t handle)
+{
+    std::map<buffer_handle_t, SyncState>::iterator it;
+    int fd = -1;
+
+    RkRgaGetHandleFd(handle, &fd);
+    if (fd < 0)
+        return NULL;
+
+    it = mSyncStates.find(handle);
+    if (it != mSyncStates.end() && it->second.fd == fd)
+        return &it->second;
 
     /*
-    if (scaleMode && (srcFormat == RK_FORMAT_RGBA_8888 ||
-                                            srcFormat == RK_FORMAT_BGRA_8888)) {
-        scale_mode = 0;     //  force change scale_mode to 0 ,for rga not support
-    }*/
+     * A buffer we have not seen (or a recycled handle) may have been touched
+     * by the cpu through its own gralloc lock, so sync it once in both ways.
+     */
+    SyncState state;
+    state.fd = fd;
+    state.flags = SYNC_CPU_DIRTY | SYNC_DEV_DIRTY;
+    state.cpuAccess = 0;
+    state.window = 0;
+    state.busy = 0;
+    mSyncStates[handle] = state;
+
+    return &mSyncStates[handle];
+}
 
-    ditherEn = (android::bytesPerPixel(relRects.src.format) 
-                        != android::bytesPerPixel(relRects.src.format) ? 1 : 0);
+int RockchipRga::RkRgaDmaBufSync(int fd, uint64_t flags)
+{
+    struct dma_buf_sync sync;
+    int ret;
 
-    if (mVersion <= 1.003) {
-        srcMmuFlag = dstMmuFlag = 1;
+    sync.flags = flags;
+    do {
+        ret = ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
+    } while (ret && (errno == EINTR || errno == EAGAIN));
 
-#if defined(__arm64__) || defined(__aarch64__)
-        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
-                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#else
-        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
-                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#endif
-    } else if (mVersion < 2.0) {
-        /*Src*/
-        if (srcFd != -1) {
-            srcMmuFlag = srcType ? 1 : 0;
-            RkRgaSetSrcVirtualInfo(&rgaReg, 0, 0, 0, srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-            RkRgaSetFdsOffsets(&rgaReg, srcFd, 0, 0, 0);
-        } else {
-            srcMmuFlag = 1;
+    if (ret)
+        ALOGE("dma-buf sync fd=%d flags=%llx fail: %s",
+                        fd, (unsigned long long)flags, strerror(errno));
+    return ret ? -errno : 0;
+}
 
-#if defined(__arm64__) || defined(__aarch64__)
-            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
-                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-#else
-            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
-                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-#endif
-        }
-        /*dst*/
-        if (dstFd != -1) {
-            dstMmuFlag = srcType ? 1 : 0;
-            RkRgaSetDstVirtualInfo(&rgaReg, 0, 0, 0, dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-    	    /*src dst fd*/
-            RkRgaSetFdsOffsets(&rgaReg, 0, dstFd, 0, 0);
-        } else {
-            dstMmuFlag = 1;
-#if defined(__arm64__) || defined(__aarch64__)
-            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#else
-            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#endif
-        }
-    } else {
-        srcMmuFlag = ((srcFd != -1 && srcType) || srcFd == -1) ? 1 : 0;
-        dstMmuFlag = ((dstFd != -1 && dstType) || dstFd == -1) ? 1 : 0;
-#if defined(__arm64__) || defined(__aarch64__)
-        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
-                                        (unsigned long)srcBuf, 
-                                        (unsigned long)srcBuf + srcVirW * srcVirH,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
-                                        (unsigned long)dstBuf,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#else
-        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
-                                        (unsigned int)srcBuf, 
-                                        (unsigned int)srcBuf + srcVirW * srcVirH,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
-                                        (unsigned int)dstBuf,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#endif
-    }
+/*
+ * Must be called with mMutex held, right before rga accesses the buffer,
+ * and paired with RkRgaSyncDeviceDone once the access is over. Only a
+ * buffer the cpu wrote since the last rga access needs a clean, the END
+ * that closes the cpu window opened by RkRgaCpuAccessBegin.
+ */
+int RockchipRga::RkRgaSyncForDevice(buffer_handle_t handle, bool write)
+{
+    SyncState *state;
+    int ret = 0;
 
-    RkRgaSetSrcActiveInfo(&rgaReg, srcActW, srcActH, srcXPos, srcYPos);
-    RkRgaSetDstActiveInfo(&rgaReg, dstActW, dstActH, dstXPos, dstYPos);
+    if (!mExplicitSync || !handle)
+        return 0;
 
-    /*mode*/
-    RkRgaSetBitbltMode(&rgaReg, scaleMode, rotateMode, orientation, ditherEn, 0, 0);
+    state = RkRgaGetSyncState(handle);
+    if (!state)
+        return -EINVAL;
 
-    if (srcMmuFlag || dstMmuFlag) {
-        RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
-        RkRgaMmuFlag(&rgaReg, srcMmuFlag, dstMmuFlag);
-    }
+    if (state->window) {
+        ret = RkRgaDmaBufSync(state->fd, DMA_BUF_SYNC_END | state->window);
+        state->window = 0;
+        state->flags &= ~SYNC_CPU_DIRTY;
+        mCacheStats.flushIssued++;
+    } else if (state->flags & SYNC_CPU_DIRTY) {
+        /* touched through someone else's lock, a window of our own to clean it */
+        ret = RkRgaDmaBufSync(state->fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW);
+        if (!ret)
+            ret = RkRgaDmaBufSync(state->fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW);
+        state->flags &= ~SYNC_CPU_DIRTY;
+        mCacheStats.flushIssued++;
+    } else
+        mCacheStats.flushSkipped++;
 
-    if(ioctl(rgaFd, RGA_BLIT_SYNC, &rgaReg)) {
-        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
-        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
-    }
+    if (write)
+        state->flags |= SYNC_DEV_DIRTY;
+    state->busy++;
 
-    return 0;
+    return ret;
 }
 
-int RockchipRga::RkRgaBlit(buffer_handle_t src,
-                            void *dst, drm_rga_t *rects, int rotation, int blend)
+/*
+ * Called with mMutex held once the submit returned, mMutex is dropped
+ * around the blit so a cpu access may only begin after this.
+ */
+void RockchipRga::RkRgaSyncDeviceDone(buffer_handle_t handle)
 {
-    Mutex::Autolock lock(mMutex);
+    std::map<buffer_handle_t, SyncState>::iterator it;
 
-    //check rects
-    //check buffer_handle_t with rects
-    int srcVirW,srcVirH,srcActW,srcActH,srcXPos,srcYPos;
-    int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
-    int scaleMode,rotateMode,orientation,ditherEn;
-    int srcType,dstType,srcMmuFlag,dstMmuFlag;
-    int planeAlpha;
-    int dstFd = -1;
-    int srcFd = -1;
-    int ret = 0;
-    drm_rga_t tmpRects,relRects;
-    struct rga_req rgaReg;
-    bool perpixelAlpha;
-    void *srcBuf = NULL;
-    void *dstBuf = NULL;
-    RECT clip;
+    if (!mExplicitSync || !handle)
+        return;
 
-    memset(&rgaReg, 0, sizeof(struct rga_req));
+    it = mSyncStates.find(handle);
+    if (it == mSyncStates.end() || it->second.busy <= 0)
+        return;
 
-    srcType = dstType = srcMmuFlag = dstMmuFlag = 0;
+    if (!--it->second.busy)
+        mSyncCond.broadcast();
+}
 
-    if (!rects) {
-        ALOGE("%d:Has not user rects for render", __LINE__);
-        return ret;
-    }
+int RockchipRga::RkRgaCpuAccessBegin(buffer_handle_t handle, int flags)
+{
+    Mutex::Autolock lock(mMutex);
+    SyncState *state;
+    uint64_t dir;
+    int ret = 0;
 
-    if (rects->dst.wstride <= 0) {
-        ALOGE("%d:Has invalid rects for render", __LINE__);
+    if (!mExplicitSync)
+        return 0;
+
+    /* the state may be released while we sleep, look it up every time */
+    while ((state = RkRgaGetSyncState(handle)) && state->busy)
+        mSyncCond.wait(mMutex);
+    if (!state)
         return -EINVAL;
-    }
 
-    ret = RkRgaGetRects(src, NULL, &srcType, &dstType, &tmpRects);
-    if (ret) {
-        ALOGE("%d:Has not rects for render", __LINE__);
-        return ret;
-    }
+    dir = (flags & DRM_RGA_CPU_ACCESS_WRITE) ? DMA_BUF_SYNC_RW : DMA_BUF_SYNC_READ;
 
-    if (rects->src.wstride > 0)
-        memcpy(&relRects, rects, sizeof(drm_rga_t));
-    else {
-        memcpy(&(relRects.src), &(tmpRects.src), sizeof(rga_rect_t));
-        memcpy(&(relRects.dst), &(rects->dst), sizeof(rga_rect_t));
-    }
+    /*
+     * Stale lines only matter once rga wrote the buffer: a read would see
+     * them and a partial-line write would merge them back on eviction.
+     * A write needs a window anyway, its END is the clean before the next
+     * rga access. A window still open from an earlier write covers this
+     * access too.
+     */
+    if (flags && !state->window &&
+            ((state->flags & SYNC_DEV_DIRTY) || (flags & DRM_RGA_CPU_ACCESS_WRITE))) {
+        ret = RkRgaDmaBufSync(state->fd, DMA_BUF_SYNC_START | dir);
+        if (!ret)
+            state->window = dir;
+        state->flags &= ~SYNC_DEV_DIRTY;
+        mCacheStats.invalidateIssued++;
+    } else
+        mCacheStats.invalidateSkipped++;
 
-    RkRgaGetHandleMapAddress(src, &srcBuf);
-    RkRgaGetHandleFd(src, &srcFd);
+    state->cpuAccess = flags;
+    return ret;
+}
+
+int RockchipRga::RkRgaCpuAccessEnd(buffer_handle_t handle)
+{
+    Mutex::Autolock lock(mMutex);
+    SyncState *state;
+    int ret = 0;
+
+    if (!mExplicitSync)
+        return 0;
+
+    state = RkRgaGetSyncState(handle);
+    if (!state)
+        return -EINVAL;
+
+    /*
+     * The clean of a write is deferred to the next rga access, see
+     * RkRgaSyncForDevice. A read window has nothing to clean, close it.
+     */
+    if (state->cpuAccess & DRM_RGA_CPU_ACCESS_WRITE)
+        state->flags |= SYNC_CPU_DIRTY;
+    else if (state->window == DMA_BUF_SYNC_READ) {
+        ret = RkRgaDmaBufSync(state->fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+        state->window = 0;
+    }
+
+    state->cpuAccess = 0;
+    return ret;
+}
+
+int RockchipRga::RkRgaCacheSyncRelease(buffer_handle_t handle)
+{
+    Mutex::Autolock lock(mMutex);
+    std::map<buffer_handle_t, SyncState>::iterator it = mSyncStates.find(handle);
+
+    /* every START gets its END */
+    if (it != mSyncStates.end() && it->second.window)
+        RkRgaDmaBufSync(it->second.fd, DMA_BUF_SYNC_END | it->second.window);
+
+    mSyncStates.erase(handle);
+    return 0;
+}
+
+int RockchipRga::RkRgaGetCacheSyncStats(rga_cache_stats_t *stats)
+{
+    Mutex::Autolock lock(mMutex);
+
+    if (!stats)
+        return -EINVAL;
+
+    memcpy(stats, &mCacheStats, sizeof(rga_cache_stats_t));
+    return 0;
+}
+
+int RockchipRga::RkRgaBlitAsync(buffer_handle_t src, buffer_handle_t dst,
+                        drm_rga_t *rects, int rotation, int blend, int priority)
+{
+    sp<RockchipRgaJobQueue> queue;
+
+    {
+        Mutex::Autolock lock(mMutex);
+
+        RkRgaProbe();
+        if (mJobQueue == NULL) {
+            mJobQueue = new RockchipRgaJobQueue(this);
+            /* one submitter per core keeps every core busy */
+            if (mJobQueue->start(mDevices.empty() ? 1 : mDevices.size())) {
+                mJobQueue.clear();
+                return -ENODEV;
+            }
+        }
+        queue = mJobQueue;
+    }
+
+    return queue->submit(src, dst, rects, rotation, blend, priority);
+}
+
+int RockchipRga::RkRgaJobWait(int job, int timeoutMs)
+{
+    sp<RockchipRgaJobQueue> queue;
+
+    {
+        Mutex::Autolock lock(mMutex);
+        queue = mJobQueue;
+    }
+
+    if (queue == NULL)
+        return -EINVAL;
+
+    return queue->wait(job, timeoutMs);
+}
+
+int RockchipRga::RkRgaJobDetach(int job)
+{
+    sp<RockchipRgaJobQueue> queue;
+
+    {
+        Mutex::Autolock lock(mMutex);
+        queue = mJobQueue;
+    }
+
+    if (queue == NULL)
+        return -EINVAL;
+
+    return queue->detach(job);
+}
+
+int RockchipRga::RkRgaGetJobStats(rga_job_stats_t *stats)
+{
+    sp<RockchipRgaJobQueue> queue;
+
+    if (!stats)
+        return -EINVAL;
+
+    {
+        Mutex::Autolock lock(mMutex);
+        queue = mJobQueue;
+    }
+
+    if (queue == NULL) {
+        memset(stats, 0, sizeof(rga_job_stats_t));
+        return 0;
+    }
+
+    return queue->getStats(stats);
+}
+
+/*
+ * dst holds a palette already in the rga layout, the bytes of an rgba_8888
+ * pixel per entry, and the low byte of v is the DRM_RGA_PALETTE_BPPx it is
+ * for. The table is copied so the buffer may go once this returns.
+ */
+int RockchipRga::RkRgaPaletteTable(buffer_handle_t dst, 
+                                              unsigned int v, drm_rga_t *rects)
+{
+    Mutex::Autolock lock(mMutex);
+
+    void *table = NULL;
+    int mode = v & 0xFF;
+
+    if (mode > DRM_RGA_PALETTE_BPP8) {
+        ALOGE("palette mode %d not support", mode);
+        return -EINVAL;
+    }
+
+    RkRgaGetHandleMapAddress(dst, &table);
+    if (!table) {
+        ALOGE("%d:dst has not address for palette", __LINE__);
+        return -EINVAL;
+    }
+
+    if (mLogAlways || mLogOnce) {
+        ALOGD("palette mode %d from %p", mode, table);
+        mLogOnce = 0;
+    }
+
+    return RkRgaLoadPalette((const unsigned int *)table, mode);
+}
+
+int RockchipRga::RkRgaBlit(buffer_handle_t src,
+                 buffer_handle_t dst, drm_rga_t *rects, int rotation, int blend)
+{
+    Mutex::Autolock lock(mMutex);
+
+    //check rects
+    //check buffer_handle_t with rects
+    int srcVirW,srcVirH,srcActW,srcActH,srcXPos,srcYPos;
+    int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
+    int scaleMode,rotateMode,orientation,ditherEn;
+    int srcType,dstType,srcMmuFlag,dstMmuFlag;
+    int planeAlpha;
+    int dstFd = -1;
+    int srcFd = -1;
+    int ret = 0;
+    drm_rga_t tmpRects,relRects;
+    struct rga_req rgaReg;
+    bool perpixelAlpha;
+    void *srcBuf = NULL;
+    void *dstBuf = NULL;
+    RECT clip;
+
+    RkRgaProbe();
+
+    if (rects && (mLogAlways || mLogOnce)) {
+        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
+            rects->src.xoffset,rects->src.yoffset,
+            rects->src.width, rects->src.height, 
+            rects->src.wstride,rects->src.format, rects->src.size,
+            rects->dst.xoffset,rects->dst.yoffset,
+            rects->dst.width, rects->dst.height,
+            rects->dst.wstride,rects->dst.format, rects->dst.size);
+    }
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    srcType = dstType = srcMmuFlag = dstMmuFlag = 0;
+
+    ret = RkRgaGetRects(src, dst, &srcType, &dstType, &tmpRects);
+    if (ret && !rects) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects) {
+        if (rects->src.wstride > 0 && rects->dst.wstride > 0)
+            memcpy(&relRects, rects, sizeof(drm_rga_t));
+        else if (rects->src.wstride > 0) {
+            memcpy(&(relRects.src), &(rects->src), sizeof(rga_rect_t));
+            memcpy(&(relRects.dst), &(tmpRects.dst), sizeof(rga_rect_t));
+        } else if (rects->dst.wstride > 0) {
+            memcpy(&(relRects.src), &(tmpRects.src), sizeof(rga_rect_t));
+            memcpy(&(relRects.dst), &(rects->dst), sizeof(rga_rect_t));
+        }
+    } else
+        memcpy(&relRects, &tmpRects, sizeof(drm_rga_t));
+
+    if (mLogAlways || mLogOnce) {
+        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
+            tmpRects.src.xoffset,tmpRects.src.yoffset,
+            tmpRects.src.width, tmpRects.src.height, 
+            tmpRects.src.wstride,tmpRects.src.format, tmpRects.src.size,
+            tmpRects.dst.xoffset,tmpRects.dst.yoffset,
+            tmpRects.dst.width, tmpRects.dst.height,
+            tmpRects.dst.wstride,tmpRects.dst.format, tmpRects.dst.size);
+        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
+            relRects.src.xoffset,relRects.src.yoffset,
+            relRects.src.width, relRects.src.height, 
+            relRects.src.wstride,relRects.src.format, relRects.src.size,
+            relRects.dst.xoffset,relRects.dst.yoffset,
+            relRects.dst.width, relRects.dst.height,
+            relRects.dst.wstride,relRects.dst.format, relRects.dst.size);
+    }
+
+    RkRgaGetHandleMapAddress(src, &srcBuf);
+    RkRgaGetHandleFd(src, &srcFd);
     if (srcFd == -1 && !srcBuf) {
         ALOGE("%d:src has not fd and address for render", __LINE__);
         return ret;
@@ -1088,12 +1389,19 @@ int RockchipRga::RkRgaBlit(buffer_handle_t src,
     } else
         srcFd = -1;
 
-    dstBuf = dst;
-    if (!dstBuf) {
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    RkRgaGetHandleFd(dst, &dstFd);
+    if (dstFd == -1 && !dstBuf) {
         ALOGE("%d:dst has not fd and address for render", __LINE__);
         return ret;
     }
 
+    if (dstFd == 0 && !dstBuf) {
+        ALOGE("dstFd is zero, now driver not support");
+        return -EINVAL;
+    } else
+        dstFd = -1;
+
     planeAlpha = (blend & 0xFF0000) >> 16;
     perpixelAlpha = relRects.src.format == HAL_PIXEL_FORMAT_RGBA_8888 ||
                     relRects.src.format == HAL_PIXEL_FORMAT_BGRA_8888;
@@ -1126,7 +1434,6 @@ int RockchipRga::RkRgaBlit(buffer_handle_t src,
             break;
     }
 
-
     switch (rotation) {
         case HAL_TRANSFORM_FLIP_H:
             orientation = 0;
@@ -1239,9 +1546,7 @@ int RockchipRga::RkRgaBlit(buffer_handle_t src,
     clip.ymin = 0;
     clip.ymax = dstActH - 1;
 
-    //scale up use bicubic
-    if (srcActW / dstActW < 1 || srcActH / dstActH < 1)
-        scaleMode = 2;
+    scaleMode = RkRgaScaleModeOf(srcActW, srcActH, dstActW, dstActH);
 
     /*
     if (scaleMode && (srcFormat == RK_FORMAT_RGBA_8888 ||
@@ -1249,8 +1554,7 @@ int RockchipRga::RkRgaBlit(buffer_handle_t src,
         scale_mode = 0;     //  force change scale_mode to 0 ,for rga not support
     }*/
 
-    ditherEn = (android::bytesPerPixel(relRects.src.format) 
-                        != android::bytesPerPixel(relRects.src.format) ? 1 : 0);
+    ditherEn = RkRgaDitherOf(relRects.src.format, relRects.dst.format);
 
     if (mVersion <= 1.003) {
         srcMmuFlag = dstMmuFlag = 1;
@@ -1357,368 +1661,2535 @@ int RockchipRga::RkRgaBlit(buffer_handle_t src,
 #endif
     }
 
-    RkRgaSetSrcActiveInfo(&rgaReg, srcActW, srcActH, srcXPos, srcYPos);
-    RkRgaSetDstActiveInfo(&rgaReg, dstActW, dstActH, dstXPos, dstYPos);
+    RkRgaSetSrcActiveInfo(&rgaReg, srcActW, srcActH, srcXPos, srcYPos);
+    RkRgaSetDstActiveInfo(&rgaReg, dstActW, dstActH, dstXPos, dstYPos);
+
+    /*mode*/
+    RkRgaSetBitbltMode(&rgaReg, scaleMode, rotateMode, orientation, ditherEn, 0, 0);
+
+    if (srcMmuFlag || dstMmuFlag) {
+        RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
+        RkRgaMmuFlag(&rgaReg, srcMmuFlag, dstMmuFlag);
+    }
+
+    RkRgaSyncForDevice(src, false);
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    RkRgaSyncDeviceDone(src);
+    RkRgaSyncDeviceDone(dst);
+    if (ret) {
+        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+    }
+
+    if (mLogOnce)
+        mLogOnce = 0;
+
+    return ret;
+}
+
+int RockchipRga::RkRgaBlit(void *src,
+                    buffer_handle_t dst, drm_rga_t *rects, int rotation, int blend)
+{
+    Mutex::Autolock lock(mMutex);
+
+    //check rects
+    //check buffer_handle_t with rects
+    int srcVirW,srcVirH,srcActW,srcActH,srcXPos,srcYPos;
+    int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
+    int scaleMode,rotateMode,orientation,ditherEn;
+    int srcType,dstType,srcMmuFlag,dstMmuFlag;
+    int planeAlpha;
+    int dstFd = -1;
+    int srcFd = -1;
+    int ret = 0;
+    drm_rga_t tmpRects,relRects;
+    struct rga_req rgaReg;
+    bool perpixelAlpha;
+    void *srcBuf = NULL;
+    void *dstBuf = NULL;
+    RECT clip;
+
+    RkRgaProbe();
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    srcType = dstType = srcMmuFlag = dstMmuFlag = 0;
+
+    if (!rects) {
+        ALOGE("%d:Has not user rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects->src.wstride <= 0) {
+        ALOGE("%d:Has invalid rects for render", __LINE__);
+        return -EINVAL;
+    }
+
+    ret = RkRgaGetRects(NULL, dst, &srcType, &dstType, &tmpRects);
+    if (ret) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects->dst.wstride > 0)
+        memcpy(&relRects, rects, sizeof(drm_rga_t));
+    else {
+        memcpy(&(relRects.src), &(rects->src), sizeof(rga_rect_t));
+        memcpy(&(relRects.dst), &(tmpRects.dst), sizeof(rga_rect_t));
+    }
+
+    srcBuf = src;
+    if (!srcBuf) {
+        ALOGE("%d:src has not fd and address for render", __LINE__);
+        return ret;
+    }
+
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    RkRgaGetHandleFd(dst, &dstFd);
+    if (dstFd == -1 && !dstBuf) {
+        ALOGE("%d:dst has not fd and address for render", __LINE__);
+        return ret;
+    }
+
+    if (dstFd == 0 && !dstBuf) {
+        ALOGE("dstFd is zero, now driver not support");
+        return -EINVAL;
+    } else
+        dstFd = -1;
+
+    planeAlpha = (blend & 0xFF0000) >> 16;
+    perpixelAlpha = relRects.src.format == HAL_PIXEL_FORMAT_RGBA_8888 ||
+                    relRects.src.format == HAL_PIXEL_FORMAT_BGRA_8888;
+
+    switch ((blend & 0xFFFF)) {
+        case 0x0105:
+            if (perpixelAlpha && planeAlpha < 255)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 1, 9, 0);
+            else if (perpixelAlpha)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 1, 3, 0);
+            else
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
+            break;
+
+        case 0x0405:
+            if (perpixelAlpha && planeAlpha < 255)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 0, 0, 0);
+            else if (perpixelAlpha)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 0, 0, 0);
+            else
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
+            break;
+
+        case 0x0100:
+        default:
+            /* Tips: BLENDING_NONE is non-zero value, handle zero value as
+             * BLENDING_NONE. */
+            /* C = Cs
+             * A = As */
+            break;
+    }
+
+
+    switch (rotation) {
+        case HAL_TRANSFORM_FLIP_H:
+            orientation = 0;
+            rotateMode = 2;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.xoffset;
+            dstYPos = relRects.dst.yoffset;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+        case HAL_TRANSFORM_FLIP_V:
+            orientation = 0;
+            rotateMode = 3;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.xoffset;
+            dstYPos = relRects.dst.yoffset;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+        case HAL_TRANSFORM_ROT_90:
+            orientation = 90;
+            rotateMode = 1;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.width - 1;
+            //dstYPos = relRects.dst.yoffset;
+            dstYPos = 0;
+            dstActW = relRects.dst.height;
+            dstActH = relRects.dst.width;
+            break;
+        case HAL_TRANSFORM_ROT_180:
+            orientation = 180;
+            rotateMode = 1;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.width - 1;
+            dstYPos = relRects.dst.height - 1;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+        case HAL_TRANSFORM_ROT_270:
+            orientation = 270;
+            rotateMode = 1;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            //dstXPos = relRects.dst.xoffset;
+            dstXPos = 0;
+            dstYPos = relRects.dst.height - 1;
+            dstActW = relRects.dst.height;
+            dstActH = relRects.dst.width;
+            break;
+        default:
+            orientation = 0;
+            rotateMode = 0;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.xoffset;
+            dstYPos = relRects.dst.yoffset;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+    }
+
+    clip.xmin = 0;
+    clip.xmax = dstActW - 1;
+    clip.ymin = 0;
+    clip.ymax = dstActH - 1;
+
+    scaleMode = RkRgaScaleModeOf(srcActW, srcActH, dstActW, dstActH);
+
+    /*
+    if (scaleMode && (srcFormat == RK_FORMAT_RGBA_8888 ||
+                                            srcFormat == RK_FORMAT_BGRA_8888)) {
+        scale_mode = 0;     //  force change scale_mode to 0 ,for rga not support
+    }*/
+
+    ditherEn = RkRgaDitherOf(relRects.src.format, relRects.dst.format);
+
+    if (mVersion <= 1.003) {
+        srcMmuFlag = dstMmuFlag = 1;
+
+#if defined(__arm64__) || defined(__aarch64__)
+        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
+                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#else
+        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
+                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#endif
+    } else if (mVersion < 2.0) {
+        /*Src*/
+        if (srcFd != -1) {
+            srcMmuFlag = srcType ? 1 : 0;
+            RkRgaSetSrcVirtualInfo(&rgaReg, 0, 0, 0, srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+            RkRgaSetFdsOffsets(&rgaReg, srcFd, 0, 0, 0);
+        } else {
+            srcMmuFlag = 1;
+
+#if defined(__arm64__) || defined(__aarch64__)
+            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
+                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+#else
+            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
+                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+#endif
+        }
+        /*dst*/
+        if (dstFd != -1) {
+            dstMmuFlag = srcType ? 1 : 0;
+            RkRgaSetDstVirtualInfo(&rgaReg, 0, 0, 0, dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+    	    /*src dst fd*/
+            RkRgaSetFdsOffsets(&rgaReg, 0, dstFd, 0, 0);
+        } else {
+            dstMmuFlag = 1;
+#if defined(__arm64__) || defined(__aarch64__)
+            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#else
+            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#endif
+        }
+    } else {
+        srcMmuFlag = ((srcFd != -1 && srcType) || srcFd == -1) ? 1 : 0;
+        dstMmuFlag = ((dstFd != -1 && dstType) || dstFd == -1) ? 1 : 0;
+#if defined(__arm64__) || defined(__aarch64__)
+        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
+                                        (unsigned long)srcBuf, 
+                                        (unsigned long)srcBuf + srcVirW * srcVirH,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
+                                        (unsigned long)dstBuf,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#else
+        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
+                                        (unsigned int)srcBuf, 
+                                        (unsigned int)srcBuf + srcVirW * srcVirH,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
+                                        (unsigned int)dstBuf,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#endif
+    }
+
+    RkRgaSetSrcActiveInfo(&rgaReg, srcActW, srcActH, srcXPos, srcYPos);
+    RkRgaSetDstActiveInfo(&rgaReg, dstActW, dstActH, dstXPos, dstYPos);
+
+    /*mode*/
+    RkRgaSetBitbltMode(&rgaReg, scaleMode, rotateMode, orientation, ditherEn, 0, 0);
+
+    if (srcMmuFlag || dstMmuFlag) {
+        RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
+        RkRgaMmuFlag(&rgaReg, srcMmuFlag, dstMmuFlag);
+    }
+
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    RkRgaSyncDeviceDone(dst);
+    if (ret) {
+        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+    }
+
+    return ret;
+}
+
+int RockchipRga::RkRgaBlit(buffer_handle_t src,
+                            void *dst, drm_rga_t *rects, int rotation, int blend)
+{
+    Mutex::Autolock lock(mMutex);
+
+    //check rects
+    //check buffer_handle_t with rects
+    int srcVirW,srcVirH,srcActW,srcActH,srcXPos,srcYPos;
+    int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
+    int scaleMode,rotateMode,orientation,ditherEn;
+    int srcType,dstType,srcMmuFlag,dstMmuFlag;
+    int planeAlpha;
+    int dstFd = -1;
+    int srcFd = -1;
+    int ret = 0;
+    drm_rga_t tmpRects,relRects;
+    struct rga_req rgaReg;
+    bool perpixelAlpha;
+    void *srcBuf = NULL;
+    void *dstBuf = NULL;
+    RECT clip;
+
+    RkRgaProbe();
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    srcType = dstType = srcMmuFlag = dstMmuFlag = 0;
+
+    if (!rects) {
+        ALOGE("%d:Has not user rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects for render", __LINE__);
+        return -EINVAL;
+    }
+
+    ret = RkRgaGetRects(src, NULL, &srcType, &dstType, &tmpRects);
+    if (ret) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects->src.wstride > 0)
+        memcpy(&relRects, rects, sizeof(drm_rga_t));
+    else {
+        memcpy(&(relRects.src), &(tmpRects.src), sizeof(rga_rect_t));
+        memcpy(&(relRects.dst), &(rects->dst), sizeof(rga_rect_t));
+    }
+
+    RkRgaGetHandleMapAddress(src, &srcBuf);
+    RkRgaGetHandleFd(src, &srcFd);
+    if (srcFd == -1 && !srcBuf) {
+        ALOGE("%d:src has not fd and address for render", __LINE__);
+        return ret;
+    }
+
+    if (srcFd == 0 && !srcBuf) {
+        ALOGE("srcFd is zero, now driver not support");
+        return -EINVAL;
+    } else
+        srcFd = -1;
+
+    dstBuf = dst;
+    if (!dstBuf) {
+        ALOGE("%d:dst has not fd and address for render", __LINE__);
+        return ret;
+    }
+
+    planeAlpha = (blend & 0xFF0000) >> 16;
+    perpixelAlpha = relRects.src.format == HAL_PIXEL_FORMAT_RGBA_8888 ||
+                    relRects.src.format == HAL_PIXEL_FORMAT_BGRA_8888;
+
+    switch ((blend & 0xFFFF)) {
+        case 0x0105:
+            if (perpixelAlpha && planeAlpha < 255)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 1, 9, 0);
+            else if (perpixelAlpha)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 1, 3, 0);
+            else
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
+            break;
+
+        case 0x0405:
+            if (perpixelAlpha && planeAlpha < 255)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 0, 0, 0);
+            else if (perpixelAlpha)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 0, 0, 0);
+            else
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
+            break;
+
+        case 0x0100:
+        default:
+            /* Tips: BLENDING_NONE is non-zero value, handle zero value as
+             * BLENDING_NONE. */
+            /* C = Cs
+             * A = As */
+            break;
+    }
+
+
+    switch (rotation) {
+        case HAL_TRANSFORM_FLIP_H:
+            orientation = 0;
+            rotateMode = 2;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.xoffset;
+            dstYPos = relRects.dst.yoffset;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+        case HAL_TRANSFORM_FLIP_V:
+            orientation = 0;
+            rotateMode = 3;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.xoffset;
+            dstYPos = relRects.dst.yoffset;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+        case HAL_TRANSFORM_ROT_90:
+            orientation = 90;
+            rotateMode = 1;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.width - 1;
+            //dstYPos = relRects.dst.yoffset;
+            dstYPos = 0;
+            dstActW = relRects.dst.height;
+            dstActH = relRects.dst.width;
+            break;
+        case HAL_TRANSFORM_ROT_180:
+            orientation = 180;
+            rotateMode = 1;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.width - 1;
+            dstYPos = relRects.dst.height - 1;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+        case HAL_TRANSFORM_ROT_270:
+            orientation = 270;
+            rotateMode = 1;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            //dstXPos = relRects.dst.xoffset;
+            dstXPos = 0;
+            dstYPos = relRects.dst.height - 1;
+            dstActW = relRects.dst.height;
+            dstActH = relRects.dst.width;
+            break;
+        default:
+            orientation = 0;
+            rotateMode = 0;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.xoffset;
+            dstYPos = relRects.dst.yoffset;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+    }
+
+    clip.xmin = 0;
+    clip.xmax = dstActW - 1;
+    clip.ymin = 0;
+    clip.ymax = dstActH - 1;
+
+    scaleMode = RkRgaScaleModeOf(srcActW, srcActH, dstActW, dstActH);
+
+    /*
+    if (scaleMode && (srcFormat == RK_FORMAT_RGBA_8888 ||
+                                            srcFormat == RK_FORMAT_BGRA_8888)) {
+        scale_mode = 0;     //  force change scale_mode to 0 ,for rga not support
+    }*/
+
+    ditherEn = RkRgaDitherOf(relRects.src.format, relRects.dst.format);
+
+    if (mVersion <= 1.003) {
+        srcMmuFlag = dstMmuFlag = 1;
+
+#if defined(__arm64__) || defined(__aarch64__)
+        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
+                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#else
+        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
+                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#endif
+    } else if (mVersion < 2.0) {
+        /*Src*/
+        if (srcFd != -1) {
+            srcMmuFlag = srcType ? 1 : 0;
+            RkRgaSetSrcVirtualInfo(&rgaReg, 0, 0, 0, srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+            RkRgaSetFdsOffsets(&rgaReg, srcFd, 0, 0, 0);
+        } else {
+            srcMmuFlag = 1;
+
+#if defined(__arm64__) || defined(__aarch64__)
+            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
+                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+#else
+            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
+                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+#endif
+        }
+        /*dst*/
+        if (dstFd != -1) {
+            dstMmuFlag = srcType ? 1 : 0;
+            RkRgaSetDstVirtualInfo(&rgaReg, 0, 0, 0, dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+    	    /*src dst fd*/
+            RkRgaSetFdsOffsets(&rgaReg, 0, dstFd, 0, 0);
+        } else {
+            dstMmuFlag = 1;
+#if defined(__arm64__) || defined(__aarch64__)
+            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#else
+            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#endif
+        }
+    } else {
+        srcMmuFlag = ((srcFd != -1 && srcType) || srcFd == -1) ? 1 : 0;
+        dstMmuFlag = ((dstFd != -1 && dstType) || dstFd == -1) ? 1 : 0;
+#if defined(__arm64__) || defined(__aarch64__)
+        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
+                                        (unsigned long)srcBuf, 
+                                        (unsigned long)srcBuf + srcVirW * srcVirH,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
+                                        (unsigned long)dstBuf,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#else
+        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
+                                        (unsigned int)srcBuf, 
+                                        (unsigned int)srcBuf + srcVirW * srcVirH,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
+                                        (unsigned int)dstBuf,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#endif
+    }
+
+    RkRgaSetSrcActiveInfo(&rgaReg, srcActW, srcActH, srcXPos, srcYPos);
+    RkRgaSetDstActiveInfo(&rgaReg, dstActW, dstActH, dstXPos, dstYPos);
+
+    /*mode*/
+    RkRgaSetBitbltMode(&rgaReg, scaleMode, rotateMode, orientation, ditherEn, 0, 0);
+
+    if (srcMmuFlag || dstMmuFlag) {
+        RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
+        RkRgaMmuFlag(&rgaReg, srcMmuFlag, dstMmuFlag);
+    }
+
+    RkRgaSyncForDevice(src, false);
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    RkRgaSyncDeviceDone(src);
+    if (ret) {
+        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+    }
+
+    return ret;
+}
+
+int RockchipRga::RkRgaBlit(void *src, void *dst,
+                                      drm_rga_t *rects, int rotation, int blend)
+{
+    Mutex::Autolock lock(mMutex);
+
+    //check rects
+    //check buffer_handle_t with rects
+    int srcVirW,srcVirH,srcActW,srcActH,srcXPos,srcYPos;
+    int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
+    int scaleMode,rotateMode,orientation,ditherEn;
+    int srcType,dstType,srcMmuFlag,dstMmuFlag;
+    int planeAlpha;
+    int dstFd = -1;
+    int srcFd = -1;
+    int ret = 0;
+    drm_rga_t relRects;
+    struct rga_req rgaReg;
+    bool perpixelAlpha;
+    void *srcBuf = NULL;
+    void *dstBuf = NULL;
+    RECT clip;
+
+    RkRgaProbe();
+
+    if (rects && (mLogAlways || mLogOnce)) {
+        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
+            rects->src.xoffset,rects->src.yoffset,
+            rects->src.width, rects->src.height,
+            rects->src.wstride,rects->src.format, rects->src.size,
+            rects->dst.xoffset,rects->dst.yoffset,
+            rects->dst.width, rects->dst.height,
+            rects->dst.wstride,rects->dst.format, rects->dst.size);
+    }
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    srcType = dstType = srcMmuFlag = dstMmuFlag = 0;
+
+    if (!rects) {
+        ALOGE("%d:Has not user rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects for render", __LINE__);
+        return -EINVAL;
+    }
+
+    memcpy(&relRects, rects, sizeof(drm_rga_t));
+
+    srcBuf = src;
+    if (!srcBuf) {
+        ALOGE("%d:src has not fd and address for render", __LINE__);
+        return ret;
+    }
+
+    dstBuf = dst;
+    if (!dstBuf) {
+        ALOGE("%d:dst has not fd and address for render", __LINE__);
+        return ret;
+    }
+
+    planeAlpha = (blend & 0xFF0000) >> 16;
+    perpixelAlpha = relRects.src.format == HAL_PIXEL_FORMAT_RGBA_8888 ||
+                    relRects.src.format == HAL_PIXEL_FORMAT_BGRA_8888;
+
+    switch ((blend & 0xFFFF)) {
+        case 0x0105:
+            if (perpixelAlpha && planeAlpha < 255)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 1, 9, 0);
+            else if (perpixelAlpha)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 1, 3, 0);
+            else
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
+            break;
+
+        case 0x0405:
+            if (perpixelAlpha && planeAlpha < 255)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 0, 0, 0);
+            else if (perpixelAlpha)
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 0, 0, 0);
+            else
+                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
+            break;
+
+        case 0x0100:
+        default:
+            /* Tips: BLENDING_NONE is non-zero value, handle zero value as
+             * BLENDING_NONE. */
+            /* C = Cs
+             * A = As */
+            break;
+    }
+
+
+    switch (rotation) {
+        case HAL_TRANSFORM_FLIP_H:
+            orientation = 0;
+            rotateMode = 2;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.xoffset;
+            dstYPos = relRects.dst.yoffset;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+        case HAL_TRANSFORM_FLIP_V:
+            orientation = 0;
+            rotateMode = 3;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.xoffset;
+            dstYPos = relRects.dst.yoffset;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+        case HAL_TRANSFORM_ROT_90:
+            orientation = 90;
+            rotateMode = 1;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.width - 1;
+            //dstYPos = relRects.dst.yoffset;
+            dstYPos = 0;
+            dstActW = relRects.dst.height;
+            dstActH = relRects.dst.width;
+            break;
+        case HAL_TRANSFORM_ROT_180:
+            orientation = 180;
+            rotateMode = 1;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.width - 1;
+            dstYPos = relRects.dst.height - 1;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+        case HAL_TRANSFORM_ROT_270:
+            orientation = 270;
+            rotateMode = 1;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            //dstXPos = relRects.dst.xoffset;
+            dstXPos = 0;
+            dstYPos = relRects.dst.height - 1;
+            dstActW = relRects.dst.height;
+            dstActH = relRects.dst.width;
+            break;
+        default:
+            orientation = 0;
+            rotateMode = 0;
+            srcVirW = relRects.src.wstride;
+            srcVirH = relRects.src.height;
+            srcXPos = relRects.src.xoffset;
+            srcYPos = relRects.src.yoffset;
+            srcActW = relRects.src.width;
+            srcActH = relRects.src.height;
+
+            dstVirW = relRects.dst.wstride;
+            dstVirH = relRects.dst.height;
+            dstXPos = relRects.dst.xoffset;
+            dstYPos = relRects.dst.yoffset;
+            dstActW = relRects.dst.width;
+            dstActH = relRects.dst.height;
+            break;
+    }
+
+    clip.xmin = 0;
+    clip.xmax = dstActW - 1;
+    clip.ymin = 0;
+    clip.ymax = dstActH - 1;
+
+    scaleMode = RkRgaScaleModeOf(srcActW, srcActH, dstActW, dstActH);
+
+    /*
+    if (scaleMode && (srcFormat == RK_FORMAT_RGBA_8888 ||
+                                            srcFormat == RK_FORMAT_BGRA_8888)) {
+        scale_mode = 0;     //  force change scale_mode to 0 ,for rga not support
+    }*/
+
+    ditherEn = RkRgaDitherOf(relRects.src.format, relRects.dst.format);
+
+    if (mVersion <= 1.003) {
+        srcMmuFlag = dstMmuFlag = 1;
+
+#if defined(__arm64__) || defined(__aarch64__)
+        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
+                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#else
+        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
+                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#endif
+    } else if (mVersion < 2.0) {
+        /*Src*/
+        if (srcFd != -1) {
+            srcMmuFlag = srcType ? 1 : 0;
+            RkRgaSetSrcVirtualInfo(&rgaReg, 0, 0, 0, srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+            RkRgaSetFdsOffsets(&rgaReg, srcFd, 0, 0, 0);
+        } else {
+            srcMmuFlag = 1;
+
+#if defined(__arm64__) || defined(__aarch64__)
+            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
+                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+#else
+            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
+                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
+                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+#endif
+        }
+        /*dst*/
+        if (dstFd != -1) {
+            dstMmuFlag = srcType ? 1 : 0;
+            RkRgaSetDstVirtualInfo(&rgaReg, 0, 0, 0, dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+    	    /*src dst fd*/
+            RkRgaSetFdsOffsets(&rgaReg, 0, dstFd, 0, 0);
+        } else {
+            dstMmuFlag = 1;
+#if defined(__arm64__) || defined(__aarch64__)
+            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#else
+            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#endif
+        }
+    } else {
+        srcMmuFlag = ((srcFd != -1 && srcType) || srcFd == -1) ? 1 : 0;
+        dstMmuFlag = ((dstFd != -1 && dstType) || dstFd == -1) ? 1 : 0;
+#if defined(__arm64__) || defined(__aarch64__)
+        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
+                                        (unsigned long)srcBuf, 
+                                        (unsigned long)srcBuf + srcVirW * srcVirH,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
+                                        (unsigned long)dstBuf,
+                                        (unsigned long)dstBuf + dstVirW * dstVirH,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#else
+        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
+                                        (unsigned int)srcBuf, 
+                                        (unsigned int)srcBuf + srcVirW * srcVirH,
+                                        srcVirW, srcVirH,
+                                        RkRgaGetRgaFormat(relRects.src.format),0);
+        /*dst*/
+        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
+                                        (unsigned int)dstBuf,
+                                        (unsigned int)dstBuf + dstVirW * dstVirH,
+                                        dstVirW, dstVirH, &clip,
+                                        RkRgaGetRgaFormat(relRects.dst.format),0);
+#endif
+    }
+
+    RkRgaSetSrcActiveInfo(&rgaReg, srcActW, srcActH, srcXPos, srcYPos);
+    RkRgaSetDstActiveInfo(&rgaReg, dstActW, dstActH, dstXPos, dstYPos);
+
+    /*mode*/
+    RkRgaSetBitbltMode(&rgaReg, scaleMode, rotateMode, orientation, ditherEn, 0, 0);
+
+    if (srcMmuFlag || dstMmuFlag) {
+        RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
+        RkRgaMmuFlag(&rgaReg, srcMmuFlag, dstMmuFlag);
+    }
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret) {
+        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+    }
+
+    if (mLogOnce)
+        mLogOnce = 0;
+
+    return ret;
+}
+
+/*
+ * Point src and dst of a request at user buffers with the address layout of
+ * the rga version, like RkRgaBlit does. A NULL buffer leaves its side alone.
+ * The clip is absolute, so a packed rgb dst, a single plane, gets a virtual
+ * height down to the end of its rect.
+ */
+int RockchipRga::RkRgaSetImages(struct rga_req *req, void *srcBuf,
+        const rga_rect_t *src, void *dstBuf, const rga_rect_t *dst, RECT *clip)
+{
+#if defined(__arm64__) || defined(__aarch64__)
+    unsigned long srcAddr = (unsigned long)srcBuf;
+    unsigned long dstAddr = (unsigned long)dstBuf;
+#else
+    unsigned int srcAddr = (unsigned int)srcBuf;
+    unsigned int dstAddr = (unsigned int)dstBuf;
+#endif
+    int srcPlane = src ? src->wstride * src->height : 0;
+    int dstPlane = dst ? dst->wstride * dst->height : 0;
+    int dstHeight = dst ? dst->height : 0;
+    int srcMmuFlag = 0, dstMmuFlag = 0;
+
+    /* the address layout follows the driver version */
+    RkRgaProbe();
+
+    if (dst && !RockchipRgaCpu::isYuv(RkRgaGetRgaFormat(dst->format)))
+        dstHeight = dst->yoffset + dst->height;
+
+    if (srcBuf && src) {
+        srcMmuFlag = 1;
+        if (mVersion < 2.0)
+            RkRgaSetSrcVirtualInfo(req, srcAddr, srcAddr + srcPlane,
+                                        srcAddr + srcPlane * 5/4,
+                                        src->wstride, src->height,
+                                        RkRgaGetRgaFormat(src->format), 0);
+        else
+            RkRgaSetSrcVirtualInfo(req, 0, srcAddr, srcAddr + srcPlane,
+                                        src->wstride, src->height,
+                                        RkRgaGetRgaFormat(src->format), 0);
+    }
+
+    if (dstBuf && dst) {
+        dstMmuFlag = 1;
+        if (mVersion < 2.0)
+            RkRgaSetDstVirtualInfo(req, dstAddr, dstAddr + dstPlane,
+                                        dstAddr + dstPlane * 5/4,
+                                        dst->wstride, dstHeight, clip,
+                                        RkRgaGetRgaFormat(dst->format), 0);
+        else
+            RkRgaSetDstVirtualInfo(req, 0, dstAddr, dstAddr + dstPlane,
+                                        dst->wstride, dstHeight, clip,
+                                        RkRgaGetRgaFormat(dst->format), 0);
+    }
+
+    if (srcMmuFlag || dstMmuFlag) {
+        RkRgaMmuInfo(req, 1, 0, 0, 0, 0, 2);
+        RkRgaMmuFlag(req, srcMmuFlag, dstMmuFlag);
+    }
+
+    return 0;
+}
+
+/* the blend argument of RkRgaBlit */
+int RockchipRga::RkRgaSetBlend(struct rga_req *req, int srcFormat, int blend)
+{
+    int planeAlpha = (blend & 0xFF0000) >> 16;
+    bool perpixelAlpha = srcFormat == HAL_PIXEL_FORMAT_RGBA_8888 ||
+                         srcFormat == HAL_PIXEL_FORMAT_BGRA_8888;
+
+    switch ((blend & 0xFFFF)) {
+        case 0x0105:
+            if (perpixelAlpha && planeAlpha < 255)
+                RkRgaSetAlphaEnInfo(req, 1, 2, planeAlpha , 1, 9, 0);
+            else if (perpixelAlpha)
+                RkRgaSetAlphaEnInfo(req, 1, 1, 0, 1, 3, 0);
+            else
+                RkRgaSetAlphaEnInfo(req, 1, 0, planeAlpha , 0, 0, 0);
+            break;
+
+        case 0x0405:
+            if (perpixelAlpha && planeAlpha < 255)
+                RkRgaSetAlphaEnInfo(req, 1, 2, planeAlpha , 0, 0, 0);
+            else if (perpixelAlpha)
+                RkRgaSetAlphaEnInfo(req, 1, 1, 0, 0, 0, 0);
+            else
+                RkRgaSetAlphaEnInfo(req, 1, 0, planeAlpha , 0, 0, 0);
+            break;
+
+        case 0x0100:
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+/*
+ * The rga draws frame pixel (u,v) of a rotated blit at
+ *     (x_offset, y_offset) + u * (cos, sin) + v * (-sin, cos)
+ * so the frame is scaled to fit the dst rect with its bounding box, and
+ * the offsets put the box in the middle of the rect.
+ */
+int RockchipRga::RkRgaRotateBuffers(void *srcBuf, void *dstBuf,
+                                    drm_rga_t *rects, int angle, int blend)
+{
+    struct rga_req rgaReg;
+    RECT clip;
+    double c, s, fit, minX, minY, maxX, maxY;
+    int frameW, frameH, boxW, boxH, xOff, yOff;
+    int ret;
+
+    angle = ((angle % 360) + 360) % 360;
+    c = rgaCosaTable[angle] / 65536.0;
+    s = rgaSinaTable[angle] / 65536.0;
+
+    if (rects->src.width <= 0 || rects->src.height <= 0 ||
+                        rects->dst.width <= 0 || rects->dst.height <= 0)
+        return -EINVAL;
+
+    fit = (double)rects->dst.width /
+            (rects->src.width * fabs(c) + rects->src.height * fabs(s));
+    if ((double)rects->dst.height /
+            (rects->src.width * fabs(s) + rects->src.height * fabs(c)) < fit)
+        fit = (double)rects->dst.height /
+            (rects->src.width * fabs(s) + rects->src.height * fabs(c));
+
+    frameW = (int)(rects->src.width * fit);
+    frameH = (int)(rects->src.height * fit);
+    if (frameW < 1 || frameH < 1)
+        return -EINVAL;
+
+    /* corners of the frame, pixel (frameW - 1, frameH - 1) is the last one */
+    minX = maxX = minY = maxY = 0.0;
+    for (int i = 1; i < 4; i++) {
+        double u = (i & 1) ? frameW - 1 : 0;
+        double v = (i & 2) ? frameH - 1 : 0;
+        double x = u * c - v * s;
+        double y = u * s + v * c;
+
+        minX = x < minX ? x : minX;
+        maxX = x > maxX ? x : maxX;
+        minY = y < minY ? y : minY;
+        maxY = y > maxY ? y : maxY;
+    }
+
+    boxW = (int)ceil(maxX - minX) + 1;
+    boxH = (int)ceil(maxY - minY) + 1;
+    xOff = rects->dst.xoffset + (rects->dst.width - boxW) / 2 + (int)ceil(-minX);
+    yOff = rects->dst.yoffset + (rects->dst.height - boxH) / 2 + (int)ceil(-minY);
+
+    clip.xmin = rects->dst.xoffset;
+    clip.xmax = rects->dst.xoffset + rects->dst.width - 1;
+    clip.ymin = rects->dst.yoffset;
+    clip.ymax = rects->dst.yoffset + rects->dst.height - 1;
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    RkRgaSetImages(&rgaReg, srcBuf, &rects->src, dstBuf, &rects->dst, &clip);
+    RkRgaSetBlend(&rgaReg, rects->src.format, blend);
+    RkRgaSetSrcActiveInfo(&rgaReg, rects->src.width, rects->src.height,
+                                    rects->src.xoffset, rects->src.yoffset);
+    RkRgaSetDstActiveInfo(&rgaReg, frameW, frameH, xOff, yOff);
+
+    ret = RkRgaSetBitbltMode(&rgaReg, RkRgaScaleModeOf(rects->src.width,
+                    rects->src.height, frameW, frameH), BB_ROTATE, angle,
+                    RkRgaDitherOf(rects->src.format, rects->dst.format), 0, 0);
+    if (ret) {
+        ALOGE("rotate %d degree, scale %dx%d=>%dx%d not support", angle,
+                    rects->src.width, rects->src.height, frameW, frameH);
+        return -EINVAL;
+    }
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+
+    return ret;
+}
+
+int RockchipRga::RkRgaRotate(buffer_handle_t src, buffer_handle_t dst,
+                                    drm_rga_t *rects, int angle, int blend)
+{
+    Mutex::Autolock lock(mMutex);
+
+    drm_rga_t relRects;
+    void *srcBuf = NULL;
+    void *dstBuf = NULL;
+    int ret;
+
+    ret = RkRgaGetRects(src, dst, NULL, NULL, &relRects);
+    if (ret && !rects) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects && rects->src.wstride > 0)
+        memcpy(&relRects.src, &rects->src, sizeof(rga_rect_t));
+    if (rects && rects->dst.wstride > 0)
+        memcpy(&relRects.dst, &rects->dst, sizeof(rga_rect_t));
+
+    RkRgaGetHandleMapAddress(src, &srcBuf);
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!srcBuf || !dstBuf) {
+        ALOGE("%d:Has not address for render", __LINE__);
+        return -EINVAL;
+    }
+
+    RkRgaSyncForDevice(src, false);
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaRotateBuffers(srcBuf, dstBuf, &relRects, angle, blend);
+    RkRgaSyncDeviceDone(src);
+    RkRgaSyncDeviceDone(dst);
+
+    return ret;
+}
+
+int RockchipRga::RkRgaRotate(void *src, void *dst,
+                                    drm_rga_t *rects, int angle, int blend)
+{
+    Mutex::Autolock lock(mMutex);
+
+    if (!src || !dst || !rects ||
+                    rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects or buffers for render", __LINE__);
+        return -EINVAL;
+    }
+
+    return RkRgaRotateBuffers(src, dst, rects, angle, blend);
+}
+
+int RockchipRga::RkRgaFilterBuffers(void *srcBuf, void *dstBuf,
+                drm_rga_t *rects, int mode, int intensity, int dither)
+{
+    struct rga_req rgaReg;
+    RECT clip;
+    int ret;
+
+    if (mode != DRM_RGA_FILTER_BLUR && mode != DRM_RGA_FILTER_SHARPEN)
+        return -EINVAL;
+    if (intensity < 0 || intensity > 3)
+        return -EINVAL;
+
+    if (rects->src.width <= 0 || rects->src.height <= 0 ||
+            rects->src.width != rects->dst.width ||
+            rects->src.height != rects->dst.height) {
+        ALOGE("filter %dx%d=>%dx%d not support", rects->src.width,
+                rects->src.height, rects->dst.width, rects->dst.height);
+        return -EINVAL;
+    }
+
+    clip.xmin = rects->dst.xoffset;
+    clip.xmax = rects->dst.xoffset + rects->dst.width - 1;
+    clip.ymin = rects->dst.yoffset;
+    clip.ymax = rects->dst.yoffset + rects->dst.height - 1;
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    RkRgaSetImages(&rgaReg, srcBuf, &rects->src, dstBuf, &rects->dst, &clip);
+    RkRgaSetSrcActiveInfo(&rgaReg, rects->src.width, rects->src.height,
+                                    rects->src.xoffset, rects->src.yoffset);
+    RkRgaSetDstActiveInfo(&rgaReg, rects->dst.width, rects->dst.height,
+                                    rects->dst.xoffset, rects->dst.yoffset);
+    RkRgaSetBlurSharpFilterMode(&rgaReg, mode, intensity, dither ? 1 : 0);
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+
+    return ret;
+}
+
+int RockchipRga::RkRgaFilter(buffer_handle_t src, buffer_handle_t dst,
+                    drm_rga_t *rects, int mode, int intensity, int dither)
+{
+    Mutex::Autolock lock(mMutex);
+
+    drm_rga_t relRects;
+    void *srcBuf = NULL;
+    void *dstBuf = NULL;
+    int ret;
+
+    ret = RkRgaGetRects(src, dst, NULL, NULL, &relRects);
+    if (ret && !rects) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects && rects->src.wstride > 0)
+        memcpy(&relRects.src, &rects->src, sizeof(rga_rect_t));
+    if (rects && rects->dst.wstride > 0)
+        memcpy(&relRects.dst, &rects->dst, sizeof(rga_rect_t));
+
+    RkRgaGetHandleMapAddress(src, &srcBuf);
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!srcBuf || !dstBuf) {
+        ALOGE("%d:Has not address for render", __LINE__);
+        return -EINVAL;
+    }
+
+    RkRgaSyncForDevice(src, false);
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaFilterBuffers(srcBuf, dstBuf, &relRects, mode, intensity, dither);
+    RkRgaSyncDeviceDone(src);
+    RkRgaSyncDeviceDone(dst);
+
+    return ret;
+}
+
+int RockchipRga::RkRgaFilter(void *src, void *dst,
+                    drm_rga_t *rects, int mode, int intensity, int dither)
+{
+    Mutex::Autolock lock(mMutex);
+
+    if (!src || !dst || !rects ||
+                    rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects or buffers for render", __LINE__);
+        return -EINVAL;
+    }
+
+    return RkRgaFilterBuffers(src, dst, rects, mode, intensity, dither);
+}
+
+/*
+ * Run requests in order on one core: all but the last go with
+ * RGA_BLIT_ASYNC and the final RGA_BLIT_SYNC returns once the core has
+ * drained them. With DRM_RGA_ENGINE_AUTO the batch stays on the core if
+ * the cost model sends every request there. Batches no single core can
+ * take, or that go to the cpu or are split by the hybrid engine, run one
+ * by one.
+ */
+int RockchipRga::RkRgaSubmitBatch(struct rga_req *reqs, int count)
+{
+    RockchipRgaDevice *dev = NULL;
+    int engine = mEngine;
+    std::vector<int> engines;
+    bool batch = true;
+    double predicted;
+    int layout, ret = 0;
+
+    if (count <= 0)
+        return 0;
+
+    RkRgaProbe();
+    layout = RockchipRgaDevice::layoutOf(mVersion);
+
+    for (size_t i = 0; i < mDevices.size(); i++) {
+        bool all = engine == DRM_RGA_ENGINE_HW || engine == DRM_RGA_ENGINE_AUTO;
+
+        for (int j = 0; j < count && all; j++)
+            all = mDevices[i]->supports(&reqs[j], layout);
+        if (all && (!dev || mDevices[i]->depth() < dev->depth()))
+            dev = mDevices[i];
+    }
+
+    /* chosen once per request, the one by one path must not ask again */
+    if (engine == DRM_RGA_ENGINE_AUTO && dev) {
+        engines.resize(count);
+        for (int j = 0; j < count; j++) {
+            engines[j] = RkRgaChooseEngine(&reqs[j], dev, &predicted);
+            batch &= engines[j] == DRM_RGA_ENGINE_HW;
+        }
+    }
+
+    if (!dev || !batch) {
+        for (int i = 0; i < count && !ret; i++)
+            ret = RkRgaSubmitOn(&reqs[i], RGA_BLIT_SYNC,
+                                    engines.empty() ? engine : engines[i]);
+        return ret;
+    }
+
+    mMutex.unlock();
+    for (int i = 0; i < count && !ret; i++)
+        ret = dev->blit(&reqs[i], i < count - 1 ? RGA_BLIT_ASYNC : RGA_BLIT_SYNC);
+    mMutex.lock();
+
+    if (ret)
+        errno = -ret;
+    return ret;
+}
+
+/* 0xAARRGGBB to the RGBA memory order of fg_color */
+static inline unsigned int rgaFillColor(unsigned int argb)
+{
+    return (argb & 0xff00ff00) | ((argb >> 16) & 0xff) | ((argb & 0xff) << 16);
+}
+
+int RockchipRga::RkRgaFillBuffer(void *dstBuf, const rga_rect_t *rect,
+                                            const rga_fill_t *fills, int count)
+{
+    std::vector<struct rga_req> reqs;
+    COLOR_FILL gradient;
+    RECT clip;
+
+    if (!dstBuf || !rect || rect->wstride <= 0 || (count > 0 && !fills))
+        return -EINVAL;
+
+    /* fills are relative to the rect, the clip is absolute to the rga */
+    clip.xmin = rect->xoffset;
+    clip.xmax = rect->xoffset + rect->width - 1;
+    clip.ymin = rect->yoffset;
+    clip.ymax = rect->yoffset + rect->height - 1;
+
+    memset(&gradient, 0, sizeof(COLOR_FILL));
+    reqs.reserve(count);
+
+    for (int i = 0; i < count; i++) {
+        const rga_fill_t *fill = &fills[i];
+        int x0 = fill->x > 0 ? fill->x : 0;
+        int y0 = fill->y > 0 ? fill->y : 0;
+        int x1 = fill->x + fill->width;
+        int y1 = fill->y + fill->height;
+        struct rga_req req;
+        unsigned int color = rgaFillColor(fill->color);
+
+        /* clip to the rect, the gradient still starts at the fill origin */
+        x1 = x1 < rect->width ? x1 : rect->width;
+        y1 = y1 < rect->height ? y1 : rect->height;
+        if (x1 <= x0 || y1 <= y0)
+            continue;
+
+        if (x0 != fill->x || y0 != fill->y) {
+            unsigned int shifted = 0;
+
+            for (int k = 0; k < 4; k++) {
+                int ch = (((color >> (k * 8)) & 0xff) << 8) +
+                            fill->gradX[k] * (x0 - fill->x) +
+                            fill->gradY[k] * (y0 - fill->y);
+
+                ch >>= 8;
+                shifted |= (unsigned int)(ch < 0 ? 0 : (ch > 255 ? 255 : ch)) << (k * 8);
+            }
+            color = shifted;
+        }
+
+        memset(&req, 0, sizeof(struct rga_req));
+        RkRgaSetImages(&req, NULL, NULL, dstBuf, rect, &clip);
+        RkRgaSetDstActiveInfo(&req, x1 - x0, y1 - y0,
+                                rect->xoffset + x0, rect->yoffset + y0);
+        RkRgaSetColorFillMode(&req, &gradient, 1, 0, color, 0, 0, 0, 0, 0);
+
+        req.gr_color.gr_x_r = fill->gradX[0];
+        req.gr_color.gr_x_g = fill->gradX[1];
+        req.gr_color.gr_x_b = fill->gradX[2];
+        req.gr_color.gr_x_a = fill->gradX[3];
+        req.gr_color.gr_y_r = fill->gradY[0];
+        req.gr_color.gr_y_g = fill->gradY[1];
+        req.gr_color.gr_y_b = fill->gradY[2];
+        req.gr_color.gr_y_a = fill->gradY[3];
+
+        reqs.push_back(req);
+    }
+
+    if (reqs.empty())
+        return 0;
+
+    return RkRgaSubmitBatch(&reqs[0], reqs.size());
+}
+
+int RockchipRga::RkRgaFill(buffer_handle_t dst, rga_rect_t *rect,
+                                            const rga_fill_t *fills, int count)
+{
+    Mutex::Autolock lock(mMutex);
+
+    drm_rga_t tmpRects;
+    void *dstBuf = NULL;
+    int ret;
+
+    if (!rect || rect->wstride <= 0) {
+        ret = RkRgaGetRects(NULL, dst, NULL, NULL, &tmpRects);
+        if (ret) {
+            ALOGE("%d:Has not rects for render", __LINE__);
+            return ret;
+        }
+        rect = &tmpRects.dst;
+    }
+
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!dstBuf) {
+        ALOGE("%d:dst has not address for render", __LINE__);
+        return -EINVAL;
+    }
+
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaFillBuffer(dstBuf, rect, fills, count);
+    RkRgaSyncDeviceDone(dst);
+
+    return ret;
+}
+
+int RockchipRga::RkRgaFill(void *dst, rga_rect_t *rect,
+                                            const rga_fill_t *fills, int count)
+{
+    Mutex::Autolock lock(mMutex);
+
+    return RkRgaFillBuffer(dst, rect, fills, count);
+}
+
+/*
+ * Clip a segment to [xmin, xmax] x [ymin, ymax], the rga takes unsigned
+ * points. Returns false if nothing is left.
+ */
+static bool rgaClipLine(int *x0, int *y0, int *x1, int *y1,
+                                int xmin, int ymin, int xmax, int ymax)
+{
+    double t0 = 0.0, t1 = 1.0;
+    double dx = *x1 - *x0, dy = *y1 - *y0;
+    double p[4] = {-dx, dx, -dy, dy};
+    double q[4] = {(double)*x0 - xmin, (double)xmax - *x0,
+                   (double)*y0 - ymin, (double)ymax - *y0};
+    int sx = *x0, sy = *y0;
+
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0.0) {
+            if (q[i] < 0.0)
+                return false;
+            continue;
+        }
+
+        double t = q[i] / p[i];
+        if (p[i] < 0.0 && t > t0)
+            t0 = t;
+        else if (p[i] > 0.0 && t < t1)
+            t1 = t;
+    }
+
+    if (t0 > t1)
+        return false;
+
+    *x0 = sx + (int)floor(t0 * dx + 0.5);
+    *y0 = sy + (int)floor(t0 * dy + 0.5);
+    *x1 = sx + (int)floor(t1 * dx + 0.5);
+    *y1 = sy + (int)floor(t1 * dy + 0.5);
+
+    return true;
+}
+
+int RockchipRga::RkRgaDrawBuffer(void *dstBuf, const rga_rect_t *rect,
+                                            const rga_line_t *lines, int count)
+{
+    std::vector<struct rga_req> reqs;
+    RECT clip;
+
+    if (!dstBuf || !rect || rect->wstride <= 0 || (count > 0 && !lines))
+        return -EINVAL;
+
+    /* the rect is the clip window, points are absolute to the rga */
+    clip.xmin = rect->xoffset;
+    clip.xmax = rect->xoffset + rect->width - 1;
+    clip.ymin = rect->yoffset;
+    clip.ymax = rect->yoffset + rect->height - 1;
+
+    reqs.reserve(count);
+
+    for (int i = 0; i < count; i++) {
+        const rga_line_t *line = &lines[i];
+        int width = line->width > 0 ? line->width : 1;
+        int x0 = line->x0, y0 = line->y0, x1 = line->x1, y1 = line->y1;
+        struct rga_req req;
+        POINT sp, ep;
+
+        /* keep the part that can touch the rect and stays on the buffer */
+        if (!rgaClipLine(&x0, &y0, &x1, &y1,
+                            -(width < rect->xoffset ? width : rect->xoffset),
+                            -(width < rect->yoffset ? width : rect->yoffset),
+                            rect->width - 1 + width, rect->height - 1 + width))
+            continue;
+        x0 += rect->xoffset;
+        y0 += rect->yoffset;
+        x1 += rect->xoffset;
+        y1 += rect->yoffset;
+
+        sp.x = x0;
+        sp.y = y0;
+        ep.x = x1;
+        ep.y = y1;
+
+        memset(&req, 0, sizeof(struct rga_req));
+        RkRgaSetImages(&req, NULL, NULL, dstBuf, rect, &clip);
+        RkRgaSetDstActiveInfo(&req, rect->width, rect->height,
+                                            rect->xoffset, rect->yoffset);
+        RkRgaSetLineDrawingMode(&req, sp, ep, rgaFillColor(line->color),
+                                                            width, 0, 1);
+        reqs.push_back(req);
+    }
+
+    if (reqs.empty())
+        return 0;
+
+    return RkRgaSubmitBatch(&reqs[0], reqs.size());
+}
+
+int RockchipRga::RkRgaDrawLines(buffer_handle_t dst, rga_rect_t *rect,
+                                            const rga_line_t *lines, int count)
+{
+    Mutex::Autolock lock(mMutex);
+
+    drm_rga_t tmpRects;
+    void *dstBuf = NULL;
+    int ret;
+
+    if (!rect || rect->wstride <= 0) {
+        ret = RkRgaGetRects(NULL, dst, NULL, NULL, &tmpRects);
+        if (ret) {
+            ALOGE("%d:Has not rects for render", __LINE__);
+            return ret;
+        }
+        rect = &tmpRects.dst;
+    }
+
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!dstBuf) {
+        ALOGE("%d:dst has not address for render", __LINE__);
+        return -EINVAL;
+    }
+
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaDrawBuffer(dstBuf, rect, lines, count);
+    RkRgaSyncDeviceDone(dst);
+
+    return ret;
+}
+
+int RockchipRga::RkRgaDrawLines(void *dst, rga_rect_t *rect,
+                                            const rga_line_t *lines, int count)
+{
+    Mutex::Autolock lock(mMutex);
+
+    return RkRgaDrawBuffer(dst, rect, lines, count);
+}
+
+/*
+ * The table stays in mPalette for the software renderer, requests point
+ * LUT_addr at a copy of it since mMutex is dropped during the blit. 1bpp
+ * takes its two colors from the request instead.
+ */
+int RockchipRga::RkRgaLoadPalette(const unsigned int *table, int mode)
+{
+    struct rga_req rgaReg;
+    int ret;
+
+    if (mode < DRM_RGA_PALETTE_BPP1 || mode > DRM_RGA_PALETTE_BPP8 || !table)
+        return -EINVAL;
+
+    memcpy(mPalette, table, sizeof(unsigned int) << (1 << mode));
+    mPaletteMode = mode;
+    if (mode == DRM_RGA_PALETTE_BPP1)
+        return 0;
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+#if defined(__arm64__) || defined(__aarch64__)
+    RkRgaUpdatePaletteTableMode(&rgaReg, (unsigned long)table, mode);
+#else
+    RkRgaUpdatePaletteTableMode(&rgaReg, (unsigned int)table, mode);
+#endif
+    /* the table is translated by the mmu like the images, bit 11 */
+    RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
+    rgaReg.mmu_info.mmu_flag |= (0x1 << 31) | (0x1 << 11);
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+
+    return ret;
+}
+
+int RockchipRga::RkRgaSetPalette(const unsigned int *colors, int count)
+{
+    Mutex::Autolock lock(mMutex);
+
+    unsigned int table[256];
+    int mode;
+
+    for (mode = DRM_RGA_PALETTE_BPP1; mode <= DRM_RGA_PALETTE_BPP8; mode++)
+        if (count == 1 << (1 << mode))
+            break;
+    if (mode > DRM_RGA_PALETTE_BPP8 || !colors) {
+        ALOGE("palette of %d colors not support", count);
+        return -EINVAL;
+    }
+
+    for (int i = 0; i < count; i++)
+        table[i] = rgaFillColor(colors[i]);
+
+    return RkRgaLoadPalette(table, mode);
+}
+
+int RockchipRga::RkRgaPaletteBuffers(const void *srcBuf, void *dstBuf,
+                                                drm_rga_t *rects, int endian)
+{
+#if defined(__arm64__) || defined(__aarch64__)
+    unsigned long srcAddr = (unsigned long)srcBuf;
+#else
+    unsigned int srcAddr = (unsigned int)srcBuf;
+#endif
+    unsigned int palette[256];
+    struct rga_req rgaReg;
+    RECT clip;
+    int ret;
+
+    if (mPaletteMode < 0) {
+        ALOGE("%d:Has not palette for render", __LINE__);
+        return -EINVAL;
+    }
+
+    if (rects->src.width <= 0 || rects->src.height <= 0 ||
+            rects->src.width != rects->dst.width ||
+            rects->src.height != rects->dst.height) {
+        ALOGE("palette %dx%d=>%dx%d not support", rects->src.width,
+                rects->src.height, rects->dst.width, rects->dst.height);
+        return -EINVAL;
+    }
+
+    clip.xmin = rects->dst.xoffset;
+    clip.xmax = rects->dst.xoffset + rects->dst.width - 1;
+    clip.ymin = rects->dst.yoffset;
+    clip.ymax = rects->dst.yoffset + rects->dst.height - 1;
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    /* the indexed src has no hal format, RkRgaSetImages only takes dst */
+    RkRgaSetImages(&rgaReg, NULL, NULL, dstBuf, &rects->dst, &clip);
+    if (mVersion < 2.0)
+        RkRgaSetSrcVirtualInfo(&rgaReg, srcAddr, 0, 0,
+                                    rects->src.wstride, rects->src.height,
+                                    RK_FORMAT_BPP1 + mPaletteMode, 0);
+    else
+        RkRgaSetSrcVirtualInfo(&rgaReg, 0, srcAddr, 0,
+                                    rects->src.wstride, rects->src.height,
+                                    RK_FORMAT_BPP1 + mPaletteMode, 0);
+    RkRgaMmuFlag(&rgaReg, 1, 1);
+    rgaReg.mmu_info.mmu_flag |= (0x1 << 11);
+
+    RkRgaSetSrcActiveInfo(&rgaReg, rects->src.width, rects->src.height,
+                                    rects->src.xoffset, rects->src.yoffset);
+    RkRgaSetDstActiveInfo(&rgaReg, rects->dst.width, rects->dst.height,
+                                    rects->dst.xoffset, rects->dst.yoffset);
+    RkRgaSetColorPaletteMode(&rgaReg, mPaletteMode, endian & 0x1,
+                                                mPalette[0], mPalette[1]);
+    memcpy(palette, mPalette, sizeof(unsigned int) << (1 << mPaletteMode));
+#if defined(__arm64__) || defined(__aarch64__)
+    rgaReg.LUT_addr = (unsigned long)palette;
+#else
+    rgaReg.LUT_addr = (unsigned int)palette;
+#endif
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+
+    return ret;
+}
+
+int RockchipRga::RkRgaPaletteBlit(const void *src, buffer_handle_t dst,
+                                                drm_rga_t *rects, int endian)
+{
+    Mutex::Autolock lock(mMutex);
+
+    drm_rga_t relRects;
+    void *dstBuf = NULL;
+    int ret;
+
+    ret = RkRgaGetRects(NULL, dst, NULL, NULL, &relRects);
+    if (ret && !rects) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects && rects->dst.wstride > 0)
+        memcpy(&relRects.dst, &rects->dst, sizeof(rga_rect_t));
+    if (!rects || rects->src.wstride <= 0 || !src) {
+        ALOGE("%d:Has invalid src for render", __LINE__);
+        return -EINVAL;
+    }
+    memcpy(&relRects.src, &rects->src, sizeof(rga_rect_t));
+
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!dstBuf) {
+        ALOGE("%d:Has not address for render", __LINE__);
+        return -EINVAL;
+    }
+
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaPaletteBuffers(src, dstBuf, &relRects, endian);
+    RkRgaSyncDeviceDone(dst);
+
+    return ret;
+}
+
+int RockchipRga::RkRgaPaletteBlit(const void *src, void *dst,
+                                                drm_rga_t *rects, int endian)
+{
+    Mutex::Autolock lock(mMutex);
+
+    if (!src || !dst || !rects ||
+                    rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects or buffers for render", __LINE__);
+        return -EINVAL;
+    }
+
+    return RkRgaPaletteBuffers(src, dst, rects, endian);
+}
+
+/*
+ * Like the palette the pattern stays in mPattern for the software renderer,
+ * fills point pat.yrgb_addr at a copy of it.
+ */
+int RockchipRga::RkRgaSetPattern(const unsigned int *colors, int width, int height)
+{
+    Mutex::Autolock lock(mMutex);
+
+    std::vector<unsigned int> pattern;
+    struct rga_req rgaReg;
+    int ret;
+
+    if (!colors || width <= 0 || height <= 0 ||
+            width > DRM_RGA_PATTERN_MAX_SIZE || height > DRM_RGA_PATTERN_MAX_SIZE) {
+        ALOGE("pattern %dx%d not support", width, height);
+        return -EINVAL;
+    }
+
+    for (int i = 0; i < width * height; i++)
+        mPattern[i] = rgaFillColor(colors[i]);
+    mPatternWidth = width;
+    mPatternHeight = height;
+    pattern.assign(mPattern, mPattern + width * height);
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    RkRgaUpdatePattenBuffMode(&rgaReg, 0, width, height, RK_FORMAT_RGBA_8888);
+    /* pat_addr of the helper is 32 bit */
+#if defined(__arm64__) || defined(__aarch64__)
+    rgaReg.pat.yrgb_addr = (unsigned long)&pattern[0];
+#else
+    rgaReg.pat.yrgb_addr = (unsigned int)&pattern[0];
+#endif
+    RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
+    rgaReg.mmu_info.mmu_flag |= (0x1 << 31) | (0x1 << 11);
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+
+    return ret;
+}
+
+int RockchipRga::RkRgaPatternBuffer(void *dstBuf, const rga_rect_t *rect,
+                                                            int xoff, int yoff)
+{
+    std::vector<unsigned int> pattern;
+    struct rga_req rgaReg;
+    COLOR_FILL gradient;
+    RECT clip;
+    int ret;
+
+    if (!mPatternWidth) {
+        ALOGE("%d:Has not pattern for render", __LINE__);
+        return -EINVAL;
+    }
+
+    if (rect->width <= 0 || rect->height <= 0)
+        return -EINVAL;
+
+    clip.xmin = rect->xoffset;
+    clip.xmax = rect->xoffset + rect->width - 1;
+    clip.ymin = rect->yoffset;
+    clip.ymax = rect->yoffset + rect->height - 1;
+
+    /* the offsets are 8 bit in the request */
+    xoff = ((xoff % mPatternWidth) + mPatternWidth) % mPatternWidth;
+    yoff = ((yoff % mPatternHeight) + mPatternHeight) % mPatternHeight;
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+    memset(&gradient, 0, sizeof(COLOR_FILL));
+
+    RkRgaSetImages(&rgaReg, NULL, NULL, dstBuf, rect, &clip);
+    rgaReg.mmu_info.mmu_flag |= (0x1 << 11);
+    RkRgaSetDstActiveInfo(&rgaReg, rect->width, rect->height,
+                                            rect->xoffset, rect->yoffset);
+    RkRgaSetColorFillMode(&rgaReg, &gradient, 0, 1, 0, mPatternWidth,
+                                        mPatternHeight, xoff, yoff, 0);
+    RkRgaSetPatInfo(&rgaReg, mPatternWidth, mPatternHeight, xoff, yoff,
+                                                        RK_FORMAT_RGBA_8888);
+    pattern.assign(mPattern, mPattern + mPatternWidth * mPatternHeight);
+#if defined(__arm64__) || defined(__aarch64__)
+    rgaReg.pat.yrgb_addr = (unsigned long)&pattern[0];
+#else
+    rgaReg.pat.yrgb_addr = (unsigned int)&pattern[0];
+#endif
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+
+    return ret;
+}
+
+int RockchipRga::RkRgaPatternFill(buffer_handle_t dst, rga_rect_t *rect,
+                                                            int xoff, int yoff)
+{
+    Mutex::Autolock lock(mMutex);
+
+    drm_rga_t tmpRects;
+    void *dstBuf = NULL;
+    int ret;
+
+    if (!rect || rect->wstride <= 0) {
+        ret = RkRgaGetRects(NULL, dst, NULL, NULL, &tmpRects);
+        if (ret) {
+            ALOGE("%d:Has not rects for render", __LINE__);
+            return ret;
+        }
+        rect = &tmpRects.dst;
+    }
+
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!dstBuf) {
+        ALOGE("%d:dst has not address for render", __LINE__);
+        return -EINVAL;
+    }
+
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaPatternBuffer(dstBuf, rect, xoff, yoff);
+    RkRgaSyncDeviceDone(dst);
+
+    return ret;
+}
+
+int RockchipRga::RkRgaPatternFill(void *dst, rga_rect_t *rect, int xoff, int yoff)
+{
+    Mutex::Autolock lock(mMutex);
+
+    if (!dst || !rect || rect->wstride <= 0) {
+        ALOGE("%d:Has invalid rect or buffer for render", __LINE__);
+        return -EINVAL;
+    }
+
+    return RkRgaPatternBuffer(dst, rect, xoff, yoff);
+}
+
+int RockchipRga::RkRgaColorKeyBuffers(void *srcBuf, void *dstBuf,
+    drm_rga_t *rects, unsigned int keyMin, unsigned int keyMax, int flags)
+{
+    struct rga_req rgaReg;
+    RECT clip;
+    int ret;
+
+    if (!(flags & (DRM_RGA_COLORKEY_R | DRM_RGA_COLORKEY_G |
+                        DRM_RGA_COLORKEY_B | DRM_RGA_COLORKEY_A)))
+        return -EINVAL;
+
+    clip.xmin = rects->dst.xoffset;
+    clip.xmax = rects->dst.xoffset + rects->dst.width - 1;
+    clip.ymin = rects->dst.yoffset;
+    clip.ymax = rects->dst.yoffset + rects->dst.height - 1;
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    RkRgaSetImages(&rgaReg, srcBuf, &rects->src, dstBuf, &rects->dst, &clip);
+    RkRgaSetSrcActiveInfo(&rgaReg, rects->src.width, rects->src.height,
+                                    rects->src.xoffset, rects->src.yoffset);
+    RkRgaSetDstActiveInfo(&rgaReg, rects->dst.width, rects->dst.height,
+                                    rects->dst.xoffset, rects->dst.yoffset);
+    RkRgaSetSrcTransModeInfo(&rgaReg, 1,
+                        !!(flags & DRM_RGA_COLORKEY_A), !!(flags & DRM_RGA_COLORKEY_B),
+                        !!(flags & DRM_RGA_COLORKEY_G), !!(flags & DRM_RGA_COLORKEY_R),
+                        rgaFillColor(keyMin), rgaFillColor(keyMax),
+                        !!(flags & DRM_RGA_COLORKEY_ZERO));
+
+    /* after the key, the bitblt mode drops to nearest for it */
+    ret = RkRgaSetBitbltMode(&rgaReg, RGA_SCALE_NEAREST, 0, 0,
+                RkRgaDitherOf(rects->src.format, rects->dst.format), 0, 0);
+    if (ret) {
+        ALOGE("color key %dx%d=>%dx%d not support", rects->src.width,
+                rects->src.height, rects->dst.width, rects->dst.height);
+        return -EINVAL;
+    }
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+
+    return ret;
+}
+
+int RockchipRga::RkRgaColorKeyBlit(buffer_handle_t src, buffer_handle_t dst,
+    drm_rga_t *rects, unsigned int keyMin, unsigned int keyMax, int flags)
+{
+    Mutex::Autolock lock(mMutex);
+
+    drm_rga_t relRects;
+    void *srcBuf = NULL;
+    void *dstBuf = NULL;
+    int ret;
+
+    ret = RkRgaGetRects(src, dst, NULL, NULL, &relRects);
+    if (ret && !rects) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects && rects->src.wstride > 0)
+        memcpy(&relRects.src, &rects->src, sizeof(rga_rect_t));
+    if (rects && rects->dst.wstride > 0)
+        memcpy(&relRects.dst, &rects->dst, sizeof(rga_rect_t));
+
+    RkRgaGetHandleMapAddress(src, &srcBuf);
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!srcBuf || !dstBuf) {
+        ALOGE("%d:Has not address for render", __LINE__);
+        return -EINVAL;
+    }
+
+    RkRgaSyncForDevice(src, false);
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaColorKeyBuffers(srcBuf, dstBuf, &relRects, keyMin, keyMax, flags);
+    RkRgaSyncDeviceDone(src);
+    RkRgaSyncDeviceDone(dst);
+
+    return ret;
+}
+
+int RockchipRga::RkRgaColorKeyBlit(void *src, void *dst,
+    drm_rga_t *rects, unsigned int keyMin, unsigned int keyMax, int flags)
+{
+    Mutex::Autolock lock(mMutex);
+
+    if (!src || !dst || !rects ||
+                    rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects or buffers for render", __LINE__);
+        return -EINVAL;
+    }
+
+    return RkRgaColorKeyBuffers(src, dst, rects, keyMin, keyMax, flags);
+}
+
+int RockchipRga::RkRgaRopBuffers(void *srcBuf, void *dstBuf, drm_rga_t *rects,
+                            int rop, unsigned int color, const void *mask)
+{
+    bool pattern = rop & DRM_RGA_ROP_PATTERN;
+    std::vector<unsigned int> patternCopy;
+    struct rga_req rgaReg;
+    RECT clip;
+    int ret;
+
+    if (pattern && !mPatternWidth) {
+        ALOGE("%d:Has not pattern for render", __LINE__);
+        return -EINVAL;
+    }
+
+    clip.xmin = rects->dst.xoffset;
+    clip.xmax = rects->dst.xoffset + rects->dst.width - 1;
+    clip.ymin = rects->dst.yoffset;
+    clip.ymax = rects->dst.yoffset + rects->dst.height - 1;
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    RkRgaSetImages(&rgaReg, srcBuf, &rects->src, dstBuf, &rects->dst, &clip);
+    RkRgaSetSrcActiveInfo(&rgaReg, rects->src.width, rects->src.height,
+                                    rects->src.xoffset, rects->src.yoffset);
+    RkRgaSetDstActiveInfo(&rgaReg, rects->dst.width, rects->dst.height,
+                                    rects->dst.xoffset, rects->dst.yoffset);
+
+    /* rop4 takes the masked out pixels through the second code, dst as is */
+    if (mask) {
+        RkRgaSetRopEnInfo(&rgaReg, 2, (DRM_RGA_ROP_DSTCOPY << 8) | (rop & 0xff),
+                                            pattern, rgaFillColor(color));
+#if defined(__arm64__) || defined(__aarch64__)
+        RkRgaSetRopMaskInfo(&rgaReg, (unsigned long)mask, 0);
+#else
+        RkRgaSetRopMaskInfo(&rgaReg, (unsigned int)mask, 0);
+#endif
+    } else
+        RkRgaSetRopEnInfo(&rgaReg, 1, rop & 0xff, pattern, rgaFillColor(color));
+
+    if (pattern) {
+        RkRgaSetPatInfo(&rgaReg, mPatternWidth, mPatternHeight, 0, 0,
+                                                        RK_FORMAT_RGBA_8888);
+        patternCopy.assign(mPattern, mPattern + mPatternWidth * mPatternHeight);
+#if defined(__arm64__) || defined(__aarch64__)
+        rgaReg.pat.yrgb_addr = (unsigned long)&patternCopy[0];
+#else
+        rgaReg.pat.yrgb_addr = (unsigned int)&patternCopy[0];
+#endif
+    }
+    if (mask || pattern)
+        rgaReg.mmu_info.mmu_flag |= (0x1 << 11);
+
+    ret = RkRgaSetBitbltMode(&rgaReg, RkRgaScaleModeOf(rects->src.width,
+                rects->src.height, rects->dst.width, rects->dst.height),
+                                                                0, 0, 0, 0, 0);
+    if (ret) {
+        ALOGE("rop %dx%d=>%dx%d not support", rects->src.width,
+                rects->src.height, rects->dst.width, rects->dst.height);
+        return -EINVAL;
+    }
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+
+    return ret;
+}
+
+int RockchipRga::RkRgaRopBlit(buffer_handle_t src, buffer_handle_t dst,
+        drm_rga_t *rects, int rop, unsigned int color, const void *mask)
+{
+    Mutex::Autolock lock(mMutex);
+
+    drm_rga_t relRects;
+    void *srcBuf = NULL;
+    void *dstBuf = NULL;
+    int ret;
+
+    ret = RkRgaGetRects(src, dst, NULL, NULL, &relRects);
+    if (ret && !rects) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects && rects->src.wstride > 0)
+        memcpy(&relRects.src, &rects->src, sizeof(rga_rect_t));
+    if (rects && rects->dst.wstride > 0)
+        memcpy(&relRects.dst, &rects->dst, sizeof(rga_rect_t));
+
+    RkRgaGetHandleMapAddress(src, &srcBuf);
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!srcBuf || !dstBuf) {
+        ALOGE("%d:Has not address for render", __LINE__);
+        return -EINVAL;
+    }
+
+    RkRgaSyncForDevice(src, false);
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaRopBuffers(srcBuf, dstBuf, &relRects, rop, color, mask);
+    RkRgaSyncDeviceDone(src);
+    RkRgaSyncDeviceDone(dst);
+
+    return ret;
+}
+
+int RockchipRga::RkRgaRopBlit(void *src, void *dst,
+        drm_rga_t *rects, int rop, unsigned int color, const void *mask)
+{
+    Mutex::Autolock lock(mMutex);
+
+    if (!src || !dst || !rects ||
+                    rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects or buffers for render", __LINE__);
+        return -EINVAL;
+    }
+
+    return RkRgaRopBuffers(src, dst, rects, rop, color, mask);
+}
 
-    /*mode*/
-    RkRgaSetBitbltMode(&rgaReg, scaleMode, rotateMode, orientation, ditherEn, 0, 0);
+int RockchipRga::RkRgaFadeBuffers(void *srcBuf, void *dstBuf, drm_rga_t *rects,
+                                            unsigned int color, int factor)
+{
+    struct rga_req rgaReg;
+    RECT clip;
+    int ret;
 
-    if (srcMmuFlag || dstMmuFlag) {
-        RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
-        RkRgaMmuFlag(&rgaReg, srcMmuFlag, dstMmuFlag);
+    if (factor < 0 || factor > 255)
+        return -EINVAL;
+
+    clip.xmin = rects->dst.xoffset;
+    clip.xmax = rects->dst.xoffset + rects->dst.width - 1;
+    clip.ymin = rects->dst.yoffset;
+    clip.ymax = rects->dst.yoffset + rects->dst.height - 1;
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    RkRgaSetImages(&rgaReg, srcBuf, &rects->src, dstBuf, &rects->dst, &clip);
+    RkRgaSetSrcActiveInfo(&rgaReg, rects->src.width, rects->src.height,
+                                    rects->src.xoffset, rects->src.yoffset);
+    RkRgaSetDstActiveInfo(&rgaReg, rects->dst.width, rects->dst.height,
+                                    rects->dst.xoffset, rects->dst.yoffset);
+    RkRgaSetFadingEnInfo(&rgaReg, (color >> 16) & 0xff, (color >> 8) & 0xff,
+                                                                color & 0xff);
+    rgaReg.alpha_global_value = factor;
+
+    ret = RkRgaSetBitbltMode(&rgaReg, RkRgaScaleModeOf(rects->src.width,
+                rects->src.height, rects->dst.width, rects->dst.height),
+                0, 0, RkRgaDitherOf(rects->src.format, rects->dst.format), 0, 0);
+    if (ret) {
+        ALOGE("fade %dx%d=>%dx%d not support", rects->src.width,
+                rects->src.height, rects->dst.width, rects->dst.height);
+        return -EINVAL;
     }
 
-    if(ioctl(rgaFd, RGA_BLIT_SYNC, &rgaReg)) {
-        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
         ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+
+    return ret;
+}
+
+/*
+ * A plane alpha blend of from over dst is the whole cross-fade when to is
+ * dst already, otherwise a copy of to goes first on the same core.
+ */
+int RockchipRga::RkRgaCrossFadeBuffers(void *fromBuf, void *toBuf,
+                                void *dstBuf, drm_rga_t *rects, int alpha)
+{
+    struct rga_req reqs[2];
+    struct rga_req *blend = &reqs[0];
+    int count = 1;
+    RECT clip;
+
+    if (alpha < 0 || alpha > 255)
+        return -EINVAL;
+
+    clip.xmin = rects->dst.xoffset;
+    clip.xmax = rects->dst.xoffset + rects->dst.width - 1;
+    clip.ymin = rects->dst.yoffset;
+    clip.ymax = rects->dst.yoffset + rects->dst.height - 1;
+
+    memset(reqs, 0, sizeof(reqs));
+
+    if (toBuf != dstBuf) {
+        RkRgaSetImages(&reqs[0], toBuf, &rects->dst, dstBuf, &rects->dst, &clip);
+        RkRgaSetSrcActiveInfo(&reqs[0], rects->dst.width, rects->dst.height,
+                                    rects->dst.xoffset, rects->dst.yoffset);
+        RkRgaSetDstActiveInfo(&reqs[0], rects->dst.width, rects->dst.height,
+                                    rects->dst.xoffset, rects->dst.yoffset);
+        RkRgaSetBitbltMode(&reqs[0], RGA_SCALE_NEAREST, 0, 0, 0, 0, 0);
+        blend = &reqs[1];
+        count = 2;
     }
 
-    return 0;
+    RkRgaSetImages(blend, fromBuf, &rects->src, dstBuf, &rects->dst, &clip);
+    RkRgaSetSrcActiveInfo(blend, rects->src.width, rects->src.height,
+                                    rects->src.xoffset, rects->src.yoffset);
+    RkRgaSetDstActiveInfo(blend, rects->dst.width, rects->dst.height,
+                                    rects->dst.xoffset, rects->dst.yoffset);
+    RkRgaSetAlphaEnInfo(blend, 1, 0, 255 - alpha, 0, 0, 0);
+    if (RkRgaSetBitbltMode(blend, RkRgaScaleModeOf(rects->src.width,
+                rects->src.height, rects->dst.width, rects->dst.height),
+                0, 0, RkRgaDitherOf(rects->src.format, rects->dst.format), 0, 0)) {
+        ALOGE("cross fade %dx%d=>%dx%d not support", rects->src.width,
+                rects->src.height, rects->dst.width, rects->dst.height);
+        return -EINVAL;
+    }
+
+    return RkRgaSubmitBatch(reqs, count);
 }
 
-int RockchipRga::RkRgaBlit(void *src, void *dst,
-                                      drm_rga_t *rects, int rotation, int blend)
+int RockchipRga::RkRgaFade(buffer_handle_t src, buffer_handle_t dst,
+                        drm_rga_t *rects, unsigned int color, int factor)
 {
     Mutex::Autolock lock(mMutex);
 
-    //check rects
-    //check buffer_handle_t with rects
-    int srcVirW,srcVirH,srcActW,srcActH,srcXPos,srcYPos;
-    int dstVirW,dstVirH,dstActW,dstActH,dstXPos,dstYPos;
-    int scaleMode,rotateMode,orientation,ditherEn;
-    int srcType,dstType,srcMmuFlag,dstMmuFlag;
-    int planeAlpha;
-    int dstFd = -1;
-    int srcFd = -1;
-    int ret = 0;
     drm_rga_t relRects;
-    struct rga_req rgaReg;
-    bool perpixelAlpha;
     void *srcBuf = NULL;
     void *dstBuf = NULL;
-    RECT clip;
+    int ret;
 
-    if (rects && (mLogAlways || mLogOnce)) {
-        ALOGD("Src:[%d,%d,%d,%d][%d,%d,%d]=>Dst:[%d,%d,%d,%d][%d,%d,%d]",
-            rects->src.xoffset,rects->src.yoffset,
-            rects->src.width, rects->src.height,
-            rects->src.wstride,rects->src.format, rects->src.size,
-            rects->dst.xoffset,rects->dst.yoffset,
-            rects->dst.width, rects->dst.height,
-            rects->dst.wstride,rects->dst.format, rects->dst.size);
+    ret = RkRgaGetRects(src, dst, NULL, NULL, &relRects);
+    if (ret && !rects) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
     }
 
-    memset(&rgaReg, 0, sizeof(struct rga_req));
-
-    srcType = dstType = srcMmuFlag = dstMmuFlag = 0;
+    if (rects && rects->src.wstride > 0)
+        memcpy(&relRects.src, &rects->src, sizeof(rga_rect_t));
+    if (rects && rects->dst.wstride > 0)
+        memcpy(&relRects.dst, &rects->dst, sizeof(rga_rect_t));
 
-    if (!rects) {
-        ALOGE("%d:Has not user rects for render", __LINE__);
-        return ret;
+    RkRgaGetHandleMapAddress(src, &srcBuf);
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!srcBuf || !dstBuf) {
+        ALOGE("%d:Has not address for render", __LINE__);
+        return -EINVAL;
     }
 
-    if (rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
-        ALOGE("%d:Has invalid rects for render", __LINE__);
+    RkRgaSyncForDevice(src, false);
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaFadeBuffers(srcBuf, dstBuf, &relRects, color, factor);
+    RkRgaSyncDeviceDone(src);
+    RkRgaSyncDeviceDone(dst);
+
+    return ret;
+}
+
+int RockchipRga::RkRgaFade(void *src, void *dst,
+                        drm_rga_t *rects, unsigned int color, int factor)
+{
+    Mutex::Autolock lock(mMutex);
+
+    if (!src || !dst || !rects ||
+                    rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects or buffers for render", __LINE__);
         return -EINVAL;
     }
 
-    memcpy(&relRects, rects, sizeof(drm_rga_t));
+    return RkRgaFadeBuffers(src, dst, rects, color, factor);
+}
 
-    srcBuf = src;
-    if (!srcBuf) {
-        ALOGE("%d:src has not fd and address for render", __LINE__);
-        return ret;
-    }
+int RockchipRga::RkRgaCrossFade(buffer_handle_t from, buffer_handle_t to,
+                        buffer_handle_t dst, drm_rga_t *rects, int alpha)
+{
+    Mutex::Autolock lock(mMutex);
 
-    dstBuf = dst;
-    if (!dstBuf) {
-        ALOGE("%d:dst has not fd and address for render", __LINE__);
+    drm_rga_t relRects;
+    void *fromBuf = NULL;
+    void *toBuf = NULL;
+    void *dstBuf = NULL;
+    int ret;
+
+    ret = RkRgaGetRects(from, dst, NULL, NULL, &relRects);
+    if (ret && !rects) {
+        ALOGE("%d:Has not rects for render", __LINE__);
         return ret;
     }
 
-    planeAlpha = (blend & 0xFF0000) >> 16;
-    perpixelAlpha = relRects.src.format == HAL_PIXEL_FORMAT_RGBA_8888 ||
-                    relRects.src.format == HAL_PIXEL_FORMAT_BGRA_8888;
-
-    switch ((blend & 0xFFFF)) {
-        case 0x0105:
-            if (perpixelAlpha && planeAlpha < 255)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 1, 9, 0);
-            else if (perpixelAlpha)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 1, 3, 0);
-            else
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
-            break;
-
-        case 0x0405:
-            if (perpixelAlpha && planeAlpha < 255)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 2, planeAlpha , 0, 0, 0);
-            else if (perpixelAlpha)
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 1, 0, 0, 0, 0);
-            else
-                RkRgaSetAlphaEnInfo(&rgaReg, 1, 0, planeAlpha , 0, 0, 0);
-            break;
+    if (rects && rects->src.wstride > 0)
+        memcpy(&relRects.src, &rects->src, sizeof(rga_rect_t));
+    if (rects && rects->dst.wstride > 0)
+        memcpy(&relRects.dst, &rects->dst, sizeof(rga_rect_t));
 
-        case 0x0100:
-        default:
-            /* Tips: BLENDING_NONE is non-zero value, handle zero value as
-             * BLENDING_NONE. */
-            /* C = Cs
-             * A = As */
-            break;
+    RkRgaGetHandleMapAddress(from, &fromBuf);
+    RkRgaGetHandleMapAddress(to, &toBuf);
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!fromBuf || !toBuf || !dstBuf) {
+        ALOGE("%d:Has not address for render", __LINE__);
+        return -EINVAL;
     }
 
+    RkRgaSyncForDevice(from, false);
+    if (to != dst)
+        RkRgaSyncForDevice(to, false);
+    RkRgaSyncForDevice(dst, true);
 
-    switch (rotation) {
-        case HAL_TRANSFORM_FLIP_H:
-            orientation = 0;
-            rotateMode = 2;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    ret = RkRgaCrossFadeBuffers(fromBuf, toBuf, dstBuf, &relRects, alpha);
+    RkRgaSyncDeviceDone(from);
+    if (to != dst)
+        RkRgaSyncDeviceDone(to);
+    RkRgaSyncDeviceDone(dst);
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.xoffset;
-            dstYPos = relRects.dst.yoffset;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
-            break;
-        case HAL_TRANSFORM_FLIP_V:
-            orientation = 0;
-            rotateMode = 3;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    return ret;
+}
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.xoffset;
-            dstYPos = relRects.dst.yoffset;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
-            break;
-        case HAL_TRANSFORM_ROT_90:
-            orientation = 90;
-            rotateMode = 1;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+int RockchipRga::RkRgaCrossFade(void *from, void *to, void *dst,
+                                            drm_rga_t *rects, int alpha)
+{
+    Mutex::Autolock lock(mMutex);
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.width - 1;
-            //dstYPos = relRects.dst.yoffset;
-            dstYPos = 0;
-            dstActW = relRects.dst.height;
-            dstActH = relRects.dst.width;
-            break;
-        case HAL_TRANSFORM_ROT_180:
-            orientation = 180;
-            rotateMode = 1;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    if (!from || !to || !dst || !rects ||
+                    rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects or buffers for render", __LINE__);
+        return -EINVAL;
+    }
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.width - 1;
-            dstYPos = relRects.dst.height - 1;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
-            break;
-        case HAL_TRANSFORM_ROT_270:
-            orientation = 270;
-            rotateMode = 1;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+    return RkRgaCrossFadeBuffers(from, to, dst, rects, alpha);
+}
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            //dstXPos = relRects.dst.xoffset;
-            dstXPos = 0;
-            dstYPos = relRects.dst.height - 1;
-            dstActW = relRects.dst.height;
-            dstActH = relRects.dst.width;
-            break;
-        default:
-            orientation = 0;
-            rotateMode = 0;
-            srcVirW = relRects.src.wstride;
-            srcVirH = relRects.src.height;
-            srcXPos = relRects.src.xoffset;
-            srcYPos = relRects.src.yoffset;
-            srcActW = relRects.src.width;
-            srcActH = relRects.src.height;
+int RockchipRga::RkRgaDecimateBuffers(void *srcBuf, void *dstBuf,
+                                            drm_rga_t *rects, int factor)
+{
+    struct rga_req rgaReg;
+    RECT clip;
+    int ret;
 
-            dstVirW = relRects.dst.wstride;
-            dstVirH = relRects.dst.height;
-            dstXPos = relRects.dst.xoffset;
-            dstYPos = relRects.dst.yoffset;
-            dstActW = relRects.dst.width;
-            dstActH = relRects.dst.height;
-            break;
+    if ((factor != 2 && factor != 4 && factor != 8) ||
+            rects->src.width != rects->dst.width * factor ||
+            rects->src.height != rects->dst.height * factor) {
+        ALOGE("decimate %dx%d=>%dx%d not by %d", rects->src.width,
+                rects->src.height, rects->dst.width, rects->dst.height, factor);
+        return -EINVAL;
     }
 
-    clip.xmin = 0;
-    clip.xmax = dstActW - 1;
-    clip.ymin = 0;
-    clip.ymax = dstActH - 1;
+    clip.xmin = rects->dst.xoffset;
+    clip.xmax = rects->dst.xoffset + rects->dst.width - 1;
+    clip.ymin = rects->dst.yoffset;
+    clip.ymax = rects->dst.yoffset + rects->dst.height - 1;
+
+    memset(&rgaReg, 0, sizeof(struct rga_req));
+
+    RkRgaSetImages(&rgaReg, srcBuf, &rects->src, dstBuf, &rects->dst, &clip);
+    RkRgaSetSrcActiveInfo(&rgaReg, rects->src.width, rects->src.height,
+                                    rects->src.xoffset, rects->src.yoffset);
+    RkRgaSetDstActiveInfo(&rgaReg, rects->dst.width, rects->dst.height,
+                                    rects->dst.xoffset, rects->dst.yoffset);
+    RkRgaSetPreScalingMode(&rgaReg,
+                        RkRgaDitherOf(rects->src.format, rects->dst.format));
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
 
-    //scale up use bicubic
-    if (srcActW / dstActW < 1 || srcActH / dstActH < 1)
-        scaleMode = 2;
+    return ret;
+}
 
-    /*
-    if (scaleMode && (srcFormat == RK_FORMAT_RGBA_8888 ||
-                                            srcFormat == RK_FORMAT_BGRA_8888)) {
-        scale_mode = 0;     //  force change scale_mode to 0 ,for rga not support
-    }*/
+int RockchipRga::RkRgaDecimate(buffer_handle_t src, buffer_handle_t dst,
+                                            drm_rga_t *rects, int factor)
+{
+    Mutex::Autolock lock(mMutex);
 
-    ditherEn = (android::bytesPerPixel(relRects.src.format) 
-                        != android::bytesPerPixel(relRects.src.format) ? 1 : 0);
+    drm_rga_t relRects;
+    void *srcBuf = NULL;
+    void *dstBuf = NULL;
+    int ret;
 
-    if (mVersion <= 1.003) {
-        srcMmuFlag = dstMmuFlag = 1;
+    ret = RkRgaGetRects(src, dst, NULL, NULL, &relRects);
+    if (ret && !rects) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
+    }
 
-#if defined(__arm64__) || defined(__aarch64__)
-        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
-                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#else
-        RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
-                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#endif
-    } else if (mVersion < 2.0) {
-        /*Src*/
-        if (srcFd != -1) {
-            srcMmuFlag = srcType ? 1 : 0;
-            RkRgaSetSrcVirtualInfo(&rgaReg, 0, 0, 0, srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-            RkRgaSetFdsOffsets(&rgaReg, srcFd, 0, 0, 0);
-        } else {
-            srcMmuFlag = 1;
+    if (rects && rects->src.wstride > 0)
+        memcpy(&relRects.src, &rects->src, sizeof(rga_rect_t));
+    if (rects && rects->dst.wstride > 0)
+        memcpy(&relRects.dst, &rects->dst, sizeof(rga_rect_t));
 
-#if defined(__arm64__) || defined(__aarch64__)
-            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned long)srcBuf,
-                                        (unsigned long)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned long)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-#else
-            RkRgaSetSrcVirtualInfo(&rgaReg, (unsigned int)srcBuf,
-                                        (unsigned int)srcBuf + srcVirW * srcVirH, 
-                                        (unsigned int)srcBuf + srcVirW * srcVirH * 5/4,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-#endif
-        }
-        /*dst*/
-        if (dstFd != -1) {
-            dstMmuFlag = srcType ? 1 : 0;
-            RkRgaSetDstVirtualInfo(&rgaReg, 0, 0, 0, dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-    	    /*src dst fd*/
-            RkRgaSetFdsOffsets(&rgaReg, 0, dstFd, 0, 0);
-        } else {
-            dstMmuFlag = 1;
-#if defined(__arm64__) || defined(__aarch64__)
-            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned long)dstBuf,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#else
-            RkRgaSetDstVirtualInfo(&rgaReg, (unsigned int)dstBuf,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH * 5/4,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#endif
-        }
-    } else {
-        srcMmuFlag = ((srcFd != -1 && srcType) || srcFd == -1) ? 1 : 0;
-        dstMmuFlag = ((dstFd != -1 && dstType) || dstFd == -1) ? 1 : 0;
-#if defined(__arm64__) || defined(__aarch64__)
-        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
-                                        (unsigned long)srcBuf, 
-                                        (unsigned long)srcBuf + srcVirW * srcVirH,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
-                                        (unsigned long)dstBuf,
-                                        (unsigned long)dstBuf + dstVirW * dstVirH,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#else
-        RkRgaSetSrcVirtualInfo(&rgaReg, srcFd != -1 ? srcFd : 0,
-                                        (unsigned int)srcBuf, 
-                                        (unsigned int)srcBuf + srcVirW * srcVirH,
-                                        srcVirW, srcVirH,
-                                        RkRgaGetRgaFormat(relRects.src.format),0);
-        /*dst*/
-        RkRgaSetDstVirtualInfo(&rgaReg, dstFd != -1 ? dstFd : 0,
-                                        (unsigned int)dstBuf,
-                                        (unsigned int)dstBuf + dstVirW * dstVirH,
-                                        dstVirW, dstVirH, &clip,
-                                        RkRgaGetRgaFormat(relRects.dst.format),0);
-#endif
+    RkRgaGetHandleMapAddress(src, &srcBuf);
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!srcBuf || !dstBuf) {
+        ALOGE("%d:Has not address for render", __LINE__);
+        return -EINVAL;
     }
 
-    RkRgaSetSrcActiveInfo(&rgaReg, srcActW, srcActH, srcXPos, srcYPos);
-    RkRgaSetDstActiveInfo(&rgaReg, dstActW, dstActH, dstXPos, dstYPos);
+    RkRgaSyncForDevice(src, false);
+    RkRgaSyncForDevice(dst, true);
 
-    /*mode*/
-    RkRgaSetBitbltMode(&rgaReg, scaleMode, rotateMode, orientation, ditherEn, 0, 0);
+    ret = RkRgaDecimateBuffers(srcBuf, dstBuf, &relRects, factor);
+    RkRgaSyncDeviceDone(src);
+    RkRgaSyncDeviceDone(dst);
 
-    if (srcMmuFlag || dstMmuFlag) {
-        RkRgaMmuInfo(&rgaReg, 1, 0, 0, 0, 0, 2);
-        RkRgaMmuFlag(&rgaReg, srcMmuFlag, dstMmuFlag);
-    }
+    return ret;
+}
 
-    if(ioctl(rgaFd, RGA_BLIT_SYNC, &rgaReg)) {
-        printf(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
-        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
-    }
+int RockchipRga::RkRgaDecimate(void *src, void *dst, drm_rga_t *rects, int factor)
+{
+    Mutex::Autolock lock(mMutex);
 
-    if (mLogOnce)
-        mLogOnce = 0;
+    if (!src || !dst || !rects ||
+                    rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects or buffers for render", __LINE__);
+        return -EINVAL;
+    }
 
-    return 0;
+    return RkRgaDecimateBuffers(src, dst, rects, factor);
 }
 
 void RockchipRga::RkRgaLogOutRgaReq(struct rga_req rgaReg)
@@ -1789,19 +4260,229 @@ void RockchipRga::RkRgaLogOutRgaReq(struct rga_req rgaReg)
     return;
 }
 
-int RockchipRga::RkRgaScale()
+/*
+ * The dedicated paths fill only what their operation needs: the images, the
+ * two active rects and the bitblt mode. path says which of format, size and
+ * orientation may change; anything else has to match, or the request fails
+ * instead of quietly doing more than asked.
+ */
+int RockchipRga::RkRgaPathRequest(struct rga_req *req, void *srcBuf,
+                    void *dstBuf, drm_rga_t *rects, int rotation, int path)
 {
-    return 1;
+    RECT clip;
+    int dstActW, dstActH, dstXPos, dstYPos;
+    int rotateMode = BB_BYPASS;
+    int orientation = 0;
+    int scaleMode = 0;
+    int ditherEn = 0;
+    int ret;
+
+    if (!srcBuf || !dstBuf || !rects ||
+                    rects->src.wstride <= 0 || rects->dst.wstride <= 0) {
+        ALOGE("%d:Has invalid rects or buffers for render", __LINE__);
+        return -EINVAL;
+    }
+
+    if (rects->src.width <= 0 || rects->src.height <= 0 ||
+                        rects->dst.width <= 0 || rects->dst.height <= 0)
+        return -EINVAL;
+
+    if (!(path & PATH_CONVERT) && rects->src.format != rects->dst.format)
+        return -EINVAL;
+
+    dstActW = rects->dst.width;
+    dstActH = rects->dst.height;
+    dstXPos = rects->dst.xoffset;
+    dstYPos = rects->dst.yoffset;
+
+    /* rotated, the active rect is in src orientation around a dst corner */
+    switch (path & PATH_ROTATE ? rotation : 0) {
+        case 0:
+            break;
+        case HAL_TRANSFORM_FLIP_H:
+            rotateMode = BB_X_MIRROR;
+            break;
+        case HAL_TRANSFORM_FLIP_V:
+            rotateMode = BB_Y_MIRROR;
+            break;
+        case HAL_TRANSFORM_ROT_90:
+            rotateMode = BB_ROTATE;
+            orientation = 90;
+            dstActW = rects->dst.height;
+            dstActH = rects->dst.width;
+            dstXPos += rects->dst.width - 1;
+            break;
+        case HAL_TRANSFORM_ROT_180:
+            rotateMode = BB_ROTATE;
+            orientation = 180;
+            dstXPos += rects->dst.width - 1;
+            dstYPos += rects->dst.height - 1;
+            break;
+        case HAL_TRANSFORM_ROT_270:
+            rotateMode = BB_ROTATE;
+            orientation = 270;
+            dstActW = rects->dst.height;
+            dstActH = rects->dst.width;
+            dstYPos += rects->dst.height - 1;
+            break;
+        default:
+            return -EINVAL;
+    }
+
+    if (path & PATH_SCALE)
+        scaleMode = RkRgaScaleModeOf(rects->src.width, rects->src.height,
+                                                        dstActW, dstActH);
+    else if (rects->src.width != dstActW || rects->src.height != dstActH)
+        return -EINVAL;
+
+    if (path & PATH_CONVERT)
+        ditherEn = RkRgaDitherOf(rects->src.format, rects->dst.format);
+
+    clip.xmin = rects->dst.xoffset;
+    clip.xmax = rects->dst.xoffset + rects->dst.width - 1;
+    clip.ymin = rects->dst.yoffset;
+    clip.ymax = rects->dst.yoffset + rects->dst.height - 1;
+
+    memset(req, 0, sizeof(struct rga_req));
+
+    RkRgaSetImages(req, srcBuf, &rects->src, dstBuf, &rects->dst, &clip);
+    RkRgaSetSrcActiveInfo(req, rects->src.width, rects->src.height,
+                                    rects->src.xoffset, rects->src.yoffset);
+    RkRgaSetDstActiveInfo(req, dstActW, dstActH, dstXPos, dstYPos);
+
+    ret = RkRgaSetBitbltMode(req, scaleMode, rotateMode, orientation,
+                                                            ditherEn, 0, 0);
+    if (ret) {
+        ALOGE("scale %dx%d=>%dx%d not support", rects->src.width,
+                                    rects->src.height, dstActW, dstActH);
+        return -EINVAL;
+    }
+
+    return 0;
 }
 
-int RockchipRga::RkRgaRoate()
+int RockchipRga::RkRgaPathBuffers(void *srcBuf, void *dstBuf,
+                                drm_rga_t *rects, int rotation, int path)
 {
-    return 1;
+    struct rga_req rgaReg;
+    int ret;
+
+    ret = RkRgaPathRequest(&rgaReg, srcBuf, dstBuf, rects, rotation, path);
+    if (ret)
+        return ret;
+
+    ret = RkRgaSubmit(&rgaReg, RGA_BLIT_SYNC);
+    if (ret)
+        ALOGE(" %s(%d) RGA_BLIT fail: %s",__FUNCTION__, __LINE__,strerror(errno));
+
+    return ret;
 }
 
-int RockchipRga::RkRgaRoateScale()
+int RockchipRga::RkRgaPathBlit(buffer_handle_t src, buffer_handle_t dst,
+                                    drm_rga_t *rects, int rotation, int path)
 {
-    return 1;
+    drm_rga_t relRects;
+    void *srcBuf = NULL;
+    void *dstBuf = NULL;
+    int ret;
+
+    ret = RkRgaGetRects(src, dst, NULL, NULL, &relRects);
+    if (ret && !rects) {
+        ALOGE("%d:Has not rects for render", __LINE__);
+        return ret;
+    }
+
+    if (rects && rects->src.wstride > 0)
+        memcpy(&relRects.src, &rects->src, sizeof(rga_rect_t));
+    if (rects && rects->dst.wstride > 0)
+        memcpy(&relRects.dst, &rects->dst, sizeof(rga_rect_t));
+
+    RkRgaGetHandleMapAddress(src, &srcBuf);
+    RkRgaGetHandleMapAddress(dst, &dstBuf);
+    if (!srcBuf || !dstBuf) {
+        ALOGE("%d:Has not address for render", __LINE__);
+        return -EINVAL;
+    }
+
+    RkRgaSyncForDevice(src, false);
+    RkRgaSyncForDevice(dst, true);
+
+    ret = RkRgaPathBuffers(srcBuf, dstBuf, &relRects, rotation, path);
+    RkRgaSyncDeviceDone(src);
+    RkRgaSyncDeviceDone(dst);
+
+    return ret;
+}
+
+int RockchipRga::RkRgaCopy(buffer_handle_t src, buffer_handle_t dst,
+                                                        drm_rga_t *rects)
+{
+    Mutex::Autolock lock(mMutex);
+    return RkRgaPathBlit(src, dst, rects, 0, PATH_COPY);
+}
+
+int RockchipRga::RkRgaCopy(void *src, void *dst, drm_rga_t *rects)
+{
+    Mutex::Autolock lock(mMutex);
+    return RkRgaPathBuffers(src, dst, rects, 0, PATH_COPY);
+}
+
+int RockchipRga::RkRgaConvert(buffer_handle_t src, buffer_handle_t dst,
+                                                        drm_rga_t *rects)
+{
+    Mutex::Autolock lock(mMutex);
+    return RkRgaPathBlit(src, dst, rects, 0, PATH_CONVERT);
+}
+
+int RockchipRga::RkRgaConvert(void *src, void *dst, drm_rga_t *rects)
+{
+    Mutex::Autolock lock(mMutex);
+    return RkRgaPathBuffers(src, dst, rects, 0, PATH_CONVERT);
+}
+
+int RockchipRga::RkRgaScale(buffer_handle_t src, buffer_handle_t dst,
+                                                        drm_rga_t *rects)
+{
+    Mutex::Autolock lock(mMutex);
+    return RkRgaPathBlit(src, dst, rects, 0, PATH_CONVERT | PATH_SCALE);
+}
+
+int RockchipRga::RkRgaScale(void *src, void *dst, drm_rga_t *rects)
+{
+    Mutex::Autolock lock(mMutex);
+    return RkRgaPathBuffers(src, dst, rects, 0, PATH_CONVERT | PATH_SCALE);
+}
+
+int RockchipRga::RkRgaRoate(buffer_handle_t src, buffer_handle_t dst,
+                                            drm_rga_t *rects, int rotation)
+{
+    Mutex::Autolock lock(mMutex);
+    return RkRgaPathBlit(src, dst, rects, rotation,
+                                            PATH_CONVERT | PATH_ROTATE);
+}
+
+int RockchipRga::RkRgaRoate(void *src, void *dst,
+                                            drm_rga_t *rects, int rotation)
+{
+    Mutex::Autolock lock(mMutex);
+    return RkRgaPathBuffers(src, dst, rects, rotation,
+                                            PATH_CONVERT | PATH_ROTATE);
+}
+
+int RockchipRga::RkRgaRoateScale(buffer_handle_t src, buffer_handle_t dst,
+                                            drm_rga_t *rects, int rotation)
+{
+    Mutex::Autolock lock(mMutex);
+    return RkRgaPathBlit(src, dst, rects, rotation,
+                                PATH_CONVERT | PATH_SCALE | PATH_ROTATE);
+}
+
+int RockchipRga::RkRgaRoateScale(void *src, void *dst,
+                                            drm_rga_t *rects, int rotation)
+{
+    Mutex::Autolock lock(mMutex);
+    return RkRgaPathBuffers(src, dst, rects, rotation,
+                                PATH_CONVERT | PATH_SCALE | PATH_ROTATE);
 }
 
 /**********************************************************************
@@ -1891,6 +4572,8 @@ int RockchipRga::RkRgaGetRgaFormat(int format)
         case HAL_PIXEL_FORMAT_YCrCb_NV12_10:
             return RK_FORMAT_YCbCr_420_SP_10B;
 #endif
+        case DRM_RGA_FORMAT_YCbCr_P010:
+            return RGA_FORMAT_YCbCr_420_SP_P010;
         default:
             return -1;
     }
@@ -2062,8 +4745,8 @@ int RockchipRga::RkRgaSetFadingEnInfo(struct rga_req *msg,
 
 int RockchipRga::RkRgaSetSrcTransModeInfo(struct rga_req *msg,
 		unsigned char trans_mode,unsigned char a_en,unsigned char b_en,
-		unsigned char g_en,unsigned char r_en,unsigned char color_key_min,
-		unsigned char color_key_max,unsigned char zero_mode_en
+		unsigned char g_en,unsigned char r_en,unsigned int color_key_min,
+		unsigned int color_key_max,unsigned char zero_mode_en
 		)
 {
     msg->src_trans_mode = ((a_en & 1) << 4) | ((b_en & 1) << 3) | 
@@ -2094,8 +4777,8 @@ int RockchipRga::RkRgaSetBitbltMode(struct rga_req *msg,
     msg->scale_mode = scale_mode;
     msg->rotate_mode = rotate_mode;
     
-    msg->sina = sina_table[angle];
-    msg->cosa = cosa_table[angle];
+    msg->sina = rgaSinaTable[angle];
+    msg->cosa = rgaCosaTable[angle];
 
     msg->yuv2rgb_mode = yuv2rgb_mode;
 
@@ -2125,10 +4808,18 @@ int RockchipRga::RkRgaSetBitbltMode(struct rga_req *msg,
         }        
     }
    
+    /* a filter would blend the key color into the pixels around it */
     if (msg->src_trans_mode)
         msg->scale_mode = 0;
 
     msg->alpha_rop_flag |= (dither_en << 5);
+
+    if (RockchipRgaCpu::is10Bit(msg->src.format))
+        msg->yuv2rgb_mode |= mDepthMode << 6;
+
+    /* library only, the device clears it and dithers ordered */
+    if (dither_en && mDitherMode == DRM_RGA_DITHER_DIFFUSION)
+        msg->dither_mode = 1;
     
     return 0;
 }
@@ -2328,86 +5019,9 @@ int RockchipRga::RkRgaMmuFlag(struct rga_req *msg,
     return 1;
 }
 
+/* the tables are constants now, kept for callers of the old api */
 int RockchipRga::RkRgaInitTables()
 {
-    int sinaTable[360] = {
-            0,   1144,   2287,   3430,   4572,   5712,   6850,   7987,   9121,  10252,
-        11380,  12505,  13626,  14742,  15855,  16962,  18064,  19161,  20252,  21336,
-        22415,  23486,  24550,  25607,  26656,  27697,  28729,  29753,  30767,  31772,
-        32768,  33754,  34729,  35693,  36647,  37590,  38521,  39441,  40348,  41243,
-        42126,  42995,  43852,  44695,  45525,  46341,  47143,  47930,  48703,  49461,
-        50203,  50931,  51643,  52339,  53020,  53684,  54332,  54963,  55578,  56175,
-        56756,  57319,  57865,  58393,  58903,  59396,  59870,  60326,  60764,  61183,
-        61584,  61966,  62328,  62672,  62997,  63303,  63589,  63856,  64104,  64332,
-        64540,  64729,  64898,  65048,  65177,  65287,  65376,  65446,  65496,  65526,
-        65536,  65526,  65496,  65446,  65376,  65287,  65177,  65048,  64898,  64729,
-        64540,  64332,  64104,  63856,  63589,  63303,  62997,  62672,  62328,  61966,
-        61584,  61183,  60764,  60326,  59870,  59396,  58903,  58393,  57865,  57319,
-        56756,  56175,  55578,  54963,  54332,  53684,  53020,  52339,  51643,  50931,
-        50203,  49461,  48703,  47930,  47143,  46341,  45525,  44695,  43852,  42995,
-        42126,  41243,  40348,  39441,  38521,  37590,  36647,  35693,  34729,  33754,
-        32768,  31772,  30767,  29753,  28729,  27697,  26656,  25607,  24550,  23486,
-        22415,  21336,  20252,  19161,  18064,  16962,  15855,  14742,  13626,  12505,
-        11380,  10252,   9121,   7987,   6850,   5712,   4572,   3430,   2287,   1144,
-            0,  -1144,  -2287,  -3430,  -4572,  -5712,  -6850,  -7987,  -9121, -10252,
-        -11380, -12505, -13626, -14742, -15855, -16962, -18064, -19161, -20252, -21336,
-        -22415, -23486, -24550, -25607, -26656, -27697, -28729, -29753, -30767, -31772,
-        -32768, -33754, -34729, -35693, -36647, -37590, -38521, -39441, -40348, -41243,
-        -42126, -42995, -43852, -44695, -45525, -46341, -47143, -47930, -48703, -49461,
-        -50203, -50931, -51643, -52339, -53020, -53684, -54332, -54963, -55578, -56175,
-        -56756, -57319, -57865, -58393, -58903, -59396, -59870, -60326, -60764, -61183,
-        -61584, -61966, -62328, -62672, -62997, -63303, -63589, -63856, -64104, -64332,
-        -64540, -64729, -64898, -65048, -65177, -65287, -65376, -65446, -65496, -65526,
-        -65536, -65526, -65496, -65446, -65376, -65287, -65177, -65048, -64898, -64729, 
-        -64540, -64332, -64104, -63856, -63589, -63303, -62997, -62672, -62328, -61966,
-        -61584, -61183, -60764, -60326, -59870, -59396, -58903, -58393, -57865, -57319,
-        -56756, -56175, -55578, -54963, -54332, -53684, -53020, -52339, -51643, -50931,
-        -50203, -49461, -48703, -47930, -47143, -46341, -45525, -44695, -43852, -42995,
-        -42126, -41243, -40348, -39441, -38521, -37590, -36647, -35693, -34729, -33754,
-        -32768, -31772, -30767, -29753, -28729, -27697, -26656, -25607, -24550, -23486, 
-        -22415, -21336, -20252, -19161, -18064, -16962, -15855, -14742, -13626, -12505,
-        -11380, -10252, -9121,   -7987,  -6850,  -5712,  -4572,  -3430,  -2287,  -1144
-    };
-    int cosaTable[360] = {
-         65536,  65526,  65496,  65446,  65376,  65287,  65177,  65048,  64898,  64729,
-         64540,  64332,  64104,  63856,  63589,  63303,  62997,  62672,  62328,  61966,
-         61584,  61183,  60764,  60326,  59870,  59396,  58903,  58393,  57865,  57319,
-         56756,  56175,  55578,  54963,  54332,  53684,  53020,  52339,  51643,  50931,
-         50203,  49461,  48703,  47930,  47143,  46341,  45525,  44695,  43852,  42995,
-         42126,  41243,  40348,  39441,  38521,  37590,  36647,  35693,  34729,  33754,
-         32768,  31772,  30767,  29753,  28729,  27697,  26656,  25607,  24550,  23486,
-         22415,  21336,  20252,  19161,  18064,  16962,  15855,  14742,  13626,  12505,
-         11380,  10252,   9121,   7987,   6850,   5712,   4572,   3430,   2287,   1144,
-             0,  -1144,  -2287,  -3430,  -4572,  -5712,  -6850,  -7987,  -9121, -10252,
-        -11380, -12505, -13626, -14742, -15855, -16962, -18064, -19161, -20252, -21336,
-        -22415, -23486, -24550, -25607, -26656, -27697, -28729, -29753, -30767, -31772,
-        -32768, -33754, -34729, -35693, -36647, -37590, -38521, -39441, -40348, -41243,
-        -42126, -42995, -43852, -44695, -45525, -46341, -47143, -47930, -48703, -49461,
-        -50203, -50931, -51643, -52339, -53020, -53684, -54332, -54963, -55578, -56175,
-        -56756, -57319, -57865, -58393, -58903, -59396, -59870, -60326, -60764, -61183,
-        -61584, -61966, -62328, -62672, -62997, -63303, -63589, -63856, -64104, -64332,
-        -64540, -64729, -64898, -65048, -65177, -65287, -65376, -65446, -65496, -65526,
-        -65536, -65526, -65496, -65446, -65376, -65287, -65177, -65048, -64898, -64729, 
-        -64540, -64332, -64104, -63856, -63589, -63303, -62997, -62672, -62328, -61966,
-        -61584, -61183, -60764, -60326, -59870, -59396, -58903, -58393, -57865, -57319,
-        -56756, -56175, -55578, -54963, -54332, -53684, -53020, -52339, -51643, -50931,
-        -50203, -49461, -48703, -47930, -47143, -46341, -45525, -44695, -43852, -42995,
-        -42126, -41243, -40348, -39441, -38521, -37590, -36647, -35693, -34729, -33754,
-        -32768, -31772, -30767, -29753, -28729, -27697, -26656, -25607, -24550, -23486,
-        -22415, -21336, -20252, -19161, -18064, -16962, -15855, -14742, -13626, -12505, 
-        -11380, -10252,  -9121,  -7987,  -6850,  -5712,  -4572,  -3430,  -2287,  -1144,
-             0,   1144,   2287,   3430,   4572,   5712,   6850,   7987,   9121,  10252,
-         11380,  12505,  13626,  14742,  15855,  16962,  18064,  19161,  20252,  21336,
-         22415,  23486,  24550,  25607,  26656,  27697,  28729,  29753,  30767,  31772,
-         32768,  33754,  34729,  35693,  36647,  37590,  38521,  39441,  40348,  41243,
-         42126,  42995,  43852,  44695,  45525,  46341,  47143,  47930,  48703,  49461,
-         50203,  50931,  51643,  52339,  53020,  53684,  54332,  54963,  55578,  56175,
-         56756,  57319,  57865,  58393,  58903,  59396,  59870,  60326,  60764,  61183,
-         61584,  61966,  62328,  62672,  62997,  63303,  63589,  63856,  64104,  64332,
-         64540,  64729,  64898,  65048,  65177,  65287,  65376,  65446,  65496,  65526
-    };
-    memcpy(sina_table, sinaTable, sizeof(sina_table));
-    memcpy(cosa_table, cosaTable, sizeof(cosa_table));
     return 0;
 }
 
@@ -15,11 +15,14 @@
 
 #include <stdint.h>
 #include <vector>
+#include <map>
 #include <sys/types.h>
 
 #include <system/window.h>
 
 #include <utils/Thread.h>
+#include <utils/Condition.h>
+#include <utils/Singleton.h>
 
 #include <EGL/egl.h>
 #include <GLES/gl.h>
@@ -45,6 +48,10 @@
 namespace android {
 // -------------------------------------------------------------------------------
 
+class RockchipRgaJobQueue;
+class RockchipRgaDevice;
+class RockchipRgaCpu;
+
 class RockchipRga :public Singleton<RockchipRga>
 {
 /************************************public**************************************/
@@ -53,6 +60,13 @@ public:
 
     static inline RockchipRga& get() {return getInstance();}
 
+    /*
+    @fun RkRgaInit:Open the rga cores and load gralloc now. Both otherwise
+        happen on first use: the cores with the first request, gralloc with
+        the first buffer handle. The cores are probed once. When
+        persist.rga.caps_cache names a file, the probed driver versions are
+        kept there, so later processes do not ask the driver for them.
+    */
     int         RkRgaInit();
     int         RkRgaInitTables();
 
@@ -62,8 +76,115 @@ public:
     int         RkRgaGetHandleMapAddress(buffer_handle_t handle,
                                                                      void **buf);
 
+    /*
+    @fun RkRgaSetExplicitCacheSync:Let the caller own cpu cache maintenance.
+        When enabled buffers are mapped without SW usage and the library only
+        issues dma-buf syncs that the tracked cpu/rga accesses require.
+
+    @fun RkRgaCpuAccessBegin/RkRgaCpuAccessEnd:Bracket every cpu access to a
+        buffer that rga also touches while explicit cache sync is enabled.
+
+    @param flags:DRM_RGA_CPU_ACCESS_READ and/or DRM_RGA_CPU_ACCESS_WRITE
+    */
+    void        RkRgaSetExplicitCacheSync(bool enable);
+    int         RkRgaCpuAccessBegin(buffer_handle_t handle, int flags);
+    int         RkRgaCpuAccessEnd(buffer_handle_t handle);
+    int         RkRgaCacheSyncRelease(buffer_handle_t handle);
+    int         RkRgaGetCacheSyncStats(rga_cache_stats_t *stats);
+
     int         RkRgaGetRgaFormat(int format);
 
+    /*
+    @fun RkRgaAddEmulatedDevices:Add software rga cores next to the device
+        nodes, also set by persist.rga.emulate. Each request goes to the least
+        loaded core that supports it, see RkRgaGetDeviceInfo.
+    */
+    int         RkRgaAddEmulatedDevices(int count);
+
+    /*
+    @fun RkRgaSetEngine:Where blits run.
+        DRM_RGA_ENGINE_HW:    the rga cores only, the default
+        DRM_RGA_ENGINE_CPU:   the software renderer on all cpu cores
+        DRM_RGA_ENGINE_HYBRID:split the destination rows, the rga takes the top
+                              part and the cpu the rest at the same time. The
+                              split follows the measured speed of both sides.
+        DRM_RGA_ENGINE_AUTO:  per job, the one of the three the cost model of
+                              RkRgaCalibrate predicts fastest
+    */
+    int         RkRgaSetEngine(int engine);
+
+    /*
+    @fun RkRgaCalibrate:Measure the fixed cost per job and the cost per pixel
+        of the rga and of the cpu for some format pairs, with unscaled blits
+        of 64x64 and 1024x1024. The model is saved to the file named by
+        persist.rga.cost_model and read back on the next first use. Blits of
+        other threads take the engine under test while it runs.
+    @param formats:pairs of src,dst HAL formats, NULL for rgba->rgba,
+        nv12->rgba, rgba->rgb565 and nv12->nv12
+    @param pairs:number of pairs in formats
+    */
+    int         RkRgaCalibrate(const int *formats, int pairs);
+    int         RkRgaGetDispatchStats(rga_dispatch_stats_t *stats);
+
+    /*
+    @fun RkRgaSetScaleMode:Filter for scaled blits.
+        DRM_RGA_SCALE_AUTO:    bicubic when scaling up, bilinear down, the default
+        DRM_RGA_SCALE_NEAREST: fastest, blocky
+        DRM_RGA_SCALE_BILINEAR:2x2 taps
+        DRM_RGA_SCALE_BICUBIC: 4x4 taps, sharper when scaling up
+        DRM_RGA_SCALE_AREA:    box average over the covered source pixels,
+                               for large downscales. The rga does bilinear.
+    */
+    int         RkRgaSetScaleMode(int mode);
+
+    /*
+    @fun RkRgaSetDitherMode:Dither of blits that drop color depth, rgb565 dst
+        from any other format.
+        DRM_RGA_DITHER_AUTO:     ordered 4x4, the default
+        DRM_RGA_DITHER_OFF:      truncate
+        DRM_RGA_DITHER_DIFFUSION:floyd-steinberg, smoother gradients. The rga
+                                 dithers ordered, only software diffuses.
+    */
+    int         RkRgaSetDitherMode(int mode);
+
+    /*
+    @fun RkRgaSetDepthMode:How 10 bit frames, HAL_PIXEL_FORMAT_YCrCb_NV12_10
+        and DRM_RGA_FORMAT_YCbCr_P010, become 8 bit.
+        DRM_RGA_DEPTH_TRUNCATE:drop the low bits of each sample, the default
+        DRM_RGA_DEPTH_ROUND:   convert at 10 bits and round, the rga truncates
+        DRM_RGA_DEPTH_TONEMAP: HDR10 (bt.2020, PQ) to sdr, software only
+    */
+    int         RkRgaSetDepthMode(int mode);
+
+    /*
+    @fun RkRgaUnpack10Bit:Expand the area of a 10 bit frame to 16 bit samples
+        with the value in the low bits.
+    @param rect:the src frame and the area, the frame is rect->yoffset +
+        rect->height rows high and the width is even
+    @param dst:rect->height rows of rect->width luma samples, then
+        rect->height / 2 rows of rect->width interleaved chroma samples
+    */
+    int         RkRgaUnpack10Bit(const void *src, const rga_rect_t *rect,
+                                                            uint16_t *dst);
+
+    /*
+    @fun RkRgaSetCpuWorkers:Threads of the software renderer, also set by
+        persist.rga.cpu.threads and persist.rga.cpu.cluster.
+    @param threads:worker count, 0 is one per core of the cluster
+    @param cluster:DRM_RGA_CPU_CLUSTER_ANY, or _BIG/_LITTLE to pin the
+        workers to the fast or the efficient cores of a big.LITTLE soc
+    */
+    int         RkRgaSetCpuWorkers(int threads, int cluster);
+
+    /*
+    @fun RkRgaSetCpuSimd:Let the software renderer use its neon kernels,
+        on by default. Off runs the scalar reference code, rgaregress -c
+        compares the two.
+    */
+    int         RkRgaSetCpuSimd(int enable);
+    int         RkRgaGetDeviceCount();
+    int         RkRgaGetDeviceInfo(int index, rga_device_info_t *info);
+
     int         RkRgaBlit(buffer_handle_t src, buffer_handle_t dst,
                                       drm_rga_t *rects, int rotation, int blend);
     int         RkRgaBlit(void *src, buffer_handle_t dst,
@@ -72,14 +193,248 @@ public:
                                       drm_rga_t *rects, int rotation, int blend);
     int         RkRgaBlit(void *src, void *dst,
                                       drm_rga_t *rects, int rotation, int blend);
+
+    /*
+    @fun RkRgaRotate:Rotate src clockwise by any angle in degrees. The rotated
+        image is scaled to fit the dst rect and centered in it, the corners of
+        the rect outside the image are left untouched. rga2 only turns by
+        multiples of 90, other angles run in software.
+    @param blend:as RkRgaBlit
+    */
+    int         RkRgaRotate(buffer_handle_t src, buffer_handle_t dst,
+                                        drm_rga_t *rects, int angle, int blend);
+    int         RkRgaRotate(void *src, void *dst,
+                                        drm_rga_t *rects, int angle, int blend);
+
+    /*
+    @fun RkRgaFilter:Blur or sharpen the src rect into a dst rect of the same
+        size. Pixels around the src rect feed its edges, the edges of the
+        buffer repeat. src and dst must not overlap. rga2 has no filter, it
+        runs in software there.
+    @param mode:DRM_RGA_FILTER_BLUR or DRM_RGA_FILTER_SHARPEN
+    @param intensity:0 (lightest) to 3 (strongest)
+    @param dither:dither when dst has fewer bits per channel (rgb565)
+    */
+    int         RkRgaFilter(buffer_handle_t src, buffer_handle_t dst,
+                        drm_rga_t *rects, int mode, int intensity, int dither);
+    int         RkRgaFilter(void *src, void *dst,
+                        drm_rga_t *rects, int mode, int intensity, int dither);
+
+    /*
+    @fun RkRgaColorKeyBlit:Copy src to dst except the pixels that match the
+        color key, those leave dst as it is or clear it. A scaled color key
+        blit always picks the nearest src pixel, a filter would blend the key
+        color into the edges of what it hides.
+    @param keyMin/keyMax:0xAARRGGBB, a src pixel matches when every channel
+        of flags lies within the two
+    @param flags:DRM_RGA_COLORKEY_R/G/B/A channels to compare, or _RGB,
+        plus DRM_RGA_COLORKEY_ZERO to write 0 over matched pixels
+    */
+    int         RkRgaColorKeyBlit(buffer_handle_t src, buffer_handle_t dst,
+                                drm_rga_t *rects, unsigned int keyMin,
+                                unsigned int keyMax, int flags);
+    int         RkRgaColorKeyBlit(void *src, void *dst,
+                                drm_rga_t *rects, unsigned int keyMin,
+                                unsigned int keyMax, int flags);
+
+    /*
+    @fun RkRgaRopBlit:Combine src (S), dst (D) and a pattern (P) bit by bit
+        with a raster operation, in packed rgb formats.
+    @param rop:a ROP3 code, DRM_RGA_ROP_SRCCOPY and so on, or any bit i set
+        when the result for P << 2 | S << 1 | D == i is 1. Or in
+        DRM_RGA_ROP_PATTERN to take P from RkRgaSetPattern, tiled from the
+        dst rect origin.
+    @param color:0xAARRGGBB, the solid P without DRM_RGA_ROP_PATTERN
+    @param mask:NULL, or 1 bit per dst rect pixel with rows of
+        (dst width + 7) / 8 bytes, the first pixel in the high bit. Pixels
+        with a 0 bit keep dst.
+    */
+    int         RkRgaRopBlit(buffer_handle_t src, buffer_handle_t dst,
+                                drm_rga_t *rects, int rop, unsigned int color,
+                                const void *mask);
+    int         RkRgaRopBlit(void *src, void *dst,
+                                drm_rga_t *rects, int rop, unsigned int color,
+                                const void *mask);
+
+    /*
+    @fun RkRgaFade:Blit src to dst with its rgb moved toward a color, alpha
+        stays. One rga1 job, rga2 has no fading stage and runs it in
+        software.
+    @param color:0xRRGGBB to fade toward
+    @param factor:0 is src as it is, 255 the plain color
+
+    @fun RkRgaCrossFade:dst = from * (255 - alpha) / 255 + to * alpha / 255.
+        from takes rects->src, to and dst share rects->dst. With to the same
+        buffer as dst it is one blend job, otherwise a copy of to and the
+        blend go to one core as a batch.
+    @param alpha:0 is from, 255 is to
+    */
+    int         RkRgaFade(buffer_handle_t src, buffer_handle_t dst,
+                        drm_rga_t *rects, unsigned int color, int factor);
+    int         RkRgaFade(void *src, void *dst,
+                        drm_rga_t *rects, unsigned int color, int factor);
+    int         RkRgaCrossFade(buffer_handle_t from, buffer_handle_t to,
+                        buffer_handle_t dst, drm_rga_t *rects, int alpha);
+    int         RkRgaCrossFade(void *from, void *to, void *dst,
+                                            drm_rga_t *rects, int alpha);
+
+    /*
+    @fun RkRgaDecimate:Copy src to dst at 1/factor of its size, each pixel
+        the mean of a factor x factor block. rga1 runs it on the pre-scaler,
+        rga2 as a bilinear blit. The cpu averages packed rgb and nv12 into
+        the same format in place.
+    @param factor:2, 4 or 8. rects->src is factor times rects->dst in both
+        directions.
+    */
+    int         RkRgaDecimate(buffer_handle_t src, buffer_handle_t dst,
+                                                drm_rga_t *rects, int factor);
+    int         RkRgaDecimate(void *src, void *dst, drm_rga_t *rects, int factor);
+
+    /*
+    @fun RkRgaFill:Fill count areas of dst, each solid or gradient, as one
+        batch on one rga core.
+    @param rect:the dst buffer and the area fills are relative to and
+        clipped by. NULL takes the whole buffer of a handle.
+    */
+    int         RkRgaFill(buffer_handle_t dst, rga_rect_t *rect,
+                                        const rga_fill_t *fills, int count);
+    int         RkRgaFill(void *dst, rga_rect_t *rect,
+                                        const rga_fill_t *fills, int count);
+
+    /*
+    @fun RkRgaDrawLines:Draw count segments into dst as one batch, see
+        rga_set_polyline and rga_set_outline to build them. Lines are not
+        anti-aliased so the software renderer draws the same pixels.
+    @param rect:the dst buffer and the area lines are relative to and
+        clipped by. NULL takes the whole buffer of a handle.
+    */
+    int         RkRgaDrawLines(buffer_handle_t dst, rga_rect_t *rect,
+                                        const rga_line_t *lines, int count);
+    int         RkRgaDrawLines(void *dst, rga_rect_t *rect,
+                                        const rga_line_t *lines, int count);
+    /*
+    @fun RkRgaSetPalette:Load the palette of indexed blits once for all the
+        RkRgaPaletteBlit calls that follow. rga2 has no palette, expansion
+        runs in software there.
+    @param colors:0xAARRGGBB entries, 2, 4, 16 or 256 of them for 1, 2, 4 or
+        8 bits per index
+    */
+    int         RkRgaSetPalette(const unsigned int *colors, int count);
+
+    /*
+    @fun RkRgaPaletteBlit:Expand an indexed src through the palette into a dst
+        rect of the same size.
+    @param src:rows of rects->src.wstride indexes packed to the depth of the
+        palette, the src format is not used
+    @param endian:DRM_RGA_PALETTE_MSB_FIRST or DRM_RGA_PALETTE_LSB_FIRST, the
+        bits of a byte that hold its first pixel
+    */
+    int         RkRgaPaletteBlit(const void *src, buffer_handle_t dst,
+                                                drm_rga_t *rects, int endian);
+    int         RkRgaPaletteBlit(const void *src, void *dst,
+                                                drm_rga_t *rects, int endian);
+
+    /*
+    @fun RkRgaSetPattern:Load the pattern of RkRgaPatternFill once. rga2 has
+        no pattern buffer, pattern fills run in software there.
+    @param colors:width x height 0xAARRGGBB pixels, row after row, width and
+        height up to DRM_RGA_PATTERN_MAX_SIZE
+    */
+    int         RkRgaSetPattern(const unsigned int *colors, int width, int height);
+
+    /*
+    @fun RkRgaPatternFill:Tile the pattern over an area of dst, the dst
+        format is packed rgb.
+    @param rect:the dst buffer and the area to tile. NULL takes the whole
+        buffer of a handle.
+    @param xoff/yoff:pattern pixel at the origin of the area, so the tiling of
+        neighbouring areas can line up
+    */
+    int         RkRgaPatternFill(buffer_handle_t dst, rga_rect_t *rect,
+                                                        int xoff, int yoff);
+    int         RkRgaPatternFill(void *dst, rga_rect_t *rect, int xoff, int yoff);
+
+    /*
+    @fun RkRgaBlitAsync:Queue a blit for the submitter thread and return a job
+        handle at once, the job runs before any job of a lower priority class.
+
+    @param priority:DRM_RGA_PRIORITY_REALTIME/INTERACTIVE/BACKGROUND
+    @return job handle (> 0) for RkRgaJobWait, or a negative errno
+
+    @fun RkRgaJobWait:Wait for a job and release its handle. Every handle
+        must be waited for until it returns something else than -EBUSY or
+        -ETIMEDOUT, or be detached, else its slot is never reused.
+
+    @param timeoutMs:< 0 waits forever, 0 polls and returns -EBUSY if pending
+    @return the RkRgaBlit result of the job
+
+    @fun RkRgaJobDetach:Release a handle without waiting, the job still runs
+        and its slot is freed once it completes.
+    */
+    int         RkRgaBlitAsync(buffer_handle_t src, buffer_handle_t dst,
+                        drm_rga_t *rects, int rotation, int blend, int priority);
+    int         RkRgaJobWait(int job, int timeoutMs);
+    int         RkRgaJobDetach(int job);
+    int         RkRgaGetJobStats(rga_job_stats_t *stats);
+
+    /*
+    @fun RkRgaPaletteTable:Load the palette from a buffer that holds it in the
+        rga layout, the bytes of an rgba_8888 pixel per entry.
+    @param v:DRM_RGA_PALETTE_BPP1/2/4/8 in the low byte, 2, 4, 16 or 256
+        entries are read
+    @param rects:unused
+    */
     int         RkRgaPaletteTable(buffer_handle_t dst, 
                                                unsigned int v, drm_rga_t *rects);
 
     int         RkRgaStereo(buffer_handle_t src,
                                                     buffer_handle_t dst,int div);
-    int         RkRgaScale();
-    int         RkRgaRoate();
-    int         RkRgaRoateScale();
+
+    /*
+    @fun RkRgaCopy:Copy rects->src into rects->dst of the same size and
+        format. Builds no scale, blend or dither state.
+    */
+    int         RkRgaCopy(buffer_handle_t src, buffer_handle_t dst,
+                                                        drm_rga_t *rects);
+    int         RkRgaCopy(void *src, void *dst, drm_rga_t *rects);
+
+    /*
+    @fun RkRgaConvert:Convert rects->src into the format of rects->dst of
+        the same size, dithered like RkRgaBlit when the depth drops.
+    */
+    int         RkRgaConvert(buffer_handle_t src, buffer_handle_t dst,
+                                                        drm_rga_t *rects);
+    int         RkRgaConvert(void *src, void *dst, drm_rga_t *rects);
+
+    /*
+    @fun RkRgaScale:Scale rects->src to fill rects->dst with the scale mode
+        of RkRgaSetScaleMode, without rotation or blending.
+    @return -EINVAL past the 1/2 the blit core can shrink to
+    */
+    int         RkRgaScale(buffer_handle_t src, buffer_handle_t dst,
+                                                        drm_rga_t *rects);
+    int         RkRgaScale(void *src, void *dst, drm_rga_t *rects);
+
+    /*
+    @fun RkRgaRoate:Turn rects->src into rects->dst without scaling, so dst
+        is src with width and height swapped for 90 and 270.
+    @param rotation:one of HAL_TRANSFORM_ROT_90/180/270 or FLIP_H/V, like
+        RkRgaBlit. Other values return -EINVAL.
+    */
+    int         RkRgaRoate(buffer_handle_t src, buffer_handle_t dst,
+                                        drm_rga_t *rects, int rotation);
+    int         RkRgaRoate(void *src, void *dst,
+                                        drm_rga_t *rects, int rotation);
+
+    /*
+    @fun RkRgaRoateScale:RkRgaRoate that also scales the turned src to
+        fill rects->dst.
+    */
+    int         RkRgaRoateScale(buffer_handle_t src, buffer_handle_t dst,
+                                        drm_rga_t *rects, int rotation);
+    int         RkRgaRoateScale(void *src, void *dst,
+                                        drm_rga_t *rects, int rotation);
+
     int         RkRgaGetRects(buffer_handle_t src, buffer_handle_t dst,
                                     int *sType, int *dType, drm_rga_t* tmpRects);
     /*
@@ -113,12 +468,131 @@ private:
     float                           mVersion;
     static Mutex                    mMutex;
     gralloc_module_t const          *mAllocMod;
+    bool                            mProbed;
+
+    /*
+     * window:DMA_BUF_SYNC_* of the START not yet ended, 0 if none
+     * busy:rga accesses in flight, a cpu access waits for them on mSyncCond
+     */
+    struct SyncState {
+        int     fd;
+        int     flags;
+        int     cpuAccess;
+        uint64_t window;
+        int     busy;
+    };
+
+    enum {
+        SYNC_CPU_DIRTY              = 0x1,
+        SYNC_DEV_DIRTY              = 0x2,
+    };
+
+    enum {
+        PATH_COPY                   = 0x0,
+        PATH_CONVERT                = 0x1,
+        PATH_SCALE                  = 0x2,
+        PATH_ROTATE                 = 0x4,
+    };
+
+    sp<RockchipRgaJobQueue>         mJobQueue;
+    std::vector<RockchipRgaDevice*> mDevices;
+    RockchipRgaCpu                  *mCpu;
+
+    struct HybridRate {
+        double  hwRate;
+        double  cpuRate;
+        int     samples;
+    };
+
+    int                             mEngine;
+    int                             mScaleMode;
+    int                             mDitherMode;
+    int                             mDepthMode;
+    unsigned int                    mPalette[256];
+    int                             mPaletteMode;
+    unsigned int                    mPattern[DRM_RGA_PATTERN_MAX_SIZE *
+                                                DRM_RGA_PATTERN_MAX_SIZE];
+    int                             mPatternWidth;
+    int                             mPatternHeight;
+    std::map<int, HybridRate>       mHybridRates;
+
+    /* us per job, plus us per pixel read and written, fixed < 0 if unknown */
+    struct CostModel {
+        double  hwFixed;
+        double  hwPerPixel;
+        double  cpuFixed;
+        double  cpuPerPixel;
+    };
+
+    std::map<int, CostModel>        mCostModels;
+    rga_dispatch_stats_t            mDispatchStats;
+
+    bool                            mExplicitSync;
+    std::map<buffer_handle_t, SyncState> mSyncStates;
+    Condition                       mSyncCond;
+    rga_cache_stats_t               mCacheStats;
 
     friend class Singleton<RockchipRga>;
                 RockchipRga();
                  ~RockchipRga();
 
 /***********************************rgahandle*********************************/
+int         RkRgaOpenDevices();
+int         RkRgaProbe();
+int         RkRgaLoadGralloc();
+int         RkRgaSubmit(struct rga_req *req, int cmd);
+int         RkRgaSubmitOn(struct rga_req *req, int cmd, int engine);
+int         RkRgaSubmitHybrid(RockchipRgaDevice *dev,
+                                    struct rga_req *req, int cmd, int layout);
+int         RkRgaHybridSplit(const struct rga_req *req, HybridRate *rate);
+int         RkRgaChooseEngine(const struct rga_req *req,
+                                    RockchipRgaDevice *dev, double *predicted);
+int         RkRgaFitCost(void *srcBuf, void *dstBuf, int srcFormat,
+                        int dstFormat, int engine, double *fixed, double *perPixel);
+int         RkRgaLoadCostModel();
+int         RkRgaSaveCostModel();
+int         RkRgaScaleModeOf(int srcW, int srcH, int dstW, int dstH);
+int         RkRgaDitherOf(int srcFormat, int dstFormat);
+int         RkRgaSetImages(struct rga_req *req, void *srcBuf,
+                    const rga_rect_t *src, void *dstBuf, const rga_rect_t *dst,
+                                                                RECT *clip);
+int         RkRgaSetBlend(struct rga_req *req, int srcFormat, int blend);
+int         RkRgaRotateBuffers(void *srcBuf, void *dstBuf,
+                                    drm_rga_t *rects, int angle, int blend);
+int         RkRgaFilterBuffers(void *srcBuf, void *dstBuf, drm_rga_t *rects,
+                                        int mode, int intensity, int dither);
+int         RkRgaSubmitBatch(struct rga_req *reqs, int count);
+int         RkRgaLoadPalette(const unsigned int *table, int mode);
+int         RkRgaPaletteBuffers(const void *srcBuf, void *dstBuf,
+                                                drm_rga_t *rects, int endian);
+int         RkRgaPatternBuffer(void *dstBuf, const rga_rect_t *rect,
+                                                        int xoff, int yoff);
+int         RkRgaColorKeyBuffers(void *srcBuf, void *dstBuf, drm_rga_t *rects,
+                        unsigned int keyMin, unsigned int keyMax, int flags);
+int         RkRgaRopBuffers(void *srcBuf, void *dstBuf, drm_rga_t *rects,
+                        int rop, unsigned int color, const void *mask);
+int         RkRgaFadeBuffers(void *srcBuf, void *dstBuf, drm_rga_t *rects,
+                                            unsigned int color, int factor);
+int         RkRgaCrossFadeBuffers(void *fromBuf, void *toBuf, void *dstBuf,
+                                            drm_rga_t *rects, int alpha);
+int         RkRgaDecimateBuffers(void *srcBuf, void *dstBuf,
+                                                drm_rga_t *rects, int factor);
+int         RkRgaPathBlit(buffer_handle_t src, buffer_handle_t dst,
+                                    drm_rga_t *rects, int rotation, int path);
+int         RkRgaPathRequest(struct rga_req *req, void *srcBuf, void *dstBuf,
+                                    drm_rga_t *rects, int rotation, int path);
+int         RkRgaPathBuffers(void *srcBuf, void *dstBuf,
+                                    drm_rga_t *rects, int rotation, int path);
+int         RkRgaFillBuffer(void *dstBuf, const rga_rect_t *rect,
+                                        const rga_fill_t *fills, int count);
+int         RkRgaDrawBuffer(void *dstBuf, const rga_rect_t *rect,
+                                        const rga_line_t *lines, int count);
+
+SyncState*  RkRgaGetSyncState(buffer_handle_t handle);
+int         RkRgaDmaBufSync(int fd, uint64_t flags);
+int         RkRgaSyncForDevice(buffer_handle_t handle, bool write);
+void        RkRgaSyncDeviceDone(buffer_handle_t handle);
+
 int         RkRgaSetFdsOffsets(struct rga_req *req,
                                 uint16_t src_fd,     uint16_t dst_fd,
                                 uint32_t src_offset, uint32_t dst_offset);
@@ -198,8 +672,8 @@ int         RkRgaSetFadingEnInfo(struct rga_req *msg,
 
 int         RkRgaSetSrcTransModeInfo(struct rga_req *msg,
         	unsigned char trans_mode,unsigned char a_en,unsigned char b_en,
-        	unsigned char g_en,unsigned char r_en,unsigned char color_key_min,
-        	unsigned char color_key_max,unsigned char zero_mode_en);
+        	unsigned char g_en,unsigned char r_en,unsigned int color_key_min,
+        	unsigned int color_key_max,unsigned char zero_mode_en);
 
 
 // 0/near  1/bilnear  2/bicubic  
@@ -301,10 +775,6 @@ int         RkRgaMmuInfo(struct rga_req *msg,
 int         RkRgaMmuFlag(struct rga_req *msg,
                                     int  src_mmu_en,   int  dst_mmu_en);
 
-int         sina_table[360];
-
-int         cosa_table[360];
-
 };
 
 // ---------------------------------------------------------------------------
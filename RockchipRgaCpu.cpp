@@ -0,0 +1,2540 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "rockchiprga"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <math.h>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+#include "drmrga.h"
+#include "RockchipRgaCpu.h"
+
+namespace android {
+
+// ---------------------------------------------------------------------------
+
+static inline uint8_t clamp255(int v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline int div255(int v)
+{
+    v += 128;
+    return (v + (v >> 8)) >> 8;
+}
+
+/* BT.601 limited range, the rga default yuv2rgb_mode */
+static inline uint32_t yuvToRgb(int y, int u, int v)
+{
+    int c = 298 * (y - 16) + 128;
+    int d = u - 128;
+    int e = v - 128;
+
+    return RGA_CPU_PACK(clamp255((c + 409 * e) >> 8),
+                        clamp255((c - 100 * d - 208 * e) >> 8),
+                        clamp255((c + 516 * d) >> 8), 0xff);
+}
+
+static inline uint8_t rgbToY(uint32_t c)
+{
+    return ((66 * RGA_CPU_R(c) + 129 * RGA_CPU_G(c) +
+                                    25 * RGA_CPU_B(c) + 128) >> 8) + 16;
+}
+
+static inline uint8_t rgbToU(uint32_t c)
+{
+    return ((-38 * (int)RGA_CPU_R(c) - 74 * (int)RGA_CPU_G(c) +
+                                    112 * (int)RGA_CPU_B(c) + 128) >> 8) + 128;
+}
+
+static inline uint8_t rgbToV(uint32_t c)
+{
+    return ((112 * (int)RGA_CPU_R(c) - 94 * (int)RGA_CPU_G(c) -
+                                    18 * (int)RGA_CPU_B(c) + 128) >> 8) + 128;
+}
+
+static inline uint32_t swapRB(uint32_t c)
+{
+    return (c & 0xff00ff00) | ((c >> 16) & 0xff) | ((c & 0xff) << 16);
+}
+
+bool RockchipRgaCpu::sSimd = true;
+
+RockchipRgaCpu::RockchipRgaCpu():
+    mPool(NULL),
+    mThreads(0),
+    mCluster(DRM_RGA_CPU_CLUSTER_ANY),
+    mRebuild(false)
+{
+    char value[PROPERTY_VALUE_MAX];
+
+    property_get("persist.rga.cpu.threads", value, "0");
+    mThreads = atoi(value);
+    property_get("persist.rga.cpu.cluster", value, "0");
+    mCluster = atoi(value);
+    property_get("persist.rga.cpu.simd", value, "1");
+    setSimd(atoi(value) != 0);
+}
+
+RockchipRgaCpu::~RockchipRgaCpu()
+{
+    std::map<RockchipRgaThreadPool *, int>::iterator it;
+
+    for (it = mPoolUsers.begin(); it != mPoolUsers.end(); it++)
+        if (it->first != mPool)
+            delete it->first;
+    delete mPool;
+}
+
+/*
+ * Returns the pool with a reference the caller drops with releasePool().
+ * A rebuild retires the current pool, it is deleted by the last release.
+ */
+RockchipRgaThreadPool* RockchipRgaCpu::pool()
+{
+    Mutex::Autolock lock(mPoolLock);
+
+    if (mPool && mRebuild) {
+        if (!mPoolUsers[mPool]) {
+            mPoolUsers.erase(mPool);
+            delete mPool;
+        }
+        mPool = NULL;
+    }
+
+    if (!mPool) {
+        mPool = new RockchipRgaThreadPool(mThreads, mCluster);
+        mRebuild = false;
+    }
+
+    mPoolUsers[mPool]++;
+    return mPool;
+}
+
+void RockchipRgaCpu::releasePool(RockchipRgaThreadPool *workers)
+{
+    Mutex::Autolock lock(mPoolLock);
+
+    if (--mPoolUsers[workers] > 0)
+        return;
+
+    mPoolUsers.erase(workers);
+    if (workers != mPool)
+        delete workers;
+}
+
+void RockchipRgaCpu::setWorkers(int threads, int cluster)
+{
+    Mutex::Autolock lock(mPoolLock);
+
+    mThreads = threads > 0 ? threads : 0;
+    mCluster = cluster;
+    mRebuild = true;
+}
+
+void RockchipRgaCpu::setSimd(bool enable)
+{
+    __atomic_store_n(&sSimd, enable, __ATOMIC_RELAXED);
+}
+
+int RockchipRgaCpu::threads()
+{
+    RockchipRgaThreadPool *workers = pool();
+    int count = workers->threads();
+
+    releasePool(workers);
+    return count;
+}
+
+bool RockchipRgaCpu::supportsFormat(int format)
+{
+    switch (format) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_RGBX_8888:
+        case RK_FORMAT_BGRA_8888:
+        case RK_FORMAT_RGB_888:
+        case RK_FORMAT_BGR_888:
+        case RK_FORMAT_RGB_565:
+        case RK_FORMAT_YCbCr_420_SP:
+        case RK_FORMAT_YCrCb_420_SP:
+        case RK_FORMAT_YCbCr_422_SP:
+        case RK_FORMAT_YCrCb_422_SP:
+        case RK_FORMAT_YCbCr_420_SP_10B:
+        case RK_FORMAT_YCrCb_420_SP_10B:
+        case RGA_FORMAT_YCbCr_420_SP_P010:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool RockchipRgaCpu::isYuv(int format)
+{
+    switch (format) {
+        case RK_FORMAT_YCbCr_420_SP:
+        case RK_FORMAT_YCrCb_420_SP:
+        case RK_FORMAT_YCbCr_422_SP:
+        case RK_FORMAT_YCrCb_422_SP:
+        case RK_FORMAT_YCbCr_420_SP_10B:
+        case RK_FORMAT_YCrCb_420_SP_10B:
+        case RGA_FORMAT_YCbCr_420_SP_P010:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int RockchipRgaCpu::bytesPerPixel(int format)
+{
+    switch (format) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_RGBX_8888:
+        case RK_FORMAT_BGRA_8888:
+            return 4;
+        case RK_FORMAT_RGB_888:
+        case RK_FORMAT_BGR_888:
+            return 3;
+        case RK_FORMAT_RGB_565:
+        case RGA_FORMAT_YCbCr_420_SP_P010:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+bool RockchipRgaCpu::supports(const struct rga_req *req)
+{
+    /* 10 bit frames are only read, by blits */
+    if (is10Bit(req->dst.format) ||
+            (req->render_mode != bitblt_mode && is10Bit(req->src.format)))
+        return false;
+
+    /* solid and gradient fills, patterns into packed rgb */
+    if (req->render_mode == color_fill_mode && req->color_fill_mode)
+        return supportsFormat(req->dst.format) && !isYuv(req->dst.format) &&
+                req->pat.yrgb_addr && req->pat.act_w && req->pat.act_h;
+    if (req->render_mode == color_fill_mode)
+        return supportsFormat(req->dst.format);
+
+    /* the filter keeps the size */
+    if (req->render_mode == blur_sharp_filter_mode)
+        return supportsFormat(req->src.format) && supportsFormat(req->dst.format) &&
+                req->src.act_w == req->dst.act_w && req->src.act_h == req->dst.act_h;
+
+    /* indexed src expands 1:1, see paletteRows */
+    if (req->render_mode == color_palette_mode)
+        return req->src.format >= RK_FORMAT_BPP1 &&
+                req->src.format <= RK_FORMAT_BPP8 &&
+                supportsFormat(req->dst.format) &&
+                req->src.act_w == req->dst.act_w && req->src.act_h == req->dst.act_h;
+    if (req->render_mode == update_palette_table_mode ||
+                        req->render_mode == update_patten_buff_mode)
+        return true;
+
+    /* aliased lines only */
+    if (req->render_mode == line_point_drawing_mode)
+        return supportsFormat(req->dst.format) && !(req->line_draw_info.flag & 0x1);
+
+    /* exact 1/2, 1/4 and 1/8 in both directions */
+    if (req->render_mode == pre_scaling_mode) {
+        int f = req->dst.act_w ? req->src.act_w / req->dst.act_w : 0;
+
+        return supportsFormat(req->src.format) && supportsFormat(req->dst.format) &&
+                (f == 2 || f == 4 || f == 8) &&
+                req->src.act_w == req->dst.act_w * f &&
+                req->src.act_h == req->dst.act_h * f;
+    }
+
+    if (req->render_mode != bitblt_mode)
+        return false;
+
+    if (!supportsFormat(req->src.format) || !supportsFormat(req->dst.format))
+        return false;
+
+    /* rops work on the bits of straight rgb rows */
+    if ((req->alpha_rop_flag & 0x2) && (req->rotate_mode ||
+            isYuv(req->src.format) || isYuv(req->dst.format) ||
+            (req->color_fill_mode && !req->pat.yrgb_addr)))
+        return false;
+
+    return true;
+}
+
+bool RockchipRgaCpu::is10Bit(int format)
+{
+    return format == RK_FORMAT_YCbCr_420_SP_10B ||
+            format == RK_FORMAT_YCrCb_420_SP_10B ||
+            format == RGA_FORMAT_YCbCr_420_SP_P010;
+}
+
+/* bytes of a row of a 10 bit plane */
+static inline int pitch10(const RockchipRgaCpu::Image *img)
+{
+    if (img->format == RGA_FORMAT_YCbCr_420_SP_P010)
+        return img->stride * 2;
+    return (img->stride * 10 + 7) / 8;
+}
+
+int RockchipRgaCpu::setupImage(Image *img, const rga_img_info_t *info,
+                                                                    int layout)
+{
+    uint8_t *base = (uint8_t *)(layout >= 2 ? info->uv_addr : info->yrgb_addr);
+    uint8_t *uv = (uint8_t *)(layout >= 2 ? info->v_addr : info->uv_addr);
+
+    if (!base || !supportsFormat(info->format))
+        return -EINVAL;
+
+    img->y = base;
+    img->uv = uv ? uv : base + info->vir_w * info->vir_h;
+    img->format = info->format;
+    img->stride = info->vir_w;
+    img->width = info->vir_w;
+    img->height = info->vir_h;
+    img->xoff = info->x_offset;
+    img->yoff = info->y_offset;
+    img->actW = info->act_w;
+    img->actH = info->act_h;
+    img->depth = RGA_DEPTH_TRUNCATE;
+
+    /* the library places chroma after vir_w * vir_h bytes */
+    if (is10Bit(img->format))
+        img->uv = base + pitch10(img) * img->height;
+
+    return 0;
+}
+
+void RockchipRgaCpu::unpack10(const Image *img, bool chroma, int y, int x,
+                                                        int n, uint16_t *out)
+{
+    const uint8_t *row = (chroma ? img->uv : img->y) + y * pitch10(img);
+    int i = 0;
+
+    if (img->format == RGA_FORMAT_YCbCr_420_SP_P010) {
+        const uint16_t *in = (const uint16_t *)row + x;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        if (RockchipRgaCpu::simd()) {
+            for (; i + 8 <= n; i += 8)
+                vst1q_u16(out + i, vshrq_n_u16(vld1q_u16(in + i), 6));
+        }
+#endif
+        for (; i < n; i++)
+            out[i] = in[i] >> 6;
+        return;
+    }
+
+    /* scalar up to a 5 byte group, a sample spans 2 bytes */
+    for (; i < n && ((x + i) & 3); i++) {
+        int bit = (x + i) * 10;
+
+        out[i] = ((row[bit >> 3] | (row[(bit >> 3) + 1] << 8)) >> (bit & 7)) & 0x3ff;
+    }
+
+#if defined(__aarch64__)
+    /*
+     * 8 samples are 10 bytes, gather the 2 bytes of each into its lane and
+     * shift it down. The 16 byte load stays within the samples left.
+     */
+    static const uint8_t gather[16] = {0, 1, 1, 2, 2, 3, 3, 4,
+                                        5, 6, 6, 7, 7, 8, 8, 9};
+    static const int16_t shifts[8] = {0, -2, -4, -6, 0, -2, -4, -6};
+    uint8x16_t index = vld1q_u8(gather);
+    int16x8_t shift = vld1q_s16(shifts);
+    uint16x8_t mask = vdupq_n_u16(0x3ff);
+
+    for (; i + 16 <= n; i += 8) {
+        uint8x16_t bytes = vld1q_u8(row + (x + i) * 10 / 8);
+        uint16x8_t pairs = vreinterpretq_u16_u8(vqtbl1q_u8(bytes, index));
+
+        vst1q_u16(out + i, vandq_u16(vshlq_u16(pairs, shift), mask));
+    }
+#endif
+
+    for (; i < n; i++) {
+        int bit = (x + i) * 10;
+
+        out[i] = ((row[bit >> 3] | (row[(bit >> 3) + 1] << 8)) >> (bit & 7)) & 0x3ff;
+    }
+}
+
+/*
+ * PQ code value to 8 bit sdr: the PQ curve to nits, the extended reinhard
+ * curve with 203 nits as white and 1000 nits as peak, gamma 2.2.
+ */
+struct ToneCurve {
+    uint8_t     lut[1024];
+
+    ToneCurve() {
+        const double m1 = 0.1593017578125, m2 = 78.84375;
+        const double c1 = 0.8359375, c2 = 18.8515625, c3 = 18.6875;
+        const double peak = 1000.0 / 203.0;
+
+        for (int i = 0; i < 1024; i++) {
+            double e = pow(i / 1023.0, 1.0 / m2);
+            double l = pow(fmax(e - c1, 0.0) / (c2 - c3 * e), 1.0 / m1) *
+                                                            10000.0 / 203.0;
+
+            l = l * (1.0 + l / (peak * peak)) / (1.0 + l);
+            lut[i] = clamp255((int)(pow(fmin(l, 1.0), 1.0 / 2.2) * 255.0 + 0.5));
+        }
+    }
+};
+
+static inline int clamp1023(int v)
+{
+    return v < 0 ? 0 : (v > 1023 ? 1023 : v);
+}
+
+/*
+ * Truncation drops the low bits of each sample first, like the rga, then
+ * converts as an 8 bit frame. Rounding converts at 10 bits and rounds the
+ * result. Tone mapping converts with the bt.2020 matrix.
+ */
+static inline uint32_t yuv10ToRgb(int y, int u, int v, int depth)
+{
+    static const ToneCurve tone;
+    int c, d = u - 512, e = v - 512;
+
+    switch (depth) {
+        case RGA_DEPTH_ROUND:
+            c = 298 * (y - 64) + 512;
+            return RGA_CPU_PACK(clamp255((c + 409 * e) >> 10),
+                                clamp255((c - 100 * d - 208 * e) >> 10),
+                                clamp255((c + 516 * d) >> 10), 0xff);
+        case RGA_DEPTH_TONEMAP:
+            c = 299 * (y - 64) + 128;
+            return RGA_CPU_PACK(tone.lut[clamp1023((c + 431 * e) >> 8)],
+                                tone.lut[clamp1023((c - 48 * d - 167 * e) >> 8)],
+                                tone.lut[clamp1023((c + 550 * d) >> 8)], 0xff);
+        default:
+            return yuvToRgb(y >> 2, u >> 2, v >> 2);
+    }
+}
+
+/*
+ * Pixels [x, x + n) of row y of a 10 bit image in one pass, 128 at a time
+ * on the stack. Truncation and rounding convert 8 pixels per step.
+ */
+static void loadRow10(const RockchipRgaCpu::Image *img, int y, int x, int n,
+                                                                uint32_t *out)
+{
+    uint16_t luma[128], chroma[130];
+    bool crFirst = img->format == RK_FORMAT_YCrCb_420_SP_10B;
+    int depth = img->depth;
+
+    while (n > 0) {
+        int count = n < 128 ? n : 128;
+        int odd = x & 1;
+        int i = 0;
+
+        RockchipRgaCpu::unpack10(img, false, y, x, count, luma);
+        RockchipRgaCpu::unpack10(img, true, y >> 1, x - odd,
+                                            (count + odd + 1) & ~1, chroma);
+        if (crFirst) {
+            for (int k = 0; k < count + odd; k += 2) {
+                uint16_t t = chroma[k];
+
+                chroma[k] = chroma[k + 1];
+                chroma[k + 1] = t;
+            }
+        }
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        if (RockchipRgaCpu::simd() && !odd && depth != RGA_DEPTH_TONEMAP) {
+            int pre = depth == RGA_DEPTH_ROUND ? 0 : 2;
+            int16x8_t yOff = vdupq_n_s16(depth == RGA_DEPTH_ROUND ? 64 : 16);
+            int16x4_t cOff = vdup_n_s16(depth == RGA_DEPTH_ROUND ? 512 : 128);
+            int32x4_t bias = vdupq_n_s32(depth == RGA_DEPTH_ROUND ? 512 : 128);
+            int32x4_t shift = vdupq_n_s32(depth == RGA_DEPTH_ROUND ? -10 : -8);
+            int16x8_t preShift = vdupq_n_s16(-pre);
+
+            for (; i + 8 <= count; i += 8) {
+                uint16x4x2_t uv = vld2_u16(chroma + i);
+                int16x8_t ys = vsubq_s16(vshlq_s16(vreinterpretq_s16_u16(
+                                        vld1q_u16(luma + i)), preShift), yOff);
+                int16x4_t us = vsub_s16(vshl_s16(vreinterpret_s16_u16(uv.val[0]),
+                                        vget_low_s16(preShift)), cOff);
+                int16x4_t vs = vsub_s16(vshl_s16(vreinterpret_s16_u16(uv.val[1]),
+                                        vget_low_s16(preShift)), cOff);
+                int16x4x2_t u2 = vzip_s16(us, us), v2 = vzip_s16(vs, vs);
+                uint8x8x4_t rgba;
+                int32x4_t c[2], r[2], g[2], b[2];
+
+                for (int h = 0; h < 2; h++) {
+                    int16x4_t yh = h ? vget_high_s16(ys) : vget_low_s16(ys);
+
+                    c[h] = vmlal_n_s16(bias, yh, 298);
+                    r[h] = vmlal_n_s16(c[h], v2.val[h], 409);
+                    g[h] = vmlsl_n_s16(vmlsl_n_s16(c[h], u2.val[h], 100),
+                                                            v2.val[h], 208);
+                    b[h] = vmlal_n_s16(c[h], u2.val[h], 516);
+                }
+
+#define RGA_NARROW(x)   vqmovn_u16(vcombine_u16(vqmovun_s32(vshlq_s32(x[0], shift)), \
+                                                vqmovun_s32(vshlq_s32(x[1], shift))))
+                rgba.val[0] = RGA_NARROW(r);
+                rgba.val[1] = RGA_NARROW(g);
+                rgba.val[2] = RGA_NARROW(b);
+                rgba.val[3] = vdup_n_u8(0xff);
+#undef RGA_NARROW
+                vst4_u8((uint8_t *)(out + i), rgba);
+            }
+        }
+#endif
+
+        for (; i < count; i++) {
+            const uint16_t *p = chroma + ((i + odd) & ~1);
+
+            out[i] = yuv10ToRgb(luma[i], p[0], p[1], depth);
+        }
+
+        out += count;
+        x += count;
+        n -= count;
+    }
+}
+
+uint32_t RockchipRgaCpu::loadPixel(const Image *img, int x, int y)
+{
+    const uint8_t *p;
+    uint32_t c;
+    uint16_t v;
+
+    switch (img->format) {
+        case RK_FORMAT_RGBA_8888:
+            memcpy(&c, img->y + (y * img->stride + x) * 4, 4);
+            return c;
+        case RK_FORMAT_RGBX_8888:
+            memcpy(&c, img->y + (y * img->stride + x) * 4, 4);
+            return c | 0xff000000;
+        case RK_FORMAT_BGRA_8888:
+            memcpy(&c, img->y + (y * img->stride + x) * 4, 4);
+            return swapRB(c);
+        case RK_FORMAT_RGB_888:
+            p = img->y + (y * img->stride + x) * 3;
+            return RGA_CPU_PACK(p[0], p[1], p[2], 0xff);
+        case RK_FORMAT_BGR_888:
+            p = img->y + (y * img->stride + x) * 3;
+            return RGA_CPU_PACK(p[2], p[1], p[0], 0xff);
+        case RK_FORMAT_RGB_565:
+            memcpy(&v, img->y + (y * img->stride + x) * 2, 2);
+            return RGA_CPU_PACK(((v >> 8) & 0xf8) | (v >> 13),
+                                ((v >> 3) & 0xfc) | ((v >> 9) & 0x3),
+                                ((v << 3) & 0xf8) | ((v >> 2) & 0x7), 0xff);
+        case RK_FORMAT_YCbCr_420_SP_10B:
+        case RK_FORMAT_YCrCb_420_SP_10B:
+        case RGA_FORMAT_YCbCr_420_SP_P010: {
+            uint16_t luma, chroma[2];
+
+            unpack10(img, false, y, x, 1, &luma);
+            unpack10(img, true, y >> 1, x & ~1, 2, chroma);
+            if (img->format == RK_FORMAT_YCrCb_420_SP_10B)
+                return yuv10ToRgb(luma, chroma[1], chroma[0], img->depth);
+            return yuv10ToRgb(luma, chroma[0], chroma[1], img->depth);
+        }
+        case RK_FORMAT_YCbCr_420_SP:
+        case RK_FORMAT_YCrCb_420_SP:
+        case RK_FORMAT_YCbCr_422_SP:
+        case RK_FORMAT_YCrCb_422_SP:
+            p = img->uv + (img->format == RK_FORMAT_YCbCr_420_SP ||
+                           img->format == RK_FORMAT_YCrCb_420_SP ?
+                                        y >> 1 : y) * img->stride + (x & ~1);
+            if (img->format == RK_FORMAT_YCrCb_420_SP ||
+                                        img->format == RK_FORMAT_YCrCb_422_SP)
+                return yuvToRgb(img->y[y * img->stride + x], p[1], p[0]);
+            return yuvToRgb(img->y[y * img->stride + x], p[0], p[1]);
+        default:
+            return 0;
+    }
+}
+
+void RockchipRgaCpu::storePixel(const Image *img, int x, int y, uint32_t c)
+{
+    uint8_t *p;
+    uint16_t v;
+    bool sub420;
+
+    switch (img->format) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_RGBX_8888:
+            memcpy(img->y + (y * img->stride + x) * 4, &c, 4);
+            break;
+        case RK_FORMAT_BGRA_8888:
+            c = swapRB(c);
+            memcpy(img->y + (y * img->stride + x) * 4, &c, 4);
+            break;
+        case RK_FORMAT_RGB_888:
+            p = img->y + (y * img->stride + x) * 3;
+            p[0] = RGA_CPU_R(c);
+            p[1] = RGA_CPU_G(c);
+            p[2] = RGA_CPU_B(c);
+            break;
+        case RK_FORMAT_BGR_888:
+            p = img->y + (y * img->stride + x) * 3;
+            p[0] = RGA_CPU_B(c);
+            p[1] = RGA_CPU_G(c);
+            p[2] = RGA_CPU_R(c);
+            break;
+        case RK_FORMAT_RGB_565:
+            v = ((RGA_CPU_R(c) & 0xf8) << 8) | ((RGA_CPU_G(c) & 0xfc) << 3) |
+                                                            (RGA_CPU_B(c) >> 3);
+            memcpy(img->y + (y * img->stride + x) * 2, &v, 2);
+            break;
+        case RK_FORMAT_YCbCr_420_SP:
+        case RK_FORMAT_YCrCb_420_SP:
+        case RK_FORMAT_YCbCr_422_SP:
+        case RK_FORMAT_YCrCb_422_SP:
+            img->y[y * img->stride + x] = rgbToY(c);
+            sub420 = img->format == RK_FORMAT_YCbCr_420_SP ||
+                     img->format == RK_FORMAT_YCrCb_420_SP;
+            /* chroma is point sampled at the even pixel of each block */
+            if ((x & 1) || (sub420 && (y & 1)))
+                break;
+            p = img->uv + (sub420 ? y >> 1 : y) * img->stride + x;
+            if (img->format == RK_FORMAT_YCrCb_420_SP ||
+                                        img->format == RK_FORMAT_YCrCb_422_SP) {
+                p[0] = rgbToV(c);
+                p[1] = rgbToU(c);
+            } else {
+                p[0] = rgbToU(c);
+                p[1] = rgbToV(c);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void RockchipRgaCpu::loadRow(const Image *img, int y, const int *xmap,
+                                                        int n, uint32_t *out)
+{
+    const uint32_t *row32 = (const uint32_t *)(img->y + y * img->stride * 4);
+    int i;
+
+    switch (img->format) {
+        case RK_FORMAT_RGBA_8888:
+            for (i = 0; i < n; i++)
+                out[i] = row32[xmap[i]];
+            break;
+        case RK_FORMAT_RGBX_8888:
+            for (i = 0; i < n; i++)
+                out[i] = row32[xmap[i]] | 0xff000000;
+            break;
+        case RK_FORMAT_BGRA_8888:
+            for (i = 0; i < n; i++)
+                out[i] = swapRB(row32[xmap[i]]);
+            break;
+        case RK_FORMAT_YCbCr_420_SP_10B:
+        case RK_FORMAT_YCrCb_420_SP_10B:
+        case RGA_FORMAT_YCbCr_420_SP_P010:
+            /* runs of neighbouring pixels convert in one pass */
+            for (i = 0; i < n; ) {
+                int run = 1;
+
+                while (i + run < n && xmap[i + run] == xmap[i] + run)
+                    run++;
+                loadRow10(img, y, xmap[i], run, out + i);
+                i += run;
+            }
+            break;
+        default:
+            for (i = 0; i < n; i++)
+                out[i] = loadPixel(img, xmap[i], y);
+            break;
+    }
+}
+
+void RockchipRgaCpu::storeRow(const Image *img, int x, int y, int n,
+                                                        const uint32_t *in)
+{
+    uint32_t *row32 = (uint32_t *)(img->y + y * img->stride * 4) + x;
+    int i;
+
+    switch (img->format) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_RGBX_8888:
+            memcpy(row32, in, n * 4);
+            break;
+        case RK_FORMAT_BGRA_8888:
+            for (i = 0; i < n; i++)
+                row32[i] = swapRB(in[i]);
+            break;
+        default:
+            for (i = 0; i < n; i++)
+                storePixel(img, x + i, y, in[i]);
+            break;
+    }
+}
+
+static inline uint32_t blendPixel(uint32_t s, uint32_t d,
+                                int alphaMode, int global, bool premultiplied)
+{
+    int a, sa, r, g, b, oa;
+
+    switch (alphaMode) {
+        case 0:
+            a = global;
+            break;
+        case 1:
+            a = RGA_CPU_A(s);
+            break;
+        default:
+            a = div255(RGA_CPU_A(s) * global);
+            break;
+    }
+
+    /* premultiplied src-over only scales the source by the plane alpha */
+    sa = premultiplied ? (alphaMode == 1 ? 255 : global) : a;
+
+    r = div255(RGA_CPU_R(s) * sa + RGA_CPU_R(d) * (255 - a));
+    g = div255(RGA_CPU_G(s) * sa + RGA_CPU_G(d) * (255 - a));
+    b = div255(RGA_CPU_B(s) * sa + RGA_CPU_B(d) * (255 - a));
+    oa = a + div255(RGA_CPU_A(d) * (255 - a));
+
+    return RGA_CPU_PACK(clamp255(r), clamp255(g), clamp255(b), clamp255(oa));
+}
+
+/*
+ * Solid spans. Fills larger than the cache go around it with non-temporal
+ * pair stores on aarch64, the data would only evict what the caller uses.
+ */
+static void fillSpan32(uint32_t *p, uint32_t value, int n, bool stream)
+{
+    int i = 0;
+
+#if defined(__aarch64__)
+    if (stream) {
+        uint32x4_t v = vdupq_n_u32(value);
+
+        for (; i < n && ((uintptr_t)(p + i) & 31); i++)
+            p[i] = value;
+        for (; i + 8 <= n; i += 8)
+            asm volatile("stnp %q0, %q0, [%1]" : : "w"(v), "r"(p + i) : "memory");
+    }
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        uint32x4_t v = vdupq_n_u32(value);
+
+        for (; i + 4 <= n; i += 4)
+            vst1q_u32(p + i, v);
+    }
+#endif
+
+    for (; i < n; i++)
+        p[i] = value;
+}
+
+static void fillSpan16(uint16_t *p, uint16_t value, int n, bool stream)
+{
+    if (n > 0 && ((uintptr_t)p & 2)) {
+        *p++ = value;
+        n--;
+    }
+
+    fillSpan32((uint32_t *)p, value | ((uint32_t)value << 16), n >> 1, stream);
+    if (n & 1)
+        p[n - 1] = value;
+}
+
+static void fillSolid(const RockchipRgaCpu::Image *dst, uint32_t c,
+                                        int x0, int n, int y0, int y1)
+{
+    bool stream = (int64_t)n * (y1 - y0) * RockchipRgaCpu::bytesPerPixel(dst->format) >=
+                                            RockchipRgaThreadPool::cacheSize();
+    uint8_t pixel[4] = {0};
+    RockchipRgaCpu::Image one = *dst;
+    std::vector<uint32_t> row;
+    uint16_t value16;
+    uint32_t value32;
+    int y;
+
+    /* the pixel in dst format */
+    one.y = pixel;
+    one.stride = 1;
+    if (!RockchipRgaCpu::isYuv(dst->format))
+        RockchipRgaCpu::storePixel(&one, 0, 0, c);
+    memcpy(&value32, pixel, 4);
+    memcpy(&value16, pixel, 2);
+
+    switch (dst->format) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_RGBX_8888:
+        case RK_FORMAT_BGRA_8888:
+            for (y = y0; y < y1; y++)
+                fillSpan32((uint32_t *)(dst->y + (y * dst->stride + x0) * 4),
+                                                        value32, n, stream);
+            break;
+        case RK_FORMAT_RGB_565:
+            for (y = y0; y < y1; y++)
+                fillSpan16((uint16_t *)(dst->y + (y * dst->stride + x0) * 2),
+                                                        value16, n, stream);
+            break;
+        case RK_FORMAT_YCbCr_420_SP:
+        case RK_FORMAT_YCrCb_420_SP:
+        case RK_FORMAT_YCbCr_422_SP:
+        case RK_FORMAT_YCrCb_422_SP: {
+            bool sub420 = dst->format == RK_FORMAT_YCbCr_420_SP ||
+                          dst->format == RK_FORMAT_YCrCb_420_SP;
+            bool vu = dst->format == RK_FORMAT_YCrCb_420_SP ||
+                      dst->format == RK_FORMAT_YCrCb_422_SP;
+            /* chroma is sampled at the even pixels, as storePixel does */
+            int cx0 = (x0 + 1) & ~1, cn = (x0 + n - cx0 + 1) >> 1;
+
+            pixel[0] = vu ? rgbToV(c) : rgbToU(c);
+            pixel[1] = vu ? rgbToU(c) : rgbToV(c);
+            memcpy(&value16, pixel, 2);
+
+            for (y = y0; y < y1; y++) {
+                memset(dst->y + y * dst->stride + x0, rgbToY(c), n);
+                if (sub420 && (y & 1))
+                    continue;
+                fillSpan16((uint16_t *)(dst->uv + (sub420 ? y >> 1 : y) *
+                                        dst->stride + cx0), value16, cn, stream);
+            }
+            break;
+        }
+        default:
+            row.assign(n, c);
+            for (y = y0; y < y1; y++)
+                RockchipRgaCpu::storeRow(dst, x0, y, n, &row[0]);
+            break;
+    }
+}
+
+/*
+ * Color fill of the dst act area, rows [v0, v1) of it. fg_color is the
+ * color of the top left pixel in RGBA memory order, gr_color the change of
+ * each channel per pixel right and down in 8.8 fixed point. The gradient
+ * saturates when bit 6 of alpha_rop_flag is set and wraps otherwise.
+ * Like the rga, only the pixels inside the absolute clip are written.
+ */
+static int fillRows(const struct rga_req *req,
+                            const RockchipRgaCpu::Image *dst, int v0, int v1)
+{
+    const COLOR_FILL *gr = &req->gr_color;
+    int dx[4] = {gr->gr_x_r, gr->gr_x_g, gr->gr_x_b, gr->gr_x_a};
+    int dy[4] = {gr->gr_y_r, gr->gr_y_g, gr->gr_y_b, gr->gr_y_a};
+    bool saturate = (req->alpha_rop_flag >> 6) & 0x1;
+    uint32_t c = req->fg_color;
+    int x0 = dst->xoff, n = dst->actW, u0 = 0;
+
+    if (v0 < 0)
+        v0 = 0;
+    if (v1 > dst->actH)
+        v1 = dst->actH;
+    if (dst->yoff + v0 < req->clip.ymin)
+        v0 = req->clip.ymin - dst->yoff;
+    if (dst->yoff + v1 > req->clip.ymax + 1)
+        v1 = req->clip.ymax + 1 - dst->yoff;
+    if (dst->yoff + v1 > dst->height)
+        v1 = dst->height - dst->yoff;
+    if (x0 < req->clip.xmin)
+        u0 = req->clip.xmin - x0;
+    if (x0 + n > req->clip.xmax + 1)
+        n = req->clip.xmax + 1 - x0;
+    if (x0 + n > dst->width)
+        n = dst->width - x0;
+    if (n <= u0 || v1 <= v0)
+        return 0;
+
+    if (!dx[0] && !dx[1] && !dx[2] && !dx[3] && !dy[0] && !dy[1] && !dy[2] && !dy[3]) {
+        fillSolid(dst, c, x0 + u0, n - u0, dst->yoff + v0, dst->yoff + v1);
+        return 0;
+    }
+
+    std::vector<uint32_t> row(n);
+
+    for (int v = v0; v < v1; v++) {
+        int base[4];
+
+        for (int k = 0; k < 4; k++)
+            base[k] = (int)(((c >> (k * 8)) & 0xff) << 8) + dy[k] * v;
+
+        for (int u = u0; u < n; u++) {
+            uint32_t pixel = 0;
+
+            for (int k = 0; k < 4; k++) {
+                int value = (base[k] + dx[k] * u) >> 8;
+
+                value = saturate ? clamp255(value) : (value & 0xff);
+                pixel |= (uint32_t)value << (k * 8);
+            }
+            row[u] = pixel;
+        }
+
+        RockchipRgaCpu::storeRow(dst, x0 + u0, dst->yoff + v, n - u0,
+                                                                &row[u0]);
+    }
+
+    return 0;
+}
+
+/*
+ * One segment of line_point_drawing_mode, both end points are drawn unless
+ * bit 1 of the flag clears the last one. It is stepped with Bresenham and a
+ * wide line is a span of line_width pixels across the major axis at each
+ * step. Only rows [v0, v1) of the dst act area are touched.
+ */
+static int lineRows(const struct rga_req *req,
+                            const RockchipRgaCpu::Image *dst, int v0, int v1)
+{
+    const line_draw_t *line = &req->line_draw_info;
+    int x = line->start_point.x, y = line->start_point.y;
+    int x1 = line->end_point.x, y1 = line->end_point.y;
+    int dx = abs(x1 - x), dy = -abs(y1 - y);
+    int sx = x < x1 ? 1 : -1, sy = y < y1 ? 1 : -1;
+    int err = dx + dy, e2;
+    int width = line->line_width > 0 ? line->line_width : 1;
+    int lo = -((width - 1) / 2), hi = width / 2;
+    bool last = (line->flag >> 1) & 0x1;
+    bool xMajor = dx >= -dy;
+    int xmin = req->clip.xmin, xmax = req->clip.xmax;
+    int ymin = dst->yoff + v0, ymax = dst->yoff + v1 - 1;
+
+    if (ymin < req->clip.ymin)
+        ymin = req->clip.ymin;
+    if (ymax > req->clip.ymax)
+        ymax = req->clip.ymax;
+    if (xmin < 0)
+        xmin = 0;
+    if (xmax >= dst->width)
+        xmax = dst->width - 1;
+    if (ymin < 0)
+        ymin = 0;
+    if (ymax >= dst->height)
+        ymax = dst->height - 1;
+
+    for (;;) {
+        bool end = x == x1 && y == y1;
+
+        if (end && !last)
+            break;
+
+        for (int k = lo; k <= hi; k++) {
+            int px = xMajor ? x : x + k;
+            int py = xMajor ? y + k : y;
+
+            if (px >= xmin && px <= xmax && py >= ymin && py <= ymax)
+                RockchipRgaCpu::storePixel(dst, px, py, line->color);
+        }
+
+        if (end)
+            break;
+
+        e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Dithered stores into rgb565, bit 5 of alpha_rop_flag. The ordered dither
+ * adds the 4x4 bayer threshold, scaled to the bits a channel drops, in the
+ * same pass that packs the pixels. dither_mode 1 diffuses the error down
+ * and right instead (floyd-steinberg), carried from row to row in err.
+ * stripeRows keeps such a frame in one stripe, so the output does not
+ * depend on the cache size or the worker count.
+ */
+static const uint8_t bayer4x4[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5},
+};
+
+static inline uint32_t ditherPixel(uint32_t c, int x, int y)
+{
+    int d = bayer4x4[y & 3][x & 3];
+
+    /* 5 bits drop 3, 6 bits drop 2 */
+    return RGA_CPU_PACK(clamp255(RGA_CPU_R(c) + (d >> 1)),
+                        clamp255(RGA_CPU_G(c) + (d >> 2)),
+                        clamp255(RGA_CPU_B(c) + (d >> 1)), RGA_CPU_A(c));
+}
+
+static void storeRow565Ordered(const RockchipRgaCpu::Image *dst, int x, int y,
+                                                int n, const uint32_t *row)
+{
+    uint16_t *out = (uint16_t *)(dst->y + (y * dst->stride + x) * 2);
+    uint8_t rb[8], g[8];
+    int i = 0;
+
+    /* the threshold repeats every 4 pixels, 8 lanes line up with any x */
+    for (int k = 0; k < 8; k++) {
+        rb[k] = bayer4x4[y & 3][(x + k) & 3] >> 1;
+        g[k] = bayer4x4[y & 3][(x + k) & 3] >> 2;
+    }
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        uint8x8_t addRb = vld1_u8(rb), addG = vld1_u8(g);
+
+        for (; i + 8 <= n; i += 8) {
+            uint8x8x4_t c = vld4_u8((const uint8_t *)(row + i));
+            uint16x8_t r = vshll_n_u8(vqadd_u8(c.val[0], addRb), 8);
+            uint16x8_t gr = vshll_n_u8(vqadd_u8(c.val[1], addG), 8);
+            uint16x8_t b = vshll_n_u8(vqadd_u8(c.val[2], addRb), 8);
+
+            vst1q_u16(out + i, vsriq_n_u16(vsriq_n_u16(r, gr, 5), b, 11));
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        int r = clamp255(RGA_CPU_R(row[i]) + rb[i & 7]);
+        int gr = clamp255(RGA_CPU_G(row[i]) + g[i & 7]);
+        int b = clamp255(RGA_CPU_B(row[i]) + rb[i & 7]);
+
+        out[i] = ((r & 0xf8) << 8) | ((gr & 0xfc) << 3) | (b >> 3);
+    }
+}
+
+/* err holds two rows of n + 2 pixels, 3 channels in 16ths */
+static void storeRow565Diffused(const RockchipRgaCpu::Image *dst, int x, int y,
+                                    int n, const uint32_t *row, int *err)
+{
+    static const int keep[3] = {0xf8, 0xfc, 0xf8};
+    uint16_t *out = (uint16_t *)(dst->y + (y * dst->stride + x) * 2);
+    int *cur = err + (y & 1) * (n + 2) * 3;
+    int *next = err + (~y & 1) * (n + 2) * 3;
+
+    memset(next, 0, (n + 2) * 3 * sizeof(int));
+
+    for (int i = 0; i < n; i++) {
+        int q[3];
+
+        for (int k = 0; k < 3; k++) {
+            int *e = cur + (i + 1) * 3 + k;
+            int value = clamp255(((row[i] >> (k * 8)) & 0xff) + (*e + 8) / 16);
+            int left = value - (value & keep[k]);
+
+            q[k] = value & keep[k];
+            e[3] += left * 7;
+            next[i * 3 + k] += left * 3;
+            next[(i + 1) * 3 + k] += left * 5;
+            next[(i + 2) * 3 + k] += left;
+        }
+
+        out[i] = (q[0] << 8) | (q[1] << 3) | (q[2] >> 3);
+    }
+}
+
+static void storeDithered(const struct rga_req *req,
+            const RockchipRgaCpu::Image *dst, int x, int y, int n,
+            const uint32_t *row, std::vector<int> *err)
+{
+    if (!((req->alpha_rop_flag >> 5) & 0x1) || dst->format != RK_FORMAT_RGB_565) {
+        RockchipRgaCpu::storeRow(dst, x, y, n, row);
+        return;
+    }
+
+    if (!req->dither_mode) {
+        storeRow565Ordered(dst, x, y, n, row);
+        return;
+    }
+
+    if (err->size() < (size_t)(n + 2) * 6)
+        err->assign((n + 2) * 6, 0);
+    storeRow565Diffused(dst, x, y, n, row, &(*err)[0]);
+}
+
+/* binomial taps of radius 1..4, they sum to 1 << 2r */
+static const uint8_t blurTaps[4][9] = {
+    {1, 2, 1},
+    {1, 4, 6, 4, 1},
+    {1, 6, 15, 20, 15, 6, 1},
+    {1, 8, 28, 56, 70, 56, 28, 8, 1},
+};
+
+static void blurRowV(const uint8_t **rows, const uint8_t *taps, int count,
+                                                    int n, uint16_t *out)
+{
+    int i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        for (; i + 8 <= n; i += 8) {
+            uint16x8_t acc = vmull_u8(vld1_u8(rows[0] + i), vdup_n_u8(taps[0]));
+
+            for (int k = 1; k < count; k++)
+                acc = vmlal_u8(acc, vld1_u8(rows[k] + i), vdup_n_u8(taps[k]));
+            vst1q_u16(out + i, acc);
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        int sum = 0;
+
+        for (int k = 0; k < count; k++)
+            sum += taps[k] * rows[k][i];
+        out[i] = sum;
+    }
+}
+
+/* in holds count - 1 more pixels than out, channels are 4 apart */
+static void blurRowH(const uint16_t *in, const uint8_t *taps, int count,
+                                            int shift, int n, uint8_t *out)
+{
+    int i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        int32x4_t right = vdupq_n_s32(-shift);
+
+        for (; i + 8 <= n; i += 8) {
+            uint16x8_t x = vld1q_u16(in + i);
+            uint32x4_t lo = vmull_n_u16(vget_low_u16(x), taps[0]);
+            uint32x4_t hi = vmull_n_u16(vget_high_u16(x), taps[0]);
+
+            for (int k = 1; k < count; k++) {
+                x = vld1q_u16(in + i + k * 4);
+                lo = vmlal_n_u16(lo, vget_low_u16(x), taps[k]);
+                hi = vmlal_n_u16(hi, vget_high_u16(x), taps[k]);
+            }
+
+            lo = vrshlq_u32(lo, right);
+            hi = vrshlq_u32(hi, right);
+            vst1_u8(out + i, vqmovn_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi))));
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        uint32_t sum = 0;
+
+        for (int k = 0; k < count; k++)
+            sum += taps[k] * in[i + k * 4];
+        out[i] = clamp255((sum + (1u << (shift - 1))) >> shift);
+    }
+}
+
+/*
+ * blur_sharp_filter_mode: bit 2 of bsfilter_flag picks sharpen over blur,
+ * bits 1:0 the strength. A blur of strength t is a binomial filter of
+ * radius t + 1, sharpen adds (t + 1) / 2 times the detail a radius 1 blur
+ * removes. Rows and columns around the src act area are read for the
+ * edges, the edges of the buffer repeat.
+ */
+static int filterRows(const struct rga_req *req, const RockchipRgaCpu::Image *src,
+                        const RockchipRgaCpu::Image *dst, int v0, int v1)
+{
+    bool sharpen = (req->bsfilter_flag >> 2) & 0x1;
+    int strength = req->bsfilter_flag & 0x3;
+    int radius = sharpen ? 1 : strength + 1;
+    int count = radius * 2 + 1;
+    int amount = (strength + 1) * 128;
+    const uint8_t *taps = blurTaps[radius - 1];
+    int w = src->actW, span = w + radius * 2;
+    std::vector<uint32_t> lines(count * span), row(w);
+    std::vector<int> tags(count, -1), xmap(span);
+    std::vector<uint16_t> acc(span * 4);
+    std::vector<const uint8_t *> rows(count);
+    std::vector<int> err;
+    /* like a blit the act area may reach past vir_h, its rows exist */
+    int height = src->yoff + src->actH > src->height ?
+                                        src->yoff + src->actH : src->height;
+
+    for (int i = 0; i < span; i++) {
+        int x = src->xoff + i - radius;
+
+        xmap[i] = x < 0 ? 0 : (x >= src->width ? src->width - 1 : x);
+    }
+
+    if (v1 > dst->actH)
+        v1 = dst->actH;
+    if (dst->yoff + v1 > dst->height)
+        v1 = dst->height - dst->yoff;
+    if (dst->xoff + w > dst->width)
+        w = dst->width - dst->xoff;
+
+    for (int v = v0; v < v1 && w > 0; v++) {
+        for (int k = 0; k < count; k++) {
+            int y = src->yoff + v + k - radius;
+            int slot;
+
+            y = y < 0 ? 0 : (y >= height ? height - 1 : y);
+            slot = y % count;
+            if (tags[slot] != y) {
+                RockchipRgaCpu::loadRow(src, y, &xmap[0], span,
+                                                    &lines[slot * span]);
+                tags[slot] = y;
+            }
+            rows[k] = (const uint8_t *)&lines[slot * span];
+        }
+
+        blurRowV(&rows[0], taps, count, span * 4, &acc[0]);
+        blurRowH(&acc[0], taps, count, radius * 4, w * 4, (uint8_t *)&row[0]);
+
+        if (sharpen) {
+            const uint8_t *s = rows[radius] + radius * 4;
+            uint8_t *b = (uint8_t *)&row[0];
+
+            for (int i = 0; i < w * 4; i++)
+                b[i] = (i & 3) == 3 ? s[i] :
+                        clamp255(s[i] + (((s[i] - b[i]) * amount) >> 8));
+        }
+
+        storeDithered(req, dst, dst->xoff, dst->yoff + v, w, &row[0], &err);
+    }
+
+    return 0;
+}
+
+/*
+ * color_palette_mode: the src holds 1 << palette_mode bits per pixel,
+ * endian_mode 0 has the first pixel in the high bits of a byte. 1bpp takes
+ * its two colors from fg_color/bg_color, the other depths from the table
+ * at LUT_addr. Colors are in the layout of an rgba_8888 pixel.
+ */
+static void unpackIndexes(const uint8_t *src, int x, int n, int bits,
+                                                bool lsbFirst, uint8_t *idx)
+{
+    int perByte = 8 / bits, mask = (1 << bits) - 1;
+
+    if (bits == 8) {
+        memcpy(idx, src + x, n);
+        return;
+    }
+
+    for (int i = 0; i < n; i++) {
+        int p = x + i;
+        int shift = (p % perByte) * bits;
+
+        if (!lsbFirst)
+            shift = 8 - bits - shift;
+        idx[i] = (src[p / perByte] >> shift) & mask;
+    }
+}
+
+/* planes[c][i] is channel c of table entry i */
+static void lookupRow(const uint8_t (*planes)[256], int entries,
+                                    const uint8_t *idx, int n, uint32_t *row)
+{
+    int i = 0;
+
+#if defined(__aarch64__)
+    /* tbl answers 0 for indexes past its table, so 64 entry slices add up */
+    uint8x16x4_t table[4][4];
+    int slices = (entries + 63) / 64;
+
+    for (int s = 0; s < slices; s++)
+        for (int c = 0; c < 4; c++)
+            for (int q = 0; q < 4; q++)
+                table[s][c].val[q] = vld1q_u8(planes[c] + s * 64 + q * 16);
+
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t in = vld1q_u8(idx + i);
+        uint8x16x4_t out;
+
+        for (int c = 0; c < 4; c++)
+            out.val[c] = vqtbl4q_u8(table[0][c], in);
+        for (int s = 1; s < slices; s++) {
+            uint8x16_t slice = vsubq_u8(in, vdupq_n_u8(s * 64));
+
+            for (int c = 0; c < 4; c++)
+                out.val[c] = vorrq_u8(out.val[c], vqtbl4q_u8(table[s][c], slice));
+        }
+        vst4q_u8((uint8_t *)(row + i), out);
+    }
+#endif
+
+    for (; i < n; i++)
+        row[i] = RGA_CPU_PACK(planes[0][idx[i]], planes[1][idx[i]],
+                                        planes[2][idx[i]], planes[3][idx[i]]);
+}
+
+static int paletteRows(const struct rga_req *req, int layout,
+                        const RockchipRgaCpu::Image *dst, int v0, int v1)
+{
+    const rga_img_info_t *info = &req->src;
+    const uint8_t *base = (const uint8_t *)(layout >= 2 ? info->uv_addr :
+                                                            info->yrgb_addr);
+    int bits = 1 << (info->format - RK_FORMAT_BPP1);
+    int entries = 1 << bits;
+    int pitch = (info->vir_w * bits + 7) / 8;
+    bool lsbFirst = req->endian_mode & 0x1;
+    const uint32_t *lut = (const uint32_t *)req->LUT_addr;
+    uint32_t pair[2] = {req->fg_color, req->bg_color};
+    uint8_t planes[4][256];
+    int w = dst->actW;
+
+    if (bits == 1)
+        lut = pair;
+    if (!base || !lut)
+        return -EINVAL;
+
+    memset(planes, 0, sizeof(planes));
+    for (int i = 0; i < entries; i++) {
+        planes[0][i] = RGA_CPU_R(lut[i]);
+        planes[1][i] = RGA_CPU_G(lut[i]);
+        planes[2][i] = RGA_CPU_B(lut[i]);
+        planes[3][i] = RGA_CPU_A(lut[i]);
+    }
+
+    if (v1 > dst->actH)
+        v1 = dst->actH;
+    if (dst->yoff + v1 > dst->height)
+        v1 = dst->height - dst->yoff;
+    if (dst->xoff + w > dst->width)
+        w = dst->width - dst->xoff;
+    if (w <= 0)
+        return 0;
+
+    std::vector<uint8_t> idx(w);
+    std::vector<uint32_t> row(w);
+
+    for (int v = v0; v < v1; v++) {
+        unpackIndexes(base + (info->y_offset + v) * pitch, info->x_offset,
+                                                    w, bits, lsbFirst, &idx[0]);
+        lookupRow(planes, entries, &idx[0], w, &row[0]);
+        RockchipRgaCpu::storeRow(dst, dst->xoff, dst->yoff + v, w, &row[0]);
+    }
+
+    return 0;
+}
+
+/*
+ * Pattern fill, color_fill_mode 1: pat.yrgb_addr holds pat.act_w x
+ * pat.act_h pixels in the layout of rgba_8888 and the pattern pixel at the
+ * dst origin is (pat.x_offset, pat.y_offset). Every pattern row is tiled
+ * once in the dst format by doubling copies, dst rows are then plain copies
+ * of those.
+ */
+static int patternRows(const struct rga_req *req,
+                            const RockchipRgaCpu::Image *dst, int v0, int v1)
+{
+    const uint32_t *pat = (const uint32_t *)req->pat.yrgb_addr;
+    int pw = req->pat.act_w, ph = req->pat.act_h;
+    int px = req->pat.x_offset % pw, py = req->pat.y_offset % ph;
+    int bpp = RockchipRgaCpu::bytesPerPixel(dst->format);
+    int x0 = dst->xoff, n = dst->actW, span;
+    RockchipRgaCpu::Image line;
+
+    if (v1 > dst->actH)
+        v1 = dst->actH;
+    if (dst->yoff + v1 > dst->height)
+        v1 = dst->height - dst->yoff;
+    if (x0 + n > dst->width)
+        n = dst->width - x0;
+    if (n <= 0 || v1 <= v0)
+        return 0;
+
+    /* the first copy of a row starts px pixels in, so it is one wider */
+    span = n + pw;
+    int rows = v1 - v0 < ph ? v1 - v0 : ph;
+    std::vector<uint8_t> tiles((size_t)rows * span * bpp);
+
+    memset(&line, 0, sizeof(line));
+    line.format = dst->format;
+    line.stride = line.width = span;
+    line.height = 1;
+
+    for (int r = 0; r < rows; r++) {
+        int y = (py + v0 + r) % ph;
+        uint8_t *tile = &tiles[(size_t)r * span * bpp];
+        int done = pw;
+
+        line.y = tile;
+        RockchipRgaCpu::storeRow(&line, 0, 0, pw, pat + y * pw);
+        while (done < span) {
+            int copy = done < span - done ? done : span - done;
+
+            memcpy(tile + done * bpp, tile, copy * bpp);
+            done += copy;
+        }
+    }
+
+    for (int v = v0; v < v1; v++)
+        memcpy(dst->y + ((dst->yoff + v) * dst->stride + x0) * bpp,
+                &tiles[((size_t)((v - v0) % rows) * span + px) * bpp], n * bpp);
+
+    return 0;
+}
+
+/*
+ * Color key, src_trans_mode: bit 0 enables it and bits 1-4 pick the r, g,
+ * b, a channels it compares. A src pixel whose picked channels all lie in
+ * color_key_min..color_key_max leaves dst alone, or clears it to 0 in zero
+ * mode (bit 4 of alpha_rop_mode). The key is in the layout of the pixels.
+ */
+struct ColorKey {
+    bool        enabled;
+    bool        zero;
+    uint32_t    min;
+    uint32_t    max;
+    uint32_t    mask;
+};
+
+static void setupKey(const struct rga_req *req, ColorKey *key)
+{
+    key->enabled = req->src_trans_mode & 0x1;
+    key->zero = (req->alpha_rop_mode >> 4) & 0x1;
+    key->min = req->color_key_min;
+    key->max = req->color_key_max;
+    key->mask = 0;
+    for (int k = 0; k < 4; k++)
+        if (req->src_trans_mode & (0x2 << k))
+            key->mask |= 0xffu << (k * 8);
+}
+
+static inline bool keyMatch(const ColorKey *key, uint32_t c)
+{
+    for (int k = 0; k < 32; k += 8) {
+        uint32_t v = (c >> k) & 0xff;
+
+        if (((key->mask >> k) & 0xff) &&
+                (v < ((key->min >> k) & 0xff) || v > ((key->max >> k) & 0xff)))
+            return false;
+    }
+
+    return true;
+}
+
+/* row[i] becomes back[i] (or 0) where it matches the key */
+static void keyRow(const ColorKey *key, const uint32_t *back, int n, uint32_t *row)
+{
+    int i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        uint8x16_t lo = vreinterpretq_u8_u32(vdupq_n_u32(key->min));
+        uint8x16_t hi = vreinterpretq_u8_u32(vdupq_n_u32(key->max));
+        uint8x16_t skip = vreinterpretq_u8_u32(vdupq_n_u32(~key->mask));
+        uint32_t all = 0xffffffff;
+
+        for (; i + 4 <= n; i += 4) {
+            uint32x4_t c = vld1q_u32(row + i);
+            uint8x16_t b = vreinterpretq_u8_u32(c);
+            uint8x16_t in = vorrq_u8(vandq_u8(vcgeq_u8(b, lo), vcleq_u8(b, hi)), skip);
+            uint32x4_t hit = vceqq_u32(vreinterpretq_u32_u8(in), vdupq_n_u32(all));
+            uint32x4_t keep = key->zero ? vdupq_n_u32(0) : vld1q_u32(back + i);
+
+            vst1q_u32(row + i, vbslq_u32(hit, keep, c));
+        }
+    }
+#endif
+
+    for (; i < n; i++)
+        if (keyMatch(key, row[i]))
+            row[i] = key->zero ? 0 : back[i];
+}
+
+/*
+ * ROP3, alpha_rop_flag bit 1: bit (P << 2 | S << 1 | D) of rop_code is the
+ * result for those input bits, so a result is the or of the minterms the
+ * code sets. P is fg_color, or the pattern at pat.yrgb_addr when
+ * color_fill_mode is set. ROP4 (alpha_rop_mode bits 3:2 == 2) adds a 1bpp
+ * mask at rop_mask_addr, one bit per dst pixel of the act area with the
+ * first pixel in the high bit; rop_code bits 15:8 are the ROP3 where the
+ * mask is 0.
+ */
+static void ropRow(int code, const uint32_t *pat, const uint32_t *back,
+                                                    int n, uint32_t *row)
+{
+    uint64_t minterms[8][3];
+    int count = 0, i = 0;
+
+    for (int m = 0; m < 8; m++) {
+        if (!(code & (1 << m)))
+            continue;
+        minterms[count][0] = (m & 4) ? 0 : ~0ULL;
+        minterms[count][1] = (m & 2) ? 0 : ~0ULL;
+        minterms[count][2] = (m & 1) ? 0 : ~0ULL;
+        count++;
+    }
+
+    /* two pixels per word, the xor with all ones picks the inverted input */
+    for (; i + 2 <= n; i += 2) {
+        uint64_t p, s, d, r = 0;
+
+        memcpy(&p, pat + i, 8);
+        memcpy(&s, row + i, 8);
+        memcpy(&d, back + i, 8);
+        for (int t = 0; t < count; t++)
+            r |= (p ^ minterms[t][0]) & (s ^ minterms[t][1]) & (d ^ minterms[t][2]);
+        memcpy(row + i, &r, 8);
+    }
+
+    for (; i < n; i++) {
+        uint32_t r = 0;
+
+        for (int t = 0; t < count; t++)
+            r |= (pat[i] ^ (uint32_t)minterms[t][0]) &
+                 (row[i] ^ (uint32_t)minterms[t][1]) &
+                 (back[i] ^ (uint32_t)minterms[t][2]);
+        row[i] = r;
+    }
+}
+
+static void ropBlitRow(const struct rga_req *req, const RockchipRgaCpu::Image *dst,
+        int x0, int y0, int v, int n, uint32_t *row, uint32_t *pat,
+        uint32_t *back, uint32_t *fore, int *xmap)
+{
+    bool rop4 = ((req->alpha_rop_mode >> 2) & 0x3) == 2 && req->rop_mask_addr;
+    const uint32_t *pattern = (const uint32_t *)req->pat.yrgb_addr;
+    int pw = req->pat.act_w, ph = req->pat.act_h;
+
+    for (int u = 0; u < n; u++)
+        xmap[u] = x0 + u;
+    RockchipRgaCpu::loadRow(dst, y0, xmap, n, back);
+
+    if (req->color_fill_mode && pattern && pw && ph) {
+        const uint32_t *line = pattern +
+                        ((v + req->pat.y_offset) % ph) * pw;
+
+        for (int u = 0; u < n; u++)
+            pat[u] = line[(u + req->pat.x_offset) % pw];
+    } else {
+        for (int u = 0; u < n; u++)
+            pat[u] = req->fg_color;
+    }
+
+    if (!rop4) {
+        ropRow(req->rop_code & 0xff, pat, back, n, row);
+        return;
+    }
+
+    const uint8_t *mask = (const uint8_t *)req->rop_mask_addr +
+                                        v * ((req->dst.act_w + 7) / 8);
+
+    memcpy(fore, row, n * sizeof(uint32_t));
+    ropRow(req->rop_code & 0xff, pat, back, n, fore);
+    ropRow((req->rop_code >> 8) & 0xff, pat, back, n, row);
+    for (int u = 0; u < n; u++)
+        if ((mask[u >> 3] >> (7 - (u & 7))) & 0x1)
+            row[u] = fore[u];
+}
+
+/*
+ * row += (to - row) * w / 255 on every channel, rounded like div255. Plane
+ * alpha blending is the lerp from dst to src, fading the lerp from src to
+ * the fading color.
+ */
+static void lerpRow(uint32_t *row, const uint32_t *to, int w, int n)
+{
+    uint8_t *p = (uint8_t *)row;
+    const uint8_t *q = (const uint8_t *)to;
+    int i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        uint8x8_t wt = vdup_n_u8(w), wr = vdup_n_u8(255 - w);
+        uint16x8_t half = vdupq_n_u16(128);
+
+        for (; i + 16 <= n * 4; i += 16) {
+            uint8x16_t a = vld1q_u8(p + i), b = vld1q_u8(q + i);
+            uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(a), wr), vget_low_u8(b), wt);
+            uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(a), wr), vget_high_u8(b), wt);
+
+            lo = vaddq_u16(lo, half);
+            hi = vaddq_u16(hi, half);
+            vst1q_u8(p + i, vcombine_u8(vshrn_n_u16(vsraq_n_u16(lo, lo, 8), 8),
+                                        vshrn_n_u16(vsraq_n_u16(hi, hi, 8), 8)));
+        }
+    }
+#endif
+
+    for (; i < n * 4; i++)
+        p[i] = div255(p[i] * (255 - w) + q[i] * w);
+}
+
+/*
+ * Decimation by 2, 4 or 8, pre_scaling_mode. An output sample is the
+ * rounded mean of an f x f block: the f rows are summed, then neighbouring
+ * samples of a channel are added in log2(f) halving passes. 8 x 8 x 255
+ * still fits 16 bits.
+ */
+static void halveRow(uint16_t *sum, int n, int channels)
+{
+    int i = 0;
+
+    /* in place, a step writes below what the next step reads */
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        if (channels == 1) {
+            for (; i + 8 <= n; i += 8) {
+                uint16x8x2_t p = vld2q_u16(sum + i * 2);
+
+                vst1q_u16(sum + i, vaddq_u16(p.val[0], p.val[1]));
+            }
+        } else if (channels == 2) {
+            for (; i + 8 <= n; i += 8) {
+                uint32x4x2_t p = vld2q_u32((const uint32_t *)(sum + i * 2));
+
+                vst1q_u16(sum + i, vaddq_u16(vreinterpretq_u16_u32(p.val[0]),
+                                            vreinterpretq_u16_u32(p.val[1])));
+            }
+        } else if (channels == 4) {
+            for (; i + 8 <= n; i += 8) {
+                uint16x8_t a = vld1q_u16(sum + i * 2);
+                uint16x8_t b = vld1q_u16(sum + i * 2 + 8);
+
+                vst1q_u16(sum + i, vaddq_u16(
+                            vcombine_u16(vget_low_u16(a), vget_low_u16(b)),
+                            vcombine_u16(vget_high_u16(a), vget_high_u16(b))));
+            }
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        int p = i / channels, c = i - p * channels;
+
+        sum[i] = sum[p * 2 * channels + c] + sum[(p * 2 + 1) * channels + c];
+    }
+}
+
+/* n output samples from rows of n * f samples */
+static void boxRow(const uint8_t **rows, int f, int channels, int n,
+                                                uint16_t *sum, uint8_t *out)
+{
+    int len = n * f, shift = 0, i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        for (; i + 8 <= len; i += 8) {
+            uint16x8_t acc = vaddl_u8(vld1_u8(rows[0] + i), vld1_u8(rows[1] + i));
+
+            for (int k = 2; k < f; k++)
+                acc = vaddw_u8(acc, vld1_u8(rows[k] + i));
+            vst1q_u16(sum + i, acc);
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        int s = 0;
+
+        for (int k = 0; k < f; k++)
+            s += rows[k][i];
+        sum[i] = s;
+    }
+
+    for (int step = f; step > 1; step >>= 1) {
+        len >>= 1;
+        halveRow(sum, len, channels);
+        shift += 2;
+    }
+
+    i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        int16x8_t down = vdupq_n_s16(-shift);
+
+        for (; i + 8 <= n; i += 8)
+            vst1_u8(out + i, vqmovn_u16(vrshlq_u16(vld1q_u16(sum + i), down)));
+    }
+#endif
+    for (; i < n; i++)
+        out[i] = (sum[i] + (1 << (shift - 1))) >> shift;
+}
+
+/*
+ * Packed formats and nv12/nv21 into the same format average their bytes
+ * in place, other pairs go through rgba rows.
+ */
+static int decimateRows(const struct rga_req *req,
+        const RockchipRgaCpu::Image *src, const RockchipRgaCpu::Image *dst,
+                                                            int v0, int v1)
+{
+    int f = src->actW / dst->actW, w = dst->actW;
+    int bpp = RockchipRgaCpu::bytesPerPixel(src->format);
+    bool sp420 = src->format == RK_FORMAT_YCbCr_420_SP ||
+                 src->format == RK_FORMAT_YCrCb_420_SP;
+    bool planes = src->format == dst->format && src->format != RK_FORMAT_RGB_565 &&
+                            (!RockchipRgaCpu::isYuv(src->format) || sp420);
+    std::vector<uint16_t> sum(w * f * 4);
+    std::vector<const uint8_t *> rows(f);
+    std::vector<uint32_t> lines, row;
+    std::vector<int> xmap, err;
+
+    if (v1 > dst->actH)
+        v1 = dst->actH;
+
+    if (!planes) {
+        lines.resize(w * f * f);
+        row.resize(w);
+        xmap.resize(w * f);
+        for (int i = 0; i < w * f; i++)
+            xmap[i] = src->xoff + i;
+    }
+
+    for (int v = v0; v < v1; v++) {
+        int sy = src->yoff + v * f;
+
+        if (!planes) {
+            for (int k = 0; k < f; k++) {
+                RockchipRgaCpu::loadRow(src, sy + k, &xmap[0], w * f,
+                                                    &lines[k * w * f]);
+                rows[k] = (const uint8_t *)&lines[k * w * f];
+            }
+            boxRow(&rows[0], f, 4, w * 4, &sum[0], (uint8_t *)&row[0]);
+            storeDithered(req, dst, dst->xoff, dst->yoff + v, w, &row[0], &err);
+            continue;
+        }
+
+        for (int k = 0; k < f; k++)
+            rows[k] = src->y + ((sy + k) * src->stride + src->xoff) * bpp;
+        boxRow(&rows[0], f, bpp, w * bpp, &sum[0],
+                    dst->y + ((dst->yoff + v) * dst->stride + dst->xoff) * bpp);
+
+        /* a chroma row per two luma rows, offsets are even */
+        if (!sp420 || (v & 1))
+            continue;
+        for (int k = 0; k < f; k++)
+            rows[k] = src->uv + (src->yoff / 2 + v / 2 * f + k) * src->stride +
+                                                                    src->xoff;
+        boxRow(&rows[0], f, 2, w, &sum[0], dst->uv +
+                    (dst->yoff / 2 + v / 2) * dst->stride + dst->xoff);
+    }
+
+    return 0;
+}
+
+/* fx, fy are 7 bit fractions, 128 is the next pixel */
+static inline uint32_t bilerp(uint32_t p00, uint32_t p01,
+                                uint32_t p10, uint32_t p11, int fx, int fy)
+{
+    uint32_t out = 0;
+
+    for (int sh = 0; sh < 32; sh += 8) {
+        int top = ((p00 >> sh) & 0xff) * (128 - fy) + ((p10 >> sh) & 0xff) * fy;
+        int bot = ((p01 >> sh) & 0xff) * (128 - fy) + ((p11 >> sh) & 0xff) * fy;
+
+        out |= (uint32_t)((top * (128 - fx) + bot * fx + 8192) >> 14) << sh;
+    }
+
+    return out;
+}
+
+/* two horizontally adjacent RGBA pixels on two rows */
+static inline uint32_t bilerpRgba(const uint8_t *top, const uint8_t *bot,
+                                                            int fx, int fy)
+{
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        uint16x8_t col = vmlal_u8(vmull_u8(vld1_u8(top), vdup_n_u8(128 - fy)),
+                                            vld1_u8(bot), vdup_n_u8(fy));
+        uint32x4_t row = vmlal_n_u16(vmull_n_u16(vget_low_u16(col), 128 - fx),
+                                            vget_high_u16(col), fx);
+        uint16x4_t n = vrshrn_n_u32(row, 14);
+
+        return vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(n, n))), 0);
+    }
+#endif
+    uint32_t p[4];
+
+    memcpy(p, top, 8);
+    memcpy(p + 2, bot, 8);
+    return bilerp(p[0], p[1], p[2], p[3], fx, fy);
+}
+
+/*
+ * Rotation by an angle that is not a multiple of 90 degrees. It is walked
+ * from the destination so there are no holes, dst pixel (x,y) shows frame
+ * pixel
+ *     u =  cos * (x - x_offset) + sin * (y - y_offset)
+ *     v = -sin * (x - x_offset) + cos * (y - y_offset)
+ * in 16.16, which steps by (cos, -sin) along a row. Rows [v0, v1) of the
+ * frame are mapped to the same share of the bounding box rows.
+ */
+static int rotateRows(const struct rga_req *req, const RockchipRgaCpu::Image *src,
+                        const RockchipRgaCpu::Image *dst, int v0, int v1)
+{
+    int64_t c = req->cosa, s = req->sina;
+    int frameW = dst->actW, frameH = dst->actH;
+    int srcW = src->actW, srcH = src->actH;
+    int64_t kx = ((int64_t)srcW << 16) / frameW;
+    int64_t ky = ((int64_t)srcH << 16) / frameH;
+    int64_t uMax = (int64_t)frameW * 65536 - 32768;
+    int64_t vMax = (int64_t)frameH * 65536 - 32768;
+    bool alphaEn = req->alpha_rop_flag & 0x1;
+    bool premultiplied = (req->alpha_rop_flag >> 3) & 0x1;
+    bool nearest = req->scale_mode == RGA_SCALE_NEAREST;
+    int alphaMode = req->alpha_rop_mode & 0x3;
+    int global = req->alpha_global_value;
+    int xMin = dst->xoff, xMax = dst->xoff, yMin = dst->yoff, yMax = dst->yoff;
+    int rows, ya, yb;
+
+    for (int i = 1; i < 4; i++) {
+        int64_t u = (i & 1) ? frameW - 1 : 0;
+        int64_t v = (i & 2) ? frameH - 1 : 0;
+        int x = dst->xoff + (int)((u * c - v * s) >> 16);
+        int y = dst->yoff + (int)((u * s + v * c) >> 16);
+
+        xMin = x < xMin ? x : xMin;
+        xMax = x > xMax ? x : xMax;
+        yMin = y < yMin ? y : yMin;
+        yMax = y > yMax ? y : yMax;
+    }
+
+    /* one more pixel around for the rounding of the corners */
+    rows = yMax - yMin + 3;
+    ya = yMin - 1 + (int)((int64_t)v0 * rows / frameH);
+    yb = yMin - 1 + (int)((int64_t)v1 * rows / frameH);
+    xMin--;
+    xMax++;
+
+    if (req->clip.xmax > req->clip.xmin || req->clip.ymax > req->clip.ymin) {
+        xMin = xMin < req->clip.xmin ? req->clip.xmin : xMin;
+        xMax = xMax > req->clip.xmax ? req->clip.xmax : xMax;
+        ya = ya < req->clip.ymin ? req->clip.ymin : ya;
+        yb = yb > req->clip.ymax + 1 ? req->clip.ymax + 1 : yb;
+    }
+    xMin = xMin < 0 ? 0 : xMin;
+    xMax = xMax >= dst->width ? dst->width - 1 : xMax;
+    ya = ya < 0 ? 0 : ya;
+    yb = yb > dst->height ? dst->height : yb;
+
+    for (int y = ya; y < yb; y++) {
+        int64_t dy = y - dst->yoff, dx = xMin - dst->xoff;
+        int64_t u = c * dx + s * dy;
+        int64_t v = c * dy - s * dx;
+
+        for (int x = xMin; x <= xMax; x++, u += c, v -= s) {
+            int64_t su, sv;
+            int xi, yi, x1, y1;
+            uint32_t color;
+
+            if (u < -32768 || v < -32768 || u >= uMax || v >= vMax)
+                continue;
+
+            su = ((u + 32768) * kx >> 16) - 32768;
+            sv = ((v + 32768) * ky >> 16) - 32768;
+
+            if (nearest) {
+                xi = (int)((su + 32768) >> 16);
+                yi = (int)((sv + 32768) >> 16);
+                xi = xi >= srcW ? srcW - 1 : xi;
+                yi = yi >= srcH ? srcH - 1 : yi;
+                color = RockchipRgaCpu::loadPixel(src, src->xoff + xi,
+                                                            src->yoff + yi);
+            } else {
+                int fx = (int)(su >> 9) & 127, fy = (int)(sv >> 9) & 127;
+
+                xi = (int)(su >> 16);
+                yi = (int)(sv >> 16);
+                x1 = xi + 1 >= srcW ? srcW - 1 : xi + 1;
+                y1 = yi + 1 >= srcH ? srcH - 1 : yi + 1;
+                xi = xi < 0 ? 0 : xi;
+                yi = yi < 0 ? 0 : yi;
+
+                if (src->format == RK_FORMAT_RGBA_8888 && x1 == xi + 1) {
+                    const uint8_t *p = src->y + ((src->yoff + yi) * src->stride +
+                                                        src->xoff + xi) * 4;
+
+                    color = bilerpRgba(p, p + (y1 - yi) * src->stride * 4, fx, fy);
+                } else
+                    color = bilerp(
+                        RockchipRgaCpu::loadPixel(src, src->xoff + xi, src->yoff + yi),
+                        RockchipRgaCpu::loadPixel(src, src->xoff + x1, src->yoff + yi),
+                        RockchipRgaCpu::loadPixel(src, src->xoff + xi, src->yoff + y1),
+                        RockchipRgaCpu::loadPixel(src, src->xoff + x1, src->yoff + y1),
+                        fx, fy);
+            }
+
+            if (alphaEn)
+                color = blendPixel(color, RockchipRgaCpu::loadPixel(dst, x, y),
+                                            alphaMode, global, premultiplied);
+            RockchipRgaCpu::storePixel(dst, x, y, color);
+        }
+    }
+
+    return 0;
+}
+
+static double cubicWeight(double x)
+{
+    /* keys kernel with a = -0.5 */
+    x = fabs(x);
+    if (x < 1.0)
+        return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0)
+        return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+sp<RockchipRgaCpu::ScaleTable> RockchipRgaCpu::scaleTable(int srcSize,
+                                                    int dstSize, int mode)
+{
+    uint64_t key = ((uint64_t)mode << 48) | ((uint64_t)srcSize << 24) | dstSize;
+    double scale = (double)srcSize / dstSize;
+    std::vector<double> weight;
+    sp<ScaleTable> table;
+
+    {
+        Mutex::Autolock lock(mTableLock);
+        std::map<uint64_t, sp<ScaleTable> >::iterator it = mTables.find(key);
+
+        if (it != mTables.end())
+            return it->second;
+    }
+
+    table = new ScaleTable();
+    if (mode == RGA_SCALE_BICUBIC)
+        table->taps = 4;
+    else if (mode == RGA_SCALE_AREA)
+        table->taps = (int)ceil(scale) + 1;
+    else
+        table->taps = 2;
+
+    table->index.resize(dstSize * table->taps);
+    table->coef.resize(dstSize * table->taps);
+    weight.resize(table->taps);
+
+    for (int i = 0; i < dstSize; i++) {
+        double center = (i + 0.5) * scale - 0.5;
+        double sum = 0.0;
+        int first, big = 0, total = 0;
+
+        if (mode == RGA_SCALE_AREA) {
+            /* coverage of source pixel j by the footprint of output i */
+            double left = i * scale, right = (i + 1) * scale;
+
+            first = (int)floor(left);
+            for (int k = 0; k < table->taps; k++) {
+                double lo = first + k, hi = first + k + 1;
+
+                weight[k] = (hi < right ? hi : right) - (lo > left ? lo : left);
+                if (weight[k] < 0.0)
+                    weight[k] = 0.0;
+            }
+        } else if (mode == RGA_SCALE_BICUBIC) {
+            first = (int)floor(center) - 1;
+            for (int k = 0; k < 4; k++)
+                weight[k] = cubicWeight(center - (first + k));
+        } else {
+            first = (int)floor(center);
+            weight[1] = center - first;
+            weight[0] = 1.0 - weight[1];
+        }
+
+        for (int k = 0; k < table->taps; k++)
+            sum += weight[k];
+
+        /* quantize to 1 << 14 and give the rounding error to the largest tap */
+        for (int k = 0; k < table->taps; k++) {
+            int j = first + k;
+            int c = (int)floor(weight[k] / sum * 16384.0 + 0.5);
+
+            table->index[i * table->taps + k] = j < 0 ? 0 :
+                                            (j >= srcSize ? srcSize - 1 : j);
+            table->coef[i * table->taps + k] = c;
+            total += c;
+            if (weight[k] > weight[big])
+                big = k;
+        }
+        table->coef[i * table->taps + big] += 16384 - total;
+    }
+
+    Mutex::Autolock lock(mTableLock);
+    /* in-flight users hold their own reference */
+    if (mTables.size() >= 16)
+        mTables.clear();
+    mTables[key] = table;
+
+    return table;
+}
+
+/*
+ * Horizontally filtered source rows, as 16 bit R,G,B,A with 6 fraction
+ * bits. A ring of vertical-taps rows is enough since each output row needs
+ * a window of consecutive source rows.
+ */
+struct ScaleRows {
+    std::vector<int16_t>        rows;
+    std::vector<int>            tags;
+    std::vector<uint32_t>       line;
+    std::vector<int>            xmap;
+    int                         width;
+};
+
+static const int16_t* scaleRowH(const RockchipRgaCpu::Image *src,
+                                const RockchipRgaCpu::ScaleTable *h,
+                                ScaleRows *cache, int sy)
+{
+    int slot = sy % cache->tags.size();
+    int16_t *out = &cache->rows[slot * cache->width * 4];
+    const int *index = &h->index[0];
+    const int16_t *coef = &h->coef[0];
+    const uint8_t *line;
+
+    if (cache->tags[slot] == sy)
+        return out;
+
+    RockchipRgaCpu::loadRow(src, src->yoff + sy, &cache->xmap[0],
+                                        cache->xmap.size(), &cache->line[0]);
+    line = (const uint8_t *)&cache->line[0];
+
+    for (int u = 0; u < cache->width; u++) {
+        int r = 0, g = 0, b = 0, a = 0;
+
+        for (int k = 0; k < h->taps; k++) {
+            const uint8_t *p = line + index[k] * 4;
+
+            r += coef[k] * p[0];
+            g += coef[k] * p[1];
+            b += coef[k] * p[2];
+            a += coef[k] * p[3];
+        }
+        out[0] = (r + 128) >> 8;
+        out[1] = (g + 128) >> 8;
+        out[2] = (b + 128) >> 8;
+        out[3] = (a + 128) >> 8;
+
+        out += 4;
+        index += h->taps;
+        coef += h->taps;
+    }
+
+    cache->tags[slot] = sy;
+    return &cache->rows[slot * cache->width * 4];
+}
+
+static void scaleRowV(const RockchipRgaCpu::ScaleTable *v, int dy,
+                    const int16_t **rows, int n, uint8_t *out)
+{
+    const int16_t *coef = &v->coef[dy * v->taps];
+    int i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (RockchipRgaCpu::simd()) {
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t x = vld1q_s16(rows[0] + i);
+            int32x4_t lo = vmull_n_s16(vget_low_s16(x), coef[0]);
+            int32x4_t hi = vmull_n_s16(vget_high_s16(x), coef[0]);
+
+            for (int k = 1; k < v->taps; k++) {
+                x = vld1q_s16(rows[k] + i);
+                lo = vmlal_n_s16(lo, vget_low_s16(x), coef[k]);
+                hi = vmlal_n_s16(hi, vget_high_s16(x), coef[k]);
+            }
+
+            lo = vrshrq_n_s32(lo, 20);
+            hi = vrshrq_n_s32(hi, 20);
+            vst1_u8(out + i, vqmovn_u16(vcombine_u16(vqmovun_s32(lo),
+                                                            vqmovun_s32(hi))));
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        int sum = 0;
+
+        for (int k = 0; k < v->taps; k++)
+            sum += coef[k] * rows[k][i];
+        out[i] = clamp255((sum + (1 << 19)) >> 20);
+    }
+}
+
+/*
+ * Crop, scale, nv12->rgb and a quarter turn in one pass, the camera preview
+ * blit. The row path converts and filters whole src rows into a frame row,
+ * then scatters it down a dst column, a new cache line for every pixel.
+ * Here the dst is walked in square tiles, so a tile reads a small window of
+ * the src and writes short runs along dst rows. Each pixel is filtered
+ * straight from its 2x2 src pixels with the tables and rounding of
+ * scaleRowH and scaleRowV, the output stays the same to the bit.
+ */
+#define FUSED_TILE      32
+
+static inline bool fusable(const struct rga_req *req, int cx, bool filtered)
+{
+    int src = req->src.format, dst = req->dst.format;
+
+    return req->rotate_mode == BB_ROTATE && cx == 0 &&
+            (src == RK_FORMAT_YCbCr_420_SP || src == RK_FORMAT_YCrCb_420_SP) &&
+            (dst == RK_FORMAT_RGBA_8888 || dst == RK_FORMAT_RGBX_8888 ||
+                                            dst == RK_FORMAT_BGRA_8888) &&
+            !(req->alpha_rop_flag & 0x7) && !(req->src_trans_mode & 0x1) &&
+            (!filtered || req->scale_mode == RGA_SCALE_BILINEAR);
+}
+
+/* src pixel x of a luma row and its chroma row as loadPixel converts it */
+static inline uint32_t fusedPixel(const uint8_t *luma, const uint8_t *chroma,
+                                                            int x, bool nv21)
+{
+    const uint8_t *p = chroma + (x & ~1);
+
+    return nv21 ? yuvToRgb(luma[x], p[1], p[0]) : yuvToRgb(luma[x], p[0], p[1]);
+}
+
+/* scaleRowH of one output pixel, r,g,b with 6 fraction bits */
+static inline void fusedRowH(const RockchipRgaCpu::Image *src, int y,
+                        int x0, int x1, int c0, int c1, bool nv21, int *out)
+{
+    const uint8_t *luma = src->y + y * src->stride;
+    const uint8_t *chroma = src->uv + (y >> 1) * src->stride;
+    uint32_t p0 = fusedPixel(luma, chroma, x0, nv21);
+    uint32_t p1 = fusedPixel(luma, chroma, x1, nv21);
+
+    out[0] = (c0 * (int)RGA_CPU_R(p0) + c1 * (int)RGA_CPU_R(p1) + 128) >> 8;
+    out[1] = (c0 * (int)RGA_CPU_G(p0) + c1 * (int)RGA_CPU_G(p1) + 128) >> 8;
+    out[2] = (c0 * (int)RGA_CPU_B(p0) + c1 * (int)RGA_CPU_B(p1) + 128) >> 8;
+}
+
+static int fusedRows(const struct rga_req *req, const RockchipRgaCpu::Image *src,
+                        const RockchipRgaCpu::Image *dst, int sx,
+                        const RockchipRgaCpu::ScaleTable *h,
+                        const RockchipRgaCpu::ScaleTable *vt, int v0, int v1)
+{
+    int frameW = req->dst.act_w, frameH = req->dst.act_h;
+    int srcW = req->src.act_w, srcH = req->src.act_h;
+    bool nv21 = src->format == RK_FORMAT_YCrCb_420_SP;
+    bool bgra = dst->format == RK_FORMAT_BGRA_8888;
+    int xa, xb, ya, yb;
+
+    /* frame pixel (u,v) lands on (xoff - v * sx, yoff + u * sx) */
+    xa = sx > 0 ? dst->xoff - (v1 - 1) : dst->xoff + v0;
+    xb = sx > 0 ? dst->xoff - v0 : dst->xoff + v1 - 1;
+    ya = sx > 0 ? dst->yoff : dst->yoff - (frameW - 1);
+    yb = sx > 0 ? dst->yoff + frameW - 1 : dst->yoff;
+    xa = xa < 0 ? 0 : xa;
+    ya = ya < 0 ? 0 : ya;
+    xb = xb >= dst->width ? dst->width - 1 : xb;
+    yb = yb >= dst->height ? dst->height - 1 : yb;
+    if (xa > xb || ya > yb)
+        return 0;
+
+    /* src rows of each dst column and src columns of each dst row */
+    std::vector<int> rows((xb - xa + 1) * 2), rowCoef((xb - xa + 1) * 2);
+    std::vector<int> cols((yb - ya + 1) * 2), colCoef((yb - ya + 1) * 2);
+
+    for (int x = xa; x <= xb; x++) {
+        int v = (dst->xoff - x) * sx, i = (x - xa) * 2;
+
+        if (vt) {
+            rows[i] = src->yoff + vt->index[v * 2];
+            rows[i + 1] = src->yoff + vt->index[v * 2 + 1];
+            rowCoef[i] = vt->coef[v * 2];
+            rowCoef[i + 1] = vt->coef[v * 2 + 1];
+        } else
+            rows[i] = src->yoff + (int)(((2LL * v + 1) * srcH) / (2LL * frameH));
+    }
+
+    for (int y = ya; y <= yb; y++) {
+        int u = (y - dst->yoff) * sx, i = (y - ya) * 2;
+
+        if (h) {
+            cols[i] = src->xoff + h->index[u * 2];
+            cols[i + 1] = src->xoff + h->index[u * 2 + 1];
+            colCoef[i] = h->coef[u * 2];
+            colCoef[i + 1] = h->coef[u * 2 + 1];
+        } else
+            cols[i] = src->xoff + (int)(((2LL * u + 1) * srcW) / (2LL * frameW));
+    }
+
+    for (int ty = ya; ty <= yb; ty += FUSED_TILE) {
+        int tyEnd = ty + FUSED_TILE - 1 > yb ? yb : ty + FUSED_TILE - 1;
+
+        for (int tx = xa; tx <= xb; tx += FUSED_TILE) {
+            int txEnd = tx + FUSED_TILE - 1 > xb ? xb : tx + FUSED_TILE - 1;
+
+            for (int y = ty; y <= tyEnd; y++) {
+                uint32_t *out = (uint32_t *)(dst->y + y * dst->stride * 4);
+                const int *col = &cols[(y - ya) * 2];
+                const int *hc = &colCoef[(y - ya) * 2];
+                /* neighbours along a dst row mostly share src rows */
+                int seen[2] = {-1, -1}, last[2][3];
+
+                for (int x = tx; x <= txEnd; x++) {
+                    const int *row = &rows[(x - xa) * 2];
+                    uint32_t c;
+
+                    if (vt) {
+                        const int *vc = &rowCoef[(x - xa) * 2];
+                        int taps[2][3], rgb[3];
+
+                        for (int k = 0; k < 2; k++) {
+                            if (row[k] == seen[0])
+                                memcpy(taps[k], last[0], sizeof(taps[k]));
+                            else if (row[k] == seen[1])
+                                memcpy(taps[k], last[1], sizeof(taps[k]));
+                            else
+                                fusedRowH(src, row[k], col[0], col[1],
+                                                hc[0], hc[1], nv21, taps[k]);
+                        }
+                        memcpy(last, taps, sizeof(last));
+                        seen[0] = row[0];
+                        seen[1] = row[1];
+
+                        for (int k = 0; k < 3; k++)
+                            rgb[k] = clamp255((vc[0] * taps[0][k] +
+                                        vc[1] * taps[1][k] + (1 << 19)) >> 20);
+                        c = RGA_CPU_PACK(rgb[0], rgb[1], rgb[2], 0xff);
+                    } else
+                        c = fusedPixel(src->y + row[0] * src->stride,
+                                    src->uv + (row[0] >> 1) * src->stride,
+                                    col[0], nv21);
+
+                    out[x] = bgra ? swapRB(c) : c;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+int RockchipRgaCpu::blit(const struct rga_req *req, int layout)
+{
+    return blitRows(req, layout, 0, req->dst.act_h);
+}
+
+void RockchipRgaCpu::runStripe(void *arg, int index)
+{
+    Stripes *stripes = (Stripes *)arg;
+    int v0 = stripes->v0 + index * stripes->rows;
+    int v1 = v0 + stripes->rows;
+    int ret;
+
+    if (v1 > stripes->v1)
+        v1 = stripes->v1;
+
+    ret = stripes->cpu->blitRows(&stripes->req, stripes->layout, v0, v1);
+    if (ret)
+        stripes->result = ret;
+}
+
+/*
+ * Stripes are sized so the source and destination rows they touch fit in
+ * half the cache, but there are still at least two per worker to balance.
+ */
+int RockchipRgaCpu::stripeRows(const struct rga_req *req, int rows, int workers)
+{
+    int srcBpp = bytesPerPixel(req->src.format);
+    int dstBpp = bytesPerPixel(req->dst.format);
+    int frameH = req->dst.act_h > 0 ? req->dst.act_h : 1;
+    int64_t bytes, budget = RockchipRgaThreadPool::cacheSize() / 2;
+    int fit, even;
+
+    /* a line touches a few pixels per row, stripes only cost */
+    if (req->render_mode == line_point_drawing_mode)
+        return rows > 2 ? rows : 2;
+
+    /* the diffused error runs down the whole frame, a stripe would reset it */
+    if (req->dither_mode)
+        return rows > 2 ? rows : 2;
+
+    /* yuv is 1.5 bytes per pixel, bytesPerPixel reports the luma plane */
+    bytes = (int64_t)req->dst.act_w * dstBpp * (isYuv(req->dst.format) ? 3 : 2) / 2;
+    bytes += (int64_t)req->src.act_w * srcBpp * (isYuv(req->src.format) ? 3 : 2) / 2 *
+                                                    req->src.act_h / frameH;
+    if (req->rotate_mode)
+        bytes += (int64_t)req->src.act_h * srcBpp;
+
+    fit = bytes > 0 ? budget / bytes : rows;
+    even = (rows + workers * 2 - 1) / (workers * 2);
+    if (fit > even)
+        fit = even;
+
+    /* even rows keep 420 chroma rows inside one stripe */
+    fit = (fit + 1) & ~1;
+    return fit > 0 ? fit : 2;
+}
+
+int RockchipRgaCpu::blitAsync(Stripes *stripes, const struct rga_req *req,
+                                                int layout, int v0, int v1)
+{
+    RockchipRgaThreadPool *workers;
+    int count;
+
+    if (!supports(req) || v1 <= v0)
+        return -EINVAL;
+
+    workers = pool();
+
+    stripes->pool = workers;
+    stripes->cpu = this;
+    memcpy(&stripes->req, req, sizeof(struct rga_req));
+    stripes->layout = layout;
+    stripes->v0 = v0;
+    stripes->v1 = v1;
+    stripes->result = 0;
+
+    count = workers->threads();
+    stripes->rows = stripeRows(req, v1 - v0, count > 0 ? count : 1);
+    count = (v1 - v0 + stripes->rows - 1) / stripes->rows;
+
+    workers->run(&stripes->group, runStripe, stripes, count);
+    return 0;
+}
+
+int RockchipRgaCpu::wait(Stripes *stripes)
+{
+    stripes->pool->wait(&stripes->group);
+    releasePool(stripes->pool);
+
+    return stripes->result;
+}
+
+int RockchipRgaCpu::blitParallel(const struct rga_req *req, int layout)
+{
+    Stripes stripes;
+    int ret;
+
+    /* a single stripe is not worth the trip through the pool */
+    if (stripeRows(req, req->dst.act_h, threads()) >= req->dst.act_h)
+        return blit(req, layout);
+
+    ret = blitAsync(&stripes, req, layout, 0, req->dst.act_h);
+    if (ret)
+        return ret;
+
+    return wait(&stripes);
+}
+
+int RockchipRgaCpu::blitRows(const struct rga_req *req, int layout,
+                                                            int v0, int v1)
+{
+    Image src, dst;
+    int frameW, frameH, srcW, srcH;
+    int cx, sx, x0, y0, x, y, u, v, sy;
+    bool alphaEn, premultiplied, linear, filtered, rop, fade, lerp, dither;
+    int alphaMode, global;
+    sp<ScaleTable> h, vt;
+    std::vector<const int16_t *> taps;
+    ScaleRows cache;
+
+    if (!supports(req))
+        return -EINVAL;
+
+    /* tables and patterns live in the requests, there is nothing to load */
+    if (req->render_mode == update_palette_table_mode ||
+                        req->render_mode == update_patten_buff_mode)
+        return 0;
+
+    if (req->render_mode == color_fill_mode ||
+                        req->render_mode == line_point_drawing_mode ||
+                        req->render_mode == color_palette_mode) {
+        if (setupImage(&dst, &req->dst, layout))
+            return -EINVAL;
+        if (req->render_mode == color_palette_mode)
+            return paletteRows(req, layout, &dst, v0, v1);
+        if (req->render_mode == line_point_drawing_mode)
+            return lineRows(req, &dst, v0, v1);
+        if (req->color_fill_mode)
+            return patternRows(req, &dst, v0, v1);
+        return fillRows(req, &dst, v0, v1);
+    }
+
+    if (setupImage(&src, &req->src, layout) ||
+                                        setupImage(&dst, &req->dst, layout))
+        return -EINVAL;
+    src.depth = RGA_DEPTH_MODE(req);
+
+    if (req->render_mode == blur_sharp_filter_mode)
+        return filterRows(req, &src, &dst, v0, v1);
+    if (req->render_mode == pre_scaling_mode)
+        return decimateRows(req, &src, &dst, v0, v1);
+
+    frameW = req->dst.act_w;
+    frameH = req->dst.act_h;
+    srcW = req->src.act_w;
+    srcH = req->src.act_h;
+    if (!frameW || !frameH || !srcW || !srcH)
+        return -EINVAL;
+
+    if (v0 < 0)
+        v0 = 0;
+    if (v1 > frameH)
+        v1 = frameH;
+
+    /* destination of frame pixel (u,v) is (x0,y0) + u*(cx,sx) + v*(-sx,cx) */
+    if (req->rotate_mode == BB_ROTATE && req->sina && req->cosa)
+        return rotateRows(req, &src, &dst, v0, v1);
+
+    cx = 1;
+    sx = 0;
+    if (req->rotate_mode == BB_ROTATE) {
+        cx = req->cosa / 65536;
+        sx = req->sina / 65536;
+    }
+
+    /* the rop setup sets bit 0 too, rops do not blend */
+    rop = req->alpha_rop_flag & 0x2;
+    alphaEn = (req->alpha_rop_flag & 0x1) && !rop;
+    premultiplied = (req->alpha_rop_flag >> 3) & 0x1;
+    alphaMode = req->alpha_rop_mode & 0x3;
+    global = req->alpha_global_value;
+    fade = (req->alpha_rop_flag >> 2) & 0x1;
+    dither = ((req->alpha_rop_flag >> 5) & 0x1) && dst.format == RK_FORMAT_RGB_565;
+    /* plane alpha alone is a lerp, src alpha does not take part */
+    lerp = alphaEn && alphaMode == 0;
+    linear = cx == 1 && req->rotate_mode != BB_X_MIRROR && (!alphaEn || lerp);
+    filtered = req->scale_mode != RGA_SCALE_NEAREST &&
+                                    (srcW != frameW || srcH != frameH);
+
+    if (fusable(req, cx, filtered)) {
+        if (filtered) {
+            h = scaleTable(srcW, frameW, req->scale_mode);
+            vt = scaleTable(srcH, frameH, req->scale_mode);
+        }
+        return fusedRows(req, &src, &dst, sx, h.get(), vt.get(), v0, v1);
+    }
+
+    std::vector<int> xmap(frameW);
+    std::vector<uint32_t> row(frameW);
+    std::vector<int> backXmap;
+    std::vector<uint32_t> back, pat, fore, fadeTo;
+    std::vector<int> err;
+    ColorKey key;
+
+    for (u = 0; u < frameW; u++)
+        xmap[u] = src.xoff + (int)(((2LL * u + 1) * srcW) / (2LL * frameW));
+
+    if (fade)
+        fadeTo.resize(frameW);
+
+    setupKey(req, &key);
+    if ((key.enabled || rop || lerp) && linear) {
+        back.resize(frameW);
+        backXmap.resize(frameW);
+    }
+    if (rop && linear) {
+        pat.resize(frameW);
+        fore.resize(frameW);
+    }
+
+    if (filtered) {
+        h = scaleTable(srcW, frameW, req->scale_mode);
+        vt = scaleTable(srcH, frameH, req->scale_mode);
+
+        cache.width = frameW;
+        cache.rows.resize(vt->taps * frameW * 4);
+        cache.tags.assign(vt->taps, -1);
+        cache.line.resize(srcW);
+        cache.xmap.resize(srcW);
+        for (u = 0; u < srcW; u++)
+            cache.xmap[u] = src.xoff + u;
+        taps.resize(vt->taps);
+    }
+
+    for (v = v0; v < v1; v++) {
+        if (filtered) {
+            for (int k = 0; k < vt->taps; k++)
+                taps[k] = scaleRowH(&src, h.get(), &cache,
+                                            vt->index[v * vt->taps + k]);
+            scaleRowV(vt.get(), v, &taps[0], frameW * 4, (uint8_t *)&row[0]);
+        } else {
+            sy = src.yoff + (int)(((2LL * v + 1) * srcH) / (2LL * frameH));
+            loadRow(&src, sy, &xmap[0], frameW, &row[0]);
+        }
+
+        /* fading moves rgb toward the fading color by the global alpha */
+        if (fade) {
+            uint32_t color = RGA_CPU_PACK(req->fading.r, req->fading.g,
+                                                        req->fading.b, 0);
+
+            for (u = 0; u < frameW; u++)
+                fadeTo[u] = (row[u] & RGA_CPU_PACK(0, 0, 0, 0xff)) | color;
+            lerpRow(&row[0], &fadeTo[0], global, frameW);
+        }
+
+        x0 = dst.xoff;
+        y0 = dst.yoff + v;
+        if (req->rotate_mode == BB_Y_MIRROR)
+            y0 = dst.yoff + frameH - 1 - v;
+        else if (req->rotate_mode == BB_ROTATE) {
+            x0 = dst.xoff - v * sx;
+            y0 = dst.yoff + v * cx;
+        }
+
+        if (linear) {
+            int n = frameW;
+
+            if (y0 < 0 || y0 >= dst.height || x0 >= dst.width)
+                continue;
+            if (x0 + n > dst.width)
+                n = dst.width - x0;
+            if (key.enabled) {
+                for (u = 0; u < n; u++)
+                    backXmap[u] = x0 + u;
+                if (!key.zero)
+                    loadRow(&dst, y0, &backXmap[0], n, &back[0]);
+                keyRow(&key, &back[0], n, &row[0]);
+            }
+            if (rop)
+                ropBlitRow(req, &dst, x0, y0, v, n, &row[0], &pat[0],
+                                        &back[0], &fore[0], &backXmap[0]);
+            if (lerp) {
+                for (u = 0; u < n; u++) {
+                    backXmap[u] = x0 + u;
+                    row[u] |= RGA_CPU_PACK(0, 0, 0, 0xff);
+                }
+                loadRow(&dst, y0, &backXmap[0], n, &back[0]);
+                lerpRow(&back[0], &row[0], global, n);
+                storeDithered(req, &dst, x0, y0, n, &back[0], &err);
+                continue;
+            }
+            storeDithered(req, &dst, x0, y0, n, &row[0], &err);
+            continue;
+        }
+
+        for (u = 0; u < frameW; u++) {
+            uint32_t c = row[u];
+
+            if (req->rotate_mode == BB_X_MIRROR) {
+                x = x0 + frameW - 1 - u;
+                y = y0;
+            } else {
+                x = x0 + u * cx;
+                y = y0 + u * sx;
+            }
+
+            if (x < 0 || y < 0 || x >= dst.width || y >= dst.height)
+                continue;
+
+            if (key.enabled && keyMatch(&key, c)) {
+                if (key.zero)
+                    storePixel(&dst, x, y, 0);
+                continue;
+            }
+
+            if (alphaEn)
+                c = blendPixel(c, loadPixel(&dst, x, y),
+                                            alphaMode, global, premultiplied);
+            if (dither)
+                c = ditherPixel(c, x, y);
+            storePixel(&dst, x, y, c);
+        }
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
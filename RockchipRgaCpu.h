@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#ifndef _rockchip_rga_cpu_
+#define _rockchip_rga_cpu_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <map>
+#include <vector>
+
+#include <hardware/rga.h>
+#include <utils/RefBase.h>
+
+#include "RockchipRgaThreadPool.h"
+
+namespace android {
+// -------------------------------------------------------------------------------
+
+/*
+ * rga_req.scale_mode values. The rga knows the first three, area is only
+ * done in software and goes to the rga as bilinear, whose downscaler
+ * averages too.
+ */
+enum {
+    RGA_SCALE_NEAREST           = 0,
+    RGA_SCALE_BILINEAR          = 1,
+    RGA_SCALE_BICUBIC           = 2,
+    RGA_SCALE_AREA              = 3,
+};
+
+/*
+ * P010 has no rga format, only the software renderer reads it. A sample is
+ * a little endian 16 bit word with the value in the top 10 bits. The rk 10
+ * bit formats pack 4 samples into 5 bytes, lsb first. vir_w counts pixels
+ * for both and the chroma plane follows the luma rows.
+ */
+enum {
+    RGA_FORMAT_YCbCr_420_SP_P010 = 0x30,
+};
+
+/*
+ * How 10 bit samples become 8 bit, bits 6-7 of rga_req.yuv2rgb_mode. The
+ * rga truncates, so the device clears the field before the ioctl and
+ * leaves tone mapping to software. Tone mapping reads the frame as
+ * HDR10 (bt.2020, PQ) and writes gamma 2.2 for a 203 nit white.
+ */
+enum {
+    RGA_DEPTH_TRUNCATE          = 0,
+    RGA_DEPTH_ROUND             = 1,
+    RGA_DEPTH_TONEMAP           = 2,
+};
+
+#define RGA_DEPTH_MODE(req)         (((req)->yuv2rgb_mode >> 6) & 0x3)
+
+/*
+ * Software renderer for rga_req.
+ *
+ * Executes a request the way the rga would, so it backs emulated devices
+ * and any job the hardware cannot or should not take. The request is read
+ * with the address layout RockchipRga used to build it (see RkRgaBlit):
+ *   layout 0/1: yrgb_addr/uv_addr are virtual addresses
+ *   layout 2:   yrgb_addr is a fd, uv_addr/v_addr are the virtual addresses
+ */
+class RockchipRgaCpu
+{
+public:
+                RockchipRgaCpu();
+                ~RockchipRgaCpu();
+
+    /*
+    @fun blit:Run a whole request.
+
+    @fun blitRows:Run rows [v0, v1) of the destination frame of a request,
+        the frame is the act_w x act_h area before rotation, so disjoint row
+        ranges write disjoint pixels whatever the rotation is.
+    */
+    int         blit(const struct rga_req *req, int layout);
+    int         blitRows(const struct rga_req *req, int layout, int v0, int v1);
+
+    /*
+    @fun blitAsync:Split rows [v0, v1) of a request into stripes for the
+        worker threads and return at once, wait() joins them.
+    */
+    struct Stripes {
+        RockchipRgaThreadPool::Group group;
+        RockchipRgaThreadPool       *pool;
+        RockchipRgaCpu              *cpu;
+        struct rga_req              req;
+        int                         layout;
+        int                         v0;
+        int                         v1;
+        int                         rows;
+        int                         result;
+    };
+
+    int         blitAsync(Stripes *stripes, const struct rga_req *req,
+                                                int layout, int v0, int v1);
+    int         wait(Stripes *stripes);
+    int         blitParallel(const struct rga_req *req, int layout);
+    int         threads();
+
+    /*
+    @fun setWorkers:Size the worker pool and pin it to a cluster, the next
+        blit gets a new pool and the old one goes once its stripes are done.
+    @param threads:worker count, 0 is one per core of the cluster
+    @param cluster:DRM_RGA_CPU_CLUSTER_ANY/BIG/LITTLE
+    */
+    void        setWorkers(int threads, int cluster);
+
+    /*
+    @fun setSimd:Run the neon kernels where the build has them, the default,
+        also cleared by persist.rga.cpu.simd=0. Off runs the scalar code,
+        which the neon kernels must match bit for bit.
+    */
+    static void setSimd(bool enable);
+    static bool simd() {return __atomic_load_n(&sSimd, __ATOMIC_RELAXED);}
+
+    static bool supports(const struct rga_req *req);
+    static bool supportsFormat(int format);
+
+    struct Image {
+        uint8_t     *y;
+        uint8_t     *uv;
+        int         format;
+        int         stride;
+        int         width;
+        int         height;
+        int         xoff;
+        int         yoff;
+        int         actW;
+        int         actH;
+        int         depth;
+    };
+
+    static int  setupImage(Image *img, const rga_img_info_t *info, int layout);
+    static int  bytesPerPixel(int format);
+    static bool isYuv(int format);
+    static bool is10Bit(int format);
+
+    /*
+    @fun unpack10:Samples [x, x + n) of a row of a 10 bit image as 16 bit
+        values in the low bits. Chroma rows count interleaved samples, two
+        per pixel pair.
+    @param chroma:read row y of the chroma plane instead of the luma plane
+    */
+    static void unpack10(const Image *img, bool chroma, int y, int x, int n,
+                                                            uint16_t *out);
+
+    static uint32_t loadPixel(const Image *img, int x, int y);
+    static void storePixel(const Image *img, int x, int y, uint32_t c);
+    static void loadRow(const Image *img, int y, const int *xmap,
+                                                    int n, uint32_t *out);
+    static void storeRow(const Image *img, int x, int y, int n,
+                                                    const uint32_t *in);
+
+    /*
+    @fun scaleTable:Separable filter mapping srcSize samples to dstSize,
+        cached per ratio and mode. Output i is the sum over k < taps of
+        coef[i * taps + k] * sample[index[i * taps + k]] >> 14, indices are
+        clamped to the source so edges repeat.
+    */
+    struct ScaleTable : public RefBase {
+        int                         taps;
+        std::vector<int>            index;
+        std::vector<int16_t>        coef;
+    };
+
+    sp<ScaleTable> scaleTable(int srcSize, int dstSize, int mode);
+
+private:
+    static void runStripe(void *arg, int index);
+    static int  stripeRows(const struct rga_req *req, int rows, int workers);
+    RockchipRgaThreadPool* pool();
+    void        releasePool(RockchipRgaThreadPool *workers);
+
+    RockchipRgaThreadPool           *mPool;
+    Mutex                           mPoolLock;
+    int                             mThreads;
+    int                             mCluster;
+    bool                            mRebuild;
+    /* references per pool, retired pools stay here until released */
+    std::map<RockchipRgaThreadPool *, int> mPoolUsers;
+
+    Mutex                           mTableLock;
+    std::map<uint64_t, sp<ScaleTable> > mTables;
+
+    static bool                     sSimd;
+};
+
+/* internal pixels are R,G,B,A bytes in memory order, like RK_FORMAT_RGBA_8888 */
+#define RGA_CPU_PACK(r, g, b, a)    ((uint32_t)(r) | ((uint32_t)(g) << 8) | \
+                                    ((uint32_t)(b) << 16) | ((uint32_t)(a) << 24))
+#define RGA_CPU_R(c)                ((c) & 0xff)
+#define RGA_CPU_G(c)                (((c) >> 8) & 0xff)
+#define RGA_CPU_B(c)                (((c) >> 16) & 0xff)
+#define RGA_CPU_A(c)                ((c) >> 24)
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
+
+#endif
@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "rockchiprga"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include <utils/Log.h>
+
+#include "RockchipRgaCpu.h"
+#include "RockchipRgaDevice.h"
+
+namespace android {
+
+// ---------------------------------------------------------------------------
+
+RockchipRgaDevice::RockchipRgaDevice():
+    mFd(-1),
+    mVersion(0),
+    mCpu(NULL),
+    mDepth(0),
+    mJobs(0),
+    mMaxWidth(0),
+    mMaxScaleUp(0),
+    mMaxScaleDown(0),
+    m10BitInput(false)
+{
+    mName[0] = '\0';
+}
+
+RockchipRgaDevice::~RockchipRgaDevice()
+{
+    if (mFd > -1) {
+        close(mFd);
+        mFd = -1;
+    }
+}
+
+RockchipRgaDevice* RockchipRgaDevice::open(const char *path, float version)
+{
+    RockchipRgaDevice *dev;
+    char buf[256];
+    int fd;
+
+    fd = ::open(path, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0)
+        return NULL;
+
+    memset(buf, 0, sizeof(buf));
+    if (version <= 0 && ioctl(fd, RGA_GET_VERSION, buf)) {
+        ALOGE("%s RGA_GET_VERSION fail: %s", path, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    dev = new RockchipRgaDevice();
+    dev->mFd = fd;
+    dev->mVersion = version > 0 ? version : atof(buf);
+    snprintf(dev->mName, sizeof(dev->mName), "%s", path);
+    dev->initCaps();
+
+    return dev;
+}
+
+RockchipRgaDevice* RockchipRgaDevice::createEmulated(int index, float version,
+                                                        RockchipRgaCpu *cpu)
+{
+    RockchipRgaDevice *dev;
+
+    if (!cpu)
+        return NULL;
+
+    dev = new RockchipRgaDevice();
+    dev->mVersion = version;
+    dev->mCpu = cpu;
+    snprintf(dev->mName, sizeof(dev->mName), "emulated%d", index);
+    dev->initCaps();
+
+    return dev;
+}
+
+int RockchipRgaDevice::layoutOf(float version)
+{
+    if (version <= 1.003)
+        return 0;
+    else if (version < 2.0)
+        return 1;
+    return 2;
+}
+
+/* rga1 can only downscale by 2 in one pass, rga2 by 16 */
+void RockchipRgaDevice::initCaps()
+{
+    if (mVersion < 2.0) {
+        mMaxWidth = 2048;
+        mMaxScaleUp = 8;
+        mMaxScaleDown = 2;
+        m10BitInput = false;
+    } else {
+        mMaxWidth = 4096;
+        mMaxScaleUp = 16;
+        mMaxScaleDown = 16;
+        m10BitInput = true;
+    }
+
+    /* software cores are only limited by the renderer */
+    if (mCpu) {
+        mMaxWidth = 8192;
+        mMaxScaleUp = 65536;
+        mMaxScaleDown = 65536;
+        m10BitInput = false;
+    }
+}
+
+bool RockchipRgaDevice::supportsFormat(int format) const
+{
+    if (mCpu)
+        return RockchipRgaCpu::supportsFormat(format);
+
+    switch (format) {
+        case RK_FORMAT_YCbCr_420_SP_10B:
+        case RK_FORMAT_YCrCb_420_SP_10B:
+            return m10BitInput;
+        default:
+            return format >= RK_FORMAT_RGBA_8888 && format <= RK_FORMAT_BPP8;
+    }
+}
+
+bool RockchipRgaDevice::supports(const struct rga_req *req, int layout) const
+{
+    /* the request addresses are only meaningful to cores of the same layout */
+    if (layoutOf(mVersion) != layout)
+        return false;
+
+    if (mCpu && !RockchipRgaCpu::supports(req))
+        return false;
+
+    /*
+     * rga2 dropped line drawing, the blur/sharpen filter, palettes, patterns
+     * and the gradient fill
+     */
+    if ((req->render_mode == line_point_drawing_mode ||
+            req->render_mode == blur_sharp_filter_mode ||
+            req->render_mode == color_palette_mode ||
+            req->render_mode == update_palette_table_mode ||
+            req->render_mode == update_patten_buff_mode) && !mCpu && mVersion >= 2.0)
+        return false;
+    if (req->render_mode == color_fill_mode && !mCpu && mVersion >= 2.0 &&
+            (req->color_fill_mode || req->gr_color.gr_x_r || req->gr_color.gr_x_g ||
+             req->gr_color.gr_x_b || req->gr_color.gr_x_a ||
+             req->gr_color.gr_y_r || req->gr_color.gr_y_g ||
+             req->gr_color.gr_y_b || req->gr_color.gr_y_a))
+        return false;
+
+    /* table loads carry no image */
+    if (req->render_mode == update_palette_table_mode ||
+            req->render_mode == update_patten_buff_mode)
+        return true;
+
+    if (!supportsFormat(req->dst.format) || req->dst.act_w > mMaxWidth)
+        return false;
+
+    /* fills and lines only write dst */
+    if (req->render_mode == color_fill_mode ||
+            req->render_mode == line_point_drawing_mode)
+        return true;
+
+    /* an indexed src is no image format, see color_palette_mode */
+    if ((req->render_mode != color_palette_mode && !supportsFormat(req->src.format)) ||
+            req->src.act_w > mMaxWidth)
+        return false;
+
+    if (req->render_mode != bitblt_mode && req->render_mode != pre_scaling_mode)
+        return true;
+
+    /* the rga truncates 10 bit samples, tone mapping is software */
+    if (!mCpu && RGA_DEPTH_MODE(req) == RGA_DEPTH_TONEMAP)
+        return false;
+
+    /* rga2 has no fading stage */
+    if (!mCpu && mVersion >= 2.0 && (req->alpha_rop_flag & 0x4))
+        return false;
+
+    /* rga2 has no pattern buffer and no rop mask */
+    if (!mCpu && mVersion >= 2.0 && (req->alpha_rop_flag & 0x2) &&
+                                    (req->color_fill_mode || req->rop_mask_addr))
+        return false;
+
+    /* rga2 only turns by multiples of 90 degrees */
+    if (!mCpu && mVersion >= 2.0 && req->rotate_mode == BB_ROTATE &&
+                                                    req->sina && req->cosa)
+        return false;
+
+    if (req->src.act_w > req->dst.act_w * mMaxScaleDown ||
+        req->src.act_h > req->dst.act_h * mMaxScaleDown ||
+        req->dst.act_w > req->src.act_w * mMaxScaleUp ||
+        req->dst.act_h > req->src.act_h * mMaxScaleUp)
+        return false;
+
+    return true;
+}
+
+int RockchipRgaDevice::blit(struct rga_req *req, int cmd)
+{
+    struct rga_req hwReq;
+    int ret;
+
+    __atomic_fetch_add(&mDepth, 1, __ATOMIC_RELAXED);
+
+    if (mCpu)
+        ret = mCpu->blit(req, layoutOf(mVersion));
+    else if (req->scale_mode == RGA_SCALE_AREA || req->dither_mode ||
+            RGA_DEPTH_MODE(req) ||
+            (req->render_mode == pre_scaling_mode && mVersion >= 2.0)) {
+        /* area sampling, error diffusion and rounding are software only */
+        memcpy(&hwReq, req, sizeof(struct rga_req));
+        if (hwReq.scale_mode == RGA_SCALE_AREA)
+            hwReq.scale_mode = RGA_SCALE_BILINEAR;
+        /* rga2 has no pre-scaler, its scaler averages when it shrinks */
+        if (hwReq.render_mode == pre_scaling_mode) {
+            hwReq.render_mode = bitblt_mode;
+            hwReq.scale_mode = RGA_SCALE_BILINEAR;
+        }
+        hwReq.dither_mode = 0;
+        hwReq.yuv2rgb_mode &= 0x3f;
+        ret = ioctl(mFd, cmd, &hwReq) ? -errno : 0;
+    } else
+        ret = ioctl(mFd, cmd, req) ? -errno : 0;
+
+    __atomic_fetch_add(&mJobs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&mDepth, 1, __ATOMIC_RELAXED);
+
+    return ret;
+}
+
+int RockchipRgaDevice::getInfo(rga_device_info_t *info) const
+{
+    if (!info)
+        return -EINVAL;
+
+    memset(info, 0, sizeof(rga_device_info_t));
+    snprintf(info->name, sizeof(info->name), "%s", mName);
+    info->version = mVersion;
+    info->emulated = mCpu ? 1 : 0;
+    info->depth = depth();
+    info->jobs = __atomic_load_n(&mJobs, __ATOMIC_RELAXED);
+    info->maxWidth = mMaxWidth;
+    info->maxScaleUp = mMaxScaleUp;
+    info->maxScaleDown = mMaxScaleDown;
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#ifndef _rockchip_rga_device_
+#define _rockchip_rga_device_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <hardware/rga.h>
+
+#include "drmrga.h"
+
+namespace android {
+// -------------------------------------------------------------------------------
+
+class RockchipRgaCpu;
+
+/*
+ * One rga core: a device node, or a software core emulated by RockchipRgaCpu.
+ * Tracks what the core can do and how many jobs are in flight on it, so
+ * RockchipRga can dispatch each request to the least loaded capable core.
+ */
+class RockchipRgaDevice
+{
+public:
+    /*
+    @fun open:Open a device node.
+    @param version:the driver version if known, 0 asks the driver
+    */
+    static RockchipRgaDevice* open(const char *path, float version = 0);
+    static RockchipRgaDevice* createEmulated(int index, float version,
+                                                        RockchipRgaCpu *cpu);
+                ~RockchipRgaDevice();
+
+    /*
+    @fun layoutOf:The address layout RkRgaBlit uses for a driver version:
+        0 for <= 1.003, 1 for < 2.0, 2 for newer ones.
+    */
+    static int  layoutOf(float version);
+
+    int         blit(struct rga_req *req, int cmd);
+    bool        supports(const struct rga_req *req, int layout) const;
+    int         getInfo(rga_device_info_t *info) const;
+
+    int         fd() const {return mFd;}
+    float       version() const {return mVersion;}
+    int32_t     depth() const {return __atomic_load_n(&mDepth, __ATOMIC_RELAXED);}
+    bool        emulated() const {return mCpu != NULL;}
+
+private:
+                RockchipRgaDevice();
+
+    void        initCaps();
+    bool        supportsFormat(int format) const;
+
+    int                             mFd;
+    float                           mVersion;
+    char                            mName[32];
+    RockchipRgaCpu                  *mCpu;
+    int32_t                         mDepth;
+    uint32_t                        mJobs;
+
+    int                             mMaxWidth;
+    int                             mMaxScaleUp;
+    int                             mMaxScaleDown;
+    bool                            m10BitInput;
+};
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "rockchiprga"
+
+#include <limits.h>
+
+#include <utils/Log.h>
+
+#include "RockchipRga.h"
+
+using namespace android;
+
+/* the hal takes drm transforms, the library the HAL_TRANSFORM ones of RkRgaBlit */
+static int rgaHalRotation(int rotation)
+{
+    switch (rotation) {
+        case DRM_RGA_TRANSFORM_ROT_0:
+            return 0;
+        case DRM_RGA_TRANSFORM_ROT_90:
+            return HAL_TRANSFORM_ROT_90;
+        case DRM_RGA_TRANSFORM_ROT_180:
+            return HAL_TRANSFORM_ROT_180;
+        case DRM_RGA_TRANSFORM_ROT_270:
+        case DRM_RGA_TRANSFORM_FLIP_H | DRM_RGA_TRANSFORM_ROT_90:
+            return HAL_TRANSFORM_ROT_270;
+        case DRM_RGA_TRANSFORM_FLIP_H:
+            return HAL_TRANSFORM_FLIP_H;
+        case DRM_RGA_TRANSFORM_FLIP_V:
+            return HAL_TRANSFORM_FLIP_V;
+        default:
+            return -EINVAL;
+    }
+}
+
+static int rgaCopy(struct rga_device * /* dev */,
+                    buffer_handle_t src, buffer_handle_t dst, drm_rga_t *rects)
+{
+    return RockchipRga::get().RkRgaCopy(src, dst, rects);
+}
+
+static int rgaConvert(struct rga_device * /* dev */,
+                    buffer_handle_t src, buffer_handle_t dst, drm_rga_t *rects)
+{
+    return RockchipRga::get().RkRgaConvert(src, dst, rects);
+}
+
+static int rgaScale(struct rga_device * /* dev */,
+                    buffer_handle_t src, buffer_handle_t dst, drm_rga_t *rects)
+{
+    return RockchipRga::get().RkRgaScale(src, dst, rects);
+}
+
+static int rgaRotateScale(struct rga_device * /* dev */, buffer_handle_t src,
+                    buffer_handle_t dst, drm_rga_t *rects, int rotation)
+{
+    int halRotation = rgaHalRotation(rotation);
+
+    if (halRotation < 0)
+        return halRotation;
+
+    return RockchipRga::get().RkRgaRoateScale(src, dst, rects, halRotation);
+}
+
+static int rgaFillColor(struct rga_device * /* dev */,
+                    buffer_handle_t handle, int data, drm_rga_t *rects)
+{
+    rga_fill_t fill;
+
+    /* one solid area, RkRgaFill clips it to the rect */
+    memset(&fill, 0, sizeof(rga_fill_t));
+    fill.width = INT_MAX;
+    fill.height = INT_MAX;
+    fill.color = (unsigned int)data;
+
+    return RockchipRga::get().RkRgaFill(handle,
+                            rects && rects->dst.wstride > 0 ? &rects->dst : NULL,
+                            &fill, 1);
+}
+
+static int rgaQuery(struct rga_device * /* dev */, int /* cmd */, ...)
+{
+    return -ENOSYS;
+}
+
+static int rgaControl(struct rga_device * /* dev */, int /* cmd */, ...)
+{
+    return -ENOSYS;
+}
+
+static int rgaDump(struct rga_device * /* dev */, char *buff, int buff_len)
+{
+    RockchipRga& rkRga(RockchipRga::get());
+    int count = rkRga.RkRgaGetDeviceCount();
+    int len = 0;
+
+    if (!buff || buff_len <= 0)
+        return -EINVAL;
+
+    buff[0] = '\0';
+    for (int i = 0; i < count && len < buff_len; i++) {
+        rga_device_info_t info;
+
+        if (rkRga.RkRgaGetDeviceInfo(i, &info))
+            continue;
+        len += snprintf(buff + len, buff_len - len, "%s %f\n",
+                                                    info.name, info.version);
+    }
+
+    return 0;
+}
+
+static int rgaDeviceClose(struct hw_device_t *device)
+{
+    free(device);
+    return 0;
+}
+
+static int rgaDeviceOpen(const struct hw_module_t *module, const char * /* id */,
+                                                    struct hw_device_t **device)
+{
+    rga_device_t *dev;
+
+    dev = (rga_device_t *)calloc(1, sizeof(rga_device_t));
+    if (!dev)
+        return -ENOMEM;
+
+    dev->common.tag = HARDWARE_DEVICE_TAG;
+    dev->common.version = HARDWARE_DEVICE_API_VERSION(1, 0);
+    dev->common.module = const_cast<struct hw_module_t *>(module);
+    dev->common.close = rgaDeviceClose;
+
+    dev->rgaCopy = rgaCopy;
+    dev->rgaConvert = rgaConvert;
+    dev->rgaScale = rgaScale;
+    dev->rgaRotateScale = rgaRotateScale;
+    dev->rgaFillColor = rgaFillColor;
+    dev->rgaQuery = rgaQuery;
+    dev->rgaControl = rgaControl;
+    dev->rgaDump = rgaDump;
+
+    *device = &dev->common;
+    return 0;
+}
+
+static struct hw_module_methods_t rgaModuleMethods = {
+    open: rgaDeviceOpen,
+};
+
+rga_module_t HAL_MODULE_INFO_SYM = {
+    common: {
+        tag: HARDWARE_MODULE_TAG,
+        module_api_version: HARDWARE_MODULE_API_VERSION(1, 0),
+        hal_api_version: HARDWARE_HAL_API_VERSION,
+        id: DRMRGA_HARDWARE_MODULE_ID,
+        name: "Rockchip rga module",
+        author: "Rockchip Electronics Co.Ltd",
+        methods: &rgaModuleMethods,
+        dso: NULL,
+        reserved: {0},
+    },
+};
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "rockchiprga"
+
+#include <stdint.h>
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+
+#include <utils/Log.h>
+
+#include "RockchipRga.h"
+#include "RockchipRgaJobQueue.h"
+
+namespace android {
+
+// ---------------------------------------------------------------------------
+
+RockchipRgaJobQueue::RockchipRgaJobQueue(RockchipRga *rga):
+    mRga(rga),
+    mFreeSlots(~0ULL),
+    mExit(false)
+{
+    memset(mJobs, 0, sizeof(mJobs));
+    memset(&mStats, 0, sizeof(rga_job_stats_t));
+    for (int i = 0; i < DRM_RGA_PRIORITY_COUNT; i++)
+        queueInit(&mQueues[i]);
+    sem_init(&mPending, 0, 0);
+}
+
+/*
+ * The submitters sleep in sem_wait and use mRga, wake each one with an
+ * exit token and join it before the semaphore goes away. Jobs still
+ * queued are dropped.
+ */
+RockchipRgaJobQueue::~RockchipRgaJobQueue()
+{
+    __atomic_store_n(&mExit, true, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < mSubmitters.size(); i++)
+        sem_post(&mPending);
+    for (size_t i = 0; i < mSubmitters.size(); i++)
+        mSubmitters[i]->requestExitAndWait();
+    mSubmitters.clear();
+
+    sem_destroy(&mPending);
+}
+
+int RockchipRgaJobQueue::start(int submitters)
+{
+    for (int i = 0; i < submitters; i++) {
+        sp<Submitter> submitter = new Submitter(this);
+
+        if (submitter->run("rga_submit", PRIORITY_URGENT_DISPLAY)) {
+            ALOGE("start rga submit thread %d fail", i);
+            return mSubmitters.empty() ? -ENODEV : 0;
+        }
+        mSubmitters.push_back(submitter);
+    }
+
+    return 0;
+}
+
+/*
+ * Intrusive multi-producer single-consumer queue (Vyukov): producers only
+ * swap the head pointer, so submit never blocks behind the submitters.
+ * The submitters serialize on mPopLock to act as the single consumer.
+ */
+void RockchipRgaJobQueue::queueInit(MpscQueue *q)
+{
+    q->stub.next = NULL;
+    q->head = &q->stub;
+    q->tail = &q->stub;
+}
+
+void RockchipRgaJobQueue::queuePush(MpscQueue *q, JobNode *node)
+{
+    JobNode *prev;
+
+    __atomic_store_n(&node->next, (JobNode *)NULL, __ATOMIC_RELAXED);
+    prev = __atomic_exchange_n(&q->head, node, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+}
+
+RockchipRgaJobQueue::JobNode* RockchipRgaJobQueue::queuePop(MpscQueue *q)
+{
+    JobNode *tail = q->tail;
+    JobNode *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    JobNode *head;
+
+    if (tail == &q->stub) {
+        if (!next)
+            return NULL;
+        q->tail = next;
+        tail = next;
+        next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+    }
+
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+
+    /* a producer swapped head but has not linked its node yet */
+    head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    if (tail != head)
+        return NULL;
+
+    queuePush(q, &q->stub);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+int RockchipRgaJobQueue::allocSlot()
+{
+    uint64_t slots = __atomic_load_n(&mFreeSlots, __ATOMIC_ACQUIRE);
+
+    while (slots) {
+        int slot = __builtin_ctzll(slots);
+        uint64_t next = slots & ~(1ULL << slot);
+
+        if (__atomic_compare_exchange_n(&mFreeSlots, &slots, next, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return slot;
+    }
+
+    return -EBUSY;
+}
+
+/* called with mDoneLock held, which orders it against findJob */
+void RockchipRgaJobQueue::freeSlot(int slot)
+{
+    mJobs[slot].detached = false;
+    __atomic_store_n(&mJobs[slot].state, (int32_t)JOB_FREE, __ATOMIC_RELEASE);
+    __atomic_fetch_or(&mFreeSlots, 1ULL << slot, __ATOMIC_ACQ_REL);
+}
+
+int RockchipRgaJobQueue::submit(buffer_handle_t src, buffer_handle_t dst,
+                        drm_rga_t *rects, int rotation, int blend, int priority)
+{
+    uint32_t generation;
+    Job *job;
+    int slot;
+
+    if (priority < 0 || priority >= DRM_RGA_PRIORITY_COUNT)
+        return -EINVAL;
+
+    slot = allocSlot();
+    if (slot < 0) {
+        ALOGE("rga job queue is full");
+        return slot;
+    }
+
+    job = &mJobs[slot];
+    job->src = src;
+    job->dst = dst;
+    job->hasRects = rects != NULL;
+    if (rects)
+        memcpy(&job->rects, rects, sizeof(drm_rga_t));
+    job->rotation = rotation;
+    job->blend = blend;
+    job->priority = priority;
+    job->result = 0;
+    generation = (__atomic_load_n(&job->generation, __ATOMIC_RELAXED) + 1) & 0x3fffff;
+    if (!generation)
+        generation = 1;
+    __atomic_store_n(&job->generation, generation, __ATOMIC_RELAXED);
+    job->queueTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    __atomic_store_n(&job->state, (int32_t)JOB_QUEUED, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&mStats.submitted[priority], 1, __ATOMIC_RELAXED);
+
+    queuePush(&mQueues[priority], &job->node);
+    sem_post(&mPending);
+
+    return (int)((generation << 8) | slot);
+}
+
+RockchipRgaJobQueue::Job* RockchipRgaJobQueue::nextJob()
+{
+    Mutex::Autolock lock(mPopLock);
+    JobNode *node;
+
+    for (int i = 0; i < DRM_RGA_PRIORITY_COUNT; i++) {
+        node = queuePop(&mQueues[i]);
+        if (node)
+            return reinterpret_cast<Job *>(node);
+    }
+
+    return NULL;
+}
+
+bool RockchipRgaJobQueue::runOne()
+{
+    Job *job;
+    nsecs_t latency;
+
+    while (sem_wait(&mPending) && errno == EINTR)
+        ;
+
+    if (__atomic_load_n(&mExit, __ATOMIC_ACQUIRE))
+        return false;
+
+    /* the semaphore guarantees a job, only a racing producer can hide it */
+    while (!(job = nextJob()))
+        sched_yield();
+
+    __atomic_store_n(&job->state, (int32_t)JOB_RUNNING, __ATOMIC_RELEASE);
+    job->result = mRga->RkRgaBlit(job->src, job->dst,
+                    job->hasRects ? &job->rects : NULL, job->rotation, job->blend);
+
+    latency = ns2us(systemTime(SYSTEM_TIME_MONOTONIC) - job->queueTime);
+
+    Mutex::Autolock lock(mDoneLock);
+    mStats.completed[job->priority]++;
+    mStats.totalLatencyUs[job->priority] += latency;
+    if (latency > mStats.maxLatencyUs[job->priority])
+        mStats.maxLatencyUs[job->priority] = latency;
+    if (job->detached)
+        freeSlot(job - mJobs);
+    else
+        __atomic_store_n(&job->state, (int32_t)JOB_DONE, __ATOMIC_RELEASE);
+    mDoneCond.broadcast();
+
+    return true;
+}
+
+/*
+ * Called with mDoneLock held. A slot is only freed under mDoneLock, and
+ * submit publishes the new generation before the QUEUED state, so a stale
+ * handle can never match a slot that was freed and issued again.
+ */
+RockchipRgaJobQueue::Job* RockchipRgaJobQueue::findJob(int handle)
+{
+    int slot = handle & 0xff;
+    uint32_t generation = (uint32_t)handle >> 8;
+    Job *job;
+
+    if (handle <= 0 || slot >= MAX_JOBS)
+        return NULL;
+
+    job = &mJobs[slot];
+    if (__atomic_load_n(&job->state, __ATOMIC_ACQUIRE) == JOB_FREE ||
+            __atomic_load_n(&job->generation, __ATOMIC_RELAXED) != generation ||
+            job->detached)
+        return NULL;
+
+    return job;
+}
+
+int RockchipRgaJobQueue::wait(int handle, int timeoutMs)
+{
+    nsecs_t deadline = systemTime(SYSTEM_TIME_MONOTONIC) +
+                                milliseconds_to_nanoseconds(timeoutMs);
+    Mutex::Autolock lock(mDoneLock);
+    Job *job;
+    int ret;
+
+    /* look the job up again after every sleep, another waiter may free it */
+    while ((job = findJob(handle)) &&
+            __atomic_load_n(&job->state, __ATOMIC_ACQUIRE) != JOB_DONE) {
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        if (timeoutMs == 0)
+            return -EBUSY;
+        if (timeoutMs < 0)
+            mDoneCond.wait(mDoneLock);
+        else if (now >= deadline)
+            return -ETIMEDOUT;
+        else
+            mDoneCond.waitRelative(mDoneLock, deadline - now);
+    }
+
+    if (!job)
+        return -EINVAL;
+
+    ret = job->result;
+    freeSlot(job - mJobs);
+
+    return ret;
+}
+
+/*
+ * Give up on a job, its slot is freed as soon as it completes. A handle
+ * that is neither waited for nor detached holds its slot forever.
+ */
+int RockchipRgaJobQueue::detach(int handle)
+{
+    Mutex::Autolock lock(mDoneLock);
+    Job *job = findJob(handle);
+
+    if (!job)
+        return -EINVAL;
+
+    if (__atomic_load_n(&job->state, __ATOMIC_ACQUIRE) == JOB_DONE)
+        freeSlot(job - mJobs);
+    else
+        job->detached = true;
+
+    return 0;
+}
+
+int RockchipRgaJobQueue::getStats(rga_job_stats_t *stats)
+{
+    Mutex::Autolock lock(mDoneLock);
+
+    if (!stats)
+        return -EINVAL;
+
+    memcpy(stats, &mStats, sizeof(rga_job_stats_t));
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#ifndef _rockchip_rga_job_queue_
+#define _rockchip_rga_job_queue_
+
+#include <stdint.h>
+#include <semaphore.h>
+#include <sys/types.h>
+
+#include <utils/Thread.h>
+#include <utils/Mutex.h>
+#include <utils/Condition.h>
+#include <utils/Timers.h>
+#include <utils/RefBase.h>
+
+#include <vector>
+
+#include "drmrga.h"
+
+namespace android {
+// -------------------------------------------------------------------------------
+
+class RockchipRga;
+
+/*
+ * Prioritized asynchronous submission for RockchipRga.
+ *
+ * Producers push jobs into one lock-free multi-producer queue per priority
+ * class, one submitter thread per rga core drains the highest non-empty
+ * class into the devices. Since a core runs one job at a time, a realtime
+ * job waits for at most the jobs that are already in flight.
+ */
+class RockchipRgaJobQueue : public virtual RefBase
+{
+public:
+                RockchipRgaJobQueue(RockchipRga *rga);
+    virtual     ~RockchipRgaJobQueue();
+
+    int         start(int submitters);
+    int         submit(buffer_handle_t src, buffer_handle_t dst,
+                       drm_rga_t *rects, int rotation, int blend, int priority);
+    int         wait(int job, int timeoutMs);
+    int         detach(int job);
+    int         getStats(rga_job_stats_t *stats);
+
+    enum {
+        MAX_JOBS                    = 64,
+    };
+
+private:
+    struct JobNode {
+        JobNode                     *next;
+    };
+
+    struct Job {
+        JobNode                     node;
+        buffer_handle_t             src;
+        buffer_handle_t             dst;
+        drm_rga_t                   rects;
+        bool                        hasRects;
+        int                         rotation;
+        int                         blend;
+        int                         priority;
+        int                         result;
+        bool                        detached;
+        int32_t                     state;
+        uint32_t                    generation;
+        nsecs_t                     queueTime;
+    };
+
+    struct MpscQueue {
+        JobNode                     *head;
+        JobNode                     *tail;
+        JobNode                     stub;
+    };
+
+    enum {
+        JOB_FREE                    = 0,
+        JOB_QUEUED,
+        JOB_RUNNING,
+        JOB_DONE,
+    };
+
+    class Submitter : public Thread {
+    public:
+                    Submitter(RockchipRgaJobQueue *queue):
+                                            Thread(false), mQueue(queue) {}
+    private:
+        virtual bool threadLoop() {return mQueue->runOne();}
+        RockchipRgaJobQueue         *mQueue;
+    };
+
+    bool        runOne();
+
+    void        queueInit(MpscQueue *q);
+    void        queuePush(MpscQueue *q, JobNode *node);
+    JobNode*    queuePop(MpscQueue *q);
+
+    int         allocSlot();
+    void        freeSlot(int slot);
+    Job*        findJob(int handle);
+    Job*        nextJob();
+
+    RockchipRga                     *mRga;
+    Job                             mJobs[MAX_JOBS];
+    uint64_t                        mFreeSlots;
+    MpscQueue                       mQueues[DRM_RGA_PRIORITY_COUNT];
+    sem_t                           mPending;
+    bool                            mExit;
+    Mutex                           mPopLock;
+    std::vector< sp<Submitter> >    mSubmitters;
+    Mutex                           mDoneLock;
+    Condition                       mDoneCond;
+    rga_job_stats_t                 mStats;
+};
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
+
+#endif
@@ -0,0 +1,444 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "rockchiprga"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+
+#include <utils/Log.h>
+
+#include "RockchipRga.h"
+#include "RockchipRgaPipeline.h"
+
+namespace android {
+
+// ---------------------------------------------------------------------------
+
+RockchipRgaPipeline::RockchipRgaPipeline(size_t size, int depth):
+    mStarted(false),
+    mExit(false)
+{
+    addRing(size, depth);
+}
+
+RockchipRgaPipeline::~RockchipRgaPipeline()
+{
+    stop();
+
+    for (size_t i = 0; i < mStages.size(); i++)
+        delete mStages[i];
+
+    freeRings();
+    for (size_t i = 0; i < mRings.size(); i++)
+        delete mRings[i];
+}
+
+RockchipRgaPipeline::Ring* RockchipRgaPipeline::addRing(size_t size, int depth)
+{
+    Ring *ring = new Ring();
+
+    ring->size = size;
+    ring->depth = depth;
+    ring->maxFilled = 0;
+    mRings.push_back(ring);
+
+    return ring;
+}
+
+int RockchipRgaPipeline::addStage(const char *name, StageFunc func, void *arg,
+                                                    size_t size, int depth)
+{
+    Mutex::Autolock lock(mLock);
+    Stage *stage;
+
+    if (mStarted)
+        return -EBUSY;
+    if (!func || !size || depth < 1 || depth > MAX_DEPTH)
+        return -EINVAL;
+
+    stage = new Stage();
+    memset(stage->name, 0, sizeof(stage->name));
+    strncpy(stage->name, name ? name : "", sizeof(stage->name) - 1);
+    stage->func = func;
+    stage->arg = arg;
+    memset(&stage->rects, 0, sizeof(drm_rga_t));
+    stage->rotation = 0;
+    memset(&stage->stats, 0, sizeof(rga_pipeline_stats_t));
+
+    mStages.push_back(stage);
+    addRing(size, depth);
+
+    return mStages.size() - 1;
+}
+
+int RockchipRgaPipeline::blitStage(void *arg, void *in, void *out,
+                                                    int64_t * /* timestamp */)
+{
+    Stage *stage = (Stage *)arg;
+
+    return RockchipRga::get().RkRgaBlit(in, out, &stage->rects,
+                                                        stage->rotation, 0);
+}
+
+int RockchipRgaPipeline::addBlitStage(const char *name, const drm_rga_t *rects,
+                                        int rotation, size_t size, int depth)
+{
+    int index;
+
+    if (!rects)
+        return -EINVAL;
+
+    index = addStage(name, blitStage, NULL, size, depth);
+    if (index < 0)
+        return index;
+
+    Mutex::Autolock lock(mLock);
+    mStages[index]->arg = mStages[index];
+    memcpy(&mStages[index]->rects, rects, sizeof(drm_rga_t));
+    mStages[index]->rotation = rotation;
+
+    return index;
+}
+
+/* with mLock held or once the runners are gone */
+void RockchipRgaPipeline::freeRings()
+{
+    for (size_t i = 0; i < mRings.size(); i++) {
+        Ring *ring = mRings[i];
+
+        for (size_t k = 0; k < ring->buffers.size(); k++)
+            free(ring->buffers[k]);
+        ring->buffers.clear();
+        ring->frames.clear();
+        ring->readyTimes.clear();
+        ring->states.clear();
+        ring->free.clear();
+        ring->filled.clear();
+        ring->maxFilled = 0;
+    }
+}
+
+/* with mLock held, wakes every runner and waiter to see mExit */
+void RockchipRgaPipeline::wakeAll()
+{
+    for (size_t i = 0; i < mRings.size(); i++) {
+        mRings[i]->freeCond.broadcast();
+        mRings[i]->filledCond.broadcast();
+    }
+}
+
+/* without mLock, the runners take it on their way out */
+void RockchipRgaPipeline::joinRunners()
+{
+    for (size_t i = 0; i < mStages.size(); i++) {
+        if (mStages[i]->runner != NULL) {
+            mStages[i]->runner->requestExitAndWait();
+            mStages[i]->runner.clear();
+        }
+    }
+}
+
+/*
+ * A failed start leaves the pipeline as it was before, the rings freed
+ * and the runners already started joined, so it may be retried.
+ */
+int RockchipRgaPipeline::start()
+{
+    int ret = 0;
+
+    {
+        Mutex::Autolock lock(mLock);
+
+        if (mStarted || mExit)
+            return -EBUSY;
+        if (mStages.empty() || mRings[0]->size == 0 ||
+                        mRings[0]->depth < 1 || mRings[0]->depth > MAX_DEPTH)
+            return -EINVAL;
+
+        /* page aligned, the rga maps whole pages */
+        for (size_t i = 0; i < mRings.size() && !ret; i++) {
+            Ring *ring = mRings[i];
+
+            ring->buffers.assign(ring->depth, (void *)NULL);
+            ring->frames.resize(ring->depth);
+            ring->readyTimes.assign(ring->depth, 0);
+            ring->states.assign(ring->depth, (int)SLOT_FREE);
+            for (int k = 0; k < ring->depth; k++) {
+                if (posix_memalign(&ring->buffers[k], 4096, ring->size)) {
+                    ring->buffers[k] = NULL;
+                    ALOGE("pipeline ring %d: no memory for %zu bytes",
+                                                        (int)i, ring->size);
+                    ret = -ENOMEM;
+                    break;
+                }
+                ring->free.push_back(k);
+            }
+        }
+        if (ret) {
+            freeRings();
+            return ret;
+        }
+
+        for (size_t i = 0; i < mStages.size(); i++) {
+            mStages[i]->stats.depth = mRings[i]->depth;
+            mStages[i]->runner = new Runner(this, i);
+            if (mStages[i]->runner->run("rga_pipeline", PRIORITY_URGENT_DISPLAY)) {
+                ALOGE("start pipeline stage %s fail", mStages[i]->name);
+                mStages[i]->runner.clear();
+                mExit = true;
+                wakeAll();
+                ret = -ENODEV;
+                break;
+            }
+        }
+        if (!ret) {
+            mStarted = true;
+            return 0;
+        }
+    }
+
+    joinRunners();
+
+    Mutex::Autolock lock(mLock);
+    freeRings();
+    mExit = false;
+    return ret;
+}
+
+void RockchipRgaPipeline::stop()
+{
+    {
+        Mutex::Autolock lock(mLock);
+
+        mExit = true;
+        wakeAll();
+    }
+
+    joinRunners();
+}
+
+/* with mLock held, the front slot of from once there is one */
+int RockchipRgaPipeline::takeSlot(Ring *ring, std::deque<int> *from,
+                                            Condition *cond, int timeoutMs)
+{
+    nsecs_t deadline = systemTime(SYSTEM_TIME_MONOTONIC) +
+                                milliseconds_to_nanoseconds(timeoutMs);
+    int slot;
+
+    while (from->empty() && !mExit) {
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        if (timeoutMs == 0)
+            return -EBUSY;
+        if (timeoutMs < 0)
+            cond->wait(mLock);
+        else if (now >= deadline)
+            return -ETIMEDOUT;
+        else
+            cond->waitRelative(mLock, deadline - now);
+    }
+
+    if (mExit)
+        return -EPIPE;
+
+    slot = from->front();
+    from->pop_front();
+    ring->states[slot] = SLOT_BUSY;
+
+    return slot;
+}
+
+bool RockchipRgaPipeline::runStage(int index)
+{
+    Stage *stage = mStages[index];
+    Ring *in = mRings[index];
+    Ring *out = mRings[index + 1];
+    nsecs_t stallStart, runStart, done;
+    int64_t timestamp;
+    int inSlot, outSlot, ret;
+    Frame frame;
+
+    {
+        Mutex::Autolock lock(mLock);
+
+        inSlot = takeSlot(in, &in->filled, &in->filledCond, -1);
+        if (inSlot < 0)
+            return false;
+
+        stallStart = systemTime(SYSTEM_TIME_MONOTONIC);
+        outSlot = takeSlot(out, &out->free, &out->freeCond, -1);
+        if (outSlot < 0)
+            return false;
+        stage->stats.stallUs += ns2us(systemTime(SYSTEM_TIME_MONOTONIC) - stallStart);
+
+        frame = in->frames[inSlot];
+    }
+
+    timestamp = frame.timestamp;
+    runStart = systemTime(SYSTEM_TIME_MONOTONIC);
+    ret = stage->func(stage->arg, in->buffers[inSlot], out->buffers[outSlot],
+                                                                &timestamp);
+    done = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    Mutex::Autolock lock(mLock);
+    stage->stats.busyUs += ns2us(done - runStart);
+
+    if (ret) {
+        stage->stats.errors++;
+        out->states[outSlot] = SLOT_FREE;
+        out->free.push_front(outSlot);
+        out->freeCond.signal();
+    } else {
+        unsigned int latency = ns2us(done - in->readyTimes[inSlot]);
+
+        out->frames[outSlot] = frame;
+        out->frames[outSlot].data = out->buffers[outSlot];
+        out->frames[outSlot].index = outSlot;
+        out->frames[outSlot].timestamp = timestamp;
+        out->readyTimes[outSlot] = done;
+        out->states[outSlot] = SLOT_FILLED;
+        out->filled.push_back(outSlot);
+        if (out->filled.size() > out->maxFilled)
+            out->maxFilled = out->filled.size();
+        out->filledCond.signal();
+
+        stage->stats.frames++;
+        stage->stats.totalLatencyUs += latency;
+        if (latency > stage->stats.maxLatencyUs)
+            stage->stats.maxLatencyUs = latency;
+    }
+
+    in->states[inSlot] = SLOT_FREE;
+    in->free.push_back(inSlot);
+    in->freeCond.signal();
+
+    return true;
+}
+
+int RockchipRgaPipeline::dequeueInput(Frame *frame, int timeoutMs)
+{
+    Mutex::Autolock lock(mLock);
+    Ring *ring = mRings[0];
+    int slot;
+
+    if (!frame)
+        return -EINVAL;
+    if (!mStarted)
+        return -EPIPE;
+
+    slot = takeSlot(ring, &ring->free, &ring->freeCond, timeoutMs);
+    if (slot < 0)
+        return slot;
+
+    ring->states[slot] = SLOT_CLIENT;
+    frame->data = ring->buffers[slot];
+    frame->index = slot;
+    frame->timestamp = 0;
+    frame->queueTime = 0;
+
+    return 0;
+}
+
+int RockchipRgaPipeline::queueInput(const Frame *frame)
+{
+    Mutex::Autolock lock(mLock);
+    Ring *ring = mRings[0];
+    nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    if (!frame || frame->index < 0 || frame->index >= ring->depth ||
+                    ring->states.empty() ||
+                    ring->states[frame->index] != SLOT_CLIENT)
+        return -EINVAL;
+    if (mExit)
+        return -EPIPE;
+
+    ring->frames[frame->index] = *frame;
+    ring->frames[frame->index].queueTime = now;
+    ring->readyTimes[frame->index] = now;
+    ring->states[frame->index] = SLOT_FILLED;
+    ring->filled.push_back(frame->index);
+    if (ring->filled.size() > ring->maxFilled)
+        ring->maxFilled = ring->filled.size();
+    ring->filledCond.signal();
+
+    return 0;
+}
+
+int RockchipRgaPipeline::acquireOutput(Frame *frame, int timeoutMs)
+{
+    Mutex::Autolock lock(mLock);
+    Ring *ring = mRings.back();
+    int slot;
+
+    if (!frame)
+        return -EINVAL;
+    if (!mStarted)
+        return -EPIPE;
+
+    slot = takeSlot(ring, &ring->filled, &ring->filledCond, timeoutMs);
+    if (slot < 0)
+        return slot;
+
+    ring->states[slot] = SLOT_CLIENT;
+    *frame = ring->frames[slot];
+
+    return 0;
+}
+
+int RockchipRgaPipeline::releaseOutput(const Frame *frame)
+{
+    Mutex::Autolock lock(mLock);
+    Ring *ring = mRings.back();
+
+    if (!frame || frame->index < 0 || frame->index >= ring->depth ||
+                    ring->states.empty() ||
+                    ring->states[frame->index] != SLOT_CLIENT)
+        return -EINVAL;
+
+    ring->states[frame->index] = SLOT_FREE;
+    ring->free.push_back(frame->index);
+    ring->freeCond.signal();
+
+    return 0;
+}
+
+int RockchipRgaPipeline::getStats(int stage, rga_pipeline_stats_t *stats)
+{
+    Mutex::Autolock lock(mLock);
+
+    if (!stats || stage < 0 || stage >= (int)mStages.size())
+        return -EINVAL;
+
+    memcpy(stats, &mStages[stage]->stats, sizeof(rga_pipeline_stats_t));
+    stats->queued = mRings[stage]->filled.size();
+    stats->maxQueued = mRings[stage]->maxFilled;
+
+    return 0;
+}
+
+size_t RockchipRgaPipeline::footprint() const
+{
+    size_t bytes = 0;
+
+    for (size_t i = 0; i < mRings.size(); i++)
+        bytes += mRings[i]->size * mRings[i]->depth;
+
+    return bytes;
+}
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
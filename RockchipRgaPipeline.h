@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#ifndef _rockchip_rga_pipeline_
+#define _rockchip_rga_pipeline_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <utils/Thread.h>
+#include <utils/Mutex.h>
+#include <utils/Condition.h>
+#include <utils/Timers.h>
+#include <utils/RefBase.h>
+
+#include <deque>
+#include <vector>
+
+#include "drmrga.h"
+
+namespace android {
+// -------------------------------------------------------------------------------
+
+/*
+ * A chain of stages joined by fixed rings of buffers, e.g.
+ * decode -> RkRgaBlit -> encode.
+ *
+ * Ring 0 holds the frames the producer fills, stage i reads ring i and
+ * writes ring i + 1, the consumer takes frames from the last ring. Each
+ * stage runs on its own thread and holds its input until its output ring
+ * has a free buffer, so a slow stage fills the rings in front of it and
+ * in the end blocks dequeueInput. Memory stays at the rings allocated by
+ * start, and the producer runs at the pace of the slowest stage.
+ */
+class RockchipRgaPipeline : public virtual RefBase
+{
+public:
+    /*
+    @value index:    slot in the ring, pass the frame back unchanged
+    @value timestamp:set by the producer, carried through the stages
+    @value queueTime:when queueInput took the frame, for end to end latency
+    */
+    struct Frame {
+        void                        *data;
+        int                         index;
+        int64_t                     timestamp;
+        nsecs_t                     queueTime;
+    };
+
+    /*
+    @param in:the frame to read
+    @param out:the buffer of the stage output ring to write
+    @param timestamp:of the frame, the stage may change it
+    @return 0, or an error to drop the frame
+    */
+    typedef int (*StageFunc)(void *arg, void *in, void *out, int64_t *timestamp);
+
+    /*
+    @param size:bytes of a producer buffer
+    @param depth:producer buffers, 2 or 3 is enough unless the producer
+        is bursty
+    */
+                RockchipRgaPipeline(size_t size, int depth);
+    virtual     ~RockchipRgaPipeline();
+
+    /*
+    @fun addStage:Append a stage that writes into a ring of depth buffers
+        of size bytes. Only before start.
+    */
+    int         addStage(const char *name, StageFunc func, void *arg,
+                                                    size_t size, int depth);
+
+    /*
+    @fun addBlitStage:Append a stage that runs RkRgaBlit with rects, in and
+        out being the src and dst buffers.
+    */
+    int         addBlitStage(const char *name, const drm_rga_t *rects,
+                                        int rotation, size_t size, int depth);
+
+    /*
+    @fun start:Allocate the rings and start a thread per stage.
+    */
+    int         start();
+
+    /*
+    @fun stop:Stop the stages and wake every waiter with -EPIPE, the frames
+        still in the rings are dropped.
+    */
+    void        stop();
+
+    /*
+    @fun dequeueInput:Take a free producer buffer to fill.
+    @param timeoutMs:< 0 waits forever, 0 returns -EBUSY if the ring is full
+    */
+    int         dequeueInput(Frame *frame, int timeoutMs);
+    int         queueInput(const Frame *frame);
+
+    /*
+    @fun acquireOutput:Take the oldest frame out of the last stage, the
+        buffer stays the caller's until releaseOutput.
+    */
+    int         acquireOutput(Frame *frame, int timeoutMs);
+    int         releaseOutput(const Frame *frame);
+
+    int         stages() const {return mStages.size();}
+    int         getStats(int stage, rga_pipeline_stats_t *stats);
+
+    /* bytes of all rings */
+    size_t      footprint() const;
+
+    enum {
+        MAX_DEPTH                   = 32,
+    };
+
+private:
+    enum {
+        SLOT_FREE                   = 0,
+        SLOT_CLIENT,
+        SLOT_FILLED,
+        SLOT_BUSY,
+    };
+
+    struct Ring {
+        size_t                      size;
+        int                         depth;
+        std::vector<void*>          buffers;
+        std::vector<Frame>          frames;
+        std::vector<nsecs_t>        readyTimes;
+        std::vector<int>            states;
+        std::deque<int>             free;
+        std::deque<int>             filled;
+        unsigned int                maxFilled;
+        Condition                   freeCond;
+        Condition                   filledCond;
+    };
+
+    class Runner : public Thread {
+    public:
+                    Runner(RockchipRgaPipeline *pipeline, int stage):
+                        Thread(false), mPipeline(pipeline), mStage(stage) {}
+    private:
+        virtual bool threadLoop() {return mPipeline->runStage(mStage);}
+        RockchipRgaPipeline         *mPipeline;
+        int                         mStage;
+    };
+
+    struct Stage {
+        char                        name[32];
+        StageFunc                   func;
+        void                        *arg;
+        drm_rga_t                   rects;
+        int                         rotation;
+        sp<Runner>                  runner;
+        rga_pipeline_stats_t        stats;
+    };
+
+    static int  blitStage(void *arg, void *in, void *out, int64_t *timestamp);
+
+    Ring*       addRing(size_t size, int depth);
+    int         takeSlot(Ring *ring, std::deque<int> *from, Condition *cond,
+                                                                int timeoutMs);
+    bool        runStage(int index);
+    void        freeRings();
+    void        wakeAll();
+    void        joinRunners();
+
+    std::vector<Ring*>              mRings;
+    std::vector<Stage*>             mStages;
+    Mutex                           mLock;
+    bool                            mStarted;
+    bool                            mExit;
+};
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
+
+#endif
@@ -0,0 +1,507 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "rockchiprga"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <utils/Log.h>
+
+#include "RockchipRga.h"
+#include "RockchipRgaCpu.h"
+#include "RockchipRgaRawVideo.h"
+
+/* from linux/udmabuf.h, which older kernel headers lack */
+struct rga_udmabuf_create {
+    uint32_t memfd;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t size;
+};
+
+#define RGA_UDMABUF_FLAGS_CLOEXEC   0x01
+#define RGA_UDMABUF_CREATE          _IOW('u', 0x42, struct rga_udmabuf_create)
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC                 0x0001U
+#define MFD_ALLOW_SEALING           0x0002U
+#endif
+
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS                 1033
+#define F_SEAL_SHRINK               0x0002
+#endif
+
+namespace android {
+
+// ---------------------------------------------------------------------------
+
+size_t RockchipRgaRawVideo::frameSize(const rga_rect_t *rect)
+{
+    int format;
+    size_t pitch;
+
+    if (!rect || rect->wstride <= 0 || rect->height <= 0)
+        return 0;
+
+    format = RockchipRga::get().RkRgaGetRgaFormat(rect->format);
+    if (format < 0)
+        return 0;
+
+    if (format == RGA_FORMAT_YCbCr_420_SP_P010)
+        pitch = (size_t)rect->wstride * 2;
+    else if (RockchipRgaCpu::is10Bit(format))
+        pitch = ((size_t)rect->wstride * 10 + 7) / 8;
+    else
+        pitch = (size_t)rect->wstride * RockchipRgaCpu::bytesPerPixel(format);
+
+    if (RockchipRgaCpu::isYuv(format))
+        return pitch * rect->height * 3 / 2;
+
+    return pitch * rect->height;
+}
+
+// ---------------------------------------------------------------------------
+
+RockchipRgaRawReader::RockchipRgaRawReader():
+    mFd(-1),
+    mMemFd(-1),
+    mDmabufFd(-1),
+    mBase(NULL),
+    mMapSize(0),
+    mFrameSize(0),
+    mFrames(0),
+    mWindow(NULL),
+    mWindowSize(0),
+    mSlotSize(0)
+{
+}
+
+RockchipRgaRawReader::~RockchipRgaRawReader()
+{
+    close();
+}
+
+int RockchipRgaRawReader::open(const char *path, const rga_rect_t *rect)
+{
+    struct stat st;
+    void *base;
+
+    close();
+
+    mFrameSize = RockchipRgaRawVideo::frameSize(rect);
+    if (!path || !mFrameSize)
+        return -EINVAL;
+
+    mFd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (mFd < 0 || fstat(mFd, &st)) {
+        ALOGE("open %s fail: %s", path, strerror(errno));
+        close();
+        return -errno;
+    }
+
+    mFrames = st.st_size / mFrameSize;
+    if (!mFrames) {
+        ALOGE("%s holds no whole frame of %zu bytes", path, mFrameSize);
+        close();
+        return -EINVAL;
+    }
+
+    /* private and writable, the rga may ask for write access to its src */
+    mMapSize = (size_t)mFrames * mFrameSize;
+    base = mmap(NULL, mMapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, mFd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("map %s fail: %s", path, strerror(errno));
+        close();
+        return -ENOMEM;
+    }
+
+    mBase = (uint8_t *)base;
+    madvise(mBase, mMapSize, MADV_SEQUENTIAL);
+
+    return 0;
+}
+
+void RockchipRgaRawReader::close()
+{
+    if (mWindow)
+        munmap(mWindow, mWindowSize);
+    if (mBase)
+        munmap(mBase, mMapSize);
+    if (mDmabufFd >= 0)
+        ::close(mDmabufFd);
+    if (mMemFd >= 0)
+        ::close(mMemFd);
+    if (mFd >= 0)
+        ::close(mFd);
+
+    mFd = mMemFd = mDmabufFd = -1;
+    mBase = NULL;
+    mMapSize = 0;
+    mFrames = 0;
+    mWindow = NULL;
+    mWindowSize = 0;
+    mSlotSize = 0;
+    mSlots.clear();
+}
+
+/*
+ * Only a window of the clip goes into the memfd, frame copies each frame
+ * in as it is taken. Slots are page aligned, the offsets of the frames in
+ * the dma-buf then are too.
+ */
+int RockchipRgaRawReader::importDmabuf()
+{
+    struct rga_udmabuf_create create;
+    size_t slotSize = (mFrameSize + 4095) & ~(size_t)4095;
+    int slots = mFrames < DMABUF_WINDOW ? mFrames : DMABUF_WINDOW;
+    size_t size = slotSize * slots;
+    int dev, memFd, dmabufFd;
+    void *base;
+
+    if (!mBase)
+        return -EINVAL;
+    if (mDmabufFd >= 0)
+        return 0;
+
+    dev = ::open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    if (dev < 0)
+        return -ENODEV;
+
+#ifdef __NR_memfd_create
+    memFd = syscall(__NR_memfd_create, "rga_raw_video",
+                                        MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    memFd = -1;
+    errno = ENOSYS;
+#endif
+    if (memFd < 0 || ftruncate(memFd, size)) {
+        int err = errno;
+
+        if (memFd >= 0)
+            ::close(memFd);
+        ::close(dev);
+        return -err;
+    }
+
+    base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+    if (base == MAP_FAILED) {
+        ::close(memFd);
+        ::close(dev);
+        return -ENOMEM;
+    }
+
+    /* udmabuf only takes memfds that can not shrink under it */
+    memset(&create, 0, sizeof(create));
+    create.memfd = memFd;
+    create.flags = RGA_UDMABUF_FLAGS_CLOEXEC;
+    create.offset = 0;
+    create.size = size;
+    if (fcntl(memFd, F_ADD_SEALS, F_SEAL_SHRINK) ||
+            (dmabufFd = ioctl(dev, RGA_UDMABUF_CREATE, &create)) < 0) {
+        int err = errno;
+
+        munmap(base, size);
+        ::close(memFd);
+        ::close(dev);
+        return -err;
+    }
+    ::close(dev);
+
+    mWindow = (uint8_t *)base;
+    mWindowSize = size;
+    mSlotSize = slotSize;
+    mSlots.assign(slots, -1);
+    mMemFd = memFd;
+    mDmabufFd = dmabufFd;
+
+    return 0;
+}
+
+void* RockchipRgaRawReader::frame(int index)
+{
+    uintptr_t ahead, end;
+    int slot;
+
+    if (!mBase || index < 0 || index >= mFrames)
+        return NULL;
+
+    /* read the next frames from disk while this one is blitted */
+    if (index + 1 < mFrames) {
+        ahead = (uintptr_t)(mBase + (size_t)(index + 1) * mFrameSize) &
+                                                            ~(uintptr_t)4095;
+        end = (uintptr_t)(mBase + (size_t)(index + 1 + READ_AHEAD < mFrames ?
+                            index + 1 + READ_AHEAD : mFrames) * mFrameSize);
+        madvise((void *)ahead, end - ahead, MADV_WILLNEED);
+    }
+
+    if (!mWindow)
+        return mBase + (size_t)index * mFrameSize;
+
+    slot = index % mSlots.size();
+    if (mSlots[slot] != index) {
+        memcpy(mWindow + slot * mSlotSize, mBase + (size_t)index * mFrameSize,
+                                                                mFrameSize);
+        mSlots[slot] = index;
+    }
+
+    return mWindow + slot * mSlotSize;
+}
+
+size_t RockchipRgaRawReader::offset(int index) const
+{
+    if (!mWindow)
+        return (size_t)index * mFrameSize;
+
+    return (index % mSlots.size()) * mSlotSize;
+}
+
+// ---------------------------------------------------------------------------
+
+RockchipRgaRawWriter::RockchipRgaRawWriter():
+    mFd(-1),
+    mFrameSize(0),
+    mWriting(false),
+    mExit(false),
+    mError(0),
+    mWritten(0)
+{
+}
+
+RockchipRgaRawWriter::~RockchipRgaRawWriter()
+{
+    close();
+}
+
+int RockchipRgaRawWriter::open(const char *path, const rga_rect_t *rect,
+                                                                int depth)
+{
+    if (mFd >= 0)
+        return -EBUSY;
+
+    mFrameSize = RockchipRgaRawVideo::frameSize(rect);
+    if (!path || !mFrameSize || depth < 1)
+        return -EINVAL;
+
+    mFd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (mFd < 0) {
+        ALOGE("open %s fail: %s", path, strerror(errno));
+        return -errno;
+    }
+
+    for (int i = 0; i < depth; i++) {
+        void *buffer;
+
+        if (posix_memalign(&buffer, 4096, mFrameSize)) {
+            close();
+            return -ENOMEM;
+        }
+        mBuffers.push_back(buffer);
+        mDequeued.push_back(false);
+        mFree.push_back(buffer);
+    }
+
+    mExit = false;
+    mError = 0;
+    mWritten = 0;
+    mFlusher = new Flusher(this);
+    if (mFlusher->run("rga_raw_writer", PRIORITY_BACKGROUND)) {
+        mFlusher.clear();
+        close();
+        return -ENODEV;
+    }
+
+    return 0;
+}
+
+int RockchipRgaRawWriter::close()
+{
+    int ret;
+
+    {
+        Mutex::Autolock lock(mLock);
+
+        while (mFlusher != NULL && (!mQueued.empty() || mWriting))
+            mCond.wait(mLock);
+        mExit = true;
+        mCond.broadcast();
+    }
+
+    if (mFlusher != NULL) {
+        mFlusher->requestExitAndWait();
+        mFlusher.clear();
+    }
+
+    for (size_t i = 0; i < mBuffers.size(); i++)
+        free(mBuffers[i]);
+    mBuffers.clear();
+    mDequeued.clear();
+    mFree.clear();
+    mQueued.clear();
+
+    if (mFd >= 0) {
+        if (fsync(mFd) && !mError)
+            mError = -errno;
+        ::close(mFd);
+        mFd = -1;
+    }
+
+    ret = mError;
+    mError = 0;
+    return ret;
+}
+
+int RockchipRgaRawWriter::dequeue(void **buffer, int timeoutMs)
+{
+    Mutex::Autolock lock(mLock);
+    nsecs_t deadline = systemTime(SYSTEM_TIME_MONOTONIC) +
+                                milliseconds_to_nanoseconds(timeoutMs);
+
+    if (!buffer || mFd < 0)
+        return -EINVAL;
+
+    while (mFree.empty() && !mExit) {
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        if (timeoutMs == 0)
+            return -EBUSY;
+        if (timeoutMs < 0)
+            mCond.wait(mLock);
+        else if (now >= deadline)
+            return -ETIMEDOUT;
+        else
+            mCond.waitRelative(mLock, deadline - now);
+    }
+
+    if (mExit)
+        return -EPIPE;
+    if (mError)
+        return mError;
+
+    *buffer = mFree.front();
+    mFree.pop_front();
+    for (size_t i = 0; i < mBuffers.size(); i++) {
+        if (mBuffers[i] == *buffer)
+            mDequeued[i] = true;
+    }
+
+    return 0;
+}
+
+/* only a buffer dequeue handed out and not queued since */
+int RockchipRgaRawWriter::queue(void *buffer)
+{
+    Mutex::Autolock lock(mLock);
+    size_t i;
+
+    for (i = 0; i < mBuffers.size(); i++) {
+        if (mBuffers[i] == buffer)
+            break;
+    }
+    if (i == mBuffers.size() || !mDequeued[i])
+        return -EINVAL;
+
+    mDequeued[i] = false;
+    mQueued.push_back(buffer);
+    mCond.broadcast();
+
+    return 0;
+}
+
+unsigned int RockchipRgaRawWriter::written()
+{
+    Mutex::Autolock lock(mLock);
+    return mWritten;
+}
+
+bool RockchipRgaRawWriter::flushOne()
+{
+    const uint8_t *data;
+    size_t left;
+    off_t offset;
+    void *buffer;
+    int err = 0;
+
+    {
+        Mutex::Autolock lock(mLock);
+
+        while (mQueued.empty() && !mExit)
+            mCond.wait(mLock);
+        if (mQueued.empty())
+            return false;
+
+        buffer = mQueued.front();
+        mQueued.pop_front();
+        mWriting = true;
+        offset = (off_t)mWritten * mFrameSize;
+    }
+
+    data = (const uint8_t *)buffer;
+    left = mFrameSize;
+    while (left) {
+        ssize_t n = pwrite(mFd, data, left, offset);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            err = n < 0 ? -errno : -EIO;
+            break;
+        }
+        data += n;
+        left -= n;
+        offset += n;
+    }
+
+    /*
+     * Start writeback of this frame and drop the one before from the page
+     * cache once it is on disk, a long clip then costs two frames of cache.
+     */
+    if (!err) {
+        off_t start = offset - mFrameSize;
+
+        sync_file_range(mFd, start, mFrameSize, SYNC_FILE_RANGE_WRITE);
+        if (start >= (off_t)mFrameSize) {
+            sync_file_range(mFd, start - mFrameSize, mFrameSize,
+                    SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                    SYNC_FILE_RANGE_WAIT_AFTER);
+            posix_fadvise(mFd, start - mFrameSize, mFrameSize,
+                                                    POSIX_FADV_DONTNEED);
+        }
+    }
+
+    Mutex::Autolock lock(mLock);
+    if (err && !mError) {
+        ALOGE("raw video write fail: %s", strerror(-err));
+        mError = err;
+    }
+    if (!err)
+        mWritten++;
+    mWriting = false;
+    mFree.push_back(buffer);
+    mCond.broadcast();
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
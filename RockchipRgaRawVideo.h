@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#ifndef _rockchip_rga_raw_video_
+#define _rockchip_rga_raw_video_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <utils/Thread.h>
+#include <utils/Mutex.h>
+#include <utils/Condition.h>
+#include <utils/RefBase.h>
+
+#include <deque>
+#include <vector>
+
+#include "drmrga.h"
+
+namespace android {
+// -------------------------------------------------------------------------------
+
+/*
+ * Raw frame sequences: frames of one rga_rect_t layout back to back without
+ * a header, like the yuv dumps under /data of the tests. A frame is wstride x
+ * height with chroma right after luma, the layout RkRgaBlit expects of a
+ * user buffer.
+ */
+class RockchipRgaRawVideo
+{
+public:
+    /* bytes of a frame of rect->wstride, rect->height and rect->format */
+    static size_t frameSize(const rga_rect_t *rect);
+};
+
+/*
+ * Maps the whole file, frame returns a view that goes straight to the
+ * void* RkRgaBlit calls. Pages fault in from disk on first touch, frame
+ * asks the kernel to read the next frames ahead meanwhile.
+ */
+class RockchipRgaRawReader
+{
+public:
+                RockchipRgaRawReader();
+                ~RockchipRgaRawReader();
+
+    int         open(const char *path, const rga_rect_t *rect);
+    void        close();
+
+    /*
+    @fun importDmabuf:Wrap a window of DMABUF_WINDOW frames in a sealed
+        memfd udmabuf, so dmabufFd and offset can feed dma-buf consumers.
+        From then on frame copies the frame into the next slot of the
+        window, the memory taken is the window however long the clip is.
+    @return -ENODEV without /dev/udmabuf, the file mapping stays in use
+    */
+    int         importDmabuf();
+
+    /*
+    @fun frame:View of frame index. Writable, writes stay private to the
+        process. Valid until close, or after importDmabuf until
+        DMABUF_WINDOW other frames were taken.
+    */
+    void*       frame(int index);
+
+    int         frames() const {return mFrames;}
+    size_t      frameSize() const {return mFrameSize;}
+    int         dmabufFd() const {return mDmabufFd;}
+
+    /* in the dma-buf, of a frame frame took last */
+    size_t      offset(int index) const;
+
+private:
+    enum {
+        READ_AHEAD                  = 2,
+        DMABUF_WINDOW               = 4,
+    };
+
+    int                             mFd;
+    int                             mMemFd;
+    int                             mDmabufFd;
+    uint8_t                         *mBase;
+    size_t                          mMapSize;
+    size_t                          mFrameSize;
+    int                             mFrames;
+    uint8_t                         *mWindow;
+    size_t                          mWindowSize;
+    size_t                          mSlotSize;
+    std::vector<int>                mSlots;
+};
+
+/*
+ * Appends frames from a writer thread. dequeue hands out one of depth
+ * frame buffers to render into, queue passes it to the writer and
+ * dequeue blocks while all of them wait for the disk. Written frames are
+ * pushed out of the page cache, so memory stays flat however long the
+ * clip gets.
+ */
+class RockchipRgaRawWriter
+{
+public:
+                RockchipRgaRawWriter();
+                ~RockchipRgaRawWriter();
+
+    int         open(const char *path, const rga_rect_t *rect, int depth);
+
+    /*
+    @fun close:Write what is queued and stop the writer thread.
+    @return the first write error
+    */
+    int         close();
+
+    /*
+    @param timeoutMs:< 0 waits forever, 0 returns -EBUSY if none is free
+    */
+    int         dequeue(void **buffer, int timeoutMs);
+    int         queue(void *buffer);
+
+    unsigned int written();
+
+private:
+    class Flusher : public Thread {
+    public:
+                    Flusher(RockchipRgaRawWriter *writer):
+                                            Thread(false), mWriter(writer) {}
+    private:
+        virtual bool threadLoop() {return mWriter->flushOne();}
+        RockchipRgaRawWriter        *mWriter;
+    };
+
+    bool        flushOne();
+
+    int                             mFd;
+    size_t                          mFrameSize;
+    std::vector<void*>              mBuffers;
+    std::vector<bool>               mDequeued;
+    std::deque<void*>               mFree;
+    std::deque<void*>               mQueued;
+    bool                            mWriting;
+    bool                            mExit;
+    int                             mError;
+    unsigned int                    mWritten;
+    Mutex                           mLock;
+    Condition                       mCond;
+    sp<Flusher>                     mFlusher;
+};
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
+
+#endif
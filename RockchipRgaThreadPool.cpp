@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "rockchiprga"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <utils/Log.h>
+
+#include "drmrga.h"
+#include "RockchipRgaThreadPool.h"
+
+namespace android {
+
+// ---------------------------------------------------------------------------
+
+static long readSysfsLong(const char *path)
+{
+    char buf[32];
+    FILE *file;
+    long value = -1;
+
+    file = fopen(path, "r");
+    if (!file)
+        return -1;
+
+    if (fgets(buf, sizeof(buf), file)) {
+        char *end;
+
+        value = strtol(buf, &end, 10);
+        if (*end == 'K' || *end == 'k')
+            value *= 1024;
+        else if (*end == 'M' || *end == 'm')
+            value *= 1024 * 1024;
+    }
+    fclose(file);
+
+    return value;
+}
+
+/*
+ * Cores of a big.LITTLE cluster are told apart by their max frequency,
+ * returns how many cores are in the mask.
+ */
+int RockchipRgaThreadPool::clusterMask(int cluster, cpu_set_t *mask)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    long minFreq = -1, maxFreq = -1;
+    std::vector<long> freqs;
+    char path[128];
+    int count = 0;
+
+    CPU_ZERO(mask);
+
+    for (long i = 0; i < cpus && i < CPU_SETSIZE; i++) {
+        snprintf(path, sizeof(path),
+                    "/sys/devices/system/cpu/cpu%ld/cpufreq/cpuinfo_max_freq", i);
+        freqs.push_back(readSysfsLong(path));
+        if (freqs[i] < 0)
+            continue;
+        if (maxFreq < 0 || freqs[i] > maxFreq)
+            maxFreq = freqs[i];
+        if (minFreq < 0 || freqs[i] < minFreq)
+            minFreq = freqs[i];
+    }
+
+    for (long i = 0; i < (long)freqs.size(); i++) {
+        bool pick = cluster == DRM_RGA_CPU_CLUSTER_ANY || minFreq == maxFreq ||
+                    freqs[i] < 0 ||
+                    (cluster == DRM_RGA_CPU_CLUSTER_BIG && freqs[i] == maxFreq) ||
+                    (cluster == DRM_RGA_CPU_CLUSTER_LITTLE && freqs[i] == minFreq);
+
+        if (pick) {
+            CPU_SET(i, mask);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/* per-core share of the last level cache the stripes should fit in */
+int RockchipRgaThreadPool::cacheSize()
+{
+    static int size;
+
+    if (!size) {
+        long bytes = readSysfsLong("/sys/devices/system/cpu/cpu0/cache/index2/size");
+
+        size = bytes > 0 ? bytes : 256 * 1024;
+    }
+
+    return size;
+}
+
+RockchipRgaThreadPool::RockchipRgaThreadPool(int threads, int cluster):
+    mPinned(false),
+    mQueued(0),
+    mExit(false)
+{
+    int cores = clusterMask(cluster, &mAffinity);
+
+    mPinned = cluster != DRM_RGA_CPU_CLUSTER_ANY && cores > 0;
+    if (threads <= 0)
+        threads = cores > 0 ? cores : 1;
+
+    for (int i = 0; i < threads; i++) {
+        Worker *worker = new Worker();
+
+        worker->pool = this;
+        worker->id = i;
+        if (pthread_create(&worker->thread, NULL, workerLoop, worker)) {
+            ALOGE("create rga cpu worker %d fail: %s", i, strerror(errno));
+            delete worker;
+            break;
+        }
+        mWorkers.push_back(worker);
+    }
+}
+
+RockchipRgaThreadPool::~RockchipRgaThreadPool()
+{
+    {
+        Mutex::Autolock lock(mLock);
+        mExit = true;
+        mCond.broadcast();
+    }
+
+    /* a worker still running may steal from the others, join all first */
+    for (size_t i = 0; i < mWorkers.size(); i++)
+        pthread_join(mWorkers[i]->thread, NULL);
+    for (size_t i = 0; i < mWorkers.size(); i++)
+        delete mWorkers[i];
+}
+
+void RockchipRgaThreadPool::run(Group *group, TaskFunc func,
+                                                    void *arg, int count)
+{
+    Task task;
+
+    group->pending = count;
+    group->doneTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    /* without workers the caller runs everything itself */
+    if (mWorkers.empty()) {
+        for (int i = 0; i < count; i++)
+            func(arg, i);
+        group->pending = 0;
+        group->doneTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        return;
+    }
+
+    /* counted first so a worker never sees more tasks than mQueued */
+    __atomic_add_fetch(&mQueued, count, __ATOMIC_SEQ_CST);
+
+    /* contiguous runs of tasks per worker keep neighbour stripes together */
+    for (size_t w = 0; w < mWorkers.size(); w++) {
+        Worker *worker = mWorkers[w];
+        int first = count * w / mWorkers.size();
+        int last = count * (w + 1) / mWorkers.size();
+
+        Mutex::Autolock lock(worker->lock);
+        for (int i = first; i < last; i++) {
+            task.group = group;
+            task.func = func;
+            task.arg = arg;
+            task.index = i;
+            worker->tasks.push_back(task);
+        }
+    }
+
+    Mutex::Autolock lock(mLock);
+    mCond.broadcast();
+}
+
+bool RockchipRgaThreadPool::takeTask(Worker *self, Task *task)
+{
+    {
+        Mutex::Autolock lock(self->lock);
+
+        if (!self->tasks.empty()) {
+            *task = self->tasks.front();
+            self->tasks.pop_front();
+            __atomic_sub_fetch(&mQueued, 1, __ATOMIC_SEQ_CST);
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < mWorkers.size(); i++) {
+        Worker *victim = mWorkers[(self->id + i) % mWorkers.size()];
+        Mutex::Autolock lock(victim->lock);
+
+        if (!victim->tasks.empty()) {
+            *task = victim->tasks.back();
+            victim->tasks.pop_back();
+            __atomic_sub_fetch(&mQueued, 1, __ATOMIC_SEQ_CST);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void RockchipRgaThreadPool::finish(Group *group)
+{
+    Mutex::Autolock lock(group->lock);
+
+    if (--group->pending == 0) {
+        group->doneTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        group->cond.broadcast();
+    }
+}
+
+void RockchipRgaThreadPool::wait(Group *group)
+{
+    Mutex::Autolock lock(group->lock);
+
+    while (group->pending > 0)
+        group->cond.wait(group->lock);
+}
+
+void* RockchipRgaThreadPool::workerLoop(void *arg)
+{
+    Worker *self = (Worker *)arg;
+    RockchipRgaThreadPool *pool = self->pool;
+    Task task;
+
+    if (pool->mPinned &&
+            sched_setaffinity(0, sizeof(cpu_set_t), &pool->mAffinity))
+        ALOGE("pin rga cpu worker %d fail: %s", self->id, strerror(errno));
+
+    for (;;) {
+        {
+            Mutex::Autolock lock(pool->mLock);
+
+            while (__atomic_load_n(&pool->mQueued, __ATOMIC_SEQ_CST) == 0 &&
+                                                            !pool->mExit)
+                pool->mCond.wait(pool->mLock);
+            if (pool->mExit)
+                return NULL;
+        }
+
+        /* another worker may have grabbed the task between the two checks */
+        if (!pool->takeTask(self, &task)) {
+            sched_yield();
+            continue;
+        }
+
+        task.func(task.arg, task.index);
+        pool->finish(task.group);
+    }
+
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#ifndef _rockchip_rga_thread_pool_
+#define _rockchip_rga_thread_pool_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/types.h>
+
+#include <deque>
+#include <vector>
+
+#include <utils/Mutex.h>
+#include <utils/Condition.h>
+#include <utils/Timers.h>
+
+namespace android {
+// -------------------------------------------------------------------------------
+
+/*
+ * Work-stealing workers for the software renderer.
+ *
+ * A caller hands a group of indexed tasks to the pool and waits for the
+ * group, so several groups (e.g. the cpu half of a hybrid blit and an
+ * emulated core) can overlap. Tasks are dealt out to per-worker deques,
+ * a worker takes from the front of its own deque and steals from the back
+ * of the others once it runs dry, so slow cores (LITTLE ones, or cores
+ * busy with other processes) do not hold up the group.
+ */
+class RockchipRgaThreadPool
+{
+public:
+    typedef void (*TaskFunc)(void *arg, int index);
+
+    struct Group {
+        int32_t                     pending;
+        nsecs_t                     doneTime;
+        Mutex                       lock;
+        Condition                   cond;
+    };
+
+    /*
+    @param cluster:DRM_RGA_CPU_CLUSTER_ANY/BIG/LITTLE, cores the workers
+        are pinned to
+    */
+                RockchipRgaThreadPool(int threads, int cluster);
+                ~RockchipRgaThreadPool();
+
+    void        run(Group *group, TaskFunc func, void *arg, int count);
+    void        wait(Group *group);
+    int         threads() const {return mWorkers.size();}
+
+    static int  clusterMask(int cluster, cpu_set_t *mask);
+    static int  cacheSize();
+
+private:
+    struct Task {
+        Group                       *group;
+        TaskFunc                    func;
+        void                        *arg;
+        int                         index;
+    };
+
+    struct Worker {
+        RockchipRgaThreadPool       *pool;
+        pthread_t                   thread;
+        int                         id;
+        Mutex                       lock;
+        std::deque<Task>            tasks;
+    };
+
+    static void* workerLoop(void *arg);
+    bool        takeTask(Worker *self, Task *task);
+    void        finish(Group *group);
+
+    std::vector<Worker*>            mWorkers;
+    cpu_set_t                       mAffinity;
+    bool                            mPinned;
+    int32_t                         mQueued;
+    Mutex                           mLock;
+    Condition                       mCond;
+    bool                            mExit;
+};
+
+// ---------------------------------------------------------------------------
+
+}; // namespace android
+
+#endif
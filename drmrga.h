@@ -39,6 +39,77 @@
 #define DRM_RGA_TRANSFORM_FLIP_MASK     0x000000F0
 #define DRM_RGA_TRANSFORM_FLIP_H        0x00000020
 #define DRM_RGA_TRANSFORM_FLIP_V        0x00000010
+
+#define DRM_RGA_CPU_ACCESS_READ         0x00000001
+#define DRM_RGA_CPU_ACCESS_WRITE        0x00000002
+
+#define DRM_RGA_PRIORITY_REALTIME       0
+#define DRM_RGA_PRIORITY_INTERACTIVE    1
+#define DRM_RGA_PRIORITY_BACKGROUND     2
+#define DRM_RGA_PRIORITY_COUNT          3
+
+#define DRM_RGA_ENGINE_HW               0
+#define DRM_RGA_ENGINE_CPU              1
+#define DRM_RGA_ENGINE_HYBRID           2
+#define DRM_RGA_ENGINE_AUTO             3
+
+#define DRM_RGA_CPU_CLUSTER_ANY         0
+#define DRM_RGA_CPU_CLUSTER_BIG         1
+#define DRM_RGA_CPU_CLUSTER_LITTLE      2
+
+#define DRM_RGA_SCALE_AUTO              0
+#define DRM_RGA_SCALE_NEAREST           1
+#define DRM_RGA_SCALE_BILINEAR          2
+#define DRM_RGA_SCALE_BICUBIC           3
+#define DRM_RGA_SCALE_AREA              4
+
+#define DRM_RGA_DEPTH_TRUNCATE          0
+#define DRM_RGA_DEPTH_ROUND             1
+#define DRM_RGA_DEPTH_TONEMAP           2
+
+/* HAL_PIXEL_FORMAT_YCBCR_P010 of newer android, read by the cpu only */
+#define DRM_RGA_FORMAT_YCbCr_P010       0x36
+
+#define DRM_RGA_DITHER_AUTO             0
+#define DRM_RGA_DITHER_OFF              1
+#define DRM_RGA_DITHER_DIFFUSION        2
+
+#define DRM_RGA_FILTER_BLUR             0
+#define DRM_RGA_FILTER_SHARPEN          1
+
+#define DRM_RGA_PALETTE_BPP1            0
+#define DRM_RGA_PALETTE_BPP2            1
+#define DRM_RGA_PALETTE_BPP4            2
+#define DRM_RGA_PALETTE_BPP8            3
+#define DRM_RGA_PALETTE_MSB_FIRST       0
+#define DRM_RGA_PALETTE_LSB_FIRST       1
+
+#define DRM_RGA_PATTERN_MAX_SIZE        64
+
+#define DRM_RGA_COLORKEY_R              0x00000001
+#define DRM_RGA_COLORKEY_G              0x00000002
+#define DRM_RGA_COLORKEY_B              0x00000004
+#define DRM_RGA_COLORKEY_A              0x00000008
+#define DRM_RGA_COLORKEY_RGB            0x00000007
+#define DRM_RGA_COLORKEY_ZERO           0x00000010
+
+#define DRM_RGA_ROP_BLACKNESS           0x00
+#define DRM_RGA_ROP_NOTSRCERASE         0x11
+#define DRM_RGA_ROP_NOTSRCCOPY          0x33
+#define DRM_RGA_ROP_SRCERASE            0x44
+#define DRM_RGA_ROP_DSTINVERT           0x55
+#define DRM_RGA_ROP_PATINVERT           0x5A
+#define DRM_RGA_ROP_SRCINVERT           0x66
+#define DRM_RGA_ROP_SRCAND              0x88
+#define DRM_RGA_ROP_DSTCOPY             0xAA
+#define DRM_RGA_ROP_MERGEPAINT          0xBB
+#define DRM_RGA_ROP_MERGECOPY           0xC0
+#define DRM_RGA_ROP_SRCCOPY             0xCC
+#define DRM_RGA_ROP_SRCPAINT            0xEE
+#define DRM_RGA_ROP_PATCOPY             0xF0
+#define DRM_RGA_ROP_PATPAINT            0xFB
+#define DRM_RGA_ROP_WHITENESS           0xFF
+#define DRM_RGA_ROP_PATTERN             0x00000100
 /*****************************************************************************/
 
 /*
@@ -59,6 +130,118 @@ typedef struct drm_rga {
     rga_rect_t dst;
 } drm_rga_t;
 
+/*
+@value flush*:     clean cpu cache before rga reads/writes a cpu written buffer
+@value invalidate*:invalidate cpu cache before cpu reads a rga written buffer
+*/
+typedef struct rga_cache_stats {
+    unsigned int flushIssued;
+    unsigned int flushSkipped;
+    unsigned int invalidateIssued;
+    unsigned int invalidateSkipped;
+} rga_cache_stats_t;
+
+/*
+@value frames:        frames the stage passed on
+@value errors:        frames its function failed, they are dropped
+@value totalLatencyUs:input ready to output ready, for the average, with the
+                      wait for an output buffer
+@value maxLatencyUs:  worst of the above
+@value busyUs:        time in the stage function
+@value stallUs:       time holding a frame while the output ring was full,
+                      backpressure from downstream
+@value queued:        frames waiting in the input ring of the stage now
+@value maxQueued:     most frames ever waiting there. At the depth of the
+                      ring the stage is the bottleneck.
+@value depth:         buffers in the input ring
+*/
+typedef struct rga_pipeline_stats {
+    unsigned int frames;
+    unsigned int errors;
+    uint64_t     totalLatencyUs;
+    unsigned int maxLatencyUs;
+    uint64_t     busyUs;
+    uint64_t     stallUs;
+    unsigned int queued;
+    unsigned int maxQueued;
+    unsigned int depth;
+} rga_pipeline_stats_t;
+
+/*
+@value hwJobs/cpuJobs/hybridJobs:where DRM_RGA_ENGINE_AUTO sent its jobs
+@value uncalibrated:jobs of a format pair without a cost model, they go to
+                    the rga
+@value predictedUs:sum of the predicted time of the chosen engine
+@value actualUs:   sum of the measured time, both over calibrated jobs
+*/
+typedef struct rga_dispatch_stats {
+    unsigned int hwJobs;
+    unsigned int cpuJobs;
+    unsigned int hybridJobs;
+    unsigned int uncalibrated;
+    uint64_t     predictedUs;
+    uint64_t     actualUs;
+} rga_dispatch_stats_t;
+
+/*
+@value submitted/completed:jobs per priority class
+@value maxLatencyUs:       worst queue-to-done latency per priority class
+@value totalLatencyUs:     sum of queue-to-done latency, for the average
+*/
+typedef struct rga_job_stats {
+    unsigned int submitted[DRM_RGA_PRIORITY_COUNT];
+    unsigned int completed[DRM_RGA_PRIORITY_COUNT];
+    unsigned int maxLatencyUs[DRM_RGA_PRIORITY_COUNT];
+    uint64_t     totalLatencyUs[DRM_RGA_PRIORITY_COUNT];
+} rga_job_stats_t;
+
+/*
+@value depth:      jobs in flight on the core right now
+@value jobs:       jobs the core ran so far
+@value maxScale*:  largest scale factor the core does in one pass
+*/
+typedef struct rga_device_info {
+    char         name[32];
+    float        version;
+    int          emulated;
+    int          depth;
+    unsigned int jobs;
+    int          maxWidth;
+    int          maxScaleUp;
+    int          maxScaleDown;
+} rga_device_info_t;
+
+/*
+@value x,y,width,height: area to fill, relative to the dst rect
+@value color:      0xAARRGGBB at the top left of the area
+@value gradX:      change of r,g,b,a per pixel to the right, 8.8 fixed point
+@value gradY:      change of r,g,b,a per pixel down, 8.8 fixed point.
+                   Channels saturate, all zero is a solid fill
+*/
+typedef struct rga_fill {
+    int          x;
+    int          y;
+    int          width;
+    int          height;
+    unsigned int color;
+    short        gradX[4];
+    short        gradY[4];
+} rga_fill_t;
+
+/*
+@value x0,y0,x1,y1: end points relative to the dst rect, both are drawn
+@value color:      0xAARRGGBB, drawn opaque
+@value width:      pixels across the line, 0 is 1
+*/
+typedef struct rga_line {
+    int          x0;
+    int          y0;
+    int          x1;
+    int          y1;
+    unsigned int color;
+    int          width;
+} rga_line_t;
+
 typedef struct rga_module {
     /**
      * Common methods of the hardware composer module.  This *must* be the first member of
@@ -220,6 +403,41 @@ static inline int rga_set_rect(rga_rect *rect, int x, int y, int w, int h, int s
 
     return 0;
 }
+
+/*
+@fun rga_set_polyline:Segments joining count points, given as x,y pairs,
+    for RkRgaDrawLines. Returns the number of segments, count - 1.
+*/
+static inline int rga_set_polyline(rga_line_t *lines, const int *points,
+                                    int count, unsigned int color, int width)
+{
+    if (!lines || !points || count < 2)
+        return 0;
+
+    for (int i = 0; i < count - 1; i++) {
+        lines[i].x0 = points[i * 2];
+        lines[i].y0 = points[i * 2 + 1];
+        lines[i].x1 = points[i * 2 + 2];
+        lines[i].y1 = points[i * 2 + 3];
+        lines[i].color = color;
+        lines[i].width = width;
+    }
+
+    return count - 1;
+}
+
+/*
+@fun rga_set_outline:The 4 edges of a w x h box at x,y for RkRgaDrawLines.
+    Returns 4.
+*/
+static inline int rga_set_outline(rga_line_t *lines, int x, int y, int w, int h,
+                                                unsigned int color, int width)
+{
+    int points[10] = {x, y, x + w - 1, y, x + w - 1, y + h - 1,
+                                            x, y + h - 1, x, y};
+
+    return rga_set_polyline(lines, points, 5, color, width);
+}
 /*****************************************************************************/
 
 #endif
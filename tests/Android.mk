@@ -483,3 +483,87 @@ LOCAL_32_BIT_ONLY := true
 endif
 
 include $(BUILD_EXECUTABLE)
+
+#======================================================================
+#
+#rgabench
+#
+#======================================================================
+include $(CLEAR_VARS)
+
+LOCAL_CFLAGS += -Wall -Werror -Wunreachable-code
+
+LOCAL_C_INCLUDES += hardware/rockchip/librga
+
+LOCAL_C_INCLUDES += hardware/rk29/librga
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    liblog \
+    libutils \
+    libhardware \
+    librga
+
+#has no "external/stlport" from Android 6.0 on
+ifeq (1,$(strip $(shell expr $(PLATFORM_VERSION) \< 6.0)))
+LOCAL_C_INCLUDES += \
+    external/stlport/stlport
+
+LOCAL_SHARED_LIBRARIES += \
+    libstlport
+
+LOCAL_C_INCLUDES += bionic
+endif
+
+LOCAL_SRC_FILES:= \
+    RockchipRgaBench.cpp
+
+LOCAL_MODULE:= rgabench
+
+ifdef TARGET_32_BIT_SURFACEFLINGER
+LOCAL_32_BIT_ONLY := true
+endif
+
+include $(BUILD_EXECUTABLE)
+
+#======================================================================
+#
+#rgaregress
+#
+#======================================================================
+include $(CLEAR_VARS)
+
+LOCAL_CFLAGS += -Wall -Werror -Wunreachable-code
+
+LOCAL_C_INCLUDES += hardware/rockchip/librga
+
+LOCAL_C_INCLUDES += hardware/rk29/librga
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    liblog \
+    libutils \
+    libhardware \
+    librga
+
+#has no "external/stlport" from Android 6.0 on
+ifeq (1,$(strip $(shell expr $(PLATFORM_VERSION) \< 6.0)))
+LOCAL_C_INCLUDES += \
+    external/stlport/stlport
+
+LOCAL_SHARED_LIBRARIES += \
+    libstlport
+
+LOCAL_C_INCLUDES += bionic
+endif
+
+LOCAL_SRC_FILES:= \
+    RockchipRgaRegress.cpp
+
+LOCAL_MODULE:= rgaregress
+
+ifdef TARGET_32_BIT_SURFACEFLINGER
+LOCAL_32_BIT_ONLY := true
+endif
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,1202 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "RockchipRgaBench"
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+
+#include <utils/Timers.h>
+#include <hardware/hardware.h>
+#include <RockchipRga.h>
+#include <RockchipRgaPipeline.h>
+#include <RockchipRgaRawVideo.h>
+
+///////////////////////////////////////////////////////
+
+using namespace android;
+
+#define BENCH_LOOPS     10
+
+struct BenchCase {
+    const char  *name;
+    int         srcWidth;
+    int         srcHeight;
+    int         srcFormat;
+    int         dstWidth;
+    int         dstHeight;
+    int         dstFormat;
+    int         rotation;
+};
+
+static const BenchCase scalingCases[] = {
+    {"copy rgba 1080p",    1920, 1080, HAL_PIXEL_FORMAT_RGBA_8888,
+                           1920, 1080, HAL_PIXEL_FORMAT_RGBA_8888, 0},
+    {"convert nv12->rgba", 1920, 1080, HAL_PIXEL_FORMAT_YCrCb_NV12,
+                           1920, 1080, HAL_PIXEL_FORMAT_RGBA_8888, 0},
+    {"scale 1080p->720p",  1920, 1080, HAL_PIXEL_FORMAT_RGBA_8888,
+                           1280,  720, HAL_PIXEL_FORMAT_RGBA_8888, 0},
+    {"rotate 90 1080p",    1920, 1080, HAL_PIXEL_FORMAT_RGBA_8888,
+                           1080, 1920, HAL_PIXEL_FORMAT_RGBA_8888,
+                           HAL_TRANSFORM_ROT_90},
+};
+
+static int frameSize(int width, int height, int format)
+{
+    if (format == HAL_PIXEL_FORMAT_YCrCb_NV12 ||
+                    format == HAL_PIXEL_FORMAT_YCrCb_420_SP)
+        return width * height * 3 / 2;
+    if (format == HAL_PIXEL_FORMAT_RGB_565)
+        return width * height * 2;
+    if (format == HAL_PIXEL_FORMAT_RGB_888)
+        return width * height * 3;
+    return width * height * 4;
+}
+
+/* average time of one blit in us, -1 on error */
+static int64_t benchBlit(RockchipRga &rkRga, const BenchCase *c,
+                                                    void *src, void *dst)
+{
+    drm_rga_t rects;
+    nsecs_t start;
+    int ret;
+
+    memset(&rects, 0, sizeof(drm_rga_t));
+    rga_set_rect(&rects.src, 0, 0, c->srcWidth, c->srcHeight,
+                                            c->srcWidth, c->srcFormat);
+    rga_set_rect(&rects.dst, 0, 0, c->dstWidth, c->dstHeight,
+                                            c->dstWidth, c->dstFormat);
+
+    /* warm up page tables and caches */
+    ret = rkRga.RkRgaBlit(src, dst, &rects, c->rotation, 0);
+    if (ret)
+        return -1;
+
+    start = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (int i = 0; i < BENCH_LOOPS; i++)
+        rkRga.RkRgaBlit(src, dst, &rects, c->rotation, 0);
+
+    return (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000 / BENCH_LOOPS;
+}
+
+/*
+ * Run every case on the software renderer with 1..N workers, efficiency is
+ * the speedup over one worker divided by the worker count.
+ */
+static int benchScaling(RockchipRga &rkRga, int cluster)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_CPU);
+
+    for (size_t i = 0; i < sizeof(scalingCases) / sizeof(scalingCases[0]); i++) {
+        const BenchCase *c = &scalingCases[i];
+        void *src = malloc(frameSize(c->srcWidth, c->srcHeight, c->srcFormat));
+        void *dst = malloc(frameSize(c->dstWidth, c->dstHeight, c->dstFormat));
+        int64_t single = 0;
+
+        if (!src || !dst) {
+            free(src);
+            free(dst);
+            return -ENOMEM;
+        }
+        memset(src, 0x55, frameSize(c->srcWidth, c->srcHeight, c->srcFormat));
+
+        printf("%s:\n", c->name);
+        for (long threads = 1; threads <= cpus; threads++) {
+            int64_t us;
+
+            rkRga.RkRgaSetCpuWorkers(threads, cluster);
+            us = benchBlit(rkRga, c, src, dst);
+            if (us < 0) {
+                printf("  %2ld threads: blit fail\n", threads);
+                break;
+            }
+            if (threads == 1)
+                single = us;
+
+            printf("  %2ld threads: %7lld us  %6.1f MPix/s  efficiency %3.0f%%\n",
+                        threads, (long long)us,
+                        us ? (double)c->dstWidth * c->dstHeight / us : 0.0,
+                        us ? 100.0 * single / us / threads : 0.0);
+        }
+
+        free(src);
+        free(dst);
+    }
+
+    rkRga.RkRgaSetCpuWorkers(0, DRM_RGA_CPU_CLUSTER_ANY);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+    return 0;
+}
+
+/*
+ * Zone plate: rings whose frequency grows toward the corners, sampled at
+ * the pixel centers of a width x height image of the same scene.
+ */
+static void fillZonePlate(uint8_t *buf, int width, int height)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double u = (x + 0.5) / width - 0.5;
+            double v = (y + 0.5) / height - 0.5;
+            uint8_t c = (uint8_t)(127.5 + 127.0 * cos(400.0 * (u * u + v * v)));
+            uint8_t *p = buf + (y * width + x) * 4;
+
+            p[0] = c;
+            p[1] = 255 - c;
+            p[2] = (uint8_t)(255.0 * (u + 0.5));
+            p[3] = 0xff;
+        }
+    }
+}
+
+static double psnr(const uint8_t *a, const uint8_t *b, int pixels)
+{
+    double sum = 0.0;
+
+    for (int i = 0; i < pixels * 4; i++) {
+        if ((i & 3) == 3)
+            continue;
+        sum += (double)(a[i] - b[i]) * (a[i] - b[i]);
+    }
+
+    sum /= pixels * 3.0;
+    return sum > 0.0 ? 10.0 * log10(255.0 * 255.0 / sum) : 99.0;
+}
+
+/*
+ * Scale the zone plate down and up with each filter and compare against
+ * the plate rendered at the destination size.
+ */
+static int benchQuality(RockchipRga &rkRga)
+{
+    static const struct {
+        const char  *name;
+        int         mode;
+    } modes[] = {
+        {"nearest",  DRM_RGA_SCALE_NEAREST},
+        {"bilinear", DRM_RGA_SCALE_BILINEAR},
+        {"bicubic",  DRM_RGA_SCALE_BICUBIC},
+        {"area",     DRM_RGA_SCALE_AREA},
+    };
+    static const BenchCase cases[] = {
+        {"down 1080p->540p", 1920, 1080, HAL_PIXEL_FORMAT_RGBA_8888,
+                              960,  540, HAL_PIXEL_FORMAT_RGBA_8888, 0},
+        {"up 540p->1080p",    960,  540, HAL_PIXEL_FORMAT_RGBA_8888,
+                             1920, 1080, HAL_PIXEL_FORMAT_RGBA_8888, 0},
+    };
+    static const int engines[] = {DRM_RGA_ENGINE_HW, DRM_RGA_ENGINE_CPU};
+    rga_device_info_t info;
+    bool hw = rkRga.RkRgaGetDeviceInfo(0, &info) == 0 && !info.emulated;
+
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        if (engines[e] == DRM_RGA_ENGINE_HW && !hw)
+            continue;
+        rkRga.RkRgaSetEngine(engines[e]);
+
+        for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+            const BenchCase *c = &cases[i];
+            uint8_t *src = (uint8_t *)malloc(c->srcWidth * c->srcHeight * 4);
+            uint8_t *dst = (uint8_t *)malloc(c->dstWidth * c->dstHeight * 4);
+            uint8_t *ref = (uint8_t *)malloc(c->dstWidth * c->dstHeight * 4);
+
+            if (!src || !dst || !ref) {
+                free(src);
+                free(dst);
+                free(ref);
+                return -ENOMEM;
+            }
+            fillZonePlate(src, c->srcWidth, c->srcHeight);
+            fillZonePlate(ref, c->dstWidth, c->dstHeight);
+
+            printf("%s %s:\n", engines[e] == DRM_RGA_ENGINE_HW ? "rga" : "cpu",
+                                                                    c->name);
+            for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+                int64_t us;
+
+                rkRga.RkRgaSetScaleMode(modes[m].mode);
+                memset(dst, 0, c->dstWidth * c->dstHeight * 4);
+                us = benchBlit(rkRga, c, src, dst);
+                printf("  %-8s %7lld us  psnr %5.2f dB\n", modes[m].name,
+                            (long long)us,
+                            psnr(dst, ref, c->dstWidth * c->dstHeight));
+            }
+
+            free(src);
+            free(dst);
+            free(ref);
+        }
+    }
+
+    rkRga.RkRgaSetScaleMode(DRM_RGA_SCALE_AUTO);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+    return 0;
+}
+
+/* average time of one RkRgaFill call in us */
+static int64_t benchFill(RockchipRga &rkRga, void *dst, rga_rect_t *rect,
+                                            const rga_fill_t *fills, int count)
+{
+    nsecs_t start;
+
+    rkRga.RkRgaFill(dst, rect, fills, count);
+
+    start = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (int i = 0; i < BENCH_LOOPS; i++)
+        rkRga.RkRgaFill(dst, rect, fills, count);
+
+    return (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000 / BENCH_LOOPS;
+}
+
+/*
+ * Clears and gradients of a whole 1080p and 4k frame, and a batch of 256
+ * small rects, on the rga and on the cpu.
+ */
+static int benchFills(RockchipRga &rkRga)
+{
+    static const struct {
+        const char  *name;
+        int         width;
+        int         height;
+        int         format;
+    } frames[] = {
+        {"1080p rgba", 1920, 1080, HAL_PIXEL_FORMAT_RGBA_8888},
+        {"1080p nv12", 1920, 1080, HAL_PIXEL_FORMAT_YCrCb_NV12},
+        {"4k rgba",    3840, 2160, HAL_PIXEL_FORMAT_RGBA_8888},
+        {"4k nv12",    3840, 2160, HAL_PIXEL_FORMAT_YCrCb_NV12},
+    };
+    static const int engines[] = {DRM_RGA_ENGINE_HW, DRM_RGA_ENGINE_CPU};
+    rga_device_info_t info;
+    bool hw = rkRga.RkRgaGetDeviceInfo(0, &info) == 0 && !info.emulated;
+    rga_fill_t batch[256];
+
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        if (engines[e] == DRM_RGA_ENGINE_HW && !hw)
+            continue;
+        rkRga.RkRgaSetEngine(engines[e]);
+
+        for (size_t i = 0; i < sizeof(frames) / sizeof(frames[0]); i++) {
+            int size = frameSize(frames[i].width, frames[i].height, frames[i].format);
+            void *dst = malloc(size);
+            rga_rect_t rect;
+            rga_fill_t fill;
+            int64_t us;
+
+            if (!dst)
+                return -ENOMEM;
+
+            rga_set_rect(&rect, 0, 0, frames[i].width, frames[i].height,
+                                        frames[i].width, frames[i].format);
+            memset(&fill, 0, sizeof(rga_fill_t));
+            fill.width = frames[i].width;
+            fill.height = frames[i].height;
+            fill.color = 0xff204080;
+
+            printf("%s %s:\n", engines[e] == DRM_RGA_ENGINE_HW ? "rga" : "cpu",
+                                                            frames[i].name);
+
+            us = benchFill(rkRga, dst, &rect, &fill, 1);
+            printf("  clear     %7lld us  %6.2f GB/s\n", (long long)us,
+                                        us ? (double)size / us / 1000.0 : 0.0);
+
+            fill.gradX[0] = (256 << 8) / frames[i].width;
+            fill.gradY[1] = (256 << 8) / frames[i].height;
+            us = benchFill(rkRga, dst, &rect, &fill, 1);
+            printf("  gradient  %7lld us  %6.2f GB/s\n", (long long)us,
+                                        us ? (double)size / us / 1000.0 : 0.0);
+
+            memset(batch, 0, sizeof(batch));
+            for (int k = 0; k < 256; k++) {
+                batch[k].x = (k % 16) * frames[i].width / 16;
+                batch[k].y = (k / 16) * frames[i].height / 16;
+                batch[k].width = 64;
+                batch[k].height = 64;
+                batch[k].color = 0xff000000 | (k * 0x010203);
+            }
+            us = benchFill(rkRga, dst, &rect, batch, 256);
+            printf("  256x64x64 %7lld us  %6.2f us/rect\n", (long long)us,
+                                                                us / 256.0);
+
+            free(dst);
+        }
+    }
+
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+    return 0;
+}
+
+/* 200 box outlines on a 1080p frame, the analytics overlay case */
+static int benchLines(RockchipRga &rkRga)
+{
+    static const int engines[] = {DRM_RGA_ENGINE_HW, DRM_RGA_ENGINE_CPU};
+    rga_device_info_t info;
+    bool hw = rkRga.RkRgaGetDeviceInfo(0, &info) == 0 && !info.emulated;
+    rga_line_t lines[800];
+    rga_rect_t rect;
+    void *dst;
+    int count = 0;
+
+    dst = malloc(1920 * 1080 * 4);
+    if (!dst)
+        return -ENOMEM;
+
+    rga_set_rect(&rect, 0, 0, 1920, 1080, 1920, HAL_PIXEL_FORMAT_RGBA_8888);
+    for (int i = 0; i < 200; i++)
+        count += rga_set_outline(lines + count, (i * 97) % 1700, (i * 53) % 900,
+                                    80 + i % 120, 60 + i % 90, 0xff00ff00, 2);
+
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        nsecs_t start;
+
+        if (engines[e] == DRM_RGA_ENGINE_HW && !hw)
+            continue;
+        rkRga.RkRgaSetEngine(engines[e]);
+
+        rkRga.RkRgaDrawLines(dst, &rect, lines, count);
+        start = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (int i = 0; i < BENCH_LOOPS; i++)
+            rkRga.RkRgaDrawLines(dst, &rect, lines, count);
+
+        printf("%s 200 boxes: %7lld us\n",
+                    engines[e] == DRM_RGA_ENGINE_HW ? "rga" : "cpu",
+                    (long long)(systemTime(SYSTEM_TIME_MONOTONIC) - start) /
+                                                        1000 / BENCH_LOOPS);
+    }
+
+    free(dst);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+    return 0;
+}
+
+/* latency of the filter over a full frame and a small region of it */
+static int benchFilter(RockchipRga &rkRga)
+{
+    static const int engines[] = {DRM_RGA_ENGINE_HW, DRM_RGA_ENGINE_CPU};
+    static const struct {
+        const char *name;
+        int mode;
+        int intensity;
+    } filters[] = {
+        {"blur 0",    DRM_RGA_FILTER_BLUR,    0},
+        {"blur 3",    DRM_RGA_FILTER_BLUR,    3},
+        {"sharpen 1", DRM_RGA_FILTER_SHARPEN, 1},
+    };
+    rga_device_info_t info;
+    bool hw = rkRga.RkRgaGetDeviceInfo(0, &info) == 0 && !info.emulated;
+    void *src, *dst;
+    drm_rga_t rects;
+
+    src = malloc(1920 * 1080 * 4);
+    dst = malloc(1920 * 1080 * 4);
+    if (!src || !dst) {
+        free(src);
+        free(dst);
+        return -ENOMEM;
+    }
+    fillZonePlate((uint8_t *)src, 1920, 1080);
+
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        if (engines[e] == DRM_RGA_ENGINE_HW && !hw)
+            continue;
+        rkRga.RkRgaSetEngine(engines[e]);
+
+        for (size_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++) {
+            for (int region = 0; region < 3; region++) {
+                int dstFormat = region == 2 ? HAL_PIXEL_FORMAT_RGB_565 :
+                                                HAL_PIXEL_FORMAT_RGBA_8888;
+                int w = region == 1 ? 256 : 1920;
+                int h = region == 1 ? 256 : 1080;
+                int x = region == 1 ? 832 : 0;
+                int y = region == 1 ? 412 : 0;
+                nsecs_t start;
+
+                rga_set_rect(&rects.src, x, y, w, h, 1920,
+                                                HAL_PIXEL_FORMAT_RGBA_8888);
+                rga_set_rect(&rects.dst, x, y, w, h, 1920, dstFormat);
+
+                rkRga.RkRgaFilter(src, dst, &rects, filters[f].mode,
+                                            filters[f].intensity, region == 2);
+                start = systemTime(SYSTEM_TIME_MONOTONIC);
+                for (int i = 0; i < BENCH_LOOPS; i++)
+                    rkRga.RkRgaFilter(src, dst, &rects, filters[f].mode,
+                                            filters[f].intensity, region == 2);
+
+                printf("%s %-9s %-14s: %7lld us\n",
+                        engines[e] == DRM_RGA_ENGINE_HW ? "rga" : "cpu",
+                        filters[f].name, region == 0 ? "1080p" :
+                        region == 1 ? "256x256 region" : "1080p rgb565",
+                        (long long)(systemTime(SYSTEM_TIME_MONOTONIC) - start) /
+                                                        1000 / BENCH_LOOPS);
+            }
+        }
+    }
+
+    free(src);
+    free(dst);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+    return 0;
+}
+
+/*
+ * rgba to rgb565 over a shallow gradient. The column error is the distance of
+ * the mean of a column from the source, it stays high where truncation bands.
+ */
+static int benchDither(RockchipRga &rkRga)
+{
+    static const struct {
+        const char *name;
+        int mode;
+    } modes[] = {
+        {"off",       DRM_RGA_DITHER_OFF},
+        {"ordered",   DRM_RGA_DITHER_AUTO},
+        {"diffusion", DRM_RGA_DITHER_DIFFUSION},
+    };
+    uint8_t *src;
+    uint16_t *dst;
+    drm_rga_t rects;
+
+    src = (uint8_t *)malloc(1920 * 1080 * 4);
+    dst = (uint16_t *)malloc(1920 * 1080 * 2);
+    if (!src || !dst) {
+        free(src);
+        free(dst);
+        return -ENOMEM;
+    }
+
+    for (int y = 0; y < 1080; y++) {
+        for (int x = 0; x < 1920; x++) {
+            uint8_t *p = src + (y * 1920 + x) * 4;
+
+            p[0] = 64 + x * 32 / 1920;
+            p[1] = 96 + x * 16 / 1920;
+            p[2] = 160 - x * 24 / 1920;
+            p[3] = 0xff;
+        }
+    }
+
+    rga_set_rect(&rects.src, 0, 0, 1920, 1080, 1920, HAL_PIXEL_FORMAT_RGBA_8888);
+    rga_set_rect(&rects.dst, 0, 0, 1920, 1080, 1920, HAL_PIXEL_FORMAT_RGB_565);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_CPU);
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        double error = 0;
+        nsecs_t start;
+
+        rkRga.RkRgaSetDitherMode(modes[m].mode);
+        rkRga.RkRgaBlit(src, dst, &rects, 0, 0);
+        start = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (int i = 0; i < BENCH_LOOPS; i++)
+            rkRga.RkRgaBlit(src, dst, &rects, 0, 0);
+
+        for (int x = 0; x < 1920; x++) {
+            int sum = 0, want = 0;
+
+            for (int y = 0; y < 1080; y++) {
+                sum += (dst[y * 1920 + x] >> 11) << 3;
+                want += src[(y * 1920 + x) * 4];
+            }
+            error += fabs((double)(sum - want)) / 1080;
+        }
+
+        printf("cpu dither %-9s: %7lld us, column error %.2f\n", modes[m].name,
+                (long long)(systemTime(SYSTEM_TIME_MONOTONIC) - start) /
+                                                    1000 / BENCH_LOOPS,
+                error / 1920);
+    }
+
+    free(src);
+    free(dst);
+    rkRga.RkRgaSetDitherMode(DRM_RGA_DITHER_AUTO);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+    return 0;
+}
+
+/* 4k 10 bit frames to rgba8888 on the cpu, and the unpack alone */
+static int benchHdr(RockchipRga &rkRga)
+{
+    static const struct {
+        const char *name;
+        int format;
+    } formats[] = {
+        {"rk 10 bit", HAL_PIXEL_FORMAT_YCrCb_NV12_10},
+        {"p010",      DRM_RGA_FORMAT_YCbCr_P010},
+    };
+    static const char *modes[] = {"truncate", "round", "tonemap"};
+    const int w = 3840, h = 2160;
+    uint8_t *src;
+    uint16_t *samples;
+    void *dst;
+    drm_rga_t rects;
+    nsecs_t start;
+
+    src = (uint8_t *)malloc(w * h * 3);
+    samples = (uint16_t *)malloc(w * h * 3);
+    dst = malloc(w * h * 4);
+    if (!src || !samples || !dst) {
+        free(src);
+        free(samples);
+        free(dst);
+        return -ENOMEM;
+    }
+    for (int i = 0; i < w * h * 3; i++)
+        src[i] = rand();
+
+    rga_set_rect(&rects.dst, 0, 0, w, h, w, HAL_PIXEL_FORMAT_RGBA_8888);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_CPU);
+
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        rga_set_rect(&rects.src, 0, 0, w, h, w, formats[f].format);
+
+        start = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (int i = 0; i < BENCH_LOOPS; i++)
+            rkRga.RkRgaUnpack10Bit(src, &rects.src, samples);
+        printf("cpu %-9s unpack          : %7lld us\n", formats[f].name,
+                (long long)(systemTime(SYSTEM_TIME_MONOTONIC) - start) /
+                                                    1000 / BENCH_LOOPS);
+
+        for (int m = DRM_RGA_DEPTH_TRUNCATE; m <= DRM_RGA_DEPTH_TONEMAP; m++) {
+            rkRga.RkRgaSetDepthMode(m);
+            rkRga.RkRgaBlit(src, dst, &rects, 0, 0);
+            start = systemTime(SYSTEM_TIME_MONOTONIC);
+            for (int i = 0; i < BENCH_LOOPS; i++)
+                rkRga.RkRgaBlit(src, dst, &rects, 0, 0);
+            printf("cpu %-9s to rgba %-8s: %7lld us\n", formats[f].name,
+                    modes[m], (long long)(systemTime(SYSTEM_TIME_MONOTONIC) -
+                                                start) / 1000 / BENCH_LOOPS);
+        }
+    }
+
+    free(src);
+    free(samples);
+    free(dst);
+    rkRga.RkRgaSetDepthMode(DRM_RGA_DEPTH_TRUNCATE);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+    return 0;
+}
+
+/* 1/2, 1/4 and 1/8 copies of a 4k frame, decimated and as bicubic blits */
+static int benchDecimate(RockchipRga &rkRga)
+{
+    static const int engines[] = {DRM_RGA_ENGINE_HW, DRM_RGA_ENGINE_CPU};
+    static const struct {
+        const char *name;
+        int format;
+    } formats[] = {
+        {"nv12", HAL_PIXEL_FORMAT_YCrCb_NV12},
+        {"rgba", HAL_PIXEL_FORMAT_RGBA_8888},
+    };
+    rga_device_info_t info;
+    bool hw = rkRga.RkRgaGetDeviceInfo(0, &info) == 0 && !info.emulated;
+    const int w = 3840, h = 2160;
+    void *src, *dst;
+    drm_rga_t rects;
+
+    src = malloc(w * h * 4);
+    dst = malloc(w * h);
+    if (!src || !dst) {
+        free(src);
+        free(dst);
+        return -ENOMEM;
+    }
+    fillZonePlate((uint8_t *)src, w, h);
+
+    rkRga.RkRgaSetScaleMode(DRM_RGA_SCALE_BICUBIC);
+
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        if (engines[e] == DRM_RGA_ENGINE_HW && !hw)
+            continue;
+        rkRga.RkRgaSetEngine(engines[e]);
+
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+            for (int factor = 2; factor <= 8; factor *= 2) {
+                nsecs_t start, decimate;
+
+                rga_set_rect(&rects.src, 0, 0, w, h, w, formats[f].format);
+                rga_set_rect(&rects.dst, 0, 0, w / factor, h / factor,
+                                                w / factor, formats[f].format);
+
+                rkRga.RkRgaDecimate(src, dst, &rects, factor);
+                start = systemTime(SYSTEM_TIME_MONOTONIC);
+                for (int i = 0; i < BENCH_LOOPS; i++)
+                    rkRga.RkRgaDecimate(src, dst, &rects, factor);
+                decimate = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+
+                printf("%s %s 1/%d: decimate %7lld us, ",
+                        engines[e] == DRM_RGA_ENGINE_HW ? "rga" : "cpu",
+                        formats[f].name, factor,
+                        (long long)decimate / 1000 / BENCH_LOOPS);
+
+                /* past 1/2 the blit filter falls back to nearest */
+                rkRga.RkRgaBlit(src, dst, &rects, 0, 0);
+                start = systemTime(SYSTEM_TIME_MONOTONIC);
+                for (int i = 0; i < BENCH_LOOPS; i++)
+                    rkRga.RkRgaBlit(src, dst, &rects, 0, 0);
+                printf("blit %7lld us\n",
+                        (long long)(systemTime(SYSTEM_TIME_MONOTONIC) - start) /
+                                                        1000 / BENCH_LOOPS);
+            }
+        }
+    }
+
+    free(src);
+    free(dst);
+    rkRga.RkRgaSetScaleMode(DRM_RGA_SCALE_AUTO);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+    return 0;
+}
+
+/* the dedicated call for a scaling case */
+static int pathBlit(RockchipRga &rkRga, const BenchCase *c,
+                                    void *src, void *dst, drm_rga_t *rects)
+{
+    if (c->rotation)
+        return rkRga.RkRgaRoate(src, dst, rects, c->rotation);
+    if (c->srcWidth != c->dstWidth || c->srcHeight != c->dstHeight)
+        return rkRga.RkRgaScale(src, dst, rects);
+    if (c->srcFormat != c->dstFormat)
+        return rkRga.RkRgaConvert(src, dst, rects);
+    return rkRga.RkRgaCopy(src, dst, rects);
+}
+
+/*
+ * The scaling cases through RkRgaBlit and through their dedicated call, at
+ * full size and at 1/10 where the per call setup shows.
+ */
+static int benchPaths(RockchipRga &rkRga)
+{
+    static const int divs[] = {1, 10};
+    const int count = sizeof(scalingCases) / sizeof(scalingCases[0]);
+    void *src, *dst;
+
+    src = malloc(1920 * 1080 * 4);
+    dst = malloc(1920 * 1080 * 4);
+    if (!src || !dst) {
+        free(src);
+        free(dst);
+        return -ENOMEM;
+    }
+    memset(src, 0x80, 1920 * 1080 * 4);
+
+    for (size_t d = 0; d < sizeof(divs) / sizeof(divs[0]); d++) {
+        for (int i = 0; i < count; i++) {
+            BenchCase c = scalingCases[i];
+            drm_rga_t rects;
+            int64_t blit, path;
+            nsecs_t start;
+            int ret;
+
+            c.srcWidth /= divs[d];
+            c.srcHeight /= divs[d];
+            c.dstWidth /= divs[d];
+            c.dstHeight /= divs[d];
+
+            memset(&rects, 0, sizeof(drm_rga_t));
+            rga_set_rect(&rects.src, 0, 0, c.srcWidth, c.srcHeight,
+                                                c.srcWidth, c.srcFormat);
+            rga_set_rect(&rects.dst, 0, 0, c.dstWidth, c.dstHeight,
+                                                c.dstWidth, c.dstFormat);
+
+            blit = benchBlit(rkRga, &c, src, dst);
+
+            ret = pathBlit(rkRga, &c, src, dst, &rects);
+            start = systemTime(SYSTEM_TIME_MONOTONIC);
+            for (int k = 0; k < BENCH_LOOPS; k++)
+                pathBlit(rkRga, &c, src, dst, &rects);
+            path = (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000 / BENCH_LOOPS;
+
+            printf("%-20s 1/%-2d: blit %7lld us, dedicated %7lld us%s\n",
+                    c.name, divs[d], (long long)blit, (long long)path,
+                    ret ? " (failed)" : "");
+        }
+    }
+
+    free(src);
+    free(dst);
+    return 0;
+}
+
+/*
+ * Calibrate, then copy squares of growing size on the rga, on the cpu and
+ * wherever DRM_RGA_ENGINE_AUTO sends them. Auto should track the faster
+ * of the two columns, or beat both once hybrid pays off.
+ */
+static int benchDispatch(RockchipRga &rkRga)
+{
+    static const int engines[] = {DRM_RGA_ENGINE_HW, DRM_RGA_ENGINE_CPU,
+                                                        DRM_RGA_ENGINE_AUTO};
+    static const int sizes[] = {16, 32, 64, 128, 256, 512, 1024, 2048};
+    rga_dispatch_stats_t before, after;
+    void *src, *dst;
+    int ret;
+
+    ret = rkRga.RkRgaCalibrate(NULL, 0);
+    if (ret) {
+        printf("calibrate fail: %s\n", strerror(-ret));
+        return ret;
+    }
+
+    src = malloc(2048 * 2048 * 4);
+    dst = malloc(2048 * 2048 * 4);
+    if (!src || !dst) {
+        free(src);
+        free(dst);
+        return -ENOMEM;
+    }
+    memset(src, 0x80, 2048 * 2048 * 4);
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        BenchCase c = {"", sizes[i], sizes[i], HAL_PIXEL_FORMAT_RGBA_8888,
+                        sizes[i], sizes[i], HAL_PIXEL_FORMAT_RGBA_8888, 0};
+        int64_t times[3];
+
+        for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+            rkRga.RkRgaSetEngine(engines[e]);
+            if (engines[e] == DRM_RGA_ENGINE_AUTO)
+                rkRga.RkRgaGetDispatchStats(&before);
+            times[e] = benchBlit(rkRga, &c, src, dst);
+        }
+        rkRga.RkRgaGetDispatchStats(&after);
+
+        printf("%4dx%-4d: rga %7lld us, cpu %7lld us, auto %7lld us -> %s\n",
+                sizes[i], sizes[i], (long long)times[0], (long long)times[1],
+                (long long)times[2],
+                after.hybridJobs > before.hybridJobs ? "hybrid" :
+                after.cpuJobs > before.cpuJobs ? "cpu" : "rga");
+    }
+
+    printf("predicted %llu us, measured %llu us over calibrated jobs\n",
+                (unsigned long long)after.predictedUs,
+                (unsigned long long)after.actualUs);
+
+    free(src);
+    free(dst);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+    return 0;
+}
+
+/* stands in for a hardware encoder, busy for a 4k60 frame slot */
+static int encodeStage(void * /* arg */, void *in, void *out,
+                                                    int64_t * /* timestamp */)
+{
+    memcpy(out, in, 4096);
+    usleep(16000);
+    return 0;
+}
+
+static void* drainPipeline(void *arg)
+{
+    RockchipRgaPipeline *pipeline = (RockchipRgaPipeline *)arg;
+    RockchipRgaPipeline::Frame frame;
+
+    while (pipeline->acquireOutput(&frame, -1) == 0)
+        pipeline->releaseOutput(&frame);
+
+    return NULL;
+}
+
+/*
+ * 4k nv12 frames through a 1080p rgba conversion and a fake encoder, the
+ * producer as fast as the rings let it. Throughput should settle at the
+ * slowest stage with that stage's input ring full and the footprint fixed.
+ */
+static int benchPipeline(RockchipRga & /* rkRga */)
+{
+    const int frames = 120;
+    const size_t in = 3840 * 2160 * 3 / 2, mid = 1920 * 1080 * 4;
+    sp<RockchipRgaPipeline> pipeline = new RockchipRgaPipeline(in, 3);
+    RockchipRgaPipeline::Frame frame;
+    drm_rga_t rects;
+    pthread_t drain;
+    nsecs_t start, elapsed;
+    int ret;
+
+    rga_set_rect(&rects.src, 0, 0, 3840, 2160, 3840, HAL_PIXEL_FORMAT_YCrCb_NV12);
+    rga_set_rect(&rects.dst, 0, 0, 1920, 1080, 1920, HAL_PIXEL_FORMAT_RGBA_8888);
+    pipeline->addBlitStage("convert", &rects, 0, mid, 3);
+    pipeline->addStage("encode", encodeStage, NULL, 4096, 2);
+
+    ret = pipeline->start();
+    if (ret) {
+        printf("pipeline start fail: %s\n", strerror(-ret));
+        return ret;
+    }
+    pthread_create(&drain, NULL, drainPipeline, pipeline.get());
+
+    start = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (int i = 0; i < frames; i++) {
+        if (pipeline->dequeueInput(&frame, -1))
+            break;
+        memset(frame.data, i, 4096);
+        frame.timestamp = (int64_t)i * 1000000 / 60;
+        pipeline->queueInput(&frame);
+    }
+
+    /* until the last frame left the encoder */
+    for (;;) {
+        rga_pipeline_stats_t stats;
+
+        pipeline->getStats(pipeline->stages() - 1, &stats);
+        if (stats.frames + stats.errors >= (unsigned int)frames)
+            break;
+        usleep(1000);
+    }
+    elapsed = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+
+    printf("%d frames in %lld ms, %.1f fps, %zu KiB of rings\n", frames,
+                (long long)ns2ms(elapsed), frames * 1e9 / elapsed,
+                pipeline->footprint() / 1024);
+    for (int i = 0; i < pipeline->stages(); i++) {
+        rga_pipeline_stats_t stats;
+
+        pipeline->getStats(i, &stats);
+        printf("stage %d: latency avg %6llu max %6u us, busy %3llu%%, "
+                "stall %3llu%%, queued max %u/%u\n", i,
+                (unsigned long long)(stats.frames ?
+                                    stats.totalLatencyUs / stats.frames : 0),
+                stats.maxLatencyUs,
+                (unsigned long long)(stats.busyUs * 100000 / elapsed),
+                (unsigned long long)(stats.stallUs * 100000 / elapsed),
+                stats.maxQueued, stats.depth);
+    }
+
+    pipeline->stop();
+    pthread_join(drain, NULL);
+    return 0;
+}
+
+/*
+ * Convert an nv12 clip to rgba file to file, the input mapped and the
+ * output written behind the blits. Without an input a 1080p clip of moving
+ * bars is written first, which times the writer alone.
+ */
+static int benchClip(RockchipRga &rkRga, const char *in, int width,
+                                                int height, const char *out)
+{
+    const char *synth = "/data/local/tmp/rga_clip.nv12";
+    RockchipRgaRawReader reader;
+    RockchipRgaRawWriter writer;
+    drm_rga_t rects;
+    nsecs_t start, elapsed;
+    void *buffer;
+    int ret;
+
+    rga_set_rect(&rects.src, 0, 0, width, height, width, HAL_PIXEL_FORMAT_YCrCb_NV12);
+    rga_set_rect(&rects.dst, 0, 0, width, height, width, HAL_PIXEL_FORMAT_RGBA_8888);
+
+    if (!in) {
+        size_t size = RockchipRgaRawVideo::frameSize(&rects.src);
+
+        ret = writer.open(synth, &rects.src, 3);
+        if (ret) {
+            printf("open %s fail: %s\n", synth, strerror(-ret));
+            return ret;
+        }
+
+        start = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (int i = 0; i < 120 && !writer.dequeue(&buffer, -1); i++) {
+            for (int y = 0; y < height; y++)
+                memset((uint8_t *)buffer + y * width, (y + i * 8) & 0xff, width);
+            memset((uint8_t *)buffer + width * height, 0x80, size - width * height);
+            writer.queue(buffer);
+        }
+        ret = writer.close();
+        elapsed = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+        printf("wrote 120 frames in %lld ms, %.0f MB/s%s\n",
+                (long long)ns2ms(elapsed), 120.0 * size * 1e3 / elapsed,
+                ret ? " (failed)" : "");
+        in = synth;
+    }
+
+    ret = reader.open(in, &rects.src);
+    if (ret) {
+        printf("open %s fail: %s\n", in, strerror(-ret));
+        return ret;
+    }
+    printf("%s: %d frames, udmabuf %s\n", in, reader.frames(),
+                    reader.importDmabuf() ? "no" : "yes");
+
+    ret = writer.open(out, &rects.dst, 3);
+    if (ret) {
+        printf("open %s fail: %s\n", out, strerror(-ret));
+        return ret;
+    }
+
+    start = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (int i = 0; i < reader.frames(); i++) {
+        ret = writer.dequeue(&buffer, -1);
+        if (ret)
+            break;
+        ret = rkRga.RkRgaBlit(reader.frame(i), buffer, &rects, 0, 0);
+        writer.queue(buffer);
+        if (ret)
+            break;
+    }
+    if (writer.close() && !ret)
+        ret = -EIO;
+    elapsed = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+
+    printf("converted %d frames in %lld ms, %.1f fps, %.0f MB/s in+out%s\n",
+            reader.frames(), (long long)ns2ms(elapsed),
+            reader.frames() * 1e9 / elapsed,
+            reader.frames() * (double)(reader.frameSize() +
+                    RockchipRgaRawVideo::frameSize(&rects.dst)) * 1e3 / elapsed,
+            ret ? " (failed)" : "");
+
+    return ret;
+}
+
+/* one chained step: its dedicated call and the bytes it reads and writes */
+struct FusedStep {
+    const char  *name;
+    drm_rga_t   rects;
+    void        *src;
+    void        *dst;
+    size_t      bytes;
+};
+
+static int fusedStep(RockchipRga &rkRga, FusedStep *step, int index)
+{
+    switch (index) {
+        case 0:
+            return rkRga.RkRgaCopy(step->src, step->dst, &step->rects);
+        case 1:
+            return rkRga.RkRgaScale(step->src, step->dst, &step->rects);
+        case 2:
+            return rkRga.RkRgaConvert(step->src, step->dst, &step->rects);
+        default:
+            return rkRga.RkRgaRoate(step->src, step->dst, &step->rects,
+                                                    HAL_TRANSFORM_ROT_90);
+    }
+}
+
+/*
+ * A 1080p crop of a 1920x1088 nv12 frame to a 720x1280 rgba portrait
+ * preview on the software renderer: one RkRgaBlit, which runs the fused
+ * kernel, against crop, scale, convert and rotate as four dedicated calls
+ * through frame sized temporaries. Traffic counts each byte a pass reads
+ * or writes once, caches aside.
+ */
+static int benchFused(RockchipRga &rkRga)
+{
+    const int srcW = 1920, srcH = 1088, cropW = 1920, cropH = 1080;
+    const int outW = 1280, outH = 720;
+    const size_t frame = srcW * srcH * 3 / 2, crop = cropW * cropH * 3 / 2;
+    const size_t scaled = outW * outH * 3 / 2, rgba = outW * outH * 4;
+    size_t fusedBytes = crop + rgba, chainBytes = 0;
+    int64_t fusedUs, chainUs = 0;
+    FusedStep steps[4];
+    drm_rga_t rects;
+    nsecs_t start;
+    uint8_t *buf;
+    int ret;
+
+    /* src, crop, scaled, converted, dst back to back */
+    buf = (uint8_t *)malloc(frame + crop + scaled + rgba * 2);
+    if (!buf)
+        return -ENOMEM;
+    for (size_t i = 0; i < frame; i++)
+        buf[i] = (uint8_t)(i * 7 + i / srcW);
+
+    memset(steps, 0, sizeof(steps));
+    steps[0].name = "crop";
+    rga_set_rect(&steps[0].rects.src, 0, 4, cropW, cropH, srcW,
+                                            HAL_PIXEL_FORMAT_YCrCb_NV12);
+    rga_set_rect(&steps[0].rects.dst, 0, 0, cropW, cropH, cropW,
+                                            HAL_PIXEL_FORMAT_YCrCb_NV12);
+    steps[0].src = buf;
+    steps[0].dst = buf + frame;
+    steps[0].bytes = crop * 2;
+
+    steps[1].name = "scale";
+    steps[1].rects.src = steps[0].rects.dst;
+    rga_set_rect(&steps[1].rects.dst, 0, 0, outW, outH, outW,
+                                            HAL_PIXEL_FORMAT_YCrCb_NV12);
+    steps[1].src = steps[0].dst;
+    steps[1].dst = (uint8_t *)steps[1].src + crop;
+    steps[1].bytes = crop + scaled;
+
+    steps[2].name = "convert";
+    steps[2].rects.src = steps[1].rects.dst;
+    rga_set_rect(&steps[2].rects.dst, 0, 0, outW, outH, outW,
+                                            HAL_PIXEL_FORMAT_RGBA_8888);
+    steps[2].src = steps[1].dst;
+    steps[2].dst = (uint8_t *)steps[2].src + scaled;
+    steps[2].bytes = scaled + rgba;
+
+    steps[3].name = "rotate 90";
+    steps[3].rects.src = steps[2].rects.dst;
+    rga_set_rect(&steps[3].rects.dst, 0, 0, outH, outW, outH,
+                                            HAL_PIXEL_FORMAT_RGBA_8888);
+    steps[3].src = steps[2].dst;
+    steps[3].dst = (uint8_t *)steps[3].src + rgba;
+    steps[3].bytes = rgba * 2;
+
+    memset(&rects, 0, sizeof(drm_rga_t));
+    rects.src = steps[0].rects.src;
+    rects.dst = steps[3].rects.dst;
+
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_CPU);
+    rkRga.RkRgaSetScaleMode(DRM_RGA_SCALE_BILINEAR);
+
+    /* warm up page tables, caches and the scale tables */
+    ret = rkRga.RkRgaBlit(buf, steps[3].dst, &rects, HAL_TRANSFORM_ROT_90, 0);
+    for (int k = 0; k < 4 && !ret; k++)
+        ret = fusedStep(rkRga, &steps[k], k);
+
+    if (ret) {
+        printf("fused blit fail: %d\n", ret);
+    } else {
+        start = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (int i = 0; i < BENCH_LOOPS; i++)
+            rkRga.RkRgaBlit(buf, steps[3].dst, &rects, HAL_TRANSFORM_ROT_90, 0);
+        fusedUs = (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000 / BENCH_LOOPS;
+
+        for (int k = 0; k < 4; k++) {
+            int64_t us;
+
+            start = systemTime(SYSTEM_TIME_MONOTONIC);
+            for (int i = 0; i < BENCH_LOOPS; i++)
+                fusedStep(rkRga, &steps[k], k);
+            us = (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1000 / BENCH_LOOPS;
+
+            printf("  %-10s %7lld us  %6.1f MB\n", steps[k].name, (long long)us,
+                                                steps[k].bytes / 1048576.0);
+            chainUs += us;
+            chainBytes += steps[k].bytes;
+        }
+
+        printf("chained    %7lld us  %6.1f MB  %5.2f GB/s\n", (long long)chainUs,
+                    chainBytes / 1048576.0,
+                    chainUs ? chainBytes / 1000.0 / chainUs : 0.0);
+        printf("fused      %7lld us  %6.1f MB  %5.2f GB/s\n", (long long)fusedUs,
+                    fusedBytes / 1048576.0,
+                    fusedUs ? fusedBytes / 1000.0 / fusedUs : 0.0);
+        printf("traffic %.1fx less, %.2fx faster\n",
+                    (double)chainBytes / fusedBytes,
+                    fusedUs ? (double)chainUs / fusedUs : 0.0);
+    }
+
+    free(buf);
+    rkRga.RkRgaSetScaleMode(DRM_RGA_SCALE_AUTO);
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+    return ret;
+}
+
+/*
+ * Cost of a process that blits once: getting the instance, the first blit
+ * that opens the cores, a blit once they are open. Run it first in a fresh
+ * process, with and without persist.rga.caps_cache.
+ */
+static int benchStartup()
+{
+    static uint32_t src[64 * 64], dst[64 * 64];
+    nsecs_t start, got, first, second;
+    drm_rga_t rects;
+
+    rga_set_rect(&rects.src, 0, 0, 64, 64, 64, HAL_PIXEL_FORMAT_RGBA_8888);
+    rga_set_rect(&rects.dst, 0, 0, 64, 64, 64, HAL_PIXEL_FORMAT_RGBA_8888);
+
+    start = systemTime(SYSTEM_TIME_MONOTONIC);
+    RockchipRga& rkRga(RockchipRga::get());
+    got = systemTime(SYSTEM_TIME_MONOTONIC);
+    rkRga.RkRgaBlit(src, dst, &rects, 0, 0);
+    first = systemTime(SYSTEM_TIME_MONOTONIC);
+    rkRga.RkRgaBlit(src, dst, &rects, 0, 0);
+    second = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    printf("instance    : %7lld us\n", (long long)(got - start) / 1000);
+    printf("first blit  : %7lld us\n", (long long)(first - got) / 1000);
+    printf("second blit : %7lld us\n", (long long)(second - first) / 1000);
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [scaling [big|little] | quality | fill | lines | filter |\n"
+                    "           dither | hdr | decimate | paths | dispatch | pipeline |\n"
+                    "           clip [in.nv12 width height] [out.rgba] | fused | startup]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *bench = argc > 1 ? argv[1] : "scaling";
+
+    /* before anything else gets the instance */
+    if (!strcmp(bench, "startup"))
+        return benchStartup();
+
+    RockchipRga& rkRga(RockchipRga::get());
+
+    if (!strcmp(bench, "scaling")) {
+        int cluster = DRM_RGA_CPU_CLUSTER_ANY;
+
+        if (argc > 2 && !strcmp(argv[2], "big"))
+            cluster = DRM_RGA_CPU_CLUSTER_BIG;
+        else if (argc > 2 && !strcmp(argv[2], "little"))
+            cluster = DRM_RGA_CPU_CLUSTER_LITTLE;
+
+        return benchScaling(rkRga, cluster);
+    }
+
+    if (!strcmp(bench, "quality"))
+        return benchQuality(rkRga);
+
+    if (!strcmp(bench, "fill"))
+        return benchFills(rkRga);
+
+    if (!strcmp(bench, "filter"))
+        return benchFilter(rkRga);
+
+    if (!strcmp(bench, "dither"))
+        return benchDither(rkRga);
+
+    if (!strcmp(bench, "hdr"))
+        return benchHdr(rkRga);
+
+    if (!strcmp(bench, "decimate"))
+        return benchDecimate(rkRga);
+
+    if (!strcmp(bench, "paths"))
+        return benchPaths(rkRga);
+
+    if (!strcmp(bench, "dispatch"))
+        return benchDispatch(rkRga);
+
+    if (!strcmp(bench, "pipeline"))
+        return benchPipeline(rkRga);
+
+    if (!strcmp(bench, "clip")) {
+        if (argc > 4)
+            return benchClip(rkRga, argv[2], atoi(argv[3]), atoi(argv[4]),
+                        argc > 5 ? argv[5] : "/data/local/tmp/rga_clip.rgba");
+        return benchClip(rkRga, NULL, 1920, 1080,
+                        argc > 2 ? argv[2] : "/data/local/tmp/rga_clip.rgba");
+    }
+
+    if (!strcmp(bench, "fused"))
+        return benchFused(rkRga);
+
+    if (!strcmp(bench, "lines"))
+        return benchLines(rkRga);
+
+    usage(argv[0]);
+    return -EINVAL;
+}
@@ -157,17 +157,23 @@ int main()
         printf("unlock buffer ok : %s\n","*************************************");
 
     while(1) {
-        drm_rga_t rects;
-        memset(&rects, 0, sizeof(drm_rga_t));
-        rga_set_rect(&rects.src, 0, 0, 1920, 1088, 1920, 21);
-        rga_set_rect(&rects.dst, 200, 120, 1520, 800, 1920, 1);
+        unsigned int checker[16 * 16];
+        rga_rect_t rect;
+
+        /* 16x16 checkerboard of 8x8 squares */
+        for (int i = 0; i < 16 * 16; i++)
+            checker[i] = ((i / 16 / 8) ^ (i % 16 / 8)) ? 0xffffffff : 0xff404040;
+
+        rga_set_rect(&rect, 200, 120, 1520, 800, 1920, dstFormat);
         rkRga.RkRgaSetLogOnceFlag(1);
-        ret = rkRga.RkRgaPaletteTable(gbd->handle, 0x8855aa03, &rects);
+        ret = rkRga.RkRgaSetPattern(checker, 16, 16);
+        if (!ret)
+            ret = rkRga.RkRgaPatternFill(gbd->handle, &rect, 4, 4);
 
         if (ret) {
-            printf("rgaFillColor error : %s,hnd=%p\n",
+            printf("rgaPatternFill error : %s,hnd=%p\n",
                                             strerror(errno),(void*)(gbd->handle));
-            ALOGD("rgaFillColor error : %s,hnd=%p\n",
+            ALOGD("rgaPatternFill error : %s,hnd=%p\n",
                                             strerror(errno),(void*)(gbd->handle));
         }
 
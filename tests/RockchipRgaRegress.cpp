@@ -0,0 +1,1149 @@
+/*
+ * Copyright (C) 2016 Rockchip Electronics Co.Ltd
+ * Authors:
+ *	Zhiqin Wei <wzq@rock-chips.com>
+ *
+ * This program is free software; you can redistribute  it and/or modify it
+ * under  the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation;  either version 2 of the  License, or (at your
+ * option) any later version.
+ *
+ */
+
+/*
+ * Golden output regression suite. Every case runs on the software renderer,
+ * the core the emulated devices run, on inputs the suite generates. Exact
+ * cases compare a hash of the whole dst buffer, filtered scaling compares
+ * the psnr against the scene rendered at the dst size with the minimum
+ * stored in the goldens.
+ *
+ * The goldens are the output of the scalar code. The neon kernels must give
+ * the same bits, -c runs every case on both and fails on any difference,
+ * so the same goldens hold for the arm builds. Without neon in the build
+ * both passes run the scalar code.
+ *
+ *   adb push tests/rgaregress.golden /data/local/tmp/
+ *   rgaregress                     check, non zero exit on any failure
+ *   rgaregress -u                  rewrite the goldens after a wanted change
+ *   rgaregress -c                  neon against scalar, no goldens needed
+ *
+ * The captured frame of a board, /data/inputBuffer.bin by default, differs
+ * from board to board. Its cases keep their goldens next to it, in
+ * inputBuffer.bin.golden, written by -u on that board, and are skipped
+ * where either file is missing.
+ *
+ * Failed cases leave their dst under /data/local/tmp for a look.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "RockchipRgaRegress"
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <math.h>
+
+#include <hardware/hardware.h>
+#include <RockchipRga.h>
+#include <RockchipRgaRawVideo.h>
+#include <RockchipRgaPipeline.h>
+
+#include <map>
+#include <string>
+
+///////////////////////////////////////////////////////
+
+using namespace android;
+
+#define REGRESS_WIDTH       320
+#define REGRESS_HEIGHT      240
+#define CAPTURED_WIDTH      1920
+#define CAPTURED_HEIGHT     1088
+#define CAPTURED_PREFIX     "captured-"
+
+/* dB below the measured psnr that -u stores, room for rounding changes */
+#define PSNR_MARGIN         0.5
+
+/* what the dst holds before a case, writes outside the rect change the hash */
+#define CANARY              0x5a
+
+struct Golden {
+    bool        psnr;
+    uint64_t    hash;
+    double      minPsnr;
+};
+
+struct Regress {
+    RockchipRga                     *rkRga;
+    std::map<std::string, Golden>   goldens;
+    std::map<std::string, Golden>   results;
+    bool                            update;
+    bool                            cross;
+    int                             passed;
+    int                             failed;
+};
+
+/* xxHash64 of len bytes, seed 0 */
+static uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t read64(const uint8_t *p)
+{
+    uint64_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t hashRound(uint64_t acc, uint64_t input)
+{
+    acc += input * 0xC2B2AE3D27D4EB4FULL;
+    return rotl64(acc, 31) * 0x9E3779B185EBCA87ULL;
+}
+
+static uint64_t hashMerge(uint64_t acc, uint64_t val)
+{
+    acc ^= hashRound(0, val);
+    return acc * 0x9E3779B185EBCA87ULL + 0x85EBCA77C2B2AE63ULL;
+}
+
+static uint64_t hash64(const void *data, size_t len)
+{
+    const uint64_t p1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t p2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t p3 = 0x165667B19E3779F9ULL;
+    const uint64_t p4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t p5 = 0x27D4EB2F165667C5ULL;
+    const uint8_t *p = (const uint8_t *)data;
+    const uint8_t *end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        uint64_t v1 = p1 + p2, v2 = p2, v3 = 0, v4 = -p1;
+
+        /* four independent lanes keep the multipliers busy */
+        for (; p + 32 <= end; p += 32) {
+            v1 = hashRound(v1, read64(p));
+            v2 = hashRound(v2, read64(p + 8));
+            v3 = hashRound(v3, read64(p + 16));
+            v4 = hashRound(v4, read64(p + 24));
+        }
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = hashMerge(h, v1);
+        h = hashMerge(h, v2);
+        h = hashMerge(h, v3);
+        h = hashMerge(h, v4);
+    } else {
+        h = p5;
+    }
+
+    h += len;
+    for (; p + 8 <= end; p += 8)
+        h = rotl64(h ^ hashRound(0, read64(p)), 27) * p1 + p4;
+    if (p + 4 <= end) {
+        uint32_t k;
+
+        memcpy(&k, p, sizeof(k));
+        h = rotl64(h ^ (k * p1), 23) * p2 + p3;
+        p += 4;
+    }
+    for (; p < end; p++)
+        h = rotl64(h ^ (*p * p5), 11) * p1;
+
+    h ^= h >> 33;
+    h *= p2;
+    h ^= h >> 29;
+    h *= p3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+static size_t frameSize(int width, int height, int format)
+{
+    if (format == HAL_PIXEL_FORMAT_YCrCb_NV12 ||
+                    format == HAL_PIXEL_FORMAT_YCrCb_420_SP)
+        return (size_t)width * height * 3 / 2;
+    if (format == HAL_PIXEL_FORMAT_RGB_565)
+        return (size_t)width * height * 2;
+    if (format == HAL_PIXEL_FORMAT_RGB_888)
+        return (size_t)width * height * 3;
+    return (size_t)width * height * 4;
+}
+
+/* zone plate as in rgabench quality, with an alpha ramp for the blends */
+static void fillZonePlate(uint8_t *buf, int width, int height)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double u = (x + 0.5) / width - 0.5;
+            double v = (y + 0.5) / height - 0.5;
+            uint8_t c = (uint8_t)(127.5 + 127.0 * cos(400.0 * (u * u + v * v)));
+            uint8_t *p = buf + (y * width + x) * 4;
+
+            p[0] = c;
+            p[1] = 255 - c;
+            p[2] = (uint8_t)(255.0 * (u + 0.5));
+            p[3] = (uint8_t)(255.0 * (v + 0.5));
+        }
+    }
+}
+
+/* bars of luma with a chroma checker, nothing symmetric to hide a flip */
+static void fillNv12(uint8_t *buf, int width, int height)
+{
+    uint8_t *uv = buf + width * height;
+
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            buf[y * width + x] = (uint8_t)(16 + (x * 7 + y * 3) % 220);
+
+    for (int y = 0; y < height / 2; y++) {
+        for (int x = 0; x < width / 2; x++) {
+            bool odd = ((x >> 3) ^ (y >> 3)) & 1;
+
+            uv[y * width + x * 2] = odd ? 64 + x % 128 : 192 - y % 128;
+            uv[y * width + x * 2 + 1] = odd ? 200 - y % 64 : 40 + x % 64;
+        }
+    }
+}
+
+static double psnr(const uint8_t *a, const uint8_t *b, int pixels)
+{
+    double sum = 0.0;
+
+    for (int i = 0; i < pixels * 4; i++) {
+        if ((i & 3) == 3)
+            continue;
+        sum += (double)(a[i] - b[i]) * (a[i] - b[i]);
+    }
+
+    sum /= pixels * 3.0;
+    return sum > 0.0 ? 10.0 * log10(255.0 * 255.0 / sum) : 99.0;
+}
+
+static int loadGoldens(Regress *r, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+
+    if (!file)
+        return -errno;
+
+    while (fgets(line, sizeof(line), file)) {
+        char name[128], kind[16], value[32];
+        Golden golden;
+
+        if (line[0] == '#' || sscanf(line, "%127s %15s %31s", name, kind, value) != 3)
+            continue;
+
+        memset(&golden, 0, sizeof(golden));
+        golden.psnr = !strcmp(kind, "psnr");
+        if (golden.psnr)
+            golden.minPsnr = atof(value);
+        else
+            golden.hash = strtoull(value, NULL, 16);
+        r->goldens[name] = golden;
+    }
+
+    fclose(file);
+    return 0;
+}
+
+/* the cases of the board's own frame, their goldens live next to it */
+static bool isCaptured(const std::string &name)
+{
+    return name.compare(0, strlen(CAPTURED_PREFIX), CAPTURED_PREFIX) == 0;
+}
+
+/*
+ * Write to a temp file and rename, an interrupted run keeps the old goldens.
+ * captured picks the cases of the board's frame or all the others.
+ */
+static int saveGoldens(Regress *r, const char *path, bool captured)
+{
+    std::string tmp = std::string(path) + ".tmp";
+    FILE *file = fopen(tmp.c_str(), "w");
+    std::map<std::string, Golden>::iterator it;
+
+    if (!file)
+        return -errno;
+
+    fprintf(file, "# rgaregress goldens, rewrite with rgaregress -u\n");
+    fprintf(file, "# case                          kind  value\n");
+    for (it = r->results.begin(); it != r->results.end(); it++) {
+        if (isCaptured(it->first) != captured)
+            continue;
+        if (it->second.psnr)
+            fprintf(file, "%-32s psnr  %.2f\n", it->first.c_str(),
+                                    it->second.minPsnr - PSNR_MARGIN);
+        else
+            fprintf(file, "%-32s hash  %016llx\n", it->first.c_str(),
+                                    (unsigned long long)it->second.hash);
+    }
+
+    if (fclose(file) || rename(tmp.c_str(), path)) {
+        unlink(tmp.c_str());
+        return -errno;
+    }
+
+    return 0;
+}
+
+static void dumpFailure(const char *name, const void *data, size_t size)
+{
+    char path[192];
+    FILE *file;
+
+    snprintf(path, sizeof(path), "/data/local/tmp/rgaregress-%s.bin", name);
+    file = fopen(path, "wb");
+    if (!file)
+        return;
+    fwrite(data, size, 1, file);
+    fclose(file);
+    printf("    dst dumped to %s\n", path);
+}
+
+static void report(Regress *r, const char *name, bool pass, const char *detail)
+{
+    printf("  %-32s %s  %s\n", name, pass ? "ok  " : "FAIL", detail);
+    if (pass)
+        r->passed++;
+    else
+        r->failed++;
+}
+
+static void checkHash(Regress *r, const char *name, int ret,
+                                            const void *dst, size_t size)
+{
+    std::map<std::string, Golden>::iterator it = r->goldens.find(name);
+    Golden result;
+    char detail[96];
+
+    if (ret) {
+        snprintf(detail, sizeof(detail), "blit returned %d", ret);
+        report(r, name, false, detail);
+        return;
+    }
+
+    memset(&result, 0, sizeof(result));
+    result.hash = hash64(dst, size);
+    r->results[name] = result;
+
+    if (r->update) {
+        snprintf(detail, sizeof(detail), "%016llx", (unsigned long long)result.hash);
+        report(r, name, true, detail);
+    } else if (it == r->goldens.end() || it->second.psnr) {
+        snprintf(detail, sizeof(detail), "%016llx, no golden",
+                                        (unsigned long long)result.hash);
+        report(r, name, false, detail);
+    } else {
+        snprintf(detail, sizeof(detail), "%016llx, golden %016llx",
+                                        (unsigned long long)result.hash,
+                                        (unsigned long long)it->second.hash);
+        report(r, name, result.hash == it->second.hash, detail);
+        if (result.hash != it->second.hash)
+            dumpFailure(name, dst, size);
+    }
+}
+
+static void checkPsnr(Regress *r, const char *name, int ret,
+                                const uint8_t *dst, const uint8_t *ref, int pixels)
+{
+    std::map<std::string, Golden>::iterator it = r->goldens.find(name);
+    Golden result;
+    char detail[96];
+
+    if (ret) {
+        snprintf(detail, sizeof(detail), "blit returned %d", ret);
+        report(r, name, false, detail);
+        return;
+    }
+
+    memset(&result, 0, sizeof(result));
+    result.psnr = true;
+    result.minPsnr = psnr(dst, ref, pixels);
+    result.hash = hash64(dst, (size_t)pixels * 4);
+    r->results[name] = result;
+
+    if (r->update) {
+        snprintf(detail, sizeof(detail), "%5.2f dB", result.minPsnr);
+        report(r, name, true, detail);
+    } else if (r->cross && it != r->goldens.end()) {
+        /* the same bits as the scalar pass, not just as close */
+        snprintf(detail, sizeof(detail), "%5.2f dB, %016llx, scalar %016llx",
+                                result.minPsnr, (unsigned long long)result.hash,
+                                (unsigned long long)it->second.hash);
+        report(r, name, result.hash == it->second.hash, detail);
+        if (result.hash != it->second.hash)
+            dumpFailure(name, dst, (size_t)pixels * 4);
+    } else if (it == r->goldens.end() || !it->second.psnr) {
+        snprintf(detail, sizeof(detail), "%5.2f dB, no golden", result.minPsnr);
+        report(r, name, false, detail);
+    } else {
+        snprintf(detail, sizeof(detail), "%5.2f dB, min %5.2f dB",
+                                        result.minPsnr, it->second.minPsnr);
+        report(r, name, result.minPsnr >= it->second.minPsnr, detail);
+        if (result.minPsnr < it->second.minPsnr)
+            dumpFailure(name, dst, (size_t)pixels * 4);
+    }
+}
+
+/*
+ * One blit of src into a fresh dst, dst starts as the canary or, for the
+ * blends, as a copy of under.
+ */
+static void blitCase(Regress *r, const char *name, void *src, int srcFormat,
+                    const rga_rect_t *srcRect, int dstW, int dstH, int dstFormat,
+                    const rga_rect_t *dstRect, int rotation, int blend,
+                    const void *under)
+{
+    size_t size = frameSize(dstW, dstH, dstFormat);
+    uint8_t *dst = (uint8_t *)malloc(size);
+    drm_rga_t rects;
+    int ret;
+
+    if (!dst) {
+        report(r, name, false, "no memory");
+        return;
+    }
+
+    if (under)
+        memcpy(dst, under, size);
+    else
+        memset(dst, CANARY, size);
+
+    memset(&rects, 0, sizeof(drm_rga_t));
+    if (srcRect)
+        rects.src = *srcRect;
+    else
+        rga_set_rect(&rects.src, 0, 0, REGRESS_WIDTH, REGRESS_HEIGHT,
+                                            REGRESS_WIDTH, srcFormat);
+    if (dstRect)
+        rects.dst = *dstRect;
+    else
+        rga_set_rect(&rects.dst, 0, 0, dstW, dstH, dstW, dstFormat);
+
+    ret = r->rkRga->RkRgaBlit(src, dst, &rects, rotation, blend);
+    checkHash(r, name, ret, dst, size);
+
+    free(dst);
+}
+
+static void runBlits(Regress *r, void *rgba, void *nv12, void *under)
+{
+    const int w = REGRESS_WIDTH, h = REGRESS_HEIGHT;
+    const int rgbaFmt = HAL_PIXEL_FORMAT_RGBA_8888;
+    const int nv12Fmt = HAL_PIXEL_FORMAT_YCrCb_NV12;
+    rga_rect_t src, dst;
+
+    printf("blits %dx%d:\n", w, h);
+
+    blitCase(r, "copy-rgba", rgba, rgbaFmt, NULL, w, h, rgbaFmt,
+                                                NULL, 0, 0, NULL);
+
+    rga_set_rect(&src, 17, 9, 200, 120, w, rgbaFmt);
+    rga_set_rect(&dst, 40, 60, 200, 120, w, rgbaFmt);
+    blitCase(r, "copy-rgba-crop", rgba, rgbaFmt, &src, w, h, rgbaFmt,
+                                                &dst, 0, 0, NULL);
+
+    blitCase(r, "copy-nv12", nv12, nv12Fmt, NULL, w, h, nv12Fmt,
+                                                NULL, 0, 0, NULL);
+    blitCase(r, "convert-nv12-rgba", nv12, nv12Fmt, NULL, w, h, rgbaFmt,
+                                                NULL, 0, 0, NULL);
+    blitCase(r, "convert-rgba-nv12", rgba, rgbaFmt, NULL, w, h, nv12Fmt,
+                                                NULL, 0, 0, NULL);
+    blitCase(r, "convert-rgba-rgb565", rgba, rgbaFmt, NULL, w, h,
+                                HAL_PIXEL_FORMAT_RGB_565, NULL, 0, 0, NULL);
+    blitCase(r, "convert-rgba-bgra", rgba, rgbaFmt, NULL, w, h,
+                                HAL_PIXEL_FORMAT_BGRA_8888, NULL, 0, 0, NULL);
+
+    blitCase(r, "mirror-h-rgba", rgba, rgbaFmt, NULL, w, h, rgbaFmt,
+                                    NULL, HAL_TRANSFORM_FLIP_H, 0, NULL);
+    blitCase(r, "mirror-v-rgba", rgba, rgbaFmt, NULL, w, h, rgbaFmt,
+                                    NULL, HAL_TRANSFORM_FLIP_V, 0, NULL);
+    blitCase(r, "mirror-h-nv12-rgba", nv12, nv12Fmt, NULL, w, h, rgbaFmt,
+                                    NULL, HAL_TRANSFORM_FLIP_H, 0, NULL);
+
+    blitCase(r, "rotate-90-rgba", rgba, rgbaFmt, NULL, h, w, rgbaFmt,
+                                    NULL, HAL_TRANSFORM_ROT_90, 0, NULL);
+    blitCase(r, "rotate-180-rgba", rgba, rgbaFmt, NULL, w, h, rgbaFmt,
+                                    NULL, HAL_TRANSFORM_ROT_180, 0, NULL);
+    blitCase(r, "rotate-270-rgba", rgba, rgbaFmt, NULL, h, w, rgbaFmt,
+                                    NULL, HAL_TRANSFORM_ROT_270, 0, NULL);
+    blitCase(r, "rotate-90-nv12-rgba", nv12, nv12Fmt, NULL, h, w, rgbaFmt,
+                                    NULL, HAL_TRANSFORM_ROT_90, 0, NULL);
+
+    blitCase(r, "blend-src-over", rgba, rgbaFmt, NULL, w, h, rgbaFmt,
+                                    NULL, 0, 0xff0105, under);
+    blitCase(r, "blend-src-over-plane80", rgba, rgbaFmt, NULL, w, h, rgbaFmt,
+                                    NULL, 0, 0x800105, under);
+    blitCase(r, "blend-src-plane80", rgba, rgbaFmt, NULL, w, h, rgbaFmt,
+                                    NULL, 0, 0x800405, under);
+}
+
+static void runRotate(Regress *r, void *rgba)
+{
+    static const int angles[] = {30, 135, 301};
+    const int w = REGRESS_WIDTH, h = REGRESS_HEIGHT;
+    size_t size = frameSize(w, h, HAL_PIXEL_FORMAT_RGBA_8888);
+    uint8_t *dst = (uint8_t *)malloc(size);
+
+    if (!dst) {
+        report(r, "rotate-angles", false, "no memory");
+        return;
+    }
+
+    printf("rotate %dx%d:\n", w, h);
+    for (size_t i = 0; i < sizeof(angles) / sizeof(angles[0]); i++) {
+        drm_rga_t rects;
+        char name[32];
+        int ret;
+
+        memset(dst, CANARY, size);
+        memset(&rects, 0, sizeof(drm_rga_t));
+        rga_set_rect(&rects.src, 0, 0, w, h, w, HAL_PIXEL_FORMAT_RGBA_8888);
+        rga_set_rect(&rects.dst, 0, 0, w, h, w, HAL_PIXEL_FORMAT_RGBA_8888);
+
+        snprintf(name, sizeof(name), "rotate-%d-rgba", angles[i]);
+        ret = r->rkRga->RkRgaRotate(rgba, dst, &rects, angles[i], 0);
+        checkHash(r, name, ret, dst, size);
+    }
+
+    free(dst);
+}
+
+/* the src side by side into both halves of a double width dst */
+static void runStereo(Regress *r, void *rgba, void *nv12)
+{
+    static const struct {
+        const char  *name;
+        int         format;
+    } cases[] = {
+        {"stereo-rgba", HAL_PIXEL_FORMAT_RGBA_8888},
+        {"stereo-nv12-rgba", HAL_PIXEL_FORMAT_YCrCb_NV12},
+    };
+    const int w = REGRESS_WIDTH, h = REGRESS_HEIGHT;
+    size_t size = frameSize(w * 2, h, HAL_PIXEL_FORMAT_RGBA_8888);
+    uint8_t *dst = (uint8_t *)malloc(size);
+
+    if (!dst) {
+        report(r, "stereo", false, "no memory");
+        return;
+    }
+
+    printf("stereo %dx%d:\n", w * 2, h);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        void *src = cases[i].format == HAL_PIXEL_FORMAT_RGBA_8888 ? rgba : nv12;
+        drm_rga_t rects;
+        int ret;
+
+        memset(dst, CANARY, size);
+        memset(&rects, 0, sizeof(drm_rga_t));
+        rga_set_rect(&rects.src, 0, 0, w, h, w, cases[i].format);
+        rga_set_rect(&rects.dst, 0, 0, w, h, w * 2, HAL_PIXEL_FORMAT_RGBA_8888);
+        ret = r->rkRga->RkRgaBlit(src, dst, &rects, 0, 0);
+        if (!ret) {
+            rga_set_rect(&rects.dst, w, 0, w, h, w * 2, HAL_PIXEL_FORMAT_RGBA_8888);
+            ret = r->rkRga->RkRgaBlit(src, dst, &rects, 0, 0);
+        }
+        checkHash(r, cases[i].name, ret, dst, size);
+    }
+
+    free(dst);
+}
+
+static void runPalette(Regress *r)
+{
+    static const struct {
+        const char  *name;
+        int         bits;
+        int         endian;
+    } cases[] = {
+        {"palette-8bpp", 8, DRM_RGA_PALETTE_MSB_FIRST},
+        {"palette-4bpp", 4, DRM_RGA_PALETTE_LSB_FIRST},
+        {"palette-1bpp-msb", 1, DRM_RGA_PALETTE_MSB_FIRST},
+        {"palette-1bpp-lsb", 1, DRM_RGA_PALETTE_LSB_FIRST},
+    };
+    const int w = REGRESS_WIDTH, h = REGRESS_HEIGHT;
+    size_t size = frameSize(w, h, HAL_PIXEL_FORMAT_RGBA_8888);
+    uint8_t *dst = (uint8_t *)malloc(size);
+    uint8_t *src = (uint8_t *)malloc(w * h);
+    unsigned int colors[256];
+
+    if (!dst || !src) {
+        free(dst);
+        free(src);
+        report(r, "palette", false, "no memory");
+        return;
+    }
+
+    printf("palette %dx%d:\n", w, h);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int count = 1 << cases[i].bits;
+        drm_rga_t rects;
+        int ret;
+
+        for (int k = 0; k < count; k++)
+            colors[k] = 0xff000000 | (k * 0x9e3779u & 0xffffff);
+        for (int k = 0; k < w * h * cases[i].bits / 8; k++)
+            src[k] = (uint8_t)(k * 31 + k / w * 7);
+
+        memset(dst, CANARY, size);
+        memset(&rects, 0, sizeof(drm_rga_t));
+        rga_set_rect(&rects.src, 0, 0, w, h, w, 0);
+        rga_set_rect(&rects.dst, 0, 0, w, h, w, HAL_PIXEL_FORMAT_RGBA_8888);
+
+        ret = r->rkRga->RkRgaSetPalette(colors, count);
+        if (!ret)
+            ret = r->rkRga->RkRgaPaletteBlit(src, dst, &rects, cases[i].endian);
+        checkHash(r, cases[i].name, ret, dst, size);
+    }
+
+    free(dst);
+    free(src);
+}
+
+/* pixels of the rgba dst that are not canary, against the area expected */
+static int countStray(const uint8_t *dst, int w, int h, int x0, int y0,
+                        int x1, int y1, const uint8_t *pixel, int *missed)
+{
+    int stray = 0;
+
+    *missed = 0;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            const uint8_t *p = dst + (y * w + x) * 4;
+            bool inside = x >= x0 && x < x1 && y >= y0 && y < y1;
+
+            if (inside && memcmp(p, pixel, 4))
+                (*missed)++;
+            else if (!inside && (p[0] != CANARY || p[1] != CANARY ||
+                                    p[2] != CANARY || p[3] != CANARY))
+                stray++;
+        }
+    }
+
+    return stray;
+}
+
+/*
+ * Fills and lines into a rect well below the top of the buffer, the
+ * primitives are relative to the rect and clipped by it.
+ */
+static void runOffsetRects(Regress *r)
+{
+    const int w = REGRESS_WIDTH, h = REGRESS_HEIGHT;
+    const uint8_t pixel[4] = {0x33, 0x66, 0x99, 0xff};
+    size_t size = frameSize(w, h, HAL_PIXEL_FORMAT_RGBA_8888);
+    uint8_t *dst = (uint8_t *)malloc(size);
+    char detail[64];
+    rga_rect_t rect;
+    rga_fill_t fill;
+    rga_line_t line;
+    int ret, stray, missed;
+
+    if (!dst) {
+        report(r, "offset-rects", false, "no memory");
+        return;
+    }
+
+    printf("offset rects %dx%d:\n", w, h);
+    rga_set_rect(&rect, 16, 100, 200, 100, w, HAL_PIXEL_FORMAT_RGBA_8888);
+
+    /* past the left and the bottom edge of the rect */
+    memset(dst, CANARY, size);
+    memset(&fill, 0, sizeof(rga_fill_t));
+    fill.x = -8;
+    fill.y = 60;
+    fill.width = 64;
+    fill.height = 80;
+    fill.color = 0xff336699;
+    ret = r->rkRga->RkRgaFill(dst, &rect, &fill, 1);
+    stray = countStray(dst, w, h, 16, 160, 72, 200, pixel, &missed);
+    snprintf(detail, sizeof(detail), "ret %d missed %d stray %d",
+                                                    ret, missed, stray);
+    report(r, "fill-offset-rect", !ret && !missed && !stray, detail);
+
+    /* across the whole buffer, only the part inside the rect is drawn */
+    memset(dst, CANARY, size);
+    memset(&line, 0, sizeof(rga_line_t));
+    line.x0 = -40;
+    line.y0 = 90;
+    line.x1 = w + 40;
+    line.y1 = 90;
+    line.color = 0xff336699;
+    ret = r->rkRga->RkRgaDrawLines(dst, &rect, &line, 1);
+    stray = countStray(dst, w, h, 16, 190, 216, 191, pixel, &missed);
+    snprintf(detail, sizeof(detail), "ret %d missed %d stray %d",
+                                                    ret, missed, stray);
+    report(r, "line-offset-rect", !ret && !missed && !stray, detail);
+
+    free(dst);
+}
+
+/*
+ * A hybrid blit into a rect below the top of the dst, the rga part and
+ * the cpu part together must give what the cpu alone renders. Without an
+ * rga core, emulated or not, both runs go to the cpu.
+ */
+static void runHybrid(Regress *r)
+{
+    const int w = 640, h = 480, top = 100;
+    size_t srcSize = frameSize(w, h, HAL_PIXEL_FORMAT_RGBA_8888);
+    size_t dstSize = frameSize(w, top + h, HAL_PIXEL_FORMAT_RGBA_8888);
+    uint8_t *src = (uint8_t *)malloc(srcSize);
+    uint8_t *cpu = (uint8_t *)malloc(dstSize);
+    uint8_t *hybrid = (uint8_t *)malloc(dstSize);
+    drm_rga_t rects;
+    char detail[64];
+    int cpuRet, ret, diff = 0;
+
+    if (!src || !cpu || !hybrid) {
+        free(src);
+        free(cpu);
+        free(hybrid);
+        report(r, "hybrid-offset-dst", false, "no memory");
+        return;
+    }
+
+    printf("hybrid %dx%d:\n", w, h);
+    fillZonePlate(src, w, h);
+    memset(cpu, CANARY, dstSize);
+    memset(hybrid, CANARY, dstSize);
+    memset(&rects, 0, sizeof(drm_rga_t));
+    rga_set_rect(&rects.src, 0, 0, w, h, w, HAL_PIXEL_FORMAT_RGBA_8888);
+    rga_set_rect(&rects.dst, 0, top, w, h, w, HAL_PIXEL_FORMAT_BGRA_8888);
+
+    cpuRet = r->rkRga->RkRgaConvert(src, cpu, &rects);
+    r->rkRga->RkRgaSetEngine(DRM_RGA_ENGINE_HYBRID);
+    ret = r->rkRga->RkRgaConvert(src, hybrid, &rects);
+    r->rkRga->RkRgaSetEngine(DRM_RGA_ENGINE_CPU);
+
+    for (size_t i = 0; i < dstSize; i++)
+        diff += cpu[i] != hybrid[i];
+    snprintf(detail, sizeof(detail), "ret %d/%d bytes differing %d",
+                                                    cpuRet, ret, diff);
+    report(r, "hybrid-offset-dst", !cpuRet && !ret && !diff, detail);
+
+    free(src);
+    free(cpu);
+    free(hybrid);
+}
+
+/*
+ * Error diffusion into rgb565 must not depend on how the frame is cut
+ * into stripes, one worker and many give the same bits.
+ */
+static void runDiffusion(Regress *r)
+{
+    const int w = 640, h = 480;
+    size_t srcSize = frameSize(w, h, HAL_PIXEL_FORMAT_RGBA_8888);
+    size_t dstSize = frameSize(w, h, HAL_PIXEL_FORMAT_RGB_565);
+    uint8_t *src = (uint8_t *)malloc(srcSize);
+    uint8_t *one = (uint8_t *)malloc(dstSize);
+    uint8_t *many = (uint8_t *)malloc(dstSize);
+    drm_rga_t rects;
+    char detail[64];
+    int oneRet, ret, diff = 0;
+
+    if (!src || !one || !many) {
+        free(src);
+        free(one);
+        free(many);
+        report(r, "diffusion-workers", false, "no memory");
+        return;
+    }
+
+    printf("diffusion %dx%d:\n", w, h);
+    fillZonePlate(src, w, h);
+    memset(one, CANARY, dstSize);
+    memset(many, CANARY, dstSize);
+    memset(&rects, 0, sizeof(drm_rga_t));
+    rga_set_rect(&rects.src, 0, 0, w, h, w, HAL_PIXEL_FORMAT_RGBA_8888);
+    rga_set_rect(&rects.dst, 0, 0, w, h, w, HAL_PIXEL_FORMAT_RGB_565);
+
+    r->rkRga->RkRgaSetDitherMode(DRM_RGA_DITHER_DIFFUSION);
+    r->rkRga->RkRgaSetCpuWorkers(1, DRM_RGA_CPU_CLUSTER_ANY);
+    oneRet = r->rkRga->RkRgaConvert(src, one, &rects);
+    r->rkRga->RkRgaSetCpuWorkers(8, DRM_RGA_CPU_CLUSTER_ANY);
+    ret = r->rkRga->RkRgaConvert(src, many, &rects);
+    r->rkRga->RkRgaSetCpuWorkers(0, DRM_RGA_CPU_CLUSTER_ANY);
+    r->rkRga->RkRgaSetDitherMode(DRM_RGA_DITHER_AUTO);
+
+    for (size_t i = 0; i < dstSize; i++)
+        diff += one[i] != many[i];
+    snprintf(detail, sizeof(detail), "ret %d/%d bytes differing %d",
+                                                    oneRet, ret, diff);
+    report(r, "diffusion-workers", !oneRet && !ret && !diff, detail);
+
+    free(src);
+    free(one);
+    free(many);
+}
+
+/*
+ * The filters may change in the last bit as kernels get faster, so
+ * scaling compares against the zone plate rendered at the dst size.
+ */
+static void runScaling(Regress *r)
+{
+    static const struct {
+        const char  *name;
+        int         mode;
+        int         srcW, srcH, dstW, dstH;
+    } cases[] = {
+        {"scale-nearest-down",  DRM_RGA_SCALE_NEAREST,  640, 480, 320, 240},
+        {"scale-bilinear-down", DRM_RGA_SCALE_BILINEAR, 640, 480, 320, 240},
+        {"scale-bilinear-up",   DRM_RGA_SCALE_BILINEAR, 320, 240, 480, 360},
+        {"scale-bicubic-up",    DRM_RGA_SCALE_BICUBIC,  320, 240, 480, 360},
+        {"scale-area-down",     DRM_RGA_SCALE_AREA,     640, 480, 400, 300},
+    };
+
+    printf("scaling:\n");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int dstPixels = cases[i].dstW * cases[i].dstH;
+        uint8_t *src = (uint8_t *)malloc(cases[i].srcW * cases[i].srcH * 4);
+        uint8_t *dst = (uint8_t *)malloc(dstPixels * 4);
+        uint8_t *ref = (uint8_t *)malloc(dstPixels * 4);
+        drm_rga_t rects;
+        int ret;
+
+        if (!src || !dst || !ref) {
+            free(src);
+            free(dst);
+            free(ref);
+            report(r, cases[i].name, false, "no memory");
+            continue;
+        }
+        fillZonePlate(src, cases[i].srcW, cases[i].srcH);
+        fillZonePlate(ref, cases[i].dstW, cases[i].dstH);
+        memset(dst, CANARY, dstPixels * 4);
+
+        memset(&rects, 0, sizeof(drm_rga_t));
+        rga_set_rect(&rects.src, 0, 0, cases[i].srcW, cases[i].srcH,
+                                    cases[i].srcW, HAL_PIXEL_FORMAT_RGBA_8888);
+        rga_set_rect(&rects.dst, 0, 0, cases[i].dstW, cases[i].dstH,
+                                    cases[i].dstW, HAL_PIXEL_FORMAT_RGBA_8888);
+
+        r->rkRga->RkRgaSetScaleMode(cases[i].mode);
+        ret = r->rkRga->RkRgaBlit(src, dst, &rects, 0, 0);
+        checkPsnr(r, cases[i].name, ret, dst, ref, dstPixels);
+
+        free(src);
+        free(dst);
+        free(ref);
+    }
+
+    r->rkRga->RkRgaSetScaleMode(DRM_RGA_SCALE_AUTO);
+}
+
+/*
+ * Crop, scale, nv12->rgba and a quarter turn in one blit, the camera
+ * preview case. The software renderer fuses these, the goldens hold the
+ * output of the row by row path it must match.
+ */
+static void runFused(Regress *r, void *nv12)
+{
+    static const struct {
+        const char  *name;
+        int         mode;
+        int         rotation;
+        int         cropX, cropY, cropW, cropH;
+        int         dstX, dstY, dstW, dstH;
+    } cases[] = {
+        {"fused-bilinear-down-rot90", DRM_RGA_SCALE_BILINEAR,
+                    HAL_TRANSFORM_ROT_90,   24, 16, 256, 192,  0,  0, 144, 192},
+        {"fused-bilinear-up-rot270",  DRM_RGA_SCALE_BILINEAR,
+                    HAL_TRANSFORM_ROT_270,  40, 30, 160, 120,  8, 12, 180, 240},
+        {"fused-nearest-down-rot90",  DRM_RGA_SCALE_NEAREST,
+                    HAL_TRANSFORM_ROT_90,   10,  6, 300, 200, 20,  4, 150, 220},
+        {"fused-unscaled-rot270",     DRM_RGA_SCALE_BILINEAR,
+                    HAL_TRANSFORM_ROT_270,  32,  0, 200, 240,  0, 40, 240, 200},
+    };
+    const int w = REGRESS_WIDTH, h = REGRESS_HEIGHT;
+    size_t size = frameSize(w, h, HAL_PIXEL_FORMAT_RGBA_8888);
+    uint8_t *dst = (uint8_t *)malloc(size);
+
+    if (!dst) {
+        report(r, "fused", false, "no memory");
+        return;
+    }
+
+    printf("fused %dx%d:\n", w, h);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        drm_rga_t rects;
+        int ret;
+
+        memset(dst, CANARY, size);
+        memset(&rects, 0, sizeof(drm_rga_t));
+        rga_set_rect(&rects.src, cases[i].cropX, cases[i].cropY, cases[i].cropW,
+                        cases[i].cropH, w, HAL_PIXEL_FORMAT_YCrCb_NV12);
+        rga_set_rect(&rects.dst, cases[i].dstX, cases[i].dstY, cases[i].dstW,
+                        cases[i].dstH, w, HAL_PIXEL_FORMAT_RGBA_8888);
+
+        r->rkRga->RkRgaSetScaleMode(cases[i].mode);
+        ret = r->rkRga->RkRgaBlit(nv12, dst, &rects, cases[i].rotation, 0);
+        checkHash(r, cases[i].name, ret, dst, size);
+    }
+
+    r->rkRga->RkRgaSetScaleMode(DRM_RGA_SCALE_AUTO);
+    free(dst);
+}
+
+static int copyStage(void *arg, void *in, void *out, int64_t * /* timestamp */)
+{
+    memcpy(out, in, *(size_t *)arg);
+    return 0;
+}
+
+/*
+ * The error paths of the pipeline: a blit stage whose request fails drops
+ * every frame and counts it, and a start that cannot allocate its rings
+ * unwinds so a second start fails the same way instead of leaking.
+ */
+static void runPipeline(Regress *r)
+{
+    const int w = REGRESS_WIDTH, h = REGRESS_HEIGHT, frames = 4;
+    size_t size = frameSize(w, h, HAL_PIXEL_FORMAT_RGBA_8888);
+    RockchipRgaPipeline::Frame frame;
+    rga_pipeline_stats_t stats;
+    drm_rga_t rects;
+    char detail[64];
+    int ret, retry;
+
+    printf("pipeline:\n");
+    {
+        RockchipRgaPipeline pipeline(size, 2);
+
+        /* a src format no core reads, every blit fails */
+        memset(&rects, 0, sizeof(drm_rga_t));
+        rga_set_rect(&rects.src, 0, 0, w, h, w, 0x7ff);
+        rga_set_rect(&rects.dst, 0, 0, w, h, w, HAL_PIXEL_FORMAT_RGBA_8888);
+        ret = pipeline.addBlitStage("bad-format", &rects, 0, size, 2);
+        if (ret >= 0)
+            ret = pipeline.start();
+        for (int i = 0; i < frames && !ret; i++) {
+            ret = pipeline.dequeueInput(&frame, 1000);
+            if (ret)
+                break;
+            memset(frame.data, CANARY, size);
+            frame.timestamp = i;
+            ret = pipeline.queueInput(&frame);
+        }
+        for (int i = 0; i < 100 && !ret; i++) {
+            pipeline.getStats(0, &stats);
+            if (stats.errors + stats.frames >= (unsigned int)frames)
+                break;
+            usleep(10000);
+        }
+        if (!ret)
+            ret = pipeline.getStats(0, &stats);
+        snprintf(detail, sizeof(detail), "ret %d errors %u frames %u",
+                    ret, ret ? 0 : stats.errors, ret ? 0 : stats.frames);
+        report(r, "pipeline-blit-error", !ret &&
+                    stats.errors == (unsigned int)frames && stats.frames == 0,
+                    detail);
+        pipeline.stop();
+    }
+
+    {
+        RockchipRgaPipeline pipeline(size, 2);
+
+        /* the first ring allocates, the second cannot */
+        ret = pipeline.addStage("huge", copyStage, &size, SIZE_MAX / 2, 2);
+        if (ret >= 0)
+            ret = pipeline.start();
+        retry = pipeline.start();
+        snprintf(detail, sizeof(detail), "ret %d retry %d", ret, retry);
+        report(r, "pipeline-start-nomem", ret == -ENOMEM && retry == -ENOMEM,
+                                                                    detail);
+    }
+}
+
+/*
+ * The 1920x1088 nv12 frame the other tests read, skipped when it or its
+ * goldens are missing. Returns whether the cases ran.
+ */
+static bool runCaptured(Regress *r, const char *path, bool haveGoldens)
+{
+    const int w = CAPTURED_WIDTH, h = CAPTURED_HEIGHT;
+    const int rgbaFmt = HAL_PIXEL_FORMAT_RGBA_8888;
+    const int nv12Fmt = HAL_PIXEL_FORMAT_YCrCb_NV12;
+    RockchipRgaRawReader reader;
+    rga_rect_t rect;
+    void *frame;
+
+    rga_set_rect(&rect, 0, 0, w, h, w, nv12Fmt);
+    if (reader.open(path, &rect) || !(frame = reader.frame(0))) {
+        printf("captured %s: not found, skipped\n", path);
+        return false;
+    }
+    if (!r->update && !haveGoldens) {
+        printf("captured %s: no goldens of this board, record them with -u, "
+                                                        "skipped\n", path);
+        return false;
+    }
+
+    printf("captured %dx%d:\n", w, h);
+    blitCase(r, CAPTURED_PREFIX "copy-nv12", frame, nv12Fmt, &rect, w, h,
+                                            nv12Fmt, NULL, 0, 0, NULL);
+    blitCase(r, CAPTURED_PREFIX "convert-nv12-rgba", frame, nv12Fmt, &rect,
+                                            w, h, rgbaFmt, NULL, 0, 0, NULL);
+    blitCase(r, CAPTURED_PREFIX "mirror-h-nv12-rgba", frame, nv12Fmt, &rect,
+                        w, h, rgbaFmt, NULL, HAL_TRANSFORM_FLIP_H, 0, NULL);
+    blitCase(r, CAPTURED_PREFIX "rotate-90-nv12-rgba", frame, nv12Fmt, &rect,
+                        h, w, rgbaFmt, NULL, HAL_TRANSFORM_ROT_90, 0, NULL);
+    blitCase(r, CAPTURED_PREFIX "rotate-270-nv12-nv12", frame, nv12Fmt, &rect,
+                        h, w, nv12Fmt, NULL, HAL_TRANSFORM_ROT_270, 0, NULL);
+
+    /* 1080p of the frame to a 720p portrait preview */
+    rga_set_rect(&rect, 0, 4, w, 1080, w, nv12Fmt);
+    blitCase(r, CAPTURED_PREFIX "crop-scale-rot90-nv12-rgba", frame, nv12Fmt,
+            &rect, 720, 1280, rgbaFmt, NULL, HAL_TRANSFORM_ROT_90, 0, NULL);
+    return true;
+}
+
+static bool runSuites(Regress *r, void *rgba, void *nv12, void *under,
+                                    const char *captured, bool haveCaptured)
+{
+    runBlits(r, rgba, nv12, under);
+    runRotate(r, rgba);
+    runStereo(r, rgba, nv12);
+    runPalette(r);
+    runOffsetRects(r);
+    runHybrid(r);
+    runDiffusion(r);
+    runScaling(r);
+    runFused(r, nv12);
+    runPipeline(r);
+    return runCaptured(r, captured, haveCaptured);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-u | -c] [goldens] [captured.nv12]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *goldens = "/data/local/tmp/rgaregress.golden";
+    const char *captured = "/data/inputBuffer.bin";
+    std::string capturedGoldens;
+    bool haveCaptured = false, ranCaptured;
+    const int w = REGRESS_WIDTH, h = REGRESS_HEIGHT;
+    uint8_t *rgba, *nv12, *under;
+    Regress r;
+    int arg = 1;
+
+    r.update = false;
+    r.cross = false;
+    r.passed = 0;
+    r.failed = 0;
+
+    if (arg < argc && !strcmp(argv[arg], "-u")) {
+        r.update = true;
+        arg++;
+    } else if (arg < argc && !strcmp(argv[arg], "-c")) {
+        r.cross = true;
+        arg++;
+    }
+    if (arg < argc && argv[arg][0] == '-') {
+        usage(argv[0]);
+        return -EINVAL;
+    }
+    if (arg < argc)
+        goldens = argv[arg++];
+    if (arg < argc)
+        captured = argv[arg++];
+    capturedGoldens = std::string(captured) + ".golden";
+
+    if (!r.update && !r.cross && loadGoldens(&r, goldens)) {
+        fprintf(stderr, "no goldens in %s, record them with -u\n", goldens);
+        return -ENOENT;
+    }
+    if (r.cross)
+        haveCaptured = true;
+    else if (!r.update)
+        haveCaptured = !loadGoldens(&r, capturedGoldens.c_str());
+
+    RockchipRga& rkRga(RockchipRga::get());
+
+    r.rkRga = &rkRga;
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_CPU);
+    rkRga.RkRgaSetScaleMode(DRM_RGA_SCALE_AUTO);
+    rkRga.RkRgaSetDitherMode(DRM_RGA_DITHER_AUTO);
+    rkRga.RkRgaSetDepthMode(DRM_RGA_DEPTH_TRUNCATE);
+
+    rgba = (uint8_t *)malloc(frameSize(w, h, HAL_PIXEL_FORMAT_RGBA_8888));
+    nv12 = (uint8_t *)malloc(frameSize(w, h, HAL_PIXEL_FORMAT_YCrCb_NV12));
+    under = (uint8_t *)malloc(frameSize(w, h, HAL_PIXEL_FORMAT_RGBA_8888));
+    if (!rgba || !nv12 || !under) {
+        free(rgba);
+        free(nv12);
+        free(under);
+        return -ENOMEM;
+    }
+    fillZonePlate(rgba, w, h);
+    fillNv12(nv12, w, h);
+    /* the plate turned on its side, so blends mix two different images */
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            memcpy(under + (y * w + x) * 4,
+                        rgba + ((h - 1 - y) * w + w - 1 - x) * 4, 3);
+            under[(y * w + x) * 4 + 3] = 0xff;
+        }
+    }
+
+    if (r.cross) {
+        /* the scalar pass stands in for the goldens of the neon pass */
+        printf("scalar:\n");
+        rkRga.RkRgaSetCpuSimd(0);
+        r.update = true;
+        runSuites(&r, rgba, nv12, under, captured, haveCaptured);
+        r.update = false;
+        r.goldens = r.results;
+        r.results.clear();
+        rkRga.RkRgaSetCpuSimd(1);
+        printf("neon:\n");
+    }
+    ranCaptured = runSuites(&r, rgba, nv12, under, captured, haveCaptured);
+
+    free(rgba);
+    free(nv12);
+    free(under);
+
+    rkRga.RkRgaSetEngine(DRM_RGA_ENGINE_HW);
+
+    if (r.update) {
+        int ret = saveGoldens(&r, goldens, false);
+
+        if (ret) {
+            fprintf(stderr, "write %s fail: %s\n", goldens, strerror(-ret));
+            return ret;
+        }
+        printf("goldens written to %s\n", goldens);
+
+        if (ranCaptured) {
+            ret = saveGoldens(&r, capturedGoldens.c_str(), true);
+            if (ret) {
+                fprintf(stderr, "write %s fail: %s\n",
+                                capturedGoldens.c_str(), strerror(-ret));
+                return ret;
+            }
+            printf("goldens of this board written to %s\n",
+                                                    capturedGoldens.c_str());
+        }
+        return r.failed ? -EIO : 0;
+    }
+
+    printf("%d passed, %d failed\n", r.passed, r.failed);
+    return r.failed ? -EIO : 0;
+}